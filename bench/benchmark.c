@@ -0,0 +1,1279 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * benchmark.c -- Speed of the functions of liboceanography.
+ *
+ * The inputs are profiles from the surface to 6000 decibars, with polar to
+ * tropical temperature and salinity. They are generated from a fixed seed,
+ * so that runs can be compared. Every function is timed on all the samples
+ * and reported as ns/sample and samples/s, in CSV or JSON.
+ *
+ * Usage: benchmark [--format csv|json] [--profiles N] [--time SECONDS]
+ *                  [--threads N] [--filter TEXT]
+ *
+ * The instruction set of the batch functions is selected as usual, so it
+ * can be forced with the OCEANOGRAPHY_ISA environment variable.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oceanography.h"
+
+/* Levels of every profile. Pressure grows with the square of the level, so
+ * the upper ocean, where gradients are strong, is sampled more densely. */
+#define LEVELS 512
+#define MAX_PRESSURE 6000.0
+
+#define DEFAULT_PROFILES 128
+#define DEFAULT_TIME 0.2
+
+/* Standard depths of regridding, every 60 meters. */
+#define DEPTHS 100
+
+/* Scans of the real time ring, pushed and then processed in turn. */
+#define RING 1024
+
+struct benchmark {
+    const char *function;
+    const char *path;
+    void (*run)(void);
+};
+
+/* Inputs and outputs, of n samples. */
+static size_t profiles, n;
+static double *c, *s, *t, *p, *lat, *th, *pr, *out, *sigma, *z, *rho, *cs;
+static double *all[9];
+static double *cl, *sl, *tl;
+static float *cf, *sf, *tf, *pf, *latf, *thf, *prf, *outf, *sigmaf;
+static double references[] = {0.0, 1000.0, 2000.0, 4000.0};
+static double depths[DEPTHS];
+static unsigned long histogram[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+static struct oceanography_pool *pool;
+static struct oceanography_table *svan_table;
+static struct oceanography_svp *svp;
+static struct oceanography_level levels[LEVELS];
+static struct oceanography_realtime *realtime;
+static struct oceanography_collection collection;
+static struct oceanography_profile_metrics *metrics;
+
+static unsigned long seed = 20110605UL;
+
+static double uniform(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+
+    return seed / 2147483648.0;
+}
+
+/* Fill the inputs with profiles at random latitudes between 75S and 75N.
+ * Temperature and salinity decay from surface values, that depend on the
+ * latitude, to deep water values through a thermocline of random depth.
+ */
+static void generate(void)
+{
+    size_t i, j, k;
+    double latitude, x, surface_t, deep_t, surface_s, deep_s, scale;
+
+    for (j = 0; j < profiles; j++) {
+        latitude = -75.0 + 150.0 * uniform();
+        x = cos(latitude / 57.29578);
+        x = x * x;
+        surface_t = -1.8 + 30.0 * x + uniform() - 0.5;
+        deep_t = -0.5 + 2.5 * x;
+        surface_s = 33.0 + 3.0 * x + 0.5 * (uniform() - 0.5);
+        deep_s = 34.7;
+        scale = 200.0 + 600.0 * uniform();
+
+        for (k = 0; k < LEVELS; k++) {
+            i = j * LEVELS + k;
+            x = (double) k / (LEVELS - 1);
+            p[i] = MAX_PRESSURE * x * x;
+            t[i] = deep_t + (surface_t - deep_t) * exp(-p[i] / scale) +
+                   0.01 * (uniform() - 0.5);
+            s[i] = deep_s + (surface_s - deep_s) *
+                   exp(-p[i] / (1.5 * scale)) + 0.005 * (uniform() - 0.5);
+            lat[i] = latitude;
+            pr[i] = 0.0;
+        }
+    }
+
+    conductivity_n(s, t, p, c, n);
+    potential_temperature_n(s, t, p, pr, th, n);
+    depth_n(p, lat, z, n);
+    density_n(s, t, p, rho, n);
+    sound_speed_n(s, t, p, cs, n);
+
+    /* The same samples level by level, for the functions on a level. */
+    for (j = 0; j < profiles; j++)
+        for (k = 0; k < LEVELS; k++) {
+            cl[k * profiles + j] = c[j * LEVELS + k];
+            sl[k * profiles + j] = s[j * LEVELS + k];
+            tl[k * profiles + j] = t[j * LEVELS + k];
+        }
+    for (k = 0; k < LEVELS; k++)
+        oceanography_level_init(&levels[k], p[k]);
+    for (k = 0; k < DEPTHS; k++)
+        depths[k] = 60.0 * k;
+
+    for (i = 0; i < n; i++) {
+        cf[i] = (float) c[i];
+        sf[i] = (float) s[i];
+        tf[i] = (float) t[i];
+        pf[i] = (float) p[i];
+        latf[i] = (float) lat[i];
+        thf[i] = (float) th[i];
+        prf[i] = (float) pr[i];
+    }
+}
+
+/* Scalar functions. */
+
+static void run_salinity(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = salinity(c[i], t[i], p[i]);
+}
+
+static void run_conductivity(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = conductivity(s[i], t[i], p[i]);
+}
+
+static void run_specific_volume_anomaly(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = specific_volume_anomaly(s[i], t[i], p[i], &sigma[i]);
+}
+
+static void run_depth(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = depth(p[i], lat[i]);
+}
+
+static void run_freezing_point(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = freezing_point(s[i], p[i]);
+}
+
+static void run_specific_heat(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = specific_heat(s[i], t[i], p[i]);
+}
+
+static void run_adiabatic_temperature_gradient(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = adiabatic_temperature_gradient(s[i], t[i], p[i]);
+}
+
+static void run_potential_temperature(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = potential_temperature(s[i], t[i], p[i], pr[i]);
+}
+
+static void run_in_situ_temperature(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = in_situ_temperature(s[i], th[i], p[i], pr[i]);
+}
+
+static void run_sound_speed(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = sound_speed(s[i], t[i], p[i]);
+}
+
+static void run_density(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = density(s[i], t[i], p[i]);
+}
+
+static void run_potential_density(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = potential_density(s[i], t[i], p[i], pr[i]);
+}
+
+static void run_pressure_from_depth(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = pressure_from_depth(z[i], lat[i]);
+}
+
+static void run_salinity_from_density(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = salinity_from_density(rho[i], t[i], p[i], &all[0][i]);
+}
+
+static void run_temperature_from_sound_speed(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = temperature_from_sound_speed(cs[i], s[i], p[i], &all[0][i]);
+}
+
+static void run_density_derivatives(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = density_derivatives(s[i], t[i], p[i], &all[0][i], &all[1][i],
+                                     &all[2][i]);
+}
+
+/* Batch functions. */
+
+static void run_salinity_n(void)
+{
+    salinity_n(c, t, p, out, n);
+}
+
+static void run_conductivity_n(void)
+{
+    conductivity_n(s, t, p, out, n);
+}
+
+static void run_conductivity_histogram_n(void)
+{
+    conductivity_histogram_n(s, t, p, out, histogram, n);
+}
+
+static void run_specific_volume_anomaly_n(void)
+{
+    specific_volume_anomaly_n(s, t, p, out, sigma, n);
+}
+
+static void run_depth_n(void)
+{
+    depth_n(p, lat, out, n);
+}
+
+static void run_freezing_point_n(void)
+{
+    freezing_point_n(s, p, out, n);
+}
+
+static void run_specific_heat_n(void)
+{
+    specific_heat_n(s, t, p, out, n);
+}
+
+static void run_adiabatic_temperature_gradient_n(void)
+{
+    adiabatic_temperature_gradient_n(s, t, p, out, n);
+}
+
+static void run_potential_temperature_n(void)
+{
+    potential_temperature_n(s, t, p, pr, out, n);
+}
+
+static void run_potential_temperature_multi_n(void)
+{
+    potential_temperature_multi_n(s, t, p, references, 4, all, n);
+}
+
+static void run_in_situ_temperature_n(void)
+{
+    in_situ_temperature_n(s, th, p, pr, out, n);
+}
+
+static void run_sound_speed_n(void)
+{
+    sound_speed_n(s, t, p, out, n);
+}
+
+/* Profile by profile, as an instrument would deliver them. */
+static void run_ctd_derive_n(void)
+{
+    struct ctd_outputs ctd;
+    size_t i;
+
+    for (i = 0; i < n; i += LEVELS) {
+        ctd.salinity = all[0] + i;
+        ctd.svan = all[1] + i;
+        ctd.sigma = all[2] + i;
+        ctd.theta = all[3] + i;
+        ctd.sound_speed = all[4] + i;
+        ctd.depth = all[5] + i;
+        ctd.cpsw = all[6] + i;
+        ctd.freezing_point = all[7] + i;
+        ctd.atg = all[8] + i;
+        ctd_derive_n(c + i, t + i, p + i, lat[i], 0.0, 0x1ff, &ctd, LEVELS);
+    }
+}
+
+static void run_geopotential_anomaly_n(void)
+{
+    struct geopotential state;
+    size_t i;
+
+    for (i = 0; i < n; i += LEVELS) {
+        geopotential_init(&state, 0.0);
+        geopotential_anomaly_n(&state, s + i, t + i, p + i, out + i, LEVELS);
+    }
+}
+
+static void run_dynamic_height_n(void)
+{
+    struct geopotential state;
+    size_t i;
+
+    for (i = 0; i < n; i += LEVELS) {
+        geopotential_init(&state, 0.0);
+        dynamic_height_n(&state, s + i, t + i, p + i, out + i, LEVELS);
+    }
+}
+
+static void run_density_derivatives_n(void)
+{
+    density_derivatives_n(s, t, p, out, all[0], all[1], all[2], n);
+}
+
+static void run_buoyancy_frequency_n(void)
+{
+    struct buoyancy_frequency state;
+    size_t i;
+
+    for (i = 0; i < n; i += LEVELS) {
+        buoyancy_frequency_init(&state, lat[i]);
+        buoyancy_frequency_n(&state, s + i, t + i, p + i, out + i, all[0] + i,
+                             LEVELS);
+    }
+}
+
+static void run_density_n(void)
+{
+    density_n(s, t, p, out, n);
+}
+
+static void run_potential_density_n(void)
+{
+    potential_density_n(s, t, p, pr, out, n);
+}
+
+static void run_potential_density_multi_n(void)
+{
+    potential_density_multi_n(s, t, p, references, 4, sigma, all, n);
+}
+
+static void run_pressure_from_depth_n(void)
+{
+    pressure_from_depth_n(z, lat, out, n);
+}
+
+/* Salinity and temperature of every profile at the standard depths. */
+static void run_regrid_n(void)
+{
+    const double *in[2];
+    double *regridded[2];
+    size_t i;
+
+    for (i = 0; i < profiles; i++) {
+        in[0] = s + i * LEVELS;
+        in[1] = t + i * LEVELS;
+        regridded[0] = all[0] + i * DEPTHS;
+        regridded[1] = all[1] + i * DEPTHS;
+        regrid_n(p + i * LEVELS, lat[i * LEVELS], in, 2, LEVELS, depths,
+                 DEPTHS, 0.0, regridded);
+    }
+}
+
+static void run_salinity_from_density_n(void)
+{
+    salinity_from_density_n(rho, t, p, out, all[0], n);
+}
+
+static void run_temperature_from_sound_speed_n(void)
+{
+    temperature_from_sound_speed_n(cs, s, p, out, all[0], n);
+}
+
+/* Summaries of all the outputs of the profiles, without histograms. */
+static void run_ctd_summarize_n(void)
+{
+    struct oceanography_summary summary[9];
+    struct ctd_summaries ctd;
+    size_t i;
+
+    for (i = 0; i < 9; i++)
+        oceanography_summary_init(&summary[i], NULL, 0, 0.0, 0.0);
+    ctd.salinity = &summary[0];
+    ctd.svan = &summary[1];
+    ctd.sigma = &summary[2];
+    ctd.theta = &summary[3];
+    ctd.sound_speed = &summary[4];
+    ctd.depth = &summary[5];
+    ctd.cpsw = &summary[6];
+    ctd.freezing_point = &summary[7];
+    ctd.atg = &summary[8];
+    for (i = 0; i < n; i += LEVELS)
+        ctd_summarize_n(c + i, t + i, p + i, lat[i], 0.0, 0x1ff, &ctd,
+                        LEVELS);
+}
+
+/* Functions on a pressure level, with the plans of the levels computed in
+ * advance. Every profile has the same pressure at a level. */
+
+static void run_level_init(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        oceanography_level_init(&levels[k], p[k]);
+}
+
+static void run_salinity_level_n(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        salinity_level_n(&levels[k], cl + k * profiles, tl + k * profiles,
+                         out + k * profiles, profiles);
+}
+
+static void run_conductivity_level_n(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        conductivity_level_n(&levels[k], sl + k * profiles, tl + k * profiles,
+                             out + k * profiles, profiles);
+}
+
+static void run_specific_volume_anomaly_level_n(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        specific_volume_anomaly_level_n(&levels[k], sl + k * profiles,
+                                        tl + k * profiles, out + k * profiles,
+                                        sigma + k * profiles, profiles);
+}
+
+static void run_freezing_point_level_n(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        freezing_point_level_n(&levels[k], sl + k * profiles,
+                               out + k * profiles, profiles);
+}
+
+static void run_specific_heat_level_n(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        specific_heat_level_n(&levels[k], sl + k * profiles,
+                              tl + k * profiles, out + k * profiles, profiles);
+}
+
+static void run_adiabatic_temperature_gradient_level_n(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        adiabatic_temperature_gradient_level_n(&levels[k], sl + k * profiles,
+                                               tl + k * profiles,
+                                               out + k * profiles, profiles);
+}
+
+static void run_sound_speed_level_n(void)
+{
+    size_t k;
+
+    for (k = 0; k < LEVELS; k++)
+        sound_speed_level_n(&levels[k], sl + k * profiles, tl + k * profiles,
+                            out + k * profiles, profiles);
+}
+
+/* Strided functions, walking the same arrays with a stride of 1. */
+
+static void run_salinity_strided(void)
+{
+    salinity_strided(c, 1, t, 1, p, 1, out, 1, n);
+}
+
+static void run_conductivity_strided(void)
+{
+    conductivity_strided(s, 1, t, 1, p, 1, out, 1, n);
+}
+
+static void run_specific_volume_anomaly_strided(void)
+{
+    specific_volume_anomaly_strided(s, 1, t, 1, p, 1, out, 1, sigma, 1, n);
+}
+
+static void run_depth_strided(void)
+{
+    depth_strided(p, 1, lat, 1, out, 1, n);
+}
+
+static void run_freezing_point_strided(void)
+{
+    freezing_point_strided(s, 1, p, 1, out, 1, n);
+}
+
+static void run_specific_heat_strided(void)
+{
+    specific_heat_strided(s, 1, t, 1, p, 1, out, 1, n);
+}
+
+static void run_adiabatic_temperature_gradient_strided(void)
+{
+    adiabatic_temperature_gradient_strided(s, 1, t, 1, p, 1, out, 1, n);
+}
+
+static void run_potential_temperature_strided(void)
+{
+    potential_temperature_strided(s, 1, t, 1, p, 1, pr, 1, out, 1, n);
+}
+
+static void run_in_situ_temperature_strided(void)
+{
+    in_situ_temperature_strided(s, 1, th, 1, p, 1, pr, 1, out, 1, n);
+}
+
+static void run_sound_speed_strided(void)
+{
+    sound_speed_strided(s, 1, t, 1, p, 1, out, 1, n);
+}
+
+static void run_density_strided(void)
+{
+    density_strided(s, 1, t, 1, p, 1, out, 1, n);
+}
+
+static void run_potential_density_strided(void)
+{
+    potential_density_strided(s, 1, t, 1, p, 1, pr, 1, out, 1, n);
+}
+
+static void run_pressure_from_depth_strided(void)
+{
+    pressure_from_depth_strided(z, 1, lat, 1, out, 1, n);
+}
+
+/* Single precision functions. */
+
+static void run_salinity_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = salinity_f(cf[i], tf[i], pf[i]);
+}
+
+static void run_conductivity_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = conductivity_f(sf[i], tf[i], pf[i]);
+}
+
+static void run_specific_volume_anomaly_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = specific_volume_anomaly_f(sf[i], tf[i], pf[i], &sigmaf[i]);
+}
+
+static void run_depth_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = depth_f(pf[i], latf[i]);
+}
+
+static void run_freezing_point_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = freezing_point_f(sf[i], pf[i]);
+}
+
+static void run_specific_heat_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = specific_heat_f(sf[i], tf[i], pf[i]);
+}
+
+static void run_adiabatic_temperature_gradient_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = adiabatic_temperature_gradient_f(sf[i], tf[i], pf[i]);
+}
+
+static void run_potential_temperature_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = potential_temperature_f(sf[i], tf[i], pf[i], prf[i]);
+}
+
+static void run_in_situ_temperature_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = in_situ_temperature_f(sf[i], thf[i], pf[i], prf[i]);
+}
+
+static void run_sound_speed_f(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        outf[i] = sound_speed_f(sf[i], tf[i], pf[i]);
+}
+
+static void run_salinity_n_f(void)
+{
+    salinity_n_f(cf, tf, pf, outf, n);
+}
+
+static void run_conductivity_n_f(void)
+{
+    conductivity_n_f(sf, tf, pf, outf, n);
+}
+
+static void run_specific_volume_anomaly_n_f(void)
+{
+    specific_volume_anomaly_n_f(sf, tf, pf, outf, sigmaf, n);
+}
+
+static void run_depth_n_f(void)
+{
+    depth_n_f(pf, latf, outf, n);
+}
+
+static void run_freezing_point_n_f(void)
+{
+    freezing_point_n_f(sf, pf, outf, n);
+}
+
+static void run_specific_heat_n_f(void)
+{
+    specific_heat_n_f(sf, tf, pf, outf, n);
+}
+
+static void run_adiabatic_temperature_gradient_n_f(void)
+{
+    adiabatic_temperature_gradient_n_f(sf, tf, pf, outf, n);
+}
+
+static void run_potential_temperature_n_f(void)
+{
+    potential_temperature_n_f(sf, tf, pf, prf, outf, n);
+}
+
+static void run_in_situ_temperature_n_f(void)
+{
+    in_situ_temperature_n_f(sf, thf, pf, prf, outf, n);
+}
+
+static void run_sound_speed_n_f(void)
+{
+    sound_speed_n_f(sf, tf, pf, outf, n);
+}
+
+/* Parallel functions. */
+
+static void run_salinity_parallel(void)
+{
+    salinity_parallel(pool, c, t, p, out, n);
+}
+
+static void run_conductivity_parallel(void)
+{
+    conductivity_parallel(pool, s, t, p, out, n);
+}
+
+static void run_specific_volume_anomaly_parallel(void)
+{
+    specific_volume_anomaly_parallel(pool, s, t, p, out, sigma, n);
+}
+
+static void run_depth_parallel(void)
+{
+    depth_parallel(pool, p, lat, out, n);
+}
+
+static void run_freezing_point_parallel(void)
+{
+    freezing_point_parallel(pool, s, p, out, n);
+}
+
+static void run_specific_heat_parallel(void)
+{
+    specific_heat_parallel(pool, s, t, p, out, n);
+}
+
+static void run_adiabatic_temperature_gradient_parallel(void)
+{
+    adiabatic_temperature_gradient_parallel(pool, s, t, p, out, n);
+}
+
+static void run_potential_temperature_parallel(void)
+{
+    potential_temperature_parallel(pool, s, t, p, pr, out, n);
+}
+
+static void run_sound_speed_parallel(void)
+{
+    sound_speed_parallel(pool, s, t, p, out, n);
+}
+
+static void run_ctd_derive_parallel(void)
+{
+    struct ctd_outputs ctd;
+
+    ctd.salinity = all[0];
+    ctd.svan = all[1];
+    ctd.sigma = all[2];
+    ctd.theta = all[3];
+    ctd.sound_speed = all[4];
+    ctd.depth = all[5];
+    ctd.cpsw = all[6];
+    ctd.freezing_point = all[7];
+    ctd.atg = all[8];
+    ctd_derive_parallel(pool, c, t, p, 45.0, 0.0, 0x1ff, &ctd, n);
+}
+
+static void run_collection_derive(void)
+{
+    struct ctd_outputs ctd;
+
+    ctd.salinity = all[0];
+    ctd.svan = all[1];
+    ctd.sigma = all[2];
+    ctd.theta = all[3];
+    ctd.sound_speed = all[4];
+    ctd.depth = all[5];
+    ctd.cpsw = all[6];
+    ctd.freezing_point = all[7];
+    ctd.atg = all[8];
+    oceanography_collection_derive(pool, &collection, 0.0, 0x1ff, &ctd);
+}
+
+static void run_collection_metrics(void)
+{
+    oceanography_collection_metrics(pool, &collection, 0.03, 10.0, metrics);
+}
+
+static void run_collection_regrid(void)
+{
+    const double *in[2];
+
+    in[0] = s;
+    in[1] = t;
+    oceanography_collection_regrid(pool, &collection, in, 2, depths, DEPTHS,
+                                   0.0, all);
+}
+
+/* Approximation tables, to compare with specific_volume_anomaly_n. */
+
+static void run_table_svan(void)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = oceanography_table_eval(svan_table, s[i], t[i], p[i]);
+}
+
+static void run_table_svan_n(void)
+{
+    oceanography_table_eval_n(svan_table, s, t, p, out, n);
+}
+
+/* Sound velocity profiles, queried at the depths of all the profiles. */
+
+static void run_svp_eval_n(void)
+{
+    oceanography_svp_eval_n(svp, z, out, all[0], n);
+}
+
+/* Depth, sigma and sound speed of the profiles as a longitude x level grid,
+ * with the pressure of the levels of the first profile broadcast to the
+ * others, levels varying fastest, or longitude with the level by level
+ * copies of the samples. */
+static void grid_derive(const double *salinity, const double *temperature,
+                        size_t longitude_stride, size_t level_stride)
+{
+    struct oceanography_grid grid;
+    struct ctd_outputs ctd;
+
+    grid.shape[0] = profiles;
+    grid.shape[1] = 1;
+    grid.shape[2] = LEVELS;
+    grid.stride[0] = longitude_stride;
+    grid.stride[1] = 0;
+    grid.stride[2] = level_stride;
+    grid.pressure_stride[0] = 0;
+    grid.pressure_stride[1] = 0;
+    grid.pressure_stride[2] = 1;
+    grid.latitude_stride[0] = LEVELS;
+    grid.latitude_stride[1] = 0;
+
+    ctd.salinity = NULL;
+    ctd.svan = NULL;
+    ctd.sigma = all[2];
+    ctd.theta = NULL;
+    ctd.sound_speed = all[4];
+    ctd.depth = all[5];
+    ctd.cpsw = NULL;
+    ctd.freezing_point = NULL;
+    ctd.atg = NULL;
+    oceanography_grid_derive(&grid, salinity, temperature, p, lat, 0.0,
+                             OCEANOGRAPHY_CTD_DEPTH | OCEANOGRAPHY_CTD_SIGMA |
+                             OCEANOGRAPHY_CTD_SOUND_SPEED, &ctd);
+}
+
+static void run_grid_derive_columns(void)
+{
+    grid_derive(s, t, LEVELS, 1);
+}
+
+static void run_grid_derive_levels(void)
+{
+    grid_derive(sl, tl, 1, profiles);
+}
+
+/* Real time ingestion of all the outputs in 1 decibar bins, from the same
+ * thread. */
+static void run_realtime(void)
+{
+    struct oceanography_scan scan;
+    size_t i, j;
+
+    for (i = 0; i < n; i += RING) {
+        for (j = i; j < n && j < i + RING; j++) {
+            scan.conductivity = c[j];
+            scan.temperature = t[j];
+            scan.pressure = p[j];
+            oceanography_realtime_push(realtime, &scan);
+        }
+        oceanography_realtime_process(realtime, NULL, RING);
+    }
+}
+
+static const struct benchmark benchmarks[] = {
+    {"salinity", "scalar", run_salinity},
+    {"conductivity", "scalar", run_conductivity},
+    {"specific_volume_anomaly", "scalar", run_specific_volume_anomaly},
+    {"depth", "scalar", run_depth},
+    {"freezing_point", "scalar", run_freezing_point},
+    {"specific_heat", "scalar", run_specific_heat},
+    {"adiabatic_temperature_gradient", "scalar",
+     run_adiabatic_temperature_gradient},
+    {"potential_temperature", "scalar", run_potential_temperature},
+    {"in_situ_temperature", "scalar", run_in_situ_temperature},
+    {"sound_speed", "scalar", run_sound_speed},
+    {"density_derivatives", "scalar", run_density_derivatives},
+    {"density", "scalar", run_density},
+    {"potential_density", "scalar", run_potential_density},
+    {"pressure_from_depth", "scalar", run_pressure_from_depth},
+    {"salinity_from_density", "scalar", run_salinity_from_density},
+    {"temperature_from_sound_speed", "scalar",
+     run_temperature_from_sound_speed},
+
+    {"salinity_n", "batch", run_salinity_n},
+    {"conductivity_n", "batch", run_conductivity_n},
+    {"conductivity_histogram_n", "batch", run_conductivity_histogram_n},
+    {"specific_volume_anomaly_n", "batch", run_specific_volume_anomaly_n},
+    {"depth_n", "batch", run_depth_n},
+    {"freezing_point_n", "batch", run_freezing_point_n},
+    {"specific_heat_n", "batch", run_specific_heat_n},
+    {"adiabatic_temperature_gradient_n", "batch",
+     run_adiabatic_temperature_gradient_n},
+    {"potential_temperature_n", "batch", run_potential_temperature_n},
+    {"potential_temperature_multi_n", "batch",
+     run_potential_temperature_multi_n},
+    {"in_situ_temperature_n", "batch", run_in_situ_temperature_n},
+    {"sound_speed_n", "batch", run_sound_speed_n},
+    {"ctd_derive_n", "batch", run_ctd_derive_n},
+    {"geopotential_anomaly_n", "batch", run_geopotential_anomaly_n},
+    {"dynamic_height_n", "batch", run_dynamic_height_n},
+    {"density_derivatives_n", "batch", run_density_derivatives_n},
+    {"buoyancy_frequency_n", "batch", run_buoyancy_frequency_n},
+    {"density_n", "batch", run_density_n},
+    {"potential_density_n", "batch", run_potential_density_n},
+    {"potential_density_multi_n", "batch", run_potential_density_multi_n},
+    {"ctd_summarize_n", "batch", run_ctd_summarize_n},
+    {"pressure_from_depth_n", "batch", run_pressure_from_depth_n},
+    {"regrid_n", "batch", run_regrid_n},
+    {"salinity_from_density_n", "batch", run_salinity_from_density_n},
+    {"temperature_from_sound_speed_n", "batch",
+     run_temperature_from_sound_speed_n},
+
+    {"oceanography_level_init", "level", run_level_init},
+    {"salinity_level_n", "level", run_salinity_level_n},
+    {"conductivity_level_n", "level", run_conductivity_level_n},
+    {"specific_volume_anomaly_level_n", "level",
+     run_specific_volume_anomaly_level_n},
+    {"freezing_point_level_n", "level", run_freezing_point_level_n},
+    {"specific_heat_level_n", "level", run_specific_heat_level_n},
+    {"adiabatic_temperature_gradient_level_n", "level",
+     run_adiabatic_temperature_gradient_level_n},
+    {"sound_speed_level_n", "level", run_sound_speed_level_n},
+
+    {"salinity_strided", "strided", run_salinity_strided},
+    {"conductivity_strided", "strided", run_conductivity_strided},
+    {"specific_volume_anomaly_strided", "strided",
+     run_specific_volume_anomaly_strided},
+    {"depth_strided", "strided", run_depth_strided},
+    {"freezing_point_strided", "strided", run_freezing_point_strided},
+    {"specific_heat_strided", "strided", run_specific_heat_strided},
+    {"adiabatic_temperature_gradient_strided", "strided",
+     run_adiabatic_temperature_gradient_strided},
+    {"potential_temperature_strided", "strided",
+     run_potential_temperature_strided},
+    {"in_situ_temperature_strided", "strided",
+     run_in_situ_temperature_strided},
+    {"sound_speed_strided", "strided", run_sound_speed_strided},
+    {"density_strided", "strided", run_density_strided},
+    {"potential_density_strided", "strided", run_potential_density_strided},
+    {"pressure_from_depth_strided", "strided",
+     run_pressure_from_depth_strided},
+
+    {"salinity_f", "float", run_salinity_f},
+    {"conductivity_f", "float", run_conductivity_f},
+    {"specific_volume_anomaly_f", "float", run_specific_volume_anomaly_f},
+    {"depth_f", "float", run_depth_f},
+    {"freezing_point_f", "float", run_freezing_point_f},
+    {"specific_heat_f", "float", run_specific_heat_f},
+    {"adiabatic_temperature_gradient_f", "float",
+     run_adiabatic_temperature_gradient_f},
+    {"potential_temperature_f", "float", run_potential_temperature_f},
+    {"in_situ_temperature_f", "float", run_in_situ_temperature_f},
+    {"sound_speed_f", "float", run_sound_speed_f},
+
+    {"salinity_n_f", "float_batch", run_salinity_n_f},
+    {"conductivity_n_f", "float_batch", run_conductivity_n_f},
+    {"specific_volume_anomaly_n_f", "float_batch",
+     run_specific_volume_anomaly_n_f},
+    {"depth_n_f", "float_batch", run_depth_n_f},
+    {"freezing_point_n_f", "float_batch", run_freezing_point_n_f},
+    {"specific_heat_n_f", "float_batch", run_specific_heat_n_f},
+    {"adiabatic_temperature_gradient_n_f", "float_batch",
+     run_adiabatic_temperature_gradient_n_f},
+    {"potential_temperature_n_f", "float_batch",
+     run_potential_temperature_n_f},
+    {"in_situ_temperature_n_f", "float_batch", run_in_situ_temperature_n_f},
+    {"sound_speed_n_f", "float_batch", run_sound_speed_n_f},
+
+    {"salinity_parallel", "parallel", run_salinity_parallel},
+    {"conductivity_parallel", "parallel", run_conductivity_parallel},
+    {"specific_volume_anomaly_parallel", "parallel",
+     run_specific_volume_anomaly_parallel},
+    {"depth_parallel", "parallel", run_depth_parallel},
+    {"freezing_point_parallel", "parallel", run_freezing_point_parallel},
+    {"specific_heat_parallel", "parallel", run_specific_heat_parallel},
+    {"adiabatic_temperature_gradient_parallel", "parallel",
+     run_adiabatic_temperature_gradient_parallel},
+    {"potential_temperature_parallel", "parallel",
+     run_potential_temperature_parallel},
+    {"sound_speed_parallel", "parallel", run_sound_speed_parallel},
+    {"ctd_derive_parallel", "parallel", run_ctd_derive_parallel},
+    {"oceanography_collection_derive", "parallel", run_collection_derive},
+    {"oceanography_collection_metrics", "parallel", run_collection_metrics},
+    {"oceanography_collection_regrid", "parallel", run_collection_regrid},
+
+    {"oceanography_table_eval/svan", "table", run_table_svan},
+    {"oceanography_table_eval_n/svan", "table", run_table_svan_n},
+
+    {"oceanography_svp_eval_n", "svp", run_svp_eval_n},
+
+    {"oceanography_grid_derive/columns", "grid", run_grid_derive_columns},
+    {"oceanography_grid_derive/levels", "grid", run_grid_derive_levels},
+
+    {"oceanography_realtime_process", "realtime", run_realtime}
+};
+
+#define BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/* Seconds per call of run, calling it until min_time has passed after a
+ * first call that warms the caches up. */
+static double measure(void (*run)(void), double min_time)
+{
+    double start, elapsed;
+    unsigned long calls = 0;
+
+    run();
+
+    start = now();
+    do {
+        run();
+        calls++;
+        elapsed = now() - start;
+    } while (elapsed < min_time);
+
+    return elapsed / calls;
+}
+
+static struct oceanography_table *create_table(void)
+{
+    struct oceanography_table_spec spec;
+
+    spec.function = OCEANOGRAPHY_TABLE_SVAN;
+    spec.min[0] = 30.0;
+    spec.max[0] = 38.0;
+    spec.min[1] = -2.0;
+    spec.max[1] = 32.0;
+    spec.min[2] = 0.0;
+    spec.max[2] = MAX_PRESSURE;
+    spec.cells[0] = 2;
+    spec.cells[1] = 8;
+    spec.cells[2] = 16;
+    spec.degree[0] = 1;
+    spec.degree[1] = 2;
+    spec.degree[2] = 2;
+
+    return oceanography_table_create(&spec);
+}
+
+static struct oceanography_realtime *create_realtime(void)
+{
+    struct oceanography_realtime_spec spec;
+
+    spec.capacity = RING;
+    spec.latitude = 45.0;
+    spec.reference_pressure = 0.0;
+    spec.outputs = 0x1ff;
+    spec.bin_width = 1.0;
+    spec.bins = (size_t) MAX_PRESSURE + 1;
+
+    return oceanography_realtime_create(&spec);
+}
+
+static void *allocate(size_t size)
+{
+    void *p = malloc(size * n);
+
+    if (p == NULL) {
+        fprintf(stderr, "benchmark: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return p;
+}
+
+/* The profiles as a collection, with the latitude of their first sample.
+ * The arrays of allocate() hold n elements, enough for profiles + 1. */
+static void create_collection(void)
+{
+    size_t *offset = allocate(sizeof(size_t)), j;
+    double *latitude = allocate(sizeof(double));
+
+    for (j = 0; j <= profiles; j++)
+        offset[j] = j * LEVELS;
+    for (j = 0; j < profiles; j++)
+        latitude[j] = lat[j * LEVELS];
+
+    collection.profiles = profiles;
+    collection.offset = offset;
+    collection.salinity = s;
+    collection.temperature = t;
+    collection.pressure = p;
+    collection.latitude = latitude;
+    metrics = allocate(sizeof(*metrics));
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: benchmark [--format csv|json] [--profiles N] "
+                    "[--time SECONDS]\n"
+                    "                 [--threads N] [--filter TEXT]\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    const char *format = "csv", *filter = NULL, *isa;
+    double min_time = DEFAULT_TIME, seconds, ns;
+    unsigned int threads = 0, pool_threads;
+    size_t b;
+    int i, first = 1;
+
+    profiles = DEFAULT_PROFILES;
+    for (i = 1; i < argc; i++) {
+        if (i + 1 == argc)
+            usage();
+        if (strcmp(argv[i], "--format") == 0)
+            format = argv[++i];
+        else if (strcmp(argv[i], "--profiles") == 0)
+            profiles = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--time") == 0)
+            min_time = atof(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0)
+            threads = (unsigned int) strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--filter") == 0)
+            filter = argv[++i];
+        else
+            usage();
+    }
+    if ((strcmp(format, "csv") != 0 && strcmp(format, "json") != 0) ||
+        profiles == 0)
+        usage();
+
+    n = profiles * LEVELS;
+    c = allocate(sizeof(double));
+    s = allocate(sizeof(double));
+    t = allocate(sizeof(double));
+    p = allocate(sizeof(double));
+    lat = allocate(sizeof(double));
+    th = allocate(sizeof(double));
+    pr = allocate(sizeof(double));
+    out = allocate(sizeof(double));
+    sigma = allocate(sizeof(double));
+    z = allocate(sizeof(double));
+    rho = allocate(sizeof(double));
+    cs = allocate(sizeof(double));
+    for (i = 0; i < 9; i++)
+        all[i] = allocate(sizeof(double));
+    cl = allocate(sizeof(double));
+    sl = allocate(sizeof(double));
+    tl = allocate(sizeof(double));
+    cf = allocate(sizeof(float));
+    sf = allocate(sizeof(float));
+    tf = allocate(sizeof(float));
+    pf = allocate(sizeof(float));
+    latf = allocate(sizeof(float));
+    thf = allocate(sizeof(float));
+    prf = allocate(sizeof(float));
+    outf = allocate(sizeof(float));
+    sigmaf = allocate(sizeof(float));
+
+    generate();
+    create_collection();
+
+    pool = oceanography_pool_create(threads);
+    svan_table = create_table();
+    svp = oceanography_svp_create(s, t, p, lat[0], LEVELS);
+    realtime = create_realtime();
+    if (pool == NULL || svan_table == NULL || svp == NULL ||
+        realtime == NULL) {
+        fprintf(stderr, "benchmark: out of memory\n");
+        return EXIT_FAILURE;
+    }
+    pool_threads = oceanography_pool_threads(pool);
+    isa = oceanography_isa_name(oceanography_get_isa());
+
+    if (strcmp(format, "csv") == 0)
+        printf("function,path,isa,threads,samples,ns_per_sample,"
+               "samples_per_second\n");
+    else
+        printf("{\n  \"version\": \"%s\",\n  \"isa\": \"%s\",\n"
+               "  \"samples\": %lu,\n  \"results\": [",
+               OCEANOGRAPHY_VERSION, isa, (unsigned long) n);
+
+    for (b = 0; b < BENCHMARKS; b++) {
+        if (filter != NULL && strstr(benchmarks[b].function, filter) == NULL)
+            continue;
+
+        seconds = measure(benchmarks[b].run, min_time);
+        ns = seconds * 1.0e9 / n;
+        threads = strcmp(benchmarks[b].path, "parallel") == 0 ?
+                  pool_threads : 1;
+
+        if (strcmp(format, "csv") == 0)
+            printf("%s,%s,%s,%u,%lu,%.3f,%.0f\n", benchmarks[b].function,
+                   benchmarks[b].path, isa, threads, (unsigned long) n, ns,
+                   n / seconds);
+        else
+            printf("%s\n    {\"function\": \"%s\", \"path\": \"%s\", "
+                   "\"threads\": %u, \"ns_per_sample\": %.3f, "
+                   "\"samples_per_second\": %.0f}",
+                   first ? "" : ",", benchmarks[b].function,
+                   benchmarks[b].path, threads, ns, n / seconds);
+        first = 0;
+        fflush(stdout);
+    }
+
+    if (strcmp(format, "json") == 0)
+        printf("\n  ]\n}\n");
+
+    oceanography_table_destroy(svan_table);
+    oceanography_svp_destroy(svp);
+    oceanography_realtime_destroy(realtime);
+    oceanography_pool_destroy(pool);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,686 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * batch.c -- Batch versions of the functions of liboceanography.
+ *
+ * Every function loops over n samples calling the same kernel used by the
+ * scalar function (see kernels.h), so results are bit for bit identical.
+ * The *_n versions of salinity, conductivity and of the polynomial functions
+ * run the vectorized kernels selected by dispatch.c, that give the same
+ * results.
+ *
+ * Strides are counted in elements, not in bytes. A stride of 0 repeats the
+ * first element for all the samples.
+ */
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+#include "stats.h"
+
+/* Samples whose gravity is computed at once by pressure_from_depth_n(). */
+#define BLOCK 256
+
+/* salinity_n -- convert n conductivity ratios to salinity.
+ *
+ * Units are the same of salinity().
+ */
+
+void salinity_n(const double *conductivity, const double *temperature,
+                const double *pressure, double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+    simd_select()->salinity(conductivity, temperature, pressure, out, n);
+    STATS_END(n, conductivity, 1, temperature, 1, pressure, 1);
+}
+
+void salinity_strided(const double *conductivity, size_t conductivity_stride,
+                      const double *temperature, size_t temperature_stride,
+                      const double *pressure, size_t pressure_stride,
+                      double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _salinity(conductivity[i * conductivity_stride],
+                                        temperature[i * temperature_stride],
+                                        pressure[i * pressure_stride]);
+    STATS_END(n, conductivity, conductivity_stride, temperature,
+              temperature_stride, pressure, pressure_stride);
+}
+
+/* conductivity_n -- convert n salinities to conductivity ratio.
+ *
+ * Units are the same of conductivity().
+ */
+
+void conductivity_n(const double *salinity, const double *temperature,
+                    const double *pressure, double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    simd_select()->conductivity(salinity, temperature, pressure, out,
+                                STATS_HISTOGRAM(), n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* conductivity_histogram_n -- convert n salinities to conductivity ratio,
+ * counting the Newton iterations.
+ *
+ * histogram must have OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1 elements:
+ * histogram[k] is incremented for every sample that took k iterations (0 for
+ * salinities out of range). It is not cleared, so it can be accumulated over
+ * several calls.
+ */
+
+void conductivity_histogram_n(const double *salinity,
+                              const double *temperature,
+                              const double *pressure, double *out,
+                              unsigned long *histogram, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    simd_select()->conductivity(salinity, temperature, pressure, out,
+                                histogram, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void conductivity_strided(const double *salinity, size_t salinity_stride,
+                          const double *temperature, size_t temperature_stride,
+                          const double *pressure, size_t pressure_stride,
+                          double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    int iterations;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    for (i = 0; i < n; i++) {
+        out[i * out_stride] = _conductivity_iterations(
+            salinity[i * salinity_stride], temperature[i * temperature_stride],
+            pressure[i * pressure_stride], &iterations);
+        STATS_ITERATIONS(iterations);
+    }
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* specific_volume_anomaly_n -- compute n specific volume anomalies.
+ *
+ * Units are the same of specific_volume_anomaly(). sigma can be NULL when
+ * density anomalies are not needed.
+ */
+
+void specific_volume_anomaly_n(const double *salinity,
+                               const double *temperature,
+                               const double *pressure, double *out,
+                               double *sigma, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY);
+    simd_select()->specific_volume_anomaly(salinity, temperature, pressure,
+                                           out, sigma, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void specific_volume_anomaly_strided(const double *salinity,
+                                     size_t salinity_stride,
+                                     const double *temperature,
+                                     size_t temperature_stride,
+                                     const double *pressure,
+                                     size_t pressure_stride,
+                                     double *out, size_t out_stride,
+                                     double *sigma, size_t sigma_stride,
+                                     size_t n)
+{
+    size_t i;
+    double sig;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY);
+    for (i = 0; i < n; i++) {
+        out[i * out_stride] = _specific_volume_anomaly(
+            salinity[i * salinity_stride], temperature[i * temperature_stride],
+            pressure[i * pressure_stride], &sig);
+        if (sigma != NULL)
+            sigma[i * sigma_stride] = sig;
+    }
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* depth_n -- compute n depths from pressure.
+ *
+ * Units are the same of depth().
+ */
+
+void depth_n(const double *pressure, const double *latitude, double *out,
+             size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DEPTH);
+    for (i = 0; i < n; i++)
+        out[i] = _depth(pressure[i], latitude[i]);
+    STATS_END(n, pressure, 1, latitude, 1, NULL, 0);
+}
+
+void depth_strided(const double *pressure, size_t pressure_stride,
+                   const double *latitude, size_t latitude_stride,
+                   double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DEPTH);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _depth(pressure[i * pressure_stride],
+                                     latitude[i * latitude_stride]);
+    STATS_END(n, pressure, pressure_stride, latitude, latitude_stride, NULL,
+              0);
+}
+
+/* pressure_from_depth_n -- compute n pressures from depth.
+ *
+ * Units are the same of pressure_from_depth().
+ */
+
+void pressure_from_depth_n(const double *depth, const double *latitude,
+                           double *out, size_t n)
+{
+    const struct simd_kernels *kernels = simd_select();
+    double gravity[BLOCK];
+    size_t i, j, m;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_PRESSURE_FROM_DEPTH);
+    for (i = 0; i < n; i += m) {
+        m = n - i < BLOCK ? n - i : BLOCK;
+        for (j = 0; j < m; j++)
+            gravity[j] = _gravity(latitude[i + j]);
+        kernels->pressure_from_depth(depth + i, gravity, out + i, m);
+    }
+    STATS_END(n, depth, 1, latitude, 1, NULL, 0);
+}
+
+void pressure_from_depth_strided(const double *depth, size_t depth_stride,
+                                 const double *latitude,
+                                 size_t latitude_stride, double *out,
+                                 size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_PRESSURE_FROM_DEPTH);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _pressure_from_depth(
+            depth[i * depth_stride], latitude[i * latitude_stride]);
+    STATS_END(n, depth, depth_stride, latitude, latitude_stride, NULL, 0);
+}
+
+/* freezing_point_n -- compute n freezing points of seawater.
+ *
+ * Units are the same of freezing_point().
+ */
+
+void freezing_point_n(const double *salinity, const double *pressure,
+                      double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_FREEZING_POINT);
+    simd_select()->freezing_point(salinity, pressure, out, n);
+    STATS_END(n, salinity, 1, pressure, 1, NULL, 0);
+}
+
+void freezing_point_strided(const double *salinity, size_t salinity_stride,
+                            const double *pressure, size_t pressure_stride,
+                            double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_FREEZING_POINT);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _freezing_point(salinity[i * salinity_stride],
+                                              pressure[i * pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, pressure, pressure_stride, NULL,
+              0);
+}
+
+/* specific_heat_n -- compute n specific heats of seawater.
+ *
+ * Units are the same of specific_heat().
+ */
+
+void specific_heat_n(const double *salinity, const double *temperature,
+                     const double *pressure, double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_HEAT);
+    simd_select()->specific_heat(salinity, temperature, pressure, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void specific_heat_strided(const double *salinity, size_t salinity_stride,
+                           const double *temperature,
+                           size_t temperature_stride,
+                           const double *pressure, size_t pressure_stride,
+                           double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_HEAT);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _specific_heat(salinity[i * salinity_stride],
+                                             temperature[i *
+                                                         temperature_stride],
+                                             pressure[i * pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* adiabatic_temperature_gradient_n -- compute n adiabatic temperature
+ * gradients.
+ *
+ * Units are the same of adiabatic_temperature_gradient().
+ */
+
+void adiabatic_temperature_gradient_n(const double *salinity,
+                                      const double *temperature,
+                                      const double *pressure, double *out,
+                                      size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT);
+    simd_select()->adiabatic_temperature_gradient(salinity, temperature,
+                                                  pressure, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void adiabatic_temperature_gradient_strided(const double *salinity,
+                                            size_t salinity_stride,
+                                            const double *temperature,
+                                            size_t temperature_stride,
+                                            const double *pressure,
+                                            size_t pressure_stride,
+                                            double *out, size_t out_stride,
+                                            size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _adiabatic_temperature_gradient(
+            salinity[i * salinity_stride], temperature[i * temperature_stride],
+            pressure[i * pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* potential_temperature_n -- compute n local potential temperatures.
+ *
+ * Units are the same of potential_temperature(). Use
+ * potential_temperature_strided() with a reference_pressure_stride of 0 to
+ * use the same reference pressure for all the samples.
+ */
+
+void potential_temperature_n(const double *salinity,
+                             const double *temperature,
+                             const double *pressure,
+                             const double *reference_pressure, double *out,
+                             size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE);
+    simd_select()->potential_temperature(salinity, temperature, pressure,
+                                         reference_pressure, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void potential_temperature_strided(const double *salinity,
+                                   size_t salinity_stride,
+                                   const double *temperature,
+                                   size_t temperature_stride,
+                                   const double *pressure,
+                                   size_t pressure_stride,
+                                   const double *reference_pressure,
+                                   size_t reference_pressure_stride,
+                                   double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _potential_temperature(
+            salinity[i * salinity_stride], temperature[i * temperature_stride],
+            pressure[i * pressure_stride],
+            reference_pressure[i * reference_pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* potential_temperature_multi_n -- compute the local potential temperatures
+ * of n samples at several reference pressures.
+ *
+ * out[r] receives the n potential temperatures at reference_pressure[r], for
+ * r from 0 to references - 1. The adiabatic temperature gradient at the
+ * sample is computed once for all the reference pressures, so four
+ * reference pressures take 13 evaluations of it instead of 16. Results are
+ * identical to potential_temperature().
+ */
+
+void potential_temperature_multi_n(const double *salinity,
+                                   const double *temperature,
+                                   const double *pressure,
+                                   const double *reference_pressure,
+                                   size_t references, double *const *out,
+                                   size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE);
+    simd_select()->potential_temperature_multi(salinity, temperature,
+                                               pressure, reference_pressure,
+                                               references, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* in_situ_temperature_n -- compute n in situ temperatures from potential
+ * temperatures.
+ *
+ * Units are the same of in_situ_temperature().
+ */
+
+void in_situ_temperature_n(const double *salinity,
+                           const double *potential_temperature,
+                           const double *pressure,
+                           const double *reference_pressure, double *out,
+                           size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_IN_SITU_TEMPERATURE);
+    simd_select()->in_situ_temperature(salinity, potential_temperature,
+                                       pressure, reference_pressure, out, n);
+    STATS_END(n, salinity, 1, potential_temperature, 1, pressure, 1);
+}
+
+void in_situ_temperature_strided(const double *salinity,
+                                 size_t salinity_stride,
+                                 const double *potential_temperature,
+                                 size_t potential_temperature_stride,
+                                 const double *pressure,
+                                 size_t pressure_stride,
+                                 const double *reference_pressure,
+                                 size_t reference_pressure_stride,
+                                 double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_IN_SITU_TEMPERATURE);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _in_situ_temperature(
+            salinity[i * salinity_stride],
+            potential_temperature[i * potential_temperature_stride],
+            pressure[i * pressure_stride],
+            reference_pressure[i * reference_pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, potential_temperature,
+              potential_temperature_stride, pressure, pressure_stride);
+}
+
+/* sound_speed_n -- compute n sound speeds in seawater.
+ *
+ * Units are the same of sound_speed().
+ */
+
+void sound_speed_n(const double *salinity, const double *temperature,
+                   const double *pressure, double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SOUND_SPEED);
+    simd_select()->sound_speed(salinity, temperature, pressure, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void sound_speed_strided(const double *salinity, size_t salinity_stride,
+                         const double *temperature, size_t temperature_stride,
+                         const double *pressure, size_t pressure_stride,
+                         double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SOUND_SPEED);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _sound_speed(salinity[i * salinity_stride],
+                                           temperature[i * temperature_stride],
+                                           pressure[i * pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* density_derivatives_n -- compute n density anomalies with their
+ * derivatives.
+ *
+ * Units are the same of density_derivatives(). Any of sigma, alpha, beta and
+ * kappa can be NULL when not needed.
+ */
+
+void density_derivatives_n(const double *salinity, const double *temperature,
+                           const double *pressure, double *sigma,
+                           double *alpha, double *beta, double *kappa,
+                           size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DENSITY_DERIVATIVES);
+    simd_select()->density_derivatives(salinity, temperature, pressure, sigma,
+                                       alpha, beta, kappa, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* density_n -- compute n in situ density anomalies.
+ *
+ * Units are the same of density().
+ */
+
+void density_n(const double *salinity, const double *temperature,
+               const double *pressure, double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DENSITY);
+    simd_select()->density(salinity, temperature, pressure, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void density_strided(const double *salinity, size_t salinity_stride,
+                     const double *temperature, size_t temperature_stride,
+                     const double *pressure, size_t pressure_stride,
+                     double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DENSITY);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _density(salinity[i * salinity_stride],
+                                       temperature[i * temperature_stride],
+                                       pressure[i * pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* potential_density_n -- compute n potential density anomalies.
+ *
+ * Units are the same of potential_density(). Use potential_density_strided()
+ * with a reference_pressure_stride of 0 to use the same reference pressure
+ * for all the samples.
+ */
+
+void potential_density_n(const double *salinity, const double *temperature,
+                         const double *pressure,
+                         const double *reference_pressure, double *out,
+                         size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_DENSITY);
+    simd_select()->potential_density(salinity, temperature, pressure,
+                                     reference_pressure, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void potential_density_strided(const double *salinity,
+                               size_t salinity_stride,
+                               const double *temperature,
+                               size_t temperature_stride,
+                               const double *pressure,
+                               size_t pressure_stride,
+                               const double *reference_pressure,
+                               size_t reference_pressure_stride,
+                               double *out, size_t out_stride, size_t n)
+{
+    size_t i;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_DENSITY);
+    for (i = 0; i < n; i++)
+        out[i * out_stride] = _potential_density(
+            salinity[i * salinity_stride], temperature[i * temperature_stride],
+            pressure[i * pressure_stride],
+            reference_pressure[i * reference_pressure_stride]);
+    STATS_END(n, salinity, salinity_stride, temperature, temperature_stride,
+              pressure, pressure_stride);
+}
+
+/* potential_density_multi_n -- compute the in situ density anomalies of n
+ * samples and their potential density anomalies at several reference
+ * pressures.
+ *
+ * sigma, that can be NULL, receives the n in situ density anomalies and
+ * out[r] the n potential density anomalies at reference_pressure[r], for r
+ * from 0 to references - 1: sigma-theta for a reference pressure of 0,
+ * sigma-2 for 2000 decibars. sqrt(fabs(salinity)) and the first adiabatic
+ * temperature gradient of the potential temperatures are computed once for
+ * all the outputs, and the secant bulk modulus is not computed at a zero
+ * reference pressure. Results are identical to density() and
+ * potential_density().
+ */
+
+void potential_density_multi_n(const double *salinity,
+                               const double *temperature,
+                               const double *pressure,
+                               const double *reference_pressure,
+                               size_t references, double *sigma,
+                               double *const *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_DENSITY);
+    simd_select()->potential_density_multi(salinity, temperature, pressure,
+                                           reference_pressure, references,
+                                           sigma, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* salinity_from_density_n -- compute n salinities from density anomaly.
+ *
+ * Units are the same of salinity_from_density(). residual can be NULL when
+ * not needed.
+ */
+
+void salinity_from_density_n(const double *sigma, const double *temperature,
+                             const double *pressure, double *out,
+                             double *residual, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY_FROM_DENSITY);
+    simd_select()->salinity_from_density(sigma, temperature, pressure, out,
+                                         residual, n);
+    STATS_END(n, sigma, 1, temperature, 1, pressure, 1);
+}
+
+/* temperature_from_sound_speed_n -- compute n temperatures from sound
+ * speed.
+ *
+ * Units are the same of temperature_from_sound_speed(). residual can be NULL
+ * when not needed.
+ */
+
+void temperature_from_sound_speed_n(const double *sound_speed,
+                                    const double *salinity,
+                                    const double *pressure, double *out,
+                                    double *residual, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_TEMPERATURE_FROM_SOUND_SPEED);
+    simd_select()->temperature_from_sound_speed(sound_speed, salinity,
+                                                pressure, out, residual, n);
+    STATS_END(n, sound_speed, 1, salinity, 1, pressure, 1);
+}
+
+/* ctd_derive_n -- compute the outputs selected by the mask of
+ * OCEANOGRAPHY_CTD_* flags in outputs, from n conductivity ratios,
+ * temperatures and pressures.
+ *
+ * Salinity is computed once and shared by the other outputs, as are
+ * sqrt(fabs(salinity)), pressure in bars and the adiabatic temperature
+ * gradient at the first step of potential temperature. All the outputs are
+ * written in a single pass and are identical to the ones of the individual
+ * functions. latitude is used for depth, reference_pressure for potential
+ * temperature. conductivity is not read if only depth is requested.
+ *
+ * Units are the same of the individual functions.
+ */
+
+void ctd_derive_n(const double *conductivity, const double *temperature,
+                  const double *pressure, double latitude,
+                  double reference_pressure, unsigned int outputs,
+                  const struct ctd_outputs *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CTD_DERIVE);
+    simd_select()->ctd_derive(conductivity, temperature, pressure,
+                              _gravity(latitude), reference_pressure, outputs,
+                              out, n);
+    /* conductivity may be NULL if only depth is asked. */
+    STATS_END(n, outputs & CTD_SALINITY_OUTPUTS ? conductivity : NULL, 1,
+              temperature, 1, pressure, 1);
+}
@@ -0,0 +1,402 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * collection.c -- Functions on collections of profiles.
+ *
+ * The samples of a collection are split in chunks by the thread pool. The
+ * outputs of every sample are computed by the vectorized kernels in blocks
+ * that stay in the L1 cache; the metrics and the levels of a profile are
+ * computed by the chunk holding its first sample, in a single pass over its
+ * samples.
+ */
+
+#include <math.h>
+#include <stddef.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "parallel.h"
+#include "simd.h"
+
+/* Samples computed at once by the vectorized kernels. */
+#define BLOCK 256
+
+struct derive_pass {
+    const struct oceanography_collection *collection;
+    const struct simd_kernels *kernels;
+    double reference_pressure;
+    unsigned int outputs;
+    const struct ctd_outputs *out;
+};
+
+/* Arguments of the functions computing a profile at a time. */
+struct profile_pass {
+    const struct oceanography_collection *collection;
+    const struct simd_kernels *kernels;
+    void (*run)(const struct profile_pass *pass, size_t k);
+    double threshold;                   /* metrics */
+    double reference_pressure;
+    struct oceanography_profile_metrics *metrics;
+    const double *const *in;            /* regridding */
+    size_t columns;
+    const double *depth;
+    size_t levels;
+    double fill;
+    double *const *out;
+};
+
+static void pass_init(struct profile_pass *pass,
+                      const struct oceanography_collection *collection,
+                      void (*run)(const struct profile_pass *, size_t))
+{
+    pass->collection = collection;
+    pass->kernels = simd_select();
+    pass->run = run;
+    pass->threshold = 0.0;
+    pass->reference_pressure = 0.0;
+    pass->metrics = NULL;
+    pass->in = NULL;
+    pass->columns = 0;
+    pass->depth = NULL;
+    pass->levels = 0;
+    pass->fill = 0.0;
+    pass->out = NULL;
+}
+
+/* First profile k whose offset is not below sample i, or the number of
+ * profiles if there is none. */
+static size_t first_profile(const struct oceanography_collection *collection,
+                            size_t i)
+{
+    size_t low = 0, high = collection->profiles, middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (collection->offset[middle] < i)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+/* Outputs, other than depth, of the m samples from i. */
+static void derive_block(const struct derive_pass *pass, size_t i, size_t m,
+                         const double *reference_pressure, double *buffer)
+{
+    const struct oceanography_collection *collection = pass->collection;
+    const struct simd_kernels *kernels = pass->kernels;
+    const struct ctd_outputs *out = pass->out;
+    unsigned int outputs = pass->outputs;
+    const double *s = collection->salinity + i;
+    const double *t = collection->temperature + i;
+    const double *p = collection->pressure + i;
+    size_t j;
+
+    if (outputs & OCEANOGRAPHY_CTD_SALINITY)
+        for (j = 0; j < m; j++)
+            out->salinity[i + j] = s[j];
+    if (outputs & (OCEANOGRAPHY_CTD_SVAN | OCEANOGRAPHY_CTD_SIGMA))
+        kernels->specific_volume_anomaly(
+            s, t, p, outputs & OCEANOGRAPHY_CTD_SVAN ? out->svan + i : buffer,
+            outputs & OCEANOGRAPHY_CTD_SIGMA ? out->sigma + i : NULL, m);
+    if (outputs & OCEANOGRAPHY_CTD_THETA)
+        kernels->potential_temperature(s, t, p, reference_pressure,
+                                       out->theta + i, m);
+    if (outputs & OCEANOGRAPHY_CTD_SOUND_SPEED)
+        kernels->sound_speed(s, t, p, out->sound_speed + i, m);
+    if (outputs & OCEANOGRAPHY_CTD_CPSW)
+        kernels->specific_heat(s, t, p, out->cpsw + i, m);
+    if (outputs & OCEANOGRAPHY_CTD_FREEZING_POINT)
+        kernels->freezing_point(s, p, out->freezing_point + i, m);
+    if (outputs & OCEANOGRAPHY_CTD_ATG)
+        kernels->adiabatic_temperature_gradient(s, t, p, out->atg + i, m);
+}
+
+/* Outputs of the samples from begin to end, counted from the first sample
+ * of the collection. */
+static void derive_chunk(const void *arg, size_t begin, size_t end)
+{
+    const struct derive_pass *pass = arg;
+    const struct oceanography_collection *collection = pass->collection;
+    double reference_pressure[BLOCK], buffer[BLOCK];
+    double gravity;
+    size_t i, j, k, m, next;
+
+    begin += collection->offset[0];
+    end += collection->offset[0];
+
+    if (pass->outputs & CTD_SALINITY_OUTPUTS) {
+        for (j = 0; j < BLOCK; j++)
+            reference_pressure[j] = pass->reference_pressure;
+        for (i = begin; i < end; i += m) {
+            m = end - i < BLOCK ? end - i : BLOCK;
+            derive_block(pass, i, m, reference_pressure, buffer);
+        }
+    }
+
+    /* The gravity term of depth is computed once per profile. */
+    if (pass->outputs & OCEANOGRAPHY_CTD_DEPTH) {
+        k = first_profile(collection, begin + 1) - 1;
+        for (i = begin; i < end; i = next) {
+            while (collection->offset[k + 1] <= i)
+                k++;
+            next = collection->offset[k + 1] < end ?
+                   collection->offset[k + 1] : end;
+            gravity = _gravity(collection->latitude[k]);
+            for (j = i; j < next; j++)
+                pass->out->depth[j] = _depth_gravity(collection->pressure[j],
+                                                     gravity);
+        }
+    }
+}
+
+/* Metrics of profile k. */
+static void profile_metrics(const struct profile_pass *pass, size_t k)
+{
+    const struct oceanography_collection *collection = pass->collection;
+    struct oceanography_profile_metrics *out = &pass->metrics[k];
+    const double *s, *t, *p;
+    double sigma[BLOCK];
+    double *column = sigma;
+    double zero = 0.0;
+    double gravity, z, gradient, target = 0.0;
+    double previous_z = 0.0, previous_t = 0.0, previous_sigma = 0.0;
+    size_t first, n, i, j, m;
+    int reference = 0, mixed = 0;
+
+    first = collection->offset[k];
+    n = collection->offset[k + 1] - first;
+    s = collection->salinity + first;
+    t = collection->temperature + first;
+    p = collection->pressure + first;
+
+    out->samples = n;
+    out->mixed_layer_depth = 0.0;
+    out->thermocline_depth = 0.0;
+    out->thermocline_gradient = 0.0;
+    out->surface_salinity = out->bottom_salinity = 0.0;
+    out->surface_temperature = out->bottom_temperature = 0.0;
+    out->surface_pressure = out->bottom_pressure = 0.0;
+    out->surface_sigma = out->bottom_sigma = 0.0;
+    out->bottom_depth = 0.0;
+    if (n == 0)
+        return;
+
+    gravity = _gravity(collection->latitude[k]);
+    for (i = 0; i < n; i += m) {
+        m = n - i < BLOCK ? n - i : BLOCK;
+        pass->kernels->potential_density_multi(s + i, t + i, p + i, &zero, 1,
+                                               NULL, &column, m);
+        if (i == 0) {
+            out->surface_sigma = sigma[0];
+            out->thermocline_depth = _depth_gravity(p[0], gravity);
+        }
+
+        for (j = 0; j < m; j++) {
+            z = _depth_gravity(p[i + j], gravity);
+
+            /* The largest decrease of temperature with depth, at the
+             * midpoint of the samples. */
+            if (i + j > 0 && z > previous_z) {
+                gradient = (previous_t - t[i + j]) / (z - previous_z);
+                if (gradient > out->thermocline_gradient) {
+                    out->thermocline_gradient = gradient;
+                    out->thermocline_depth = 0.5 * (z + previous_z);
+                }
+            }
+
+            /* Sigma-theta exceeds the one at the reference pressure by
+             * threshold. */
+            if (!mixed) {
+                if (!reference && p[i + j] >= pass->reference_pressure) {
+                    reference = 1;
+                    target = sigma[j] + pass->threshold;
+                } else if (reference && sigma[j] >= target) {
+                    mixed = 1;
+                    out->mixed_layer_depth = previous_z +
+                        (target - previous_sigma) /
+                        (sigma[j] - previous_sigma) * (z - previous_z);
+                }
+            }
+
+            previous_z = z;
+            previous_t = t[i + j];
+            previous_sigma = sigma[j];
+        }
+    }
+
+    out->surface_salinity = s[0];
+    out->surface_temperature = t[0];
+    out->surface_pressure = p[0];
+    out->bottom_salinity = s[n - 1];
+    out->bottom_temperature = t[n - 1];
+    out->bottom_pressure = p[n - 1];
+    out->bottom_sigma = previous_sigma;
+    out->bottom_depth = previous_z;
+    if (!mixed)
+        out->mixed_layer_depth = previous_z;
+}
+
+/* Levels of profile k. */
+static void profile_regrid(const struct profile_pass *pass, size_t k)
+{
+    const struct oceanography_collection *collection = pass->collection;
+    const double *in[OCEANOGRAPHY_REGRID_COLUMNS];
+    double *out[OCEANOGRAPHY_REGRID_COLUMNS];
+    size_t first, c;
+
+    first = collection->offset[k];
+    for (c = 0; c < pass->columns; c++) {
+        in[c] = pass->in[c] + first;
+        out[c] = pass->out[c] + k * pass->levels;
+    }
+    regrid_n(collection->pressure + first, collection->latitude[k], in,
+             pass->columns, collection->offset[k + 1] - first, pass->depth,
+             pass->levels, pass->fill, out);
+}
+
+/* Run pass on the profiles starting from begin to end, counted from the
+ * first sample of the collection; the last chunk also takes the empty
+ * profiles at the end. */
+static void profile_chunk(const void *arg, size_t begin, size_t end)
+{
+    const struct profile_pass *pass = arg;
+    const struct oceanography_collection *collection = pass->collection;
+    size_t base = collection->offset[0];
+    size_t total = collection->offset[collection->profiles] - base;
+    size_t k;
+
+    for (k = first_profile(collection, base + begin);
+         k < collection->profiles &&
+         (collection->offset[k] < base + end || end == total); k++)
+        pass->run(pass, k);
+}
+
+/* Run pass on every profile of its collection, on pool. */
+static void run_profiles(struct oceanography_pool *pool,
+                         const struct profile_pass *pass)
+{
+    const struct oceanography_collection *collection = pass->collection;
+    size_t total;
+
+    /* Without samples no chunk runs. */
+    total = collection->offset[collection->profiles] - collection->offset[0];
+    if (total == 0)
+        profile_chunk(pass, 0, 0);
+    else
+        parallel_run(pool, profile_chunk, pass, total);
+}
+
+/* oceanography_collection_derive -- compute the outputs selected by the mask
+ * of OCEANOGRAPHY_CTD_* flags in outputs for every sample of a collection,
+ * from salinity, temperature and pressure.
+ *
+ * The arrays of out are indexed as the columns of the collection. The
+ * latitude of a profile is read only for depth, reference_pressure is used
+ * for potential temperature. The salinity output is a copy of salinity.
+ * Runs on pool, or on the default pool if NULL.
+ *
+ * Results are identical to the ones of the individual functions.
+ *
+ * Units are the same of the individual functions.
+ */
+
+void oceanography_collection_derive(
+    struct oceanography_pool *pool,
+    const struct oceanography_collection *collection,
+    double reference_pressure, unsigned int outputs,
+    const struct ctd_outputs *out)
+{
+    struct derive_pass pass;
+
+    pass.collection = collection;
+    pass.kernels = simd_select();
+    pass.reference_pressure = reference_pressure;
+    pass.outputs = outputs;
+    pass.out = out;
+
+    parallel_run(pool, derive_chunk, &pass,
+                 collection->offset[collection->profiles] -
+                 collection->offset[0]);
+}
+
+/* oceanography_collection_metrics -- compute the metrics of every profile
+ * of a collection, in a single pass over its samples.
+ *
+ * The mixed layer ends where sigma-theta first exceeds by threshold the one
+ * of the first sample at or below reference_pressure, interpolated linearly
+ * between the samples; if it does not, or the profile does not reach
+ * reference_pressure, at the last sample. The thermocline is at the midpoint
+ * of the pair of samples with the largest decrease of temperature with
+ * depth, or at the first sample if temperature never decreases. Samples
+ * must be sorted by increasing pressure. Runs on pool, or on the default
+ * pool if NULL.
+ *
+ * Units:
+ *     threshold -- Kg/m^3
+ *     reference_pressure -- decibars
+ *
+ * Writes the metrics of profile k to out[k]; the ones of an empty profile
+ * are 0.
+ */
+
+void oceanography_collection_metrics(
+    struct oceanography_pool *pool,
+    const struct oceanography_collection *collection, double threshold,
+    double reference_pressure, struct oceanography_profile_metrics *out)
+{
+    struct profile_pass pass;
+
+    pass_init(&pass, collection, profile_metrics);
+    pass.threshold = threshold;
+    pass.reference_pressure = reference_pressure;
+    pass.metrics = out;
+    run_profiles(pool, &pass);
+}
+
+/* oceanography_collection_regrid -- interpolate columns of every profile of
+ * a collection to standard depths.
+ *
+ * in[c], for c from 0 to columns - 1, is indexed as the columns of the
+ * collection: it can be one of them, or an output of
+ * oceanography_collection_derive(). out[c] receives levels values per
+ * profile, the ones of profile k from out[c] + k * levels, computed by
+ * regrid_n() at the latitude of the profile. columns must not be more than
+ * OCEANOGRAPHY_REGRID_COLUMNS. Runs on pool, or on the default pool if NULL.
+ */
+
+void oceanography_collection_regrid(
+    struct oceanography_pool *pool,
+    const struct oceanography_collection *collection,
+    const double *const *in, size_t columns, const double *depth,
+    size_t levels, double fill, double *const *out)
+{
+    struct profile_pass pass;
+
+    pass_init(&pass, collection, profile_regrid);
+    pass.in = in;
+    pass.columns = columns;
+    pass.depth = depth;
+    pass.levels = levels;
+    pass.fill = fill;
+    pass.out = out;
+    run_profiles(pool, &pass);
+}
@@ -0,0 +1,631 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * dispatch.c -- Runtime selection of the vectorized kernels.
+ *
+ * At the first batch call the best instruction set compiled into the library
+ * and supported by the host CPU is selected, unless the OCEANOGRAPHY_ISA
+ * environment variable names another one (scalar, sse2, avx2 or avx512).
+ * oceanography_set_isa() forces a specific instruction set, for benchmarks
+ * and tests. The same instruction set is used by the double and by the
+ * single precision kernels.
+ *
+ * The instruction set and its kernels are published together, as a pointer
+ * to an entry of a constant table, with a release store that batch calls of
+ * any thread read with an acquire load. Without the atomic builtins of GCC
+ * and Clang the pointer is read and written under a mutex.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+
+struct selection {
+    enum oceanography_isa isa;
+    const struct simd_kernels *kernels;
+    const struct simd_kernels_f *kernels_f;
+};
+
+#ifdef __ATOMIC_ACQUIRE
+#define LOAD_ACQUIRE(pointer) __atomic_load_n(&(pointer), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(pointer, value) \
+        __atomic_store_n(&(pointer), value, __ATOMIC_RELEASE)
+#else
+#include <pthread.h>
+#define LOAD_ACQUIRE(pointer) locked_load(&(pointer))
+#define STORE_RELEASE(pointer, value) locked_store(&(pointer), value)
+#endif
+
+static const struct selection *selected = NULL;
+
+static const char *isa_names[] = {"auto", "scalar", "sse2", "avx2", "avx512"};
+
+static void salinity_scalar(const double *conductivity,
+                            const double *temperature,
+                            const double *pressure, double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _salinity(conductivity[i], temperature[i], pressure[i]);
+}
+
+static void conductivity_scalar(const double *salinity,
+                                const double *temperature,
+                                const double *pressure, double *out,
+                                unsigned long *histogram, size_t n)
+{
+    size_t i;
+    int iterations;
+
+    for (i = 0; i < n; i++) {
+        out[i] = _conductivity_iterations(salinity[i], temperature[i],
+                                          pressure[i], &iterations);
+        if (histogram != NULL)
+            histogram[iterations]++;
+    }
+}
+
+static void specific_volume_anomaly_scalar(const double *salinity,
+                                           const double *temperature,
+                                           const double *pressure,
+                                           double *out, double *sigma,
+                                           size_t n)
+{
+    size_t i;
+    double sig;
+
+    for (i = 0; i < n; i++) {
+        out[i] = _specific_volume_anomaly(salinity[i], temperature[i],
+                                          pressure[i], &sig);
+        if (sigma != NULL)
+            sigma[i] = sig;
+    }
+}
+
+static void freezing_point_scalar(const double *salinity,
+                                  const double *pressure, double *out,
+                                  size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _freezing_point(salinity[i], pressure[i]);
+}
+
+static void specific_heat_scalar(const double *salinity,
+                                 const double *temperature,
+                                 const double *pressure, double *out,
+                                 size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _specific_heat(salinity[i], temperature[i], pressure[i]);
+}
+
+static void adiabatic_temperature_gradient_scalar(const double *salinity,
+                                                  const double *temperature,
+                                                  const double *pressure,
+                                                  double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _adiabatic_temperature_gradient(salinity[i], temperature[i],
+                                                 pressure[i]);
+}
+
+static void potential_temperature_scalar(const double *salinity,
+                                        const double *temperature,
+                                        const double *pressure,
+                                        const double *reference_pressure,
+                                        double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _potential_temperature(salinity[i], temperature[i],
+                                        pressure[i], reference_pressure[i]);
+}
+
+static void potential_temperature_multi_scalar(
+    const double *salinity, const double *temperature, const double *pressure,
+    const double *reference_pressure, size_t references, double *const *out,
+    size_t n)
+{
+    size_t i, r;
+    double atg;
+
+    for (i = 0; i < n; i++) {
+        atg = _adiabatic_temperature_gradient(salinity[i], temperature[i],
+                                              pressure[i]);
+        for (r = 0; r < references; r++)
+            out[r][i] = _potential_temperature_atg(salinity[i],
+                                                   temperature[i],
+                                                   pressure[i],
+                                                   reference_pressure[r],
+                                                   atg);
+    }
+}
+
+static void in_situ_temperature_scalar(const double *salinity,
+                                       const double *theta,
+                                       const double *pressure,
+                                       const double *reference_pressure,
+                                       double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _in_situ_temperature(salinity[i], theta[i], pressure[i],
+                                      reference_pressure[i]);
+}
+
+static void sound_speed_scalar(const double *salinity,
+                               const double *temperature,
+                               const double *pressure, double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _sound_speed(salinity[i], temperature[i], pressure[i]);
+}
+
+static void ctd_derive_scalar(const double *conductivity,
+                              const double *temperature,
+                              const double *pressure, double gravity,
+                              double reference_pressure, unsigned int outputs,
+                              const struct ctd_outputs *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        _ctd_derive(conductivity, temperature, pressure, gravity,
+                    reference_pressure, outputs, out, i);
+}
+
+static void density_derivatives_scalar(const double *salinity,
+                                       const double *temperature,
+                                       const double *pressure, double *sigma,
+                                       double *alpha, double *beta,
+                                       double *kappa, size_t n)
+{
+    size_t i;
+    double a, b, k, sg;
+
+    for (i = 0; i < n; i++) {
+        sg = _density_derivatives(salinity[i], temperature[i], pressure[i],
+                                  &a, &b, &k);
+        if (sigma != NULL)
+            sigma[i] = sg;
+        if (alpha != NULL)
+            alpha[i] = a;
+        if (beta != NULL)
+            beta[i] = b;
+        if (kappa != NULL)
+            kappa[i] = k;
+    }
+}
+
+static void density_scalar(const double *salinity, const double *temperature,
+                           const double *pressure, double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _density(salinity[i], temperature[i], pressure[i]);
+}
+
+static void potential_density_scalar(const double *salinity,
+                                     const double *temperature,
+                                     const double *pressure,
+                                     const double *reference_pressure,
+                                     double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _potential_density(salinity[i], temperature[i], pressure[i],
+                                    reference_pressure[i]);
+}
+
+static void potential_density_multi_scalar(
+    const double *salinity, const double *temperature, const double *pressure,
+    const double *reference_pressure, size_t references, double *sigma,
+    double *const *out, size_t n)
+{
+    size_t i, r;
+    double sr, atg;
+
+    for (i = 0; i < n; i++) {
+        sr = sqrt(fabs(salinity[i]));
+        if (sigma != NULL)
+            sigma[i] = _density_sr(salinity[i], sr, temperature[i],
+                                   pressure[i] / 10.0);
+        atg = _adiabatic_temperature_gradient(salinity[i], temperature[i],
+                                              pressure[i]);
+        for (r = 0; r < references; r++)
+            out[r][i] = _potential_density_atg(salinity[i], sr,
+                                               temperature[i], pressure[i],
+                                               reference_pressure[r], atg);
+    }
+}
+
+static void pressure_from_depth_scalar(const double *depth,
+                                       const double *gravity, double *out,
+                                       size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _pressure_gravity(depth[i], gravity[i]);
+}
+
+static void salinity_from_density_scalar(const double *sigma,
+                                         const double *temperature,
+                                         const double *pressure, double *out,
+                                         double *residual, size_t n)
+{
+    size_t i;
+    double r;
+
+    for (i = 0; i < n; i++) {
+        out[i] = _salinity_from_density(sigma[i], temperature[i],
+                                        pressure[i], &r);
+        if (residual != NULL)
+            residual[i] = r;
+    }
+}
+
+static void temperature_from_sound_speed_scalar(const double *sound_speed,
+                                                const double *salinity,
+                                                const double *pressure,
+                                                double *out,
+                                                double *residual, size_t n)
+{
+    size_t i;
+    double r;
+
+    for (i = 0; i < n; i++) {
+        out[i] = _temperature_from_sound_speed(sound_speed[i], salinity[i],
+                                               pressure[i], &r);
+        if (residual != NULL)
+            residual[i] = r;
+    }
+}
+
+static void salinity_level_scalar(const struct oceanography_level *level,
+                                  const double *conductivity,
+                                  const double *temperature, double *out,
+                                  size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _salinity_cp(conductivity[i], temperature[i],
+                              level->conductivity);
+}
+
+static void conductivity_level_scalar(const struct oceanography_level *level,
+                                      const double *salinity,
+                                      const double *temperature, double *out,
+                                      unsigned long *histogram, size_t n)
+{
+    size_t i;
+    int iterations;
+
+    for (i = 0; i < n; i++) {
+        out[i] = _conductivity_cp_iterations(salinity[i], temperature[i],
+                                             level->conductivity,
+                                             &iterations);
+        if (histogram != NULL)
+            histogram[iterations]++;
+    }
+}
+
+static void specific_volume_anomaly_level_scalar(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, double *sigma, size_t n)
+{
+    size_t i;
+    double sig;
+
+    for (i = 0; i < n; i++) {
+        out[i] = _specific_volume_anomaly_level(level, salinity[i],
+                                                sqrt(fabs(salinity[i])),
+                                                temperature[i], &sig);
+        if (sigma != NULL)
+            sigma[i] = sig;
+    }
+}
+
+static void freezing_point_level_scalar(const struct oceanography_level *level,
+                                        const double *salinity, double *out,
+                                        size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _freezing_point(salinity[i], level->pressure);
+}
+
+static void specific_heat_level_scalar(const struct oceanography_level *level,
+                                       const double *salinity,
+                                       const double *temperature, double *out,
+                                       size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _specific_heat_level(level, salinity[i],
+                                      sqrt(fabs(salinity[i])),
+                                      temperature[i]);
+}
+
+static void adiabatic_temperature_gradient_level_scalar(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _adiabatic_temperature_gradient_level(level, salinity[i],
+                                                       temperature[i]);
+}
+
+static void sound_speed_level_scalar(const struct oceanography_level *level,
+                                     const double *salinity,
+                                     const double *temperature, double *out,
+                                     size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _sound_speed_level(level, salinity[i],
+                                    sqrt(fabs(salinity[i])), temperature[i]);
+}
+
+static void table_scalar(const struct table_layout *table,
+                         const double *salinity, const double *temperature,
+                         const double *pressure, double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        out[i] = _table_eval(table, salinity[i], temperature[i], pressure[i]);
+}
+
+const struct simd_kernels simd_kernels_scalar = {
+    salinity_scalar,
+    conductivity_scalar,
+    specific_volume_anomaly_scalar,
+    freezing_point_scalar,
+    specific_heat_scalar,
+    adiabatic_temperature_gradient_scalar,
+    potential_temperature_scalar,
+    potential_temperature_multi_scalar,
+    in_situ_temperature_scalar,
+    sound_speed_scalar,
+    ctd_derive_scalar,
+    density_derivatives_scalar,
+    density_scalar,
+    potential_density_scalar,
+    potential_density_multi_scalar,
+    pressure_from_depth_scalar,
+    salinity_from_density_scalar,
+    temperature_from_sound_speed_scalar,
+    salinity_level_scalar,
+    conductivity_level_scalar,
+    specific_volume_anomaly_level_scalar,
+    freezing_point_level_scalar,
+    specific_heat_level_scalar,
+    adiabatic_temperature_gradient_level_scalar,
+    sound_speed_level_scalar,
+    table_scalar
+};
+
+/* The kernels of every instruction set, indexed by enum oceanography_isa;
+ * the ones not compiled into the library are NULL. */
+static const struct selection selections[] = {
+    {OCEANOGRAPHY_ISA_AUTO, NULL, NULL},
+    {OCEANOGRAPHY_ISA_SCALAR, &simd_kernels_scalar, &simd_kernels_f_scalar},
+#ifdef OCEANOGRAPHY_HAVE_SSE2
+    {OCEANOGRAPHY_ISA_SSE2, &simd_kernels_sse2, &simd_kernels_f_sse2},
+#else
+    {OCEANOGRAPHY_ISA_SSE2, NULL, NULL},
+#endif
+#ifdef OCEANOGRAPHY_HAVE_AVX2
+    {OCEANOGRAPHY_ISA_AVX2, &simd_kernels_avx2, &simd_kernels_f_avx2},
+#else
+    {OCEANOGRAPHY_ISA_AVX2, NULL, NULL},
+#endif
+#ifdef OCEANOGRAPHY_HAVE_AVX512
+    {OCEANOGRAPHY_ISA_AVX512, &simd_kernels_avx512, &simd_kernels_f_avx512}
+#else
+    {OCEANOGRAPHY_ISA_AVX512, NULL, NULL}
+#endif
+};
+
+#ifdef __ATOMIC_ACQUIRE
+/* Publish value if nothing is selected. Returns the selection. */
+static const struct selection *publish_first(const struct selection *value)
+{
+    const struct selection *expected = NULL;
+
+    if (__atomic_compare_exchange_n(&selected, &expected, value, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return value;
+
+    return expected;
+}
+#else
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const struct selection *publish_first(const struct selection *value)
+{
+    pthread_mutex_lock(&lock);
+    if (selected == NULL)
+        selected = value;
+    value = selected;
+    pthread_mutex_unlock(&lock);
+
+    return value;
+}
+
+static const struct selection *locked_load(const struct selection **pointer)
+{
+    const struct selection *value;
+
+    pthread_mutex_lock(&lock);
+    value = *pointer;
+    pthread_mutex_unlock(&lock);
+
+    return value;
+}
+
+static void locked_store(const struct selection **pointer,
+                         const struct selection *value)
+{
+    pthread_mutex_lock(&lock);
+    *pointer = value;
+    pthread_mutex_unlock(&lock);
+}
+#endif
+
+/* oceanography_isa_supported -- check if an instruction set is compiled into
+ * the library and supported by the host CPU.
+ *
+ * Returns 1 if isa can be used, 0 otherwise. OCEANOGRAPHY_ISA_AUTO is always
+ * supported.
+ */
+
+int oceanography_isa_supported(enum oceanography_isa isa)
+{
+    if (isa == OCEANOGRAPHY_ISA_AUTO)
+        return 1;
+    if ((int) isa < 0 || isa > OCEANOGRAPHY_ISA_AVX512 ||
+        selections[isa].kernels == NULL)
+        return 0;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    switch (isa) {
+    case OCEANOGRAPHY_ISA_SSE2:
+        return __builtin_cpu_supports("sse2") != 0;
+    case OCEANOGRAPHY_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") != 0;
+    case OCEANOGRAPHY_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") != 0;
+    default:
+        return 1;
+    }
+#else
+    return isa == OCEANOGRAPHY_ISA_SCALAR;
+#endif
+}
+
+static enum oceanography_isa best_isa(void)
+{
+    const char *env;
+    int isa;
+
+    env = getenv("OCEANOGRAPHY_ISA");
+    if (env != NULL)
+        for (isa = OCEANOGRAPHY_ISA_SCALAR; isa <= OCEANOGRAPHY_ISA_AVX512;
+             isa++)
+            if (strcmp(env, isa_names[isa]) == 0 &&
+                oceanography_isa_supported((enum oceanography_isa) isa))
+                return (enum oceanography_isa) isa;
+
+    for (isa = OCEANOGRAPHY_ISA_AVX512; isa > OCEANOGRAPHY_ISA_SCALAR; isa--)
+        if (oceanography_isa_supported((enum oceanography_isa) isa))
+            return (enum oceanography_isa) isa;
+
+    return OCEANOGRAPHY_ISA_SCALAR;
+}
+
+/* oceanography_set_isa -- select the instruction set used by the batch
+ * functions.
+ *
+ * OCEANOGRAPHY_ISA_AUTO restores the automatic selection. Batch calls
+ * already running in other threads finish with the previous instruction
+ * set.
+ *
+ * Returns 0 on success, -1 if isa is not supported.
+ */
+
+int oceanography_set_isa(enum oceanography_isa isa)
+{
+    if (!oceanography_isa_supported(isa))
+        return -1;
+
+    if (isa == OCEANOGRAPHY_ISA_AUTO)
+        isa = best_isa();
+
+    STORE_RELEASE(selected, &selections[isa]);
+
+    return 0;
+}
+
+/* The selected instruction set, chosen automatically by the first call of
+ * any thread. The automatic choice is published only if no instruction set
+ * was selected meanwhile, so it never replaces the one of a concurrent
+ * oceanography_set_isa(). */
+static const struct selection *selection(void)
+{
+    const struct selection *current = LOAD_ACQUIRE(selected);
+
+    if (current == NULL)
+        current = publish_first(&selections[best_isa()]);
+
+    return current;
+}
+
+/* oceanography_get_isa -- get the instruction set used by the batch
+ * functions.
+ */
+
+enum oceanography_isa oceanography_get_isa(void)
+{
+    return selection()->isa;
+}
+
+/* oceanography_isa_name -- get the name of an instruction set. */
+
+const char *oceanography_isa_name(enum oceanography_isa isa)
+{
+    if ((int) isa < 0 || isa > OCEANOGRAPHY_ISA_AVX512)
+        return "unknown";
+
+    return isa_names[isa];
+}
+
+const struct simd_kernels *simd_select(void)
+{
+    return selection()->kernels;
+}
+
+const struct simd_kernels_f *simd_select_f(void)
+{
+    return selection()->kernels_f;
+}
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * float.c -- Single precision functions of liboceanography.
+ *
+ * The *_f functions compute in float, so that a vector register holds twice
+ * as many samples as in double. Their kernels are the ones of
+ * simd_template_f.h, instantiated here on plain floats: the scalar functions
+ * run them on a single sample, so they give the same results of the batch
+ * functions on every instruction set.
+ *
+ * The maximum deviations from the double functions are in the function
+ * reference.
+ */
+
+#include <math.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+#include "stats.h"
+
+/* The square root of a float computed in double and rounded to float is the
+ * correctly rounded single precision one, as given by the vector units. */
+#define V float
+#define V_WIDTH 1
+#define V_SET1(x) ((float) (x))
+#define V_LOADU(p) (*(p))
+#define V_STOREU(p, v) (*(p) = (v))
+#define V_ADD(a, b) ((a) + (b))
+#define V_SUB(a, b) ((a) - (b))
+#define V_MUL(a, b) ((a) * (b))
+#define V_DIV(a, b) ((a) / (b))
+#define V_SQRT(a) ((float) sqrt(a))
+#define V_ABS(a) ((float) fabs(a))
+#define V_MASK int
+#define V_EQ(a, b) ((a) == (b))
+#define V_LE(a, b) ((a) <= (b))
+#define V_GT(a, b) ((a) > (b))
+#define V_AND(m1, m2) ((m1) && (m2))
+#define V_ANY(m) (m)
+#define V_SELECT(m, a, b) ((m) ? (a) : (b))
+
+#define SIMD_NAME(name) name##_scalar
+
+#include "simd_template_f.h"
+
+/* salinity_f -- single precision salinity().
+ *
+ * Units are the same of salinity().
+ */
+
+float salinity_f(float conductivity, float temperature, float pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+    salinity_scalar(&conductivity, &temperature, &pressure, &out, 1);
+    STATS_END_F(1, &conductivity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* conductivity_f -- single precision conductivity().
+ *
+ * Units are the same of conductivity().
+ */
+
+float conductivity_f(float salinity, float temperature, float pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    conductivity_scalar(&salinity, &temperature, &pressure, &out,
+                        STATS_HISTOGRAM(), 1);
+    STATS_END_F(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* specific_volume_anomaly_f -- single precision specific_volume_anomaly().
+ *
+ * Units are the same of specific_volume_anomaly().
+ */
+
+float specific_volume_anomaly_f(float salinity, float temperature,
+                                float pressure, float *sigma)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY);
+    specific_volume_anomaly_scalar(&salinity, &temperature, &pressure, &out,
+                                   sigma, 1);
+    STATS_END_F(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* depth_f -- single precision depth().
+ *
+ * Units are the same of depth().
+ */
+
+float depth_f(float pressure, float latitude)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DEPTH);
+    depth_scalar(&pressure, &latitude, &out, 1);
+    STATS_END_F(1, &pressure, 0, &latitude, 0, NULL, 0);
+
+    return out;
+}
+
+/* freezing_point_f -- single precision freezing_point().
+ *
+ * Units are the same of freezing_point().
+ */
+
+float freezing_point_f(float salinity, float pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_FREEZING_POINT);
+    freezing_point_scalar(&salinity, &pressure, &out, 1);
+    STATS_END_F(1, &salinity, 0, &pressure, 0, NULL, 0);
+
+    return out;
+}
+
+/* specific_heat_f -- single precision specific_heat().
+ *
+ * Units are the same of specific_heat().
+ */
+
+float specific_heat_f(float salinity, float temperature, float pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_HEAT);
+    specific_heat_scalar(&salinity, &temperature, &pressure, &out, 1);
+    STATS_END_F(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* adiabatic_temperature_gradient_f -- single precision
+ * adiabatic_temperature_gradient().
+ *
+ * Units are the same of adiabatic_temperature_gradient().
+ */
+
+float adiabatic_temperature_gradient_f(float salinity, float temperature,
+                                       float pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT);
+    adiabatic_temperature_gradient_scalar(&salinity, &temperature, &pressure,
+                                          &out, 1);
+    STATS_END_F(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* potential_temperature_f -- single precision potential_temperature().
+ *
+ * Units are the same of potential_temperature().
+ */
+
+float potential_temperature_f(float salinity, float temperature,
+                              float pressure, float reference_pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE);
+    potential_temperature_scalar(&salinity, &temperature, &pressure,
+                                 &reference_pressure, &out, 1);
+    STATS_END_F(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* in_situ_temperature_f -- single precision in_situ_temperature().
+ *
+ * Units are the same of in_situ_temperature().
+ */
+
+float in_situ_temperature_f(float salinity, float potential_temperature,
+                            float pressure, float reference_pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_IN_SITU_TEMPERATURE);
+    in_situ_temperature_scalar(&salinity, &potential_temperature, &pressure,
+                               &reference_pressure, &out, 1);
+    STATS_END_F(1, &salinity, 0, &potential_temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* sound_speed_f -- single precision sound_speed().
+ *
+ * Units are the same of sound_speed().
+ */
+
+float sound_speed_f(float salinity, float temperature, float pressure)
+{
+    float out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SOUND_SPEED);
+    sound_speed_scalar(&salinity, &temperature, &pressure, &out, 1);
+    STATS_END_F(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* Batch functions, running the kernels selected by dispatch.c. Units are the
+ * same of the double functions, and sigma can be NULL as in
+ * specific_volume_anomaly_n().
+ */
+
+void salinity_n_f(const float *conductivity, const float *temperature,
+                  const float *pressure, float *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+    simd_select_f()->salinity(conductivity, temperature, pressure, out, n);
+    STATS_END_F(n, conductivity, 1, temperature, 1, pressure, 1);
+}
+
+void conductivity_n_f(const float *salinity, const float *temperature,
+                      const float *pressure, float *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    simd_select_f()->conductivity(salinity, temperature, pressure, out,
+                                  STATS_HISTOGRAM(), n);
+    STATS_END_F(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void specific_volume_anomaly_n_f(const float *salinity,
+                                 const float *temperature,
+                                 const float *pressure, float *out,
+                                 float *sigma, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY);
+    simd_select_f()->specific_volume_anomaly(salinity, temperature, pressure,
+                                             out, sigma, n);
+    STATS_END_F(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void depth_n_f(const float *pressure, const float *latitude, float *out,
+               size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DEPTH);
+    simd_select_f()->depth(pressure, latitude, out, n);
+    STATS_END_F(n, pressure, 1, latitude, 1, NULL, 0);
+}
+
+void freezing_point_n_f(const float *salinity, const float *pressure,
+                        float *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_FREEZING_POINT);
+    simd_select_f()->freezing_point(salinity, pressure, out, n);
+    STATS_END_F(n, salinity, 1, pressure, 1, NULL, 0);
+}
+
+void specific_heat_n_f(const float *salinity, const float *temperature,
+                       const float *pressure, float *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_HEAT);
+    simd_select_f()->specific_heat(salinity, temperature, pressure, out, n);
+    STATS_END_F(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void adiabatic_temperature_gradient_n_f(const float *salinity,
+                                        const float *temperature,
+                                        const float *pressure, float *out,
+                                        size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT);
+    simd_select_f()->adiabatic_temperature_gradient(salinity, temperature,
+                                                    pressure, out, n);
+    STATS_END_F(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void potential_temperature_n_f(const float *salinity,
+                               const float *temperature,
+                               const float *pressure,
+                               const float *reference_pressure, float *out,
+                               size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE);
+    simd_select_f()->potential_temperature(salinity, temperature, pressure,
+                                           reference_pressure, out, n);
+    STATS_END_F(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+void in_situ_temperature_n_f(const float *salinity,
+                             const float *potential_temperature,
+                             const float *pressure,
+                             const float *reference_pressure, float *out,
+                             size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_IN_SITU_TEMPERATURE);
+    simd_select_f()->in_situ_temperature(salinity, potential_temperature,
+                                         pressure, reference_pressure, out,
+                                         n);
+    STATS_END_F(n, salinity, 1, potential_temperature, 1, pressure, 1);
+}
+
+void sound_speed_n_f(const float *salinity, const float *temperature,
+                     const float *pressure, float *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SOUND_SPEED);
+    simd_select_f()->sound_speed(salinity, temperature, pressure, out, n);
+    STATS_END_F(n, salinity, 1, temperature, 1, pressure, 1);
+}
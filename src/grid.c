@@ -0,0 +1,442 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * grid.c -- Functions on gridded fields.
+ *
+ * The grid is walked in tiles of up to TILE points along the dimension with
+ * the smallest stride and more than one point, the others following in
+ * order of increasing stride, so memory is read in the order it is laid
+ * out. Tiles with unit stride are computed in place by the vectorized
+ * kernels; the other ones are gathered in buffers that stay in the L1
+ * cache, and scattered back.
+ *
+ * The gravity term of depth depends on latitude only: it is computed once
+ * per grid column, or per row when latitude does not vary along longitude.
+ * When pressure does not vary along a tile either, depth is computed once
+ * for the whole tile.
+ *
+ * When pressure varies along level only, a struct oceanography_level is
+ * initialized for every level, and tiles along longitude or latitude use the
+ * kernels of the *_level_n functions.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+
+/* Points of a tile: its buffers take 26 KiB. */
+#define TILE 256
+
+struct tile {
+    double salinity[TILE];
+    double temperature[TILE];
+    double pressure[TILE];
+    double reference_pressure[TILE];
+    double out[TILE];
+    double sigma[TILE];
+};
+
+/* Input of a tile: the field itself if contiguous, else gathered into
+ * buffer. */
+static const double *load(const double *field, size_t stride, double *buffer,
+                          size_t n)
+{
+    size_t i;
+
+    if (stride == 1)
+        return field;
+
+    for (i = 0; i < n; i++)
+        buffer[i] = field[i * stride];
+
+    return buffer;
+}
+
+/* Output of a tile: the field itself if contiguous, else buffer, to be
+ * scattered by store(). */
+static double *target(double *field, size_t stride, double *buffer)
+{
+    return stride == 1 ? field : buffer;
+}
+
+static void store(double *field, size_t stride, const double *buffer,
+                  size_t n)
+{
+    size_t i;
+
+    if (stride == 1)
+        return;
+
+    for (i = 0; i < n; i++)
+        field[i * stride] = buffer[i];
+}
+
+/* Gravity of every grid column, or of every row if latitude_stride[0] is 0,
+ * or a single one if latitude does not vary at all; width is the number of
+ * columns of a row. */
+static double *gravity_cache(const struct oceanography_grid *grid,
+                             const double *latitude, size_t *width)
+{
+    double *gravity;
+    size_t rows, i, j;
+
+    *width = grid->latitude_stride[0] != 0 ? grid->shape[0] : 1;
+    rows = grid->latitude_stride[1] != 0 ? grid->shape[1] : 1;
+    if (rows > (size_t) -1 / sizeof(double) / *width) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    gravity = malloc(*width * rows * sizeof(double));
+    if (gravity == NULL)
+        return NULL;
+
+    for (j = 0; j < rows; j++)
+        for (i = 0; i < *width; i++)
+            gravity[j * *width + i] = _gravity(
+                latitude[i * grid->latitude_stride[0] +
+                         j * grid->latitude_stride[1]]);
+
+    return gravity;
+}
+
+/* Outputs computed by the *_level_n kernels. */
+#define LEVEL_OUTPUTS (OCEANOGRAPHY_CTD_SVAN | OCEANOGRAPHY_CTD_SIGMA | \
+                       OCEANOGRAPHY_CTD_SOUND_SPEED | OCEANOGRAPHY_CTD_CPSW | \
+                       OCEANOGRAPHY_CTD_FREEZING_POINT | OCEANOGRAPHY_CTD_ATG)
+
+/* A level for every pressure of the grid, or NULL with errno set to ENOMEM
+ * if memory is not enough. */
+static struct oceanography_level *level_cache(
+    const struct oceanography_grid *grid, const double *pressure)
+{
+    struct oceanography_level *levels;
+    size_t k;
+
+    if (grid->shape[2] > (size_t) -1 / sizeof(*levels)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    levels = malloc(grid->shape[2] * sizeof(*levels));
+    if (levels == NULL)
+        return NULL;
+
+    for (k = 0; k < grid->shape[2]; k++)
+        oceanography_level_init(&levels[k],
+                                pressure[k * grid->pressure_stride[2]]);
+
+    return levels;
+}
+
+/* Arguments of oceanography_grid_derive() and the state shared by its
+ * tiles. */
+struct pass {
+    const struct oceanography_grid *grid;
+    const double *salinity;
+    const double *temperature;
+    const double *pressure;
+    unsigned int outputs;
+    const struct ctd_outputs *out;
+    const struct simd_kernels *kernels;
+    struct tile *tile;
+    const double *gravity;
+    size_t width;               /* of a row of gravity */
+    const struct oceanography_level *levels;    /* NULL if not used */
+    int inner;                  /* dimension along the tiles */
+};
+
+/* Depth of a tile of n points, from pressure with stride p_stride and
+ * gravity with stride g_stride. */
+static void tile_depth(const double *pressure, size_t p_stride,
+                       const double *gravity, size_t g_stride, double *out,
+                       size_t n)
+{
+    double d;
+    size_t i;
+
+    if (p_stride == 0 && g_stride == 0) {
+        d = _depth_gravity(*pressure, *gravity);
+        for (i = 0; i < n; i++)
+            out[i] = d;
+        return;
+    }
+
+    for (i = 0; i < n; i++)
+        out[i] = _depth_gravity(pressure[i * p_stride],
+                                gravity[i * g_stride]);
+}
+
+/* Outputs of a tile of n points at level, from salinity s and temperature
+ * t, to the offset of the tile in the output fields. */
+static void level_derive(const struct pass *pass,
+                         const struct oceanography_level *level,
+                         const double *s, const double *t, size_t offset,
+                         size_t n)
+{
+    const struct ctd_outputs *out = pass->out;
+    const struct simd_kernels *kernels = pass->kernels;
+    struct tile *tile = pass->tile;
+    unsigned int outputs = pass->outputs;
+    size_t fs = pass->grid->stride[pass->inner];
+    double *o, *sig;
+
+    if (outputs & (OCEANOGRAPHY_CTD_SVAN | OCEANOGRAPHY_CTD_SIGMA)) {
+        o = outputs & OCEANOGRAPHY_CTD_SVAN ?
+            target(out->svan + offset, fs, tile->out) : tile->out;
+        sig = outputs & OCEANOGRAPHY_CTD_SIGMA ?
+              target(out->sigma + offset, fs, tile->sigma) : NULL;
+        kernels->specific_volume_anomaly_level(level, s, t, o, sig, n);
+        if (outputs & OCEANOGRAPHY_CTD_SVAN)
+            store(out->svan + offset, fs, o, n);
+        if (outputs & OCEANOGRAPHY_CTD_SIGMA)
+            store(out->sigma + offset, fs, sig, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_SOUND_SPEED) {
+        o = target(out->sound_speed + offset, fs, tile->out);
+        kernels->sound_speed_level(level, s, t, o, n);
+        store(out->sound_speed + offset, fs, o, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_CPSW) {
+        o = target(out->cpsw + offset, fs, tile->out);
+        kernels->specific_heat_level(level, s, t, o, n);
+        store(out->cpsw + offset, fs, o, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_FREEZING_POINT) {
+        o = target(out->freezing_point + offset, fs, tile->out);
+        kernels->freezing_point_level(level, s, o, n);
+        store(out->freezing_point + offset, fs, o, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_ATG) {
+        o = target(out->atg + offset, fs, tile->out);
+        kernels->adiabatic_temperature_gradient_level(level, s, t, o, n);
+        store(out->atg + offset, fs, o, n);
+    }
+}
+
+/* Compute the tile of n points starting at index. */
+static void tile_derive(const struct pass *pass, const size_t *index,
+                        size_t n)
+{
+    const struct oceanography_grid *grid = pass->grid;
+    const struct ctd_outputs *out = pass->out;
+    const struct simd_kernels *kernels = pass->kernels;
+    struct tile *tile = pass->tile;
+    unsigned int outputs = pass->outputs;
+    const double *s, *t, *p;
+    double *o, *sig;
+    size_t offset, p_offset, g_offset, g_stride, fs, ps, i;
+    int d;
+
+    fs = grid->stride[pass->inner];
+    ps = grid->pressure_stride[pass->inner];
+    offset = p_offset = 0;
+    for (d = 0; d < 3; d++) {
+        offset += index[d] * grid->stride[d];
+        p_offset += index[d] * grid->pressure_stride[d];
+    }
+
+    if (outputs & OCEANOGRAPHY_CTD_DEPTH) {
+        g_offset = 0;
+        g_stride = 0;
+        if (grid->latitude_stride[0] != 0) {
+            g_offset += index[0];
+            g_stride = pass->inner == 0 ? 1 : g_stride;
+        }
+        if (grid->latitude_stride[1] != 0) {
+            g_offset += index[1] * pass->width;
+            g_stride = pass->inner == 1 ? pass->width : g_stride;
+        }
+        o = target(out->depth + offset, fs, tile->out);
+        tile_depth(pass->pressure + p_offset, ps, pass->gravity + g_offset,
+                   g_stride, o, n);
+        store(out->depth + offset, fs, o, n);
+    }
+    if (!(outputs & CTD_SALINITY_OUTPUTS))
+        return;
+
+    s = load(pass->salinity + offset, fs, tile->salinity, n);
+    t = load(pass->temperature + offset, fs, tile->temperature, n);
+
+    if (outputs & OCEANOGRAPHY_CTD_SALINITY)
+        for (i = 0; i < n; i++)
+            out->salinity[offset + i * fs] = s[i];
+    if (pass->levels != NULL) {
+        level_derive(pass, pass->levels + index[2], s, t, offset, n);
+        outputs &= ~LEVEL_OUTPUTS;
+        if (!(outputs & OCEANOGRAPHY_CTD_THETA))
+            return;
+    }
+
+    p = load(pass->pressure + p_offset, ps, tile->pressure, n);
+
+    if (outputs & (OCEANOGRAPHY_CTD_SVAN | OCEANOGRAPHY_CTD_SIGMA)) {
+        o = outputs & OCEANOGRAPHY_CTD_SVAN ?
+            target(out->svan + offset, fs, tile->out) : tile->out;
+        sig = outputs & OCEANOGRAPHY_CTD_SIGMA ?
+              target(out->sigma + offset, fs, tile->sigma) : NULL;
+        kernels->specific_volume_anomaly(s, t, p, o, sig, n);
+        if (outputs & OCEANOGRAPHY_CTD_SVAN)
+            store(out->svan + offset, fs, o, n);
+        if (outputs & OCEANOGRAPHY_CTD_SIGMA)
+            store(out->sigma + offset, fs, sig, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_THETA) {
+        o = target(out->theta + offset, fs, tile->out);
+        kernels->potential_temperature(s, t, p, tile->reference_pressure, o,
+                                       n);
+        store(out->theta + offset, fs, o, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_SOUND_SPEED) {
+        o = target(out->sound_speed + offset, fs, tile->out);
+        kernels->sound_speed(s, t, p, o, n);
+        store(out->sound_speed + offset, fs, o, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_CPSW) {
+        o = target(out->cpsw + offset, fs, tile->out);
+        kernels->specific_heat(s, t, p, o, n);
+        store(out->cpsw + offset, fs, o, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_FREEZING_POINT) {
+        o = target(out->freezing_point + offset, fs, tile->out);
+        kernels->freezing_point(s, p, o, n);
+        store(out->freezing_point + offset, fs, o, n);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_ATG) {
+        o = target(out->atg + offset, fs, tile->out);
+        kernels->adiabatic_temperature_gradient(s, t, p, o, n);
+        store(out->atg + offset, fs, o, n);
+    }
+}
+
+/* Nonzero if tiles should rather run along dimension a than along b: the
+ * one with the smaller stride, unless it has a single point. */
+static int before(const struct oceanography_grid *grid, int a, int b)
+{
+    if ((grid->shape[a] > 1) != (grid->shape[b] > 1))
+        return grid->shape[a] > 1;
+
+    return grid->stride[a] < grid->stride[b];
+}
+
+/* oceanography_grid_derive -- compute the outputs selected by the mask of
+ * OCEANOGRAPHY_CTD_* flags in outputs on a grid, from salinity, temperature
+ * and pressure.
+ *
+ * The grid has grid->shape[0] points along longitude, grid->shape[1] along
+ * latitude and grid->shape[2] along level. Point (i, j, k) of salinity,
+ * temperature and of the arrays of out is at offset
+ * i * grid->stride[0] + j * grid->stride[1] + k * grid->stride[2], the one
+ * of pressure uses grid->pressure_stride, and its latitude is at
+ * i * grid->latitude_stride[0] + j * grid->latitude_stride[1]. latitude is
+ * read only for depth, reference_pressure is used for potential temperature.
+ * The salinity output is a copy of salinity.
+ *
+ * Results are identical to the ones of the individual functions, or of the
+ * *_level_n functions when pressure varies along level only and level is
+ * not the dimension with the smallest stride.
+ *
+ * Units are the same of the individual functions.
+ *
+ * Returns 0 on success, -1 with errno set to ENOMEM if memory is not enough.
+ */
+
+int oceanography_grid_derive(const struct oceanography_grid *grid,
+                             const double *salinity,
+                             const double *temperature,
+                             const double *pressure, const double *latitude,
+                             double reference_pressure, unsigned int outputs,
+                             const struct ctd_outputs *out)
+{
+    struct pass pass;
+    struct oceanography_level *levels;
+    double *gravity;
+    size_t index[3], n, i;
+    int order[3], d, e;
+
+    if (grid->shape[0] == 0 || grid->shape[1] == 0 || grid->shape[2] == 0)
+        return 0;
+
+    pass.grid = grid;
+    pass.salinity = salinity;
+    pass.temperature = temperature;
+    pass.pressure = pressure;
+    pass.outputs = outputs;
+    pass.out = out;
+    pass.kernels = simd_select();
+    pass.tile = malloc(sizeof(*pass.tile));
+    if (pass.tile == NULL)
+        return -1;
+
+    gravity = NULL;
+    pass.width = 1;
+    if (outputs & OCEANOGRAPHY_CTD_DEPTH) {
+        gravity = gravity_cache(grid, latitude, &pass.width);
+        if (gravity == NULL) {
+            free(pass.tile);
+            return -1;
+        }
+    }
+    pass.gravity = gravity;
+
+    for (i = 0; i < TILE; i++)
+        pass.tile->reference_pressure[i] = reference_pressure;
+
+    /* Dimensions by increasing stride, the ones of a single point last. */
+    for (d = 0; d < 3; d++) {
+        for (e = d; e > 0 && before(grid, d, order[e - 1]); e--)
+            order[e] = order[e - 1];
+        order[e] = d;
+    }
+    pass.inner = order[0];
+
+    levels = NULL;
+    if (grid->pressure_stride[0] == 0 && grid->pressure_stride[1] == 0 &&
+        pass.inner != 2 && (outputs & LEVEL_OUTPUTS)) {
+        levels = level_cache(grid, pressure);
+        if (levels == NULL) {
+            free(gravity);
+            free(pass.tile);
+            return -1;
+        }
+    }
+    pass.levels = levels;
+
+    for (index[order[2]] = 0; index[order[2]] < grid->shape[order[2]];
+         index[order[2]]++)
+        for (index[order[1]] = 0; index[order[1]] < grid->shape[order[1]];
+             index[order[1]]++)
+            for (index[order[0]] = 0;
+                 index[order[0]] < grid->shape[order[0]];
+                 index[order[0]] += n) {
+                n = grid->shape[order[0]] - index[order[0]];
+                if (n > TILE)
+                    n = TILE;
+                tile_derive(&pass, index, n);
+            }
+
+    free(levels);
+    free(gravity);
+    free(pass.tile);
+
+    return 0;
+}
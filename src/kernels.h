@@ -0,0 +1,945 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * kernels.h -- Private per-sample kernels shared by the library sources.
+ *
+ * These are the bodies of the public functions declared in oceanography.h.
+ * They live here, as static inline functions, so that the scalar entry points
+ * and the batch loops compile the very same expressions: the compiler can
+ * inline and vectorize them inside the loops and the results are bit for bit
+ * identical to the scalar functions.
+ *
+ * This header is not installed.
+ */
+
+#ifndef OCEANOGRAPHY_KERNELS_H
+#define OCEANOGRAPHY_KERNELS_H
+
+#include <math.h>
+
+#include "oceanography.h"
+
+#if defined(__GNUC__)
+#define OCEANOGRAPHY_INLINE __inline__
+#elif defined(_MSC_VER)
+#define OCEANOGRAPHY_INLINE __inline
+#else
+#define OCEANOGRAPHY_INLINE
+#endif
+
+#define A(xt) (-3.107E-3 * (xt) + 0.4215)
+#define B(xt) ((4.464e-4 * (xt) + 3.426e-2) * (xt) + 1.0)
+#define C(xp) (((3.989e-15 * (xp) - 6.370e-10) * (xp) + 2.070e-5) * (xp))
+#define RT35(xt) ((((1.0031e-9 * (xt) - 6.9698e-7) * (xt) + 1.104259e-4) \
+                  * (xt) + 2.00564e-2) * (xt) + 0.6766097)
+
+static OCEANOGRAPHY_INLINE double _sal(double xr, double xt)
+{
+    return ((((2.7081 * xr - 7.0261) * xr + 14.0941) * xr + 25.3851)
+            * xr - 0.1692) * xr + 0.0080 + (xt / (1.0 + 0.0162 * xt)) *
+           (((((-0.0144 * xr + 0.0636) * xr - 0.0375) * xr - 0.0066)
+            * xr -0.0056) * xr + 0.0005);
+}
+
+static OCEANOGRAPHY_INLINE double _dsal(double xr, double xt)
+{
+    return ((((13.5405 * xr - 28.1044) * xr + 42.2823) * xr + 50.7702)
+            * xr - 0.1692) + ( xt / (1.0 + 0.0162 * xt)) *
+           ((((-0.0720 * xr + 0.2544) * xr -0.1125) * xr - 0.0132)
+            * xr -0.0056);
+}
+
+/* _salinity_cp -- salinity, given c_pressure = C(pressure). */
+static OCEANOGRAPHY_INLINE double _salinity_cp(double conductivity,
+                                               double temperature,
+                                               double c_pressure)
+{
+    double corrected_temperature, rt;
+    corrected_temperature = temperature - 15.0;
+
+    if (conductivity <= 5e-4)
+        return 0.0;
+
+    rt = conductivity / (RT35(temperature) * (1.0 + c_pressure /
+                                              (B(temperature) + A(temperature)
+                                              * conductivity)));
+    rt = sqrt(fabs(rt));
+
+    return _sal(rt, corrected_temperature);
+}
+
+static OCEANOGRAPHY_INLINE double _salinity(double conductivity,
+                                            double temperature,
+                                            double pressure)
+{
+    return _salinity_cp(conductivity, temperature, C(pressure));
+}
+
+/* The Newton iteration starts from a fit of the solution in sqrt(S / 35) and
+ * T - 15, good to 3.3e-3 over 0.05 <= S <= 42 and -2 <= T <= 40 degrees
+ * Celsius: this takes one iteration, instead of two or three from
+ * sqrt(S / 35), for almost every sample. The number of iterations is stored
+ * in *iterations, 0 when salinity is out of range or not a number, as in the
+ * vectorized kernels. c_pressure is C(pressure).
+ */
+static OCEANOGRAPHY_INLINE double _conductivity_cp_iterations(
+    double salinity, double temperature, double c_pressure, int *iterations)
+{
+    double corrected_temperature, u, rt, si, dels, rtt, cp, bt, r;
+    int n = 0;
+    corrected_temperature = temperature - 15.0;
+
+    *iterations = 0;
+    if (salinity <= 0.02)
+        return 0.0;
+    if (salinity != salinity)
+        return salinity;
+
+    u = sqrt(salinity / 35.0);
+    rt = ((((-0.0759721 * u + 0.226009) * u - 0.329901) * u + 1.17997) +
+          5.78313e-4 * corrected_temperature * (1.0 - u)) * u;
+    si = _sal(rt, corrected_temperature);
+
+    do {
+        rt = rt + (salinity - si) / _dsal(rt, corrected_temperature);
+        si = _sal(rt, corrected_temperature);
+        dels = fabs(si - salinity);
+        n++;
+    } while(n < OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS && dels > 1.0e-4);
+    *iterations = n;
+
+    rtt = RT35(temperature) * rt * rt;
+    cp = rtt * (c_pressure + B(temperature));
+    bt = B(temperature) - rtt * A(temperature);
+    r = sqrt(fabs(bt * bt + 4.0 * A(temperature) * cp)) - bt;
+
+    return 0.5 * r / A(temperature);
+}
+
+static OCEANOGRAPHY_INLINE double _conductivity_iterations(double salinity,
+                                                           double temperature,
+                                                           double pressure,
+                                                           int *iterations)
+{
+    return _conductivity_cp_iterations(salinity, temperature, C(pressure),
+                                       iterations);
+}
+
+static OCEANOGRAPHY_INLINE double _conductivity(double salinity,
+                                                double temperature,
+                                                double pressure)
+{
+    int iterations;
+
+    return _conductivity_iterations(salinity, temperature, pressure,
+                                    &iterations);
+}
+
+/* Functions with the _sr suffix take sr = sqrt(fabs(salinity)) and pressure
+ * already converted to bars (pressure / 10), so that callers computing
+ * several quantities of the same sample can share them.
+ */
+
+/* _sigma_sr -- density at the surface, minus 1028.1063 Kg/m^3. */
+static OCEANOGRAPHY_INLINE double _sigma_sr(double salinity, double sr,
+                                            double temperature)
+{
+    double r1, r2, r3, r4;
+
+    r4 = 4.8314e-4;
+    r1 = ((((6.536332e-9 * temperature - 1.120083e-6) * temperature +
+          1.001685e-4) * temperature - 9.095290e-3) * temperature +
+          6.793952e-2) * temperature - 28.263737;
+    r2 = (((5.3875e-9 * temperature - 8.2467e-7) * temperature + 7.6438e-5) *
+          temperature - 4.0899e-3) * temperature + 8.24493e-1;
+    r3 = (-1.6546e-6 * temperature + 1.0227e-4) * temperature - 5.72466e-3;
+
+    return (r4 * salinity + r3 * sr + r2) * salinity + r1;
+}
+
+static OCEANOGRAPHY_INLINE double _specific_volume_anomaly_sr(
+    double salinity, double sr, double temperature, double pressure,
+    double *sigma)
+{
+    double sig, a, b, c, d, e, a1, b1, aw, bw;
+    double ko, kw, k35, v350p, sva, gam, pk, dr35p, dk, dvan;
+
+    double r3500 = 1028.1063;
+    double dr350 = 28.106331;
+
+    sig = _sigma_sr(salinity, sr, temperature);
+    v350p = 1.0 / r3500;
+    sva = -sig * v350p / (r3500 + sig);
+    *sigma = sig + dr350;
+
+    if (pressure == 0.0)
+        return sva * 1.0e+8;
+
+    e = (9.1697e-10 * temperature + 2.0816e-8) * temperature - 9.9348e-7;
+    bw = (5.2787e-8 * temperature - 6.12293e-6) * temperature + 3.47718e-5;
+    b = bw + e * salinity;
+
+    d = 1.91075e-4;
+    c = (-1.6078e-6 * temperature - 1.0981e-5) * temperature + 2.2838e-3;
+    aw = ((-5.77905e-7 * temperature + 1.16092e-4) * temperature +
+          1.43713e-3) * temperature - 0.1194975;
+    a = (d * sr + c) * salinity + aw;
+
+    b1 = (-5.3009e-4 * temperature + 1.6483e-2) * temperature + 7.944e-2;
+    a1 = ((-6.1670e-5 * temperature + 1.09987e-2) * temperature - 0.603459) *
+         temperature + 54.6746;
+    kw = (((-5.155288e-5 * temperature + 1.360477e-2) * temperature -
+          2.327105) * temperature +148.4206) * temperature - 1930.06;
+    ko = (b1 * sr + a1) * salinity + kw;
+
+    dk = (b * pressure + a) * pressure + ko;
+    k35 = (5.03217e-5 * pressure + 3.359406) * pressure + 21582.27;
+    gam = pressure / k35;
+    pk = 1.0 - gam;
+    sva = sva * pk + (v350p + sva) * pressure * dk / (k35 * (k35 + dk));
+    v350p = v350p * pk;
+
+    dr35p = gam / v350p;
+    dvan = sva / (v350p * (v350p + sva));
+    *sigma = dr350 + dr35p - dvan;
+
+    return sva * 1.0e+8;
+}
+
+static OCEANOGRAPHY_INLINE double _specific_volume_anomaly(double salinity,
+                                                           double temperature,
+                                                           double pressure,
+                                                           double *sigma)
+{
+    return _specific_volume_anomaly_sr(salinity, sqrt(fabs(salinity)),
+                                       temperature, pressure / 10., sigma);
+}
+
+/* _density_derivatives_sr -- density anomaly, from the equation of state
+ * rho = rho0 / (1 - P / K) of _specific_volume_anomaly_sr(), with the
+ * thermal expansion coefficient in *alpha, the haline contraction
+ * coefficient in *beta and the isothermal compressibility, per bar, in
+ * *kappa. The derivatives of the surface density rho0 and of the secant
+ * bulk modulus K are the ones of their polynomials.
+ */
+static OCEANOGRAPHY_INLINE double _density_derivatives_sr(
+    double salinity, double sr, double temperature, double pressure,
+    double *alpha, double *beta, double *kappa)
+{
+    double rho0, sig_t, sig_s, r2, r3, e, b, c, a, aw, bw, a1, b1, kw, ko;
+    double e_t, bw_t, c_t, aw_t, a1_t, b1_t, kw_t, k, k_t, k_s, k_p, q, g;
+
+    rho0 = 1028.1063 + _sigma_sr(salinity, sr, temperature);
+    r2 = (((5.3875e-9 * temperature - 8.2467e-7) * temperature + 7.6438e-5) *
+          temperature - 4.0899e-3) * temperature + 8.24493e-1;
+    r3 = (-1.6546e-6 * temperature + 1.0227e-4) * temperature - 5.72466e-3;
+    sig_t = ((((3.268166e-8 * temperature - 4.480332e-6) * temperature +
+              3.005055e-4) * temperature - 1.819058e-2) * temperature +
+             6.793952e-2) +
+            ((((2.155e-8 * temperature - 2.47401e-6) * temperature +
+               1.52876e-4) * temperature - 4.0899e-3) +
+             (-3.3092e-6 * temperature + 1.0227e-4) * sr) * salinity;
+    sig_s = (9.6628e-4 * salinity + 1.5 * r3 * sr) + r2;
+
+    e = (9.1697e-10 * temperature + 2.0816e-8) * temperature - 9.9348e-7;
+    bw = (5.2787e-8 * temperature - 6.12293e-6) * temperature + 3.47718e-5;
+    b = bw + e * salinity;
+    c = (-1.6078e-6 * temperature - 1.0981e-5) * temperature + 2.2838e-3;
+    aw = ((-5.77905e-7 * temperature + 1.16092e-4) * temperature +
+          1.43713e-3) * temperature - 0.1194975;
+    a = (1.91075e-4 * sr + c) * salinity + aw;
+    b1 = (-5.3009e-4 * temperature + 1.6483e-2) * temperature + 7.944e-2;
+    a1 = ((-6.1670e-5 * temperature + 1.09987e-2) * temperature - 0.603459) *
+         temperature + 54.6746;
+    kw = (((-5.155288e-5 * temperature + 1.360477e-2) * temperature -
+          2.327105) * temperature + 148.4206) * temperature - 1930.06;
+    ko = (b1 * sr + a1) * salinity + kw;
+    k = ((b * pressure + a) * pressure + ko) +
+        ((5.03217e-5 * pressure + 3.359406) * pressure + 21582.27);
+
+    e_t = 1.83394e-9 * temperature + 2.0816e-8;
+    bw_t = 1.05574e-7 * temperature - 6.12293e-6;
+    c_t = -3.2156e-6 * temperature - 1.0981e-5;
+    aw_t = (-1.733715e-6 * temperature + 2.32184e-4) * temperature +
+           1.43713e-3;
+    b1_t = -1.06018e-3 * temperature + 1.6483e-2;
+    a1_t = (-1.8501e-4 * temperature + 2.19974e-2) * temperature - 0.603459;
+    kw_t = ((-2.0621152e-4 * temperature + 4.081431e-2) * temperature -
+            4.65421) * temperature + 148.4206;
+    k_t = ((bw_t + e_t * salinity) * pressure + (c_t * salinity + aw_t)) *
+          pressure + ((b1_t * sr + a1_t) * salinity + kw_t);
+    k_s = (e * pressure + (2.866125e-4 * sr + c)) * pressure +
+          (1.5 * b1 * sr + a1);
+    k_p = (2.0 * b * pressure + a) + (1.006434e-4 * pressure + 3.359406);
+
+    q = 1.0 - pressure / k;
+    g = pressure / (q * k * k);
+    *alpha = g * k_t - sig_t / rho0;
+    *beta = sig_s / rho0 - g * k_s;
+    *kappa = (k - pressure * k_p) / (q * k * k);
+
+    /* The sigma of _specific_volume_anomaly_sr(), whose dr350 is rounded
+     * differently from r3500. */
+    return rho0 / q - (1028.1063 - 28.106331);
+}
+
+/* _density_derivatives -- same as _density_derivatives_sr(), with pressure
+ * and *kappa in decibars. */
+static OCEANOGRAPHY_INLINE double _density_derivatives(
+    double salinity, double temperature, double pressure, double *alpha,
+    double *beta, double *kappa)
+{
+    double out;
+
+    out = _density_derivatives_sr(salinity, sqrt(fabs(salinity)),
+                                  temperature, pressure / 10.0, alpha, beta,
+                                  kappa);
+    *kappa = *kappa / 10.0;
+
+    return out;
+}
+
+/* _density_sr -- the density anomaly of _density_derivatives_sr(), without
+ * the derivatives. At the surface the secant bulk modulus is not needed: the
+ * result is the same, since 1 - 0 / K is exactly 1.
+ */
+static OCEANOGRAPHY_INLINE double _density_sr(double salinity, double sr,
+                                              double temperature,
+                                              double pressure)
+{
+    double rho0, e, b, c, a, aw, bw, a1, b1, kw, ko, k;
+
+    rho0 = 1028.1063 + _sigma_sr(salinity, sr, temperature);
+    if (pressure == 0.0)
+        return rho0 - (1028.1063 - 28.106331);
+
+    e = (9.1697e-10 * temperature + 2.0816e-8) * temperature - 9.9348e-7;
+    bw = (5.2787e-8 * temperature - 6.12293e-6) * temperature + 3.47718e-5;
+    b = bw + e * salinity;
+    c = (-1.6078e-6 * temperature - 1.0981e-5) * temperature + 2.2838e-3;
+    aw = ((-5.77905e-7 * temperature + 1.16092e-4) * temperature +
+          1.43713e-3) * temperature - 0.1194975;
+    a = (1.91075e-4 * sr + c) * salinity + aw;
+    b1 = (-5.3009e-4 * temperature + 1.6483e-2) * temperature + 7.944e-2;
+    a1 = ((-6.1670e-5 * temperature + 1.09987e-2) * temperature - 0.603459) *
+         temperature + 54.6746;
+    kw = (((-5.155288e-5 * temperature + 1.360477e-2) * temperature -
+          2.327105) * temperature + 148.4206) * temperature - 1930.06;
+    ko = (b1 * sr + a1) * salinity + kw;
+    k = ((b * pressure + a) * pressure + ko) +
+        ((5.03217e-5 * pressure + 3.359406) * pressure + 21582.27);
+
+    return rho0 / (1.0 - pressure / k) - (1028.1063 - 28.106331);
+}
+
+static OCEANOGRAPHY_INLINE double _density(double salinity,
+                                           double temperature,
+                                           double pressure)
+{
+    return _density_sr(salinity, sqrt(fabs(salinity)), temperature,
+                       pressure / 10.0);
+}
+
+/* _salinity_density_sr -- the inverse of _density_sr() in salinity: the
+ * salinity of density anomaly sigma, by Newton iterations on
+ * _density_derivatives_sr(), whose haline contraction coefficient times the
+ * density is the derivative. Density is almost linear in salinity: from 35,
+ * the middle of the ocean range, three iterations land within rounding and
+ * a fourth one confirms it. Iterations stop when the step falls below 1e-8,
+ * or after OCEANOGRAPHY_INVERSE_ITERATIONS.
+ */
+static OCEANOGRAPHY_INLINE double _salinity_density_sr(double sigma,
+                                                       double temperature,
+                                                       double pressure)
+{
+    double s, sig, alpha, beta, kappa, step;
+    int n = 0;
+
+    s = 35.0;
+    do {
+        sig = _density_derivatives_sr(s, sqrt(fabs(s)), temperature,
+                                      pressure, &alpha, &beta, &kappa);
+        step = (sig - sigma) / (beta * (sig + (1028.1063 - 28.106331)));
+        s = s - step;
+        n++;
+    } while (n < OCEANOGRAPHY_INVERSE_ITERATIONS && fabs(step) > 1.0e-8);
+
+    return s;
+}
+
+/* _salinity_from_density -- same as _salinity_density_sr(), with pressure
+ * in decibars and the residual density anomaly in *residual. */
+static OCEANOGRAPHY_INLINE double _salinity_from_density(double sigma,
+                                                         double temperature,
+                                                         double pressure,
+                                                         double *residual)
+{
+    double s;
+
+    pressure = pressure / 10.0;
+    s = _salinity_density_sr(sigma, temperature, pressure);
+    *residual = _density_sr(s, sqrt(fabs(s)), temperature, pressure) - sigma;
+
+    return s;
+}
+
+/* _gravity -- the latitude term of the gravity in _depth_gravity(). */
+static OCEANOGRAPHY_INLINE double _gravity(double latitude)
+{
+    double x;
+
+    x = sin(latitude / 57.29578);
+    x = x * x;
+
+    return 9.780318 * (1.0 + (5.2788e-3 + 2.36e-5 * x) * x);
+}
+
+static OCEANOGRAPHY_INLINE double _depth_gravity(double pressure,
+                                                 double gravity)
+{
+    double gr, depth;
+
+    gr = gravity + 1.092e-6 * pressure;
+    depth = (((-1.82e-15 * pressure + 2.279e-10) * pressure - 2.2512e-5) *
+             pressure + 9.72659) * pressure;
+
+    return depth / gr;
+}
+
+static OCEANOGRAPHY_INLINE double _depth(double pressure, double latitude)
+{
+    return _depth_gravity(pressure, _gravity(latitude));
+}
+
+/* _pressure_gravity -- the inverse of _depth_gravity(): the root of
+ * D(p) - depth * (gravity + 1.092e-6 * p), D being the polynomial of depth,
+ * by two Newton iterations. The first guess, the root of the quadratic part
+ * to first order, is within 0.3% up to 10000 decibars without a division;
+ * the second iteration lands within rounding. */
+static OCEANOGRAPHY_INLINE double _pressure_gravity(double depth,
+                                                   double gravity)
+{
+    double b, c, p, h, dh;
+    int k;
+
+    b = 9.72659 - 1.092e-6 * depth;
+    c = depth * gravity;
+    p = c * (1.0 / 9.72659);
+    p = (p * (2.2512e-5 / 9.72659) + 1.0) * p;
+    for (k = 0; k < 2; k++) {
+        h = (((-1.82e-15 * p + 2.279e-10) * p - 2.2512e-5) * p + b) * p - c;
+        dh = ((-7.28e-15 * p + 6.837e-10) * p - 4.5024e-5) * p + b;
+        p = p - h / dh;
+    }
+
+    return p;
+}
+
+static OCEANOGRAPHY_INLINE double _pressure_from_depth(double depth,
+                                                       double latitude)
+{
+    return _pressure_gravity(depth, _gravity(latitude));
+}
+
+static OCEANOGRAPHY_INLINE double _freezing_point_sr(double salinity,
+                                                     double sr,
+                                                     double pressure)
+{
+    return (-0.0575 + 1.710523e-3 * sr - 2.154996e-4 * salinity) * salinity -
+           7.53e-4 * pressure;
+}
+
+static OCEANOGRAPHY_INLINE double _freezing_point(double salinity,
+                                                  double pressure)
+{
+    return _freezing_point_sr(salinity, sqrt(fabs(salinity)), pressure);
+}
+
+static OCEANOGRAPHY_INLINE double _specific_heat_sr(double salinity,
+                                                    double sr,
+                                                    double temperature,
+                                                    double pressure)
+{
+    double a, b, c, cp0, cp1, cp2;
+
+    a = (-1.38385e-3 * temperature + 0.1072763) * temperature - 7.643575;
+    b = (5.148e-5 * temperature - 4.07718e-3) * temperature + 0.1770383;
+    c = (((2.093236e-5 * temperature - 2.654387e-3) * temperature +
+         0.1412855) * temperature -3.720283) * temperature + 4217.4;
+    cp0 = (b * sr + a) * salinity + c;
+
+    a = (((1.7168e-8 * temperature + 2.0357e-6) * temperature - 3.13885e-4) *
+         temperature + 1.45747e-2) * temperature - 0.49592;
+    b = (((2.2956e-11 * temperature - 4.0027e-9) * temperature + 2.87533e-7) *
+         temperature - 1.08645e-5) * temperature + 2.4931e-4;
+    c = ((6.136e-13 * temperature - 6.5637e-11) * temperature + 2.6380e-9) *
+         temperature - 5.422e-8;
+    cp1 = ((c * pressure + b) * pressure + a) * pressure;
+
+    a = (((-2.9179e-10 * temperature + 2.5941e-8) * temperature + 9.802e-7) *
+         temperature - 1.28315e-4) * temperature + 4.9247e-3;
+    b = (3.122e-8 * temperature -1.517e-6) * temperature - 1.2331e-4;
+    a = (a + b * sr) * salinity;
+    b = ((1.8448e-11 * temperature - 2.3905e-9) * temperature + 1.17054e-7) *
+        temperature - 2.9558e-6;
+    b = (b + 9.971e-8 * sr) * salinity;
+    c = (3.513e-13 * temperature - 1.7682e-11) * temperature + 5.540e-10;
+    c = (c - 1.4300e-12 * temperature * sr) * salinity;
+    cp2 = ((c * pressure + b) * pressure + a) * pressure;
+
+    return cp0 + cp1 + cp2;
+}
+
+static OCEANOGRAPHY_INLINE double _specific_heat(double salinity,
+                                                 double temperature,
+                                                 double pressure)
+{
+    return _specific_heat_sr(salinity, sqrt(fabs(salinity)), temperature,
+                             pressure / 10.0);
+}
+
+static OCEANOGRAPHY_INLINE double _adiabatic_temperature_gradient(
+    double salinity, double temperature, double pressure)
+{
+    salinity = salinity - 35.0;
+
+    return (((-2.1687e-16 * temperature + 1.8676e-14) * temperature -
+            4.6206e-13) * pressure + ((2.7759e-12 * temperature - 1.1351e-10) *
+            salinity + ((-5.4481e-14 * temperature + 8.733e-12) * temperature -
+            6.7795e-10) * temperature + 1.8741e-8)) * pressure + (-4.2393e-8 *
+            temperature + 1.8932e-6) * salinity + ((6.6228e-10 * temperature -
+            6.836e-8) * temperature + 8.5258e-6) * temperature + 3.5803e-5;
+}
+
+/* _potential_temperature_atg -- potential temperature, given atg, the
+ * adiabatic temperature gradient at (salinity, temperature, pressure).
+ */
+static OCEANOGRAPHY_INLINE double _potential_temperature_atg(
+    double salinity, double temperature, double pressure,
+    double reference_pressure, double atg)
+{
+    double h, xk, q;
+
+    h = reference_pressure - pressure;
+    xk = h * atg;
+    temperature += 0.5 * xk;
+    q = xk;
+    pressure += 0.5 * h;
+    xk = h * _adiabatic_temperature_gradient(salinity, temperature, pressure);
+    temperature += 0.29289322 * (xk - q);
+    q = 0.58578644 * xk + 0.121320344 * q;
+    xk = h * _adiabatic_temperature_gradient(salinity, temperature, pressure);
+    temperature += 1.707106781 * (xk - q);
+    q = 3.414213562 * xk - 4.121320344 * q;
+    pressure += 0.5 * h;
+    xk = h * _adiabatic_temperature_gradient(salinity, temperature, pressure);
+
+    return temperature + (xk - 2.0 * q) / 0.6;
+}
+
+static OCEANOGRAPHY_INLINE double _potential_temperature(
+    double salinity, double temperature, double pressure,
+    double reference_pressure)
+{
+    return _potential_temperature_atg(
+        salinity, temperature, pressure, reference_pressure,
+        _adiabatic_temperature_gradient(salinity, temperature, pressure));
+}
+
+/* _potential_density_atg -- density anomaly at reference_pressure of the
+ * potential temperature, given atg as _potential_temperature_atg(). */
+static OCEANOGRAPHY_INLINE double _potential_density_atg(
+    double salinity, double sr, double temperature, double pressure,
+    double reference_pressure, double atg)
+{
+    return _density_sr(salinity, sr,
+                       _potential_temperature_atg(salinity, temperature,
+                                                  pressure,
+                                                  reference_pressure, atg),
+                       reference_pressure / 10.0);
+}
+
+static OCEANOGRAPHY_INLINE double _potential_density(
+    double salinity, double temperature, double pressure,
+    double reference_pressure)
+{
+    return _potential_density_atg(
+        salinity, sqrt(fabs(salinity)), temperature, pressure,
+        reference_pressure,
+        _adiabatic_temperature_gradient(salinity, temperature, pressure));
+}
+
+/* _in_situ_temperature -- temperature at pressure whose potential
+ * temperature at reference_pressure is theta.
+ *
+ * The first guess integrates theta back from reference_pressure, then a
+ * fixed point step and OCEANOGRAPHY_IN_SITU_ITERATIONS secant steps invert
+ * _potential_temperature() to about 1.0e-13 degrees.
+ */
+static OCEANOGRAPHY_INLINE double _in_situ_temperature(
+    double salinity, double theta, double pressure, double reference_pressure)
+{
+    double t0, t1, t, f0, f1;
+    int k;
+
+    t0 = _potential_temperature(salinity, theta, reference_pressure,
+                                pressure);
+    f0 = _potential_temperature(salinity, t0, pressure, reference_pressure) -
+         theta;
+    t1 = t0 - f0;
+    for (k = 0; k < OCEANOGRAPHY_IN_SITU_ITERATIONS; k++) {
+        f1 = _potential_temperature(salinity, t1, pressure,
+                                    reference_pressure) - theta;
+        t = f1 != f0 ? t1 - f1 * (t1 - t0) / (f1 - f0) : t1;
+        t0 = t1;
+        f0 = f1;
+        t1 = t;
+    }
+
+    return t1;
+}
+
+static OCEANOGRAPHY_INLINE double _sound_speed_sr(double salinity,
+                                                  double sr,
+                                                  double temperature,
+                                                  double pressure)
+{
+    double a, a0, a1, a2, a3, b, b0, b1, c, c0, c1, c2, c3, d;
+
+    d = 1.727e-3 - 7.9836e-6 * pressure;
+
+    b1 = 7.3637e-5 + 1.7945e-7 * temperature;
+    b0 = -1.922e-2 - 4.42e-5 * temperature;
+    b = b0 + b1 * pressure;
+
+    a3 = (-3.389e-13 * temperature + 6.649e-12) * temperature + 1.100e-10;
+    a2 = ((7.988e-12 * temperature - 1.6002e-10) * temperature + 9.1041e-9) *
+         temperature - 3.9064e-7;
+
+    a1 = (((-2.0122e-10 * temperature + 1.0507e-8) * temperature - 6.4885e-8) *
+          temperature - 1.2580e-5) * temperature + 9.4742e-5;
+    a0 = (((-3.21e-8 * temperature + 2.006e-6) * temperature + 7.164e-5) *
+          temperature - 1.262e-2) * temperature + 1.389;
+    a = ((a3 * pressure + a2) * pressure + a1) * pressure + a0;
+
+    c3 = (-2.3643e-12 * temperature + 3.8504e-10) * temperature - 9.7729e-9;
+    c2 = (((1.0405e-12 * temperature - 2.5335e-10) * temperature + 2.5974e-8) *
+          temperature - 1.7107e-6) * temperature + 3.1260e-5;
+    c1 = (((-6.1185e-10 * temperature + 1.3621e-7) * temperature - 8.1788e-6) *
+          temperature + 6.8982e-4) * temperature + 0.153563;
+    c0 = ((((3.1464e-9 * temperature - 1.47800e-6) * temperature + 3.3420e-4) *
+          temperature - 5.80852e-2) * temperature + 5.03711) * temperature +
+          1402.388;
+    c = ((c3 * pressure + c2) * pressure + c1) * pressure + c0;
+
+    return c + (a + b * sr + d * salinity) * salinity;
+}
+
+static OCEANOGRAPHY_INLINE double _sound_speed(double salinity,
+                                               double temperature,
+                                               double pressure)
+{
+    return _sound_speed_sr(salinity, sqrt(fabs(salinity)), temperature,
+                           pressure / 10.0);
+}
+
+/* _sound_speed_dt_sr -- the derivative of _sound_speed_sr() in
+ * temperature, from the derivatives of its polynomials. */
+static OCEANOGRAPHY_INLINE double _sound_speed_dt_sr(double salinity,
+                                                     double sr,
+                                                     double temperature,
+                                                     double pressure)
+{
+    double a, a0, a1, a2, a3, b, c, c0, c1, c2, c3;
+
+    b = -4.42e-5 + 1.7945e-7 * pressure;
+
+    a3 = -6.778e-13 * temperature + 6.649e-12;
+    a2 = (2.3964e-11 * temperature - 3.2004e-10) * temperature + 9.1041e-9;
+    a1 = ((-8.0488e-10 * temperature + 3.1521e-8) * temperature -
+          1.2977e-7) * temperature - 1.2580e-5;
+    a0 = ((-1.284e-7 * temperature + 6.018e-6) * temperature + 1.4328e-4) *
+         temperature - 1.262e-2;
+    a = ((a3 * pressure + a2) * pressure + a1) * pressure + a0;
+
+    c3 = -4.7286e-12 * temperature + 3.8504e-10;
+    c2 = ((4.162e-12 * temperature - 7.6005e-10) * temperature + 5.1948e-8) *
+         temperature - 1.7107e-6;
+    c1 = ((-2.4474e-9 * temperature + 4.0863e-7) * temperature -
+          1.63576e-5) * temperature + 6.8982e-4;
+    c0 = (((1.5732e-8 * temperature - 5.912e-6) * temperature + 1.0026e-3) *
+          temperature - 0.1161704) * temperature + 5.03711;
+    c = ((c3 * pressure + c2) * pressure + c1) * pressure + c0;
+
+    return c + (a + b * sr) * salinity;
+}
+
+/* _temperature_sound_speed_sr -- the inverse of _sound_speed_sr() in
+ * temperature, by Newton iterations. The first guess scales the sound speed
+ * above the one at 0 degrees Celsius by the slope of _sound_speed_dt_sr()
+ * there, and corrects the curvature with a quartic fit of the inverse for
+ * pure water at the surface: it is within 0.7 degrees Celsius over the
+ * ocean range, where two iterations land within rounding and a third one
+ * confirms it. Iterations stop when the step falls below 1e-8, or after
+ * OCEANOGRAPHY_INVERSE_ITERATIONS.
+ */
+static OCEANOGRAPHY_INLINE double _temperature_sound_speed_sr(
+    double sound_speed, double salinity, double sr, double pressure)
+{
+    double x, t, step;
+    int n = 0;
+
+    x = (sound_speed - _sound_speed_sr(salinity, sr, 0.0, pressure)) /
+        _sound_speed_dt_sr(salinity, sr, 0.0, pressure);
+    t = (((3.1423e-5 * x - 5.027e-4) * x + 1.6249e-2) * x + 1.0) * x;
+    do {
+        step = (_sound_speed_sr(salinity, sr, t, pressure) - sound_speed) /
+               _sound_speed_dt_sr(salinity, sr, t, pressure);
+        t = t - step;
+        n++;
+    } while (n < OCEANOGRAPHY_INVERSE_ITERATIONS && fabs(step) > 1.0e-8);
+
+    return t;
+}
+
+/* _temperature_from_sound_speed -- same as _temperature_sound_speed_sr(),
+ * with pressure in decibars and the residual sound speed in *residual. */
+static OCEANOGRAPHY_INLINE double _temperature_from_sound_speed(
+    double sound_speed, double salinity, double pressure, double *residual)
+{
+    double sr = sqrt(fabs(salinity)), t;
+
+    pressure = pressure / 10.0;
+    t = _temperature_sound_speed_sr(sound_speed, salinity, sr, pressure);
+    *residual = _sound_speed_sr(salinity, sr, t, pressure) - sound_speed;
+
+    return t;
+}
+
+/* Kernels on a pressure level, taking the terms of a struct
+ * oceanography_level (see level.c for their layout). The polynomials in
+ * temperature and pressure are folded into polynomials in temperature, so
+ * results differ from the ones of the kernels above by rounding only.
+ */
+
+/* _poly -- the polynomial of the given degree with coefficients c[0],
+ * c[1], ... of the ascending powers of x. */
+static OCEANOGRAPHY_INLINE double _poly(const double *c, int degree, double x)
+{
+    double r = c[degree];
+
+    while (degree-- > 0)
+        r = r * x + c[degree];
+
+    return r;
+}
+
+static OCEANOGRAPHY_INLINE double _specific_volume_anomaly_level(
+    const struct oceanography_level *level, double salinity, double sr,
+    double temperature, double *sigma)
+{
+    const double *k = level->svan;
+    double sig, sva, dk, dvan;
+
+    sig = _sigma_sr(salinity, sr, temperature);
+    sva = -sig * (1.0 / 1028.1063) / (1028.1063 + sig);
+
+    if (k[12] == 0.0) {
+        *sigma = sig + 28.106331;
+        return sva * 1.0e+8;
+    }
+
+    dk = _poly(k, 4, temperature) +
+         (_poly(k + 5, 3, temperature) + _poly(k + 9, 2, temperature) * sr) *
+         salinity;
+    sva = sva * k[14] + ((1.0 / 1028.1063) + sva) * k[12] * dk /
+                        (k[13] * (k[13] + dk));
+    dvan = sva / (k[15] * (k[15] + sva));
+    *sigma = 28.106331 + k[16] - dvan;
+
+    return sva * 1.0e+8;
+}
+
+static OCEANOGRAPHY_INLINE double _specific_heat_level(
+    const struct oceanography_level *level, double salinity, double sr,
+    double temperature)
+{
+    const double *k = level->cpsw;
+
+    return _poly(k, 4, temperature) +
+           (_poly(k + 5, 4, temperature) + _poly(k + 10, 2, temperature) *
+            sr) * salinity;
+}
+
+static OCEANOGRAPHY_INLINE double _adiabatic_temperature_gradient_level(
+    const struct oceanography_level *level, double salinity,
+    double temperature)
+{
+    const double *k = level->atg;
+
+    return _poly(k, 3, temperature) +
+           _poly(k + 4, 1, temperature) * (salinity - 35.0);
+}
+
+static OCEANOGRAPHY_INLINE double _sound_speed_level(
+    const struct oceanography_level *level, double salinity, double sr,
+    double temperature)
+{
+    const double *k = level->sound_speed;
+
+    return _poly(k, 5, temperature) +
+           (_poly(k + 6, 4, temperature) + _poly(k + 11, 1, temperature) *
+            sr + k[13] * salinity) * salinity;
+}
+
+/* Outputs of ctd_derive_n() that need salinity. */
+#define CTD_SALINITY_OUTPUTS (~(unsigned int) OCEANOGRAPHY_CTD_DEPTH)
+
+/* _ctd_derive -- compute the outputs of ctd_derive_n() for sample i. */
+static OCEANOGRAPHY_INLINE void _ctd_derive(const double *conductivity,
+                                            const double *temperature,
+                                            const double *pressure,
+                                            double gravity,
+                                            double reference_pressure,
+                                            unsigned int outputs,
+                                            const struct ctd_outputs *out,
+                                            size_t i)
+{
+    double s, sr, t, p, p10, sig, v, atg;
+
+    t = temperature[i];
+    p = pressure[i];
+    p10 = p / 10.0;
+    s = sr = 0.0;
+
+    if (outputs & CTD_SALINITY_OUTPUTS) {
+        s = _salinity(conductivity[i], t, p);
+        sr = sqrt(fabs(s));
+    }
+    if (outputs & OCEANOGRAPHY_CTD_SALINITY)
+        out->salinity[i] = s;
+    if (outputs & (OCEANOGRAPHY_CTD_SVAN | OCEANOGRAPHY_CTD_SIGMA)) {
+        v = _specific_volume_anomaly_sr(s, sr, t, p10, &sig);
+        if (outputs & OCEANOGRAPHY_CTD_SVAN)
+            out->svan[i] = v;
+        if (outputs & OCEANOGRAPHY_CTD_SIGMA)
+            out->sigma[i] = sig;
+    }
+    if (outputs & (OCEANOGRAPHY_CTD_ATG | OCEANOGRAPHY_CTD_THETA)) {
+        atg = _adiabatic_temperature_gradient(s, t, p);
+        if (outputs & OCEANOGRAPHY_CTD_ATG)
+            out->atg[i] = atg;
+        if (outputs & OCEANOGRAPHY_CTD_THETA)
+            out->theta[i] = _potential_temperature_atg(s, t, p,
+                                                       reference_pressure,
+                                                       atg);
+    }
+    if (outputs & OCEANOGRAPHY_CTD_SOUND_SPEED)
+        out->sound_speed[i] = _sound_speed_sr(s, sr, t, p10);
+    if (outputs & OCEANOGRAPHY_CTD_CPSW)
+        out->cpsw[i] = _specific_heat_sr(s, sr, t, p10);
+    if (outputs & OCEANOGRAPHY_CTD_FREEZING_POINT)
+        out->freezing_point[i] = _freezing_point_sr(s, sr, p);
+    if (outputs & OCEANOGRAPHY_CTD_DEPTH)
+        out->depth[i] = _depth_gravity(p, gravity);
+}
+
+/* Piecewise polynomials of an approximation table (see table.c). */
+struct table_layout {
+    enum oceanography_table_function function;
+    unsigned int order[3];      /* degree + 1 */
+    unsigned int cells[3];
+    double min[3];
+    double max[3];
+    double scale[3];            /* cells per unit */
+    size_t stride;              /* coefficients per cell */
+    const double *coefficients;
+};
+
+static OCEANOGRAPHY_INLINE double _table_exact(double s, double t, double p)
+{
+    double sigma;
+
+    return _specific_volume_anomaly(s, t, p, &sigma);
+}
+
+static OCEANOGRAPHY_INLINE int _table_inside(const struct table_layout *table,
+                                             double s, double t, double p)
+{
+    return table->min[0] <= s && s <= table->max[0] &&
+           table->min[1] <= t && t <= table->max[1] &&
+           table->min[2] <= p && p <= table->max[2];
+}
+
+/* Cell of x along dimension dim, returning the local coordinate in
+ * [0, 1]. */
+static OCEANOGRAPHY_INLINE double _table_locate(
+    const struct table_layout *table, int dim, double x, unsigned int *c)
+{
+    double f = (x - table->min[dim]) * table->scale[dim];
+
+    *c = (unsigned int) f;
+    *c -= *c == table->cells[dim];
+
+    return f - *c;
+}
+
+/* Polynomial of a cell at the local coordinates (us, ut, up). Powers of s
+ * vary fastest: walk the coefficients backwards, from the highest powers. */
+static OCEANOGRAPHY_INLINE double _table_horner(
+    const struct table_layout *table, size_t cell, double us, double ut,
+    double up)
+{
+    const unsigned int *n = table->order;
+    const double *a = table->coefficients + table->stride * (cell + 1);
+    double r = 0.0, rt, rs;
+    unsigned int i, j, k;
+
+    for (k = 0; k < n[2]; k++) {
+        rt = 0.0;
+        for (j = 0; j < n[1]; j++) {
+            rs = *--a;
+            for (i = 1; i < n[0]; i++)
+                rs = rs * us + *--a;
+            rt = rt * ut + rs;
+        }
+        r = r * up + rt;
+    }
+
+    return r;
+}
+
+static OCEANOGRAPHY_INLINE double _table_eval(const struct table_layout *table,
+                                              double s, double t, double p)
+{
+    double us, ut, up;
+    unsigned int cs, ct, cp;
+
+    if (!_table_inside(table, s, t, p))
+        return _table_exact(s, t, p);
+
+    us = _table_locate(table, 0, s, &cs);
+    ut = _table_locate(table, 1, t, &ct);
+    up = _table_locate(table, 2, p, &cp);
+
+    return _table_horner(table, ((size_t) cp * table->cells[1] + ct) *
+                                table->cells[0] + cs, us, ut, up);
+}
+
+#endif /* OCEANOGRAPHY_KERNELS_H */
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * level.c -- Batch functions on a pressure level.
+ *
+ * The coefficients of the polynomials in temperature and pressure of sound
+ * speed, specific volume anomaly, specific heat and adiabatic temperature
+ * gradient are polynomials in pressure: oceanography_level_init() evaluates
+ * them once, leaving polynomials in temperature only, of which the fields of
+ * struct oceanography_level are the coefficients in ascending powers. With P
+ * the pressure in bars:
+ *
+ *     sound_speed[0..5]    c(T), the terms without salinity
+ *     sound_speed[6..10]   a(T), the terms in S
+ *     sound_speed[11..12]  b(T), the terms in S^1.5
+ *     sound_speed[13]      d, the term in S^2
+ *     svan[0..4]           the terms of the secant bulk modulus without
+ *                          salinity
+ *     svan[5..8]           its terms in S
+ *     svan[9..11]          its terms in S^1.5
+ *     svan[12]             P
+ *     svan[13]             the secant bulk modulus at S = 35, T = 0
+ *     svan[14]             1 - P / svan[13]
+ *     svan[15]             the specific volume at S = 35, T = 0
+ *     svan[16]             its density anomaly
+ *     cpsw[0..4]           the terms of specific heat without salinity
+ *     cpsw[5..9]           its terms in S
+ *     cpsw[10..12]         its terms in S^1.5
+ *     atg[0..3]            the terms of the adiabatic temperature gradient
+ *                          without salinity, pressure in decibars
+ *     atg[4..5]            its terms in S - 35
+ *
+ * conductivity is the pressure term C(p) of the conductivity ratio, so
+ * salinity and conductivity are bit for bit identical to the ones of the
+ * individual functions, as freezing point is. The other results differ by
+ * rounding only.
+ */
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+#include "stats.h"
+
+/* Coefficients in ascending powers of T (columns) of the ascending powers of
+ * P (rows). */
+
+static const double sound_speed_c[4][6] = {
+    {1402.388, 5.03711, -5.80852e-2, 3.3420e-4, -1.47800e-6, 3.1464e-9},
+    {0.153563, 6.8982e-4, -8.1788e-6, 1.3621e-7, -6.1185e-10, 0.0},
+    {3.1260e-5, -1.7107e-6, 2.5974e-8, -2.5335e-10, 1.0405e-12, 0.0},
+    {-9.7729e-9, 3.8504e-10, -2.3643e-12, 0.0, 0.0, 0.0}
+};
+
+static const double sound_speed_a[4][5] = {
+    {1.389, -1.262e-2, 7.164e-5, 2.006e-6, -3.21e-8},
+    {9.4742e-5, -1.2580e-5, -6.4885e-8, 1.0507e-8, -2.0122e-10},
+    {-3.9064e-7, 9.1041e-9, -1.6002e-10, 7.988e-12, 0.0},
+    {1.100e-10, 6.649e-12, -3.389e-13, 0.0, 0.0}
+};
+
+static const double sound_speed_b[2][2] = {
+    {-1.922e-2, -4.42e-5},
+    {7.3637e-5, 1.7945e-7}
+};
+
+static const double sound_speed_d[2][1] = {
+    {1.727e-3},
+    {-7.9836e-6}
+};
+
+static const double svan_k[3][5] = {
+    {-1930.06, 148.4206, -2.327105, 1.360477e-2, -5.155288e-5},
+    {-0.1194975, 1.43713e-3, 1.16092e-4, -5.77905e-7, 0.0},
+    {3.47718e-5, -6.12293e-6, 5.2787e-8, 0.0, 0.0}
+};
+
+static const double svan_s[3][4] = {
+    {54.6746, -0.603459, 1.09987e-2, -6.1670e-5},
+    {2.2838e-3, -1.0981e-5, -1.6078e-6, 0.0},
+    {-9.9348e-7, 2.0816e-8, 9.1697e-10, 0.0}
+};
+
+static const double svan_sr[2][3] = {
+    {7.944e-2, 1.6483e-2, -5.3009e-4},
+    {1.91075e-4, 0.0, 0.0}
+};
+
+static const double cpsw_k[4][5] = {
+    {4217.4, -3.720283, 0.1412855, -2.654387e-3, 2.093236e-5},
+    {-0.49592, 1.45747e-2, -3.13885e-4, 2.0357e-6, 1.7168e-8},
+    {2.4931e-4, -1.08645e-5, 2.87533e-7, -4.0027e-9, 2.2956e-11},
+    {-5.422e-8, 2.6380e-9, -6.5637e-11, 6.136e-13, 0.0}
+};
+
+static const double cpsw_s[4][5] = {
+    {-7.643575, 0.1072763, -1.38385e-3, 0.0, 0.0},
+    {4.9247e-3, -1.28315e-4, 9.802e-7, 2.5941e-8, -2.9179e-10},
+    {-2.9558e-6, 1.17054e-7, -2.3905e-9, 1.8448e-11, 0.0},
+    {5.540e-10, -1.7682e-11, 3.513e-13, 0.0, 0.0}
+};
+
+static const double cpsw_sr[4][3] = {
+    {0.1770383, -4.07718e-3, 5.148e-5},
+    {-1.2331e-4, -1.517e-6, 3.122e-8},
+    {9.971e-8, 0.0, 0.0},
+    {0.0, -1.4300e-12, 0.0}
+};
+
+static const double atg_k[3][4] = {
+    {3.5803e-5, 8.5258e-6, -6.836e-8, 6.6228e-10},
+    {1.8741e-8, -6.7795e-10, 8.733e-12, -5.4481e-14},
+    {-4.6206e-13, 1.8676e-14, -2.1687e-16, 0.0}
+};
+
+static const double atg_s[2][2] = {
+    {1.8932e-6, -4.2393e-8},
+    {-1.1351e-10, 2.7759e-12}
+};
+
+/* fold -- evaluate at p the rows polynomials of c, each of columns
+ * coefficients, into out. */
+static void fold(double *out, const double *c, int rows, int columns,
+                 double p)
+{
+    int i, j;
+
+    for (j = 0; j < columns; j++) {
+        out[j] = c[(rows - 1) * columns + j];
+        for (i = rows - 2; i >= 0; i--)
+            out[j] = out[j] * p + c[i * columns + j];
+    }
+}
+
+/* oceanography_level_init -- set the terms of level for pressure.
+ *
+ * Units: pressure in decibars.
+ */
+
+void oceanography_level_init(struct oceanography_level *level,
+                             double pressure)
+{
+    double p, k35, pk;
+
+    p = pressure / 10.0;
+    level->pressure = pressure;
+
+    fold(level->sound_speed, sound_speed_c[0], 4, 6, p);
+    fold(level->sound_speed + 6, sound_speed_a[0], 4, 5, p);
+    fold(level->sound_speed + 11, sound_speed_b[0], 2, 2, p);
+    fold(level->sound_speed + 13, sound_speed_d[0], 2, 1, p);
+
+    fold(level->svan, svan_k[0], 3, 5, p);
+    fold(level->svan + 5, svan_s[0], 3, 4, p);
+    fold(level->svan + 9, svan_sr[0], 2, 3, p);
+    k35 = (5.03217e-5 * p + 3.359406) * p + 21582.27;
+    pk = 1.0 - p / k35;
+    level->svan[12] = p;
+    level->svan[13] = k35;
+    level->svan[14] = pk;
+    level->svan[15] = (1.0 / 1028.1063) * pk;
+    level->svan[16] = (p / k35) / level->svan[15];
+
+    fold(level->cpsw, cpsw_k[0], 4, 5, p);
+    fold(level->cpsw + 5, cpsw_s[0], 4, 5, p);
+    fold(level->cpsw + 10, cpsw_sr[0], 4, 3, p);
+
+    fold(level->atg, atg_k[0], 3, 4, pressure);
+    fold(level->atg + 4, atg_s[0], 2, 2, pressure);
+
+    level->conductivity = C(pressure);
+}
+
+/* salinity_level_n -- convert n conductivity ratios at the pressure of level
+ * to salinity.
+ *
+ * Units are the same of salinity().
+ */
+
+void salinity_level_n(const struct oceanography_level *level,
+                      const double *conductivity, const double *temperature,
+                      double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+    simd_select()->salinity_level(level, conductivity, temperature, out, n);
+    STATS_END(n, conductivity, 1, temperature, 1, &level->pressure, 0);
+}
+
+/* conductivity_level_n -- convert n salinities at the pressure of level to
+ * conductivity ratio.
+ *
+ * Units are the same of conductivity().
+ */
+
+void conductivity_level_n(const struct oceanography_level *level,
+                          const double *salinity, const double *temperature,
+                          double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    simd_select()->conductivity_level(level, salinity, temperature, out,
+                                      STATS_HISTOGRAM(), n);
+    STATS_END(n, salinity, 1, temperature, 1, &level->pressure, 0);
+}
+
+/* specific_volume_anomaly_level_n -- compute n specific volume anomalies at
+ * the pressure of level.
+ *
+ * Units are the same of specific_volume_anomaly(). sigma can be NULL when
+ * density anomalies are not needed.
+ */
+
+void specific_volume_anomaly_level_n(const struct oceanography_level *level,
+                                     const double *salinity,
+                                     const double *temperature, double *out,
+                                     double *sigma, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY);
+    simd_select()->specific_volume_anomaly_level(level, salinity,
+                                                 temperature, out, sigma, n);
+    STATS_END(n, salinity, 1, temperature, 1, &level->pressure, 0);
+}
+
+/* freezing_point_level_n -- compute n freezing points of seawater at the
+ * pressure of level.
+ *
+ * Units are the same of freezing_point().
+ */
+
+void freezing_point_level_n(const struct oceanography_level *level,
+                            const double *salinity, double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_FREEZING_POINT);
+    simd_select()->freezing_point_level(level, salinity, out, n);
+    STATS_END(n, salinity, 1, &level->pressure, 0, NULL, 0);
+}
+
+/* specific_heat_level_n -- compute n specific heats of seawater at the
+ * pressure of level.
+ *
+ * Units are the same of specific_heat().
+ */
+
+void specific_heat_level_n(const struct oceanography_level *level,
+                           const double *salinity, const double *temperature,
+                           double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_HEAT);
+    simd_select()->specific_heat_level(level, salinity, temperature, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, &level->pressure, 0);
+}
+
+/* adiabatic_temperature_gradient_level_n -- compute n adiabatic temperature
+ * gradients at the pressure of level.
+ *
+ * Units are the same of adiabatic_temperature_gradient().
+ */
+
+void adiabatic_temperature_gradient_level_n(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT);
+    simd_select()->adiabatic_temperature_gradient_level(level, salinity,
+                                                        temperature, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, &level->pressure, 0);
+}
+
+/* sound_speed_level_n -- compute n sound speeds at the pressure of level.
+ *
+ * Units are the same of sound_speed().
+ */
+
+void sound_speed_level_n(const struct oceanography_level *level,
+                         const double *salinity, const double *temperature,
+                         double *out, size_t n)
+{
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SOUND_SPEED);
+    simd_select()->sound_speed_level(level, salinity, temperature, out, n);
+    STATS_END(n, salinity, 1, temperature, 1, &level->pressure, 0);
+}
@@ -25,33 +25,14 @@
  *
  * All the original variable names used in the paper are maintained, so for a
  * deep explaination you can see there.
+ *
+ * The bodies of the functions live in kernels.h, where they are shared with
+ * the batch functions of batch.c.
  */
 
-#include <math.h>
-
 #include "oceanography.h"
-
-#define A(xt) (-3.107E-3 * (xt) + 0.4215)
-#define B(xt) ((4.464e-4 * (xt) + 3.426e-2) * (xt) + 1.0)
-#define C(xp) (((3.989e-15 * (xp) - 6.370e-10) * (xp) + 2.070e-5) * (xp))
-#define RT35(xt) ((((1.0031e-9 * (xt) - 6.9698e-7) * (xt) + 1.104259e-4) \
-                  * (xt) + 2.00564e-2) * (xt) + 0.6766097)
-
-static double _sal(double xr, double xt)
-{
-    return ((((2.7081 * xr - 7.0261) * xr + 14.0941) * xr + 25.3851)
-            * xr - 0.1692) * xr + 0.0080 + (xt / (1.0 + 0.0162 * xt)) *
-           (((((-0.0144 * xr + 0.0636) * xr - 0.0375) * xr - 0.0066)
-            * xr -0.0056) * xr + 0.0005);
-}
-
-static double _dsal(double xr, double xt)
-{
-    return ((((13.5405 * xr - 28.1044) * xr + 42.2823) * xr + 50.7702)
-            * xr - 0.1692) + ( xt / (1.0 + 0.0162 * xt)) *
-           ((((-0.0720 * xr + 0.2544) * xr -0.1125) * xr - 0.0132)
-            * xr -0.0056);
-}
+#include "kernels.h"
+#include "stats.h"
 
 /* salinity -- convert conductivity ratio to salinity.
  *
@@ -64,18 +45,14 @@ static double _dsal(double xr, double xt)
 
 double salinity(double conductivity, double temperature, double pressure)
 {
-    double corrected_temperature, rt;
-    corrected_temperature = temperature - 15.0;
-
-    if (conductivity <= 5e-4)
-        return 0.0;
+    double out;
+    STATS_CALL;
 
-    rt = conductivity / (RT35(temperature) * (1.0 + C(pressure) /
-                                              (B(temperature) + A(temperature)
-                                              * conductivity)));
-    rt = sqrt(fabs(rt));
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+    out = _salinity(conductivity, temperature, pressure);
+    STATS_END(1, &conductivity, 0, &temperature, 0, &pressure, 0);
 
-    return _sal(rt, corrected_temperature);
+    return out;
 }
 
 /* conductivity -- convert salinity to conductivity ratio.
@@ -88,29 +65,17 @@ double salinity(double conductivity, double temperature, double pressure)
 
 double conductivity(double salinity, double temperature, double pressure)
 {
-    double corrected_temperature, rt, si, dels, rtt, cp, bt, r;
-    int n = 0;
-    corrected_temperature = temperature - 15.0;
-
-    if (salinity <= 0.02)
-        return 0.0;
-
-    rt = sqrt(salinity / 35.0);
-    si = _sal(rt, corrected_temperature);
+    double out;
+    int iterations;
+    STATS_CALL;
 
-    do {
-        rt = rt + (salinity - si) / _dsal(rt, corrected_temperature);
-        si = _sal(rt, corrected_temperature);
-        dels = fabs(si - salinity);
-        n++;
-    } while(n < 10 && dels > 1.0e-4);
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    out = _conductivity_iterations(salinity, temperature, pressure,
+                                   &iterations);
+    STATS_ITERATIONS(iterations);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
 
-    rtt = RT35(temperature) * rt * rt;
-    cp = rtt * (C(pressure) + B(temperature));
-    bt = B(temperature) - rtt * A(temperature);
-    r = sqrt(fabs(bt * bt + 4.0 * A(temperature) * cp)) - bt;
-
-    return 0.5 * r / A(temperature);
+    return out;
 }
 
 /* specific_volume_anomaly -- compute specific volume anomaly (steric anomaly).
@@ -127,59 +92,15 @@ double conductivity(double salinity, double temperature, double pressure)
 double specific_volume_anomaly(double salinity, double temperature,
                                double pressure, double *sigma)
 {
-    double sig, sr, r1, r2, r3, r4, a, b, c, d, e, a1, b1, aw, bw;
-    double ko, kw, k35, v350p, sva, gam, pk, dr35p, dk, dvan;
-
-    double r3500 = 1028.1063;
-    double dr350 = 28.106331;
-    r4 = 4.8314e-4;
-
-    pressure = pressure / 10.;
-    sr = sqrt(fabs(salinity));
-
-    r1 = ((((6.536332e-9 * temperature - 1.120083e-6) * temperature +
-          1.001685e-4) * temperature - 9.095290e-3) * temperature +
-          6.793952e-2) * temperature - 28.263737;
-    r2 = (((5.3875e-9 * temperature - 8.2467e-7) * temperature + 7.6438e-5) *
-          temperature - 4.0899e-3) * temperature + 8.24493e-1;
-    r3 = (-1.6546e-6 * temperature + 1.0227e-4) * temperature - 5.72466e-3;
-    sig = (r4 * salinity + r3 * sr + r2) * salinity + r1;
-    v350p = 1.0 / r3500;
-    sva = -sig * v350p / (r3500 + sig);
-    *sigma = sig + dr350;
-
-    if (pressure == 0.0)
-        return sva * 1.0e+8;
-
-    e = (9.1697e-10 * temperature + 2.0816e-8) * temperature - 9.9348e-7;
-    bw = (5.2787e-8 * temperature - 6.12293e-6) * temperature + 3.47718e-5;
-    b = bw + e * salinity;
-
-    d = 1.91075e-4;
-    c = (-1.6078e-6 * temperature - 1.0981e-5) * temperature + 2.2838e-3;
-    aw = ((-5.77905e-7 * temperature + 1.16092e-4) * temperature +
-          1.43713e-3) * temperature - 0.1194975;
-    a = (d * sr + c) * salinity + aw;
-
-    b1 = (-5.3009e-4 * temperature + 1.6483e-2) * temperature + 7.944e-2;
-    a1 = ((-6.1670e-5 * temperature + 1.09987e-2) * temperature - 0.603459) *
-         temperature + 54.6746;
-    kw = (((-5.155288e-5 * temperature + 1.360477e-2) * temperature -
-          2.327105) * temperature +148.4206) * temperature - 1930.06;
-    ko = (b1 * sr + a1) * salinity + kw;
-
-    dk = (b * pressure + a) * pressure + ko;
-    k35 = (5.03217e-5 * pressure + 3.359406) * pressure + 21582.27;
-    gam = pressure / k35;
-    pk = 1.0 - gam;
-    sva = sva * pk + (v350p + sva) * pressure * dk / (k35 * (k35 + dk));
-    v350p = v350p * pk;
-
-    dr35p = gam / v350p;
-    dvan = sva / (v350p * (v350p + sva));
-    *sigma = dr350 + dr35p - dvan;
-
-    return sva * 1.0e+8;
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY);
+    out = _specific_volume_anomaly(salinity, temperature, pressure,
+                                   sigma);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
 }
 
 /* depth -- compute depth from pressure using Saunders and Fofonoff's method.
@@ -193,16 +114,38 @@ double specific_volume_anomaly(double salinity, double temperature,
 
 double depth(double pressure, double latitude)
 {
-    double x, gr, depth;
+    double out;
+    STATS_CALL;
 
-    x = sin(latitude / 57.29578);
-    x = x * x;
-    gr = 9.780318 * (1.0 + (5.2788e-3 + 2.36e-5 * x) * x) + 1.092e-6 *
-         pressure;
-    depth = (((-1.82e-15 * pressure + 2.279e-10) * pressure - 2.2512e-5) *
-             pressure + 9.72659) * pressure;
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DEPTH);
+    out = _depth(pressure, latitude);
+    STATS_END(1, &pressure, 0, &latitude, 0, NULL, 0);
 
-    return depth / gr;
+    return out;
+}
+
+/* pressure_from_depth -- compute pressure from depth, inverting depth().
+ *
+ * Two Newton iterations solve the polynomial of depth() for pressure:
+ * depth() of the result gives back depth within rounding.
+ *
+ * Units:
+ *     depth -- meters
+ *     latitude -- degrees
+ *
+ * Returns pressure in decibars.
+ */
+
+double pressure_from_depth(double depth, double latitude)
+{
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_PRESSURE_FROM_DEPTH);
+    out = _pressure_from_depth(depth, latitude);
+    STATS_END(1, &depth, 0, &latitude, 0, NULL, 0);
+
+    return out;
 }
 
 /* freezing_point -- compute the freezing point of seawater.
@@ -216,8 +159,14 @@ double depth(double pressure, double latitude)
 
 double freezing_point(double salinity, double pressure)
 {
-    return (-0.0575 + 1.710523e-3 * sqrt(fabs(salinity)) - 2.154996e-4 *
-            salinity) * salinity - 7.53e-4 * pressure;
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_FREEZING_POINT);
+    out = _freezing_point(salinity, pressure);
+    STATS_END(1, &salinity, 0, &pressure, 0, NULL, 0);
+
+    return out;
 }
 
 /* specific_heat -- compute the specific heat of seawater.
@@ -232,37 +181,14 @@ double freezing_point(double salinity, double pressure)
 
 double specific_heat(double salinity, double temperature, double pressure)
 {
-    double a, b, c, cp0, cp1, cp2, sr;
-
-    pressure = pressure / 10.0;
-    sr = sqrt(fabs(salinity));
-
-    a = (-1.38385e-3 * temperature + 0.1072763) * temperature - 7.643575;
-    b = (5.148e-5 * temperature - 4.07718e-3) * temperature + 0.1770383;
-    c = (((2.093236e-5 * temperature - 2.654387e-3) * temperature +
-         0.1412855) * temperature -3.720283) * temperature + 4217.4;
-    cp0 = (b * sr + a) * salinity + c;
-
-    a = (((1.7168e-8 * temperature + 2.0357e-6) * temperature - 3.13885e-4) *
-         temperature + 1.45747e-2) * temperature - 0.49592;
-    b = (((2.2956e-11 * temperature - 4.0027e-9) * temperature + 2.87533e-7) *
-         temperature - 1.08645e-5) * temperature + 2.4931e-4;
-    c = ((6.136e-13 * temperature - 6.5637e-11) * temperature + 2.6380e-9) *
-         temperature - 5.422e-8;
-    cp1 = ((c * pressure + b) * pressure + a) * pressure;
-
-    a = (((-2.9179e-10 * temperature + 2.5941e-8) * temperature + 9.802e-7) *
-         temperature - 1.28315e-4) * temperature + 4.9247e-3;
-    b = (3.122e-8 * temperature -1.517e-6) * temperature - 1.2331e-4;
-    a = (a + b * sr) * salinity;
-    b = ((1.8448e-11 * temperature - 2.3905e-9) * temperature + 1.17054e-7) *
-        temperature - 2.9558e-6;
-    b = (b + 9.971e-8 * sr) * salinity;
-    c = (3.513e-13 * temperature - 1.7682e-11) * temperature + 5.540e-10;
-    c = (c - 1.4300e-12 * temperature * sr) * salinity;
-    cp2 = ((c * pressure + b) * pressure + a) * pressure;
-
-    return cp0 + cp1 + cp2;
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_HEAT);
+    out = _specific_heat(salinity, temperature, pressure);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
 }
 
 /* adiabatic_temperature_gradient -- compute the adiabatic temperature
@@ -279,14 +205,15 @@ double specific_heat(double salinity, double temperature, double pressure)
 double adiabatic_temperature_gradient(double salinity, double temperature,
                                       double pressure)
 {
-    salinity = salinity - 35.0;
-
-    return (((-2.1687e-16 * temperature + 1.8676e-14) * temperature -
-            4.6206e-13) * pressure + ((2.7759e-12 * temperature - 1.1351e-10) *
-            salinity + ((-5.4481e-14 * temperature + 8.733e-12) * temperature -
-            6.7795e-10) * temperature + 1.8741e-8)) * pressure + (-4.2393e-8 *
-            temperature + 1.8932e-6) * salinity + ((6.6228e-10 * temperature -
-            6.836e-8) * temperature + 8.5258e-6) * temperature + 3.5803e-5;
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT);
+    out = _adiabatic_temperature_gradient(salinity, temperature,
+                                          pressure);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
 }
 
 /* potential_temperature -- compute the local potential temperature at
@@ -304,23 +231,43 @@ double adiabatic_temperature_gradient(double salinity, double temperature,
 double potential_temperature(double salinity, double temperature,
                              double pressure, double reference_pressure)
 {
-    double h, xk, q;
-
-    h = reference_pressure - pressure;
-    xk = h * adiabatic_temperature_gradient(salinity, temperature, pressure);
-    temperature += 0.5 * xk;
-    q = xk;
-    pressure += 0.5 * h;
-    xk = h * adiabatic_temperature_gradient(salinity, temperature, pressure);
-    temperature += 0.29289322 * (xk - q);
-    q = 0.58578644 * xk + 0.121320344 * q;
-    xk = h * adiabatic_temperature_gradient(salinity, temperature, pressure);
-    temperature += 1.707106781 * (xk - q);
-    q = 3.414213562 * xk - 4.121320344 * q;
-    pressure += 0.5 * h;
-    xk = h * adiabatic_temperature_gradient(salinity, temperature, pressure);
-
-    return temperature + (xk - 2.0 * q) / 0.6;
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE);
+    out = _potential_temperature(salinity, temperature, pressure,
+                                 reference_pressure);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* in_situ_temperature -- compute the temperature at pressure from the
+ * potential temperature at reference pressure.
+ *
+ * This is the inverse of potential_temperature(), within 1.0e-12 degrees.
+ *
+ * Units:
+ *     salinity -- PSS-78
+ *     potential_temperature -- degrees Celsius
+ *     pressure  -- decibars
+ *     reference_pressure  -- decibars
+ *
+ * Returns in situ temperature in degrees Celsius.
+ */
+
+double in_situ_temperature(double salinity, double potential_temperature,
+                           double pressure, double reference_pressure)
+{
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_IN_SITU_TEMPERATURE);
+    out = _in_situ_temperature(salinity, potential_temperature, pressure,
+                               reference_pressure);
+    STATS_END(1, &salinity, 0, &potential_temperature, 0, &pressure, 0);
+
+    return out;
 }
 
 /* sound_speed -- compute the speed of sound in seawater by Chen and Millero.
@@ -335,36 +282,169 @@ double potential_temperature(double salinity, double temperature,
 
 double sound_speed(double salinity, double temperature, double pressure)
 {
-    double a, a0, a1, a2, a3, b, b0, b1, c, c0, c1, c2, c3, d, sr;
-
-    pressure = pressure / 10.0;
-    sr = sqrt(fabs(salinity));
-
-    d = 1.727e-3 - 7.9836e-6 * pressure;
-
-    b1 = 7.3637e-5 + 1.7945e-7 * temperature;
-    b0 = -1.922e-2 - 4.42e-5 * temperature;
-    b = b0 + b1 * pressure;
-
-    a3 = (-3.389e-13 * temperature + 6.649e-12) * temperature + 1.100e-10;
-    a2 = ((7.988e-12 * temperature - 1.6002e-10) * temperature + 9.1041e-9) *
-         temperature - 3.9064e-7;
-
-    a1 = (((-2.0122e-10 * temperature + 1.0507e-8) * temperature - 6.4885e-8) *
-          temperature - 1.2580e-5) * temperature + 9.4742e-5;
-    a0 = (((-3.21e-8 * temperature + 2.006e-6) * temperature + 7.164e-5) *
-          temperature - 1.262e-2) * temperature + 1.389;
-    a = ((a3 * pressure + a2) * pressure + a1) * pressure + a0;
-
-    c3 = (-2.3643e-12 * temperature + 3.8504e-10) * temperature - 9.7729e-9;
-    c2 = (((1.0405e-12 * temperature - 2.5335e-10) * temperature + 2.5974e-8) *
-          temperature - 1.7107e-6) * temperature + 3.1260e-5;
-    c1 = (((-6.1185e-10 * temperature + 1.3621e-7) * temperature - 8.1788e-6) *
-          temperature + 6.8982e-4) * temperature + 0.153563;
-    c0 = ((((3.1464e-9 * temperature - 1.47800e-6) * temperature + 3.3420e-4) *
-          temperature - 5.80852e-2) * temperature + 5.03711) * temperature +
-          1402.388;
-    c = ((c3 * pressure + c2) * pressure + c1) * pressure + c0;
-
-    return c + (a + b * sr + d * salinity) * salinity;
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SOUND_SPEED);
+    out = _sound_speed(salinity, temperature, pressure);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* density_derivatives -- compute in situ density with its analytic partial
+ * derivatives, in a single evaluation of the equation of state.
+ *
+ * alpha is the thermal expansion coefficient -1/rho * drho/dT, at constant
+ * in situ temperature and pressure, beta the haline contraction coefficient
+ * 1/rho * drho/dS and kappa the isothermal compressibility 1/rho * drho/dp.
+ * kappa can be NULL when not needed.
+ *
+ * Units:
+ *     salinity -- PSS-78
+ *     temperature -- degrees Celsius
+ *     pressure  -- decibars
+ *     alpha -- 1/degrees Celsius
+ *     beta -- 1/PSS-78
+ *     kappa -- 1/decibars
+ *
+ * Returns density anomaly (density minus 1000 Kg/m^3) as Kg/m^3: the sigma of
+ * specific_volume_anomaly(), within rounding.
+ */
+
+double density_derivatives(double salinity, double temperature,
+                           double pressure, double *alpha, double *beta,
+                           double *kappa)
+{
+    double out, k;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DENSITY_DERIVATIVES);
+    out = _density_derivatives(salinity, temperature, pressure, alpha, beta,
+                               &k);
+    if (kappa != NULL)
+        *kappa = k;
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* density -- compute in situ density anomaly, without the specific volume
+ * anomaly.
+ *
+ * The equation of state is the one of specific_volume_anomaly(), evaluated
+ * as density_derivatives() without the derivatives.
+ *
+ * Units:
+ *     salinity -- PSS-78
+ *     temperature -- degrees Celsius
+ *     pressure  -- decibars
+ *
+ * Returns density anomaly (density minus 1000 Kg/m^3) as Kg/m^3: the sigma of
+ * specific_volume_anomaly(), within rounding, and the one of
+ * density_derivatives().
+ */
+
+double density(double salinity, double temperature, double pressure)
+{
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DENSITY);
+    out = _density(salinity, temperature, pressure);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* potential_density -- compute potential density anomaly at reference
+ * pressure.
+ *
+ * The density anomaly of the local potential temperature at reference
+ * pressure, at reference pressure: sigma-theta for a reference pressure of
+ * 0, sigma-2 for 2000 decibars.
+ *
+ * Units:
+ *     salinity -- PSS-78
+ *     temperature -- degrees Celsius
+ *     pressure  -- decibars
+ *     reference_pressure -- decibars
+ *
+ * Returns potential density anomaly as Kg/m^3.
+ */
+
+double potential_density(double salinity, double temperature,
+                         double pressure, double reference_pressure)
+{
+    double out;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_DENSITY);
+    out = _potential_density(salinity, temperature, pressure,
+                             reference_pressure);
+    STATS_END(1, &salinity, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* salinity_from_density -- compute salinity from density anomaly, inverting
+ * density().
+ *
+ * Newton iterations on the equation of state, with the haline contraction
+ * coefficient of density_derivatives() as derivative, land within rounding
+ * in at most OCEANOGRAPHY_INVERSE_ITERATIONS. If residual is not NULL, it
+ * receives density() of the result minus sigma.
+ *
+ * Units:
+ *     sigma -- density anomaly (density minus 1000 Kg/m^3) as Kg/m^3
+ *     temperature -- degrees Celsius
+ *     pressure  -- decibars
+ *
+ * Returns salinity as PSS-78.
+ */
+
+double salinity_from_density(double sigma, double temperature,
+                             double pressure, double *residual)
+{
+    double out, r;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY_FROM_DENSITY);
+    out = _salinity_from_density(sigma, temperature, pressure, &r);
+    if (residual != NULL)
+        *residual = r;
+    STATS_END(1, &sigma, 0, &temperature, 0, &pressure, 0);
+
+    return out;
+}
+
+/* temperature_from_sound_speed -- compute temperature from sound speed,
+ * inverting sound_speed().
+ *
+ * Newton iterations on the polynomial of sound_speed(), from a first guess
+ * within 0.7 degrees Celsius over the ocean range, land within rounding in
+ * at most OCEANOGRAPHY_INVERSE_ITERATIONS. If residual is not NULL, it
+ * receives sound_speed() of the result minus sound_speed.
+ *
+ * Units:
+ *     sound_speed -- meters/second
+ *     salinity -- PSS-78
+ *     pressure  -- decibars
+ *
+ * Returns temperature in degrees Celsius.
+ */
+
+double temperature_from_sound_speed(double sound_speed, double salinity,
+                                    double pressure, double *residual)
+{
+    double out, r;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_TEMPERATURE_FROM_SOUND_SPEED);
+    out = _temperature_from_sound_speed(sound_speed, salinity, pressure, &r);
+    if (residual != NULL)
+        *residual = r;
+    STATS_END(1, &sound_speed, 0, &salinity, 0, &pressure, 0);
+
+    return out;
 }
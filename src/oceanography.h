@@ -23,6 +23,8 @@
 #ifndef OCEANOGRAPHY_H
 #define OCEANOGRAPHY_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -44,7 +46,28 @@ double adiabatic_temperature_gradient(double salinity, double temperature,
                                       double pressure);
 double potential_temperature(double salinity, double temperature,
                              double pressure, double reference_pressure);
+double in_situ_temperature(double salinity, double potential_temperature,
+                           double pressure, double reference_pressure);
 double sound_speed(double salinity, double temperature, double pressure);
+double density_derivatives(double salinity, double temperature,
+                           double pressure, double *alpha, double *beta,
+                           double *kappa);
+double density(double salinity, double temperature, double pressure);
+double potential_density(double salinity, double temperature,
+                         double pressure, double reference_pressure);
+double pressure_from_depth(double depth, double latitude);
+double salinity_from_density(double sigma, double temperature,
+                             double pressure, double *residual);
+double temperature_from_sound_speed(double sound_speed, double salinity,
+                                    double pressure, double *residual);
+
+/* Maximum number of Newton iterations of conductivity(). */
+#define OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS 10
+/* Secant steps of in_situ_temperature(), after the first guess. */
+#define OCEANOGRAPHY_IN_SITU_ITERATIONS 2
+/* Maximum number of Newton iterations of salinity_from_density() and
+ * temperature_from_sound_speed(). */
+#define OCEANOGRAPHY_INVERSE_ITERATIONS 8
 
 #define svan(salinity, temperature, pressure, sigma) \
         specific_volume_anomaly(salinity, temperature, pressure, sigma)
@@ -56,6 +79,790 @@ double sound_speed(double salinity, double temperature, double pressure);
 #define cpsw(salinity, temperature, pressure) \
              specific_heat(salinity, temperature, pressure)
 
+/* Batch functions.
+ *
+ * The *_n functions compute n samples from contiguous arrays. The *_strided
+ * functions take a stride, counted in elements, for every array: a stride
+ * greater than 1 walks interleaved records, a stride of 0 repeats the same
+ * value for all the samples. Results are identical to the scalar functions.
+ */
+
+void salinity_n(const double *conductivity, const double *temperature,
+                const double *pressure, double *out, size_t n);
+void conductivity_n(const double *salinity, const double *temperature,
+                    const double *pressure, double *out, size_t n);
+void conductivity_histogram_n(const double *salinity,
+                              const double *temperature,
+                              const double *pressure, double *out,
+                              unsigned long *histogram, size_t n);
+void specific_volume_anomaly_n(const double *salinity,
+                               const double *temperature,
+                               const double *pressure, double *out,
+                               double *sigma, size_t n);
+void depth_n(const double *pressure, const double *latitude, double *out,
+             size_t n);
+void freezing_point_n(const double *salinity, const double *pressure,
+                      double *out, size_t n);
+void specific_heat_n(const double *salinity, const double *temperature,
+                     const double *pressure, double *out, size_t n);
+void adiabatic_temperature_gradient_n(const double *salinity,
+                                      const double *temperature,
+                                      const double *pressure, double *out,
+                                      size_t n);
+void potential_temperature_n(const double *salinity,
+                             const double *temperature,
+                             const double *pressure,
+                             const double *reference_pressure, double *out,
+                             size_t n);
+void potential_temperature_multi_n(const double *salinity,
+                                   const double *temperature,
+                                   const double *pressure,
+                                   const double *reference_pressure,
+                                   size_t references, double *const *out,
+                                   size_t n);
+void in_situ_temperature_n(const double *salinity,
+                           const double *potential_temperature,
+                           const double *pressure,
+                           const double *reference_pressure, double *out,
+                           size_t n);
+void sound_speed_n(const double *salinity, const double *temperature,
+                   const double *pressure, double *out, size_t n);
+void density_derivatives_n(const double *salinity, const double *temperature,
+                           const double *pressure, double *sigma,
+                           double *alpha, double *beta, double *kappa,
+                           size_t n);
+void density_n(const double *salinity, const double *temperature,
+               const double *pressure, double *out, size_t n);
+void potential_density_n(const double *salinity, const double *temperature,
+                         const double *pressure,
+                         const double *reference_pressure, double *out,
+                         size_t n);
+void potential_density_multi_n(const double *salinity,
+                               const double *temperature,
+                               const double *pressure,
+                               const double *reference_pressure,
+                               size_t references, double *sigma,
+                               double *const *out, size_t n);
+void pressure_from_depth_n(const double *depth, const double *latitude,
+                           double *out, size_t n);
+void salinity_from_density_n(const double *sigma, const double *temperature,
+                             const double *pressure, double *out,
+                             double *residual, size_t n);
+void temperature_from_sound_speed_n(const double *sound_speed,
+                                    const double *salinity,
+                                    const double *pressure, double *out,
+                                    double *residual, size_t n);
+
+void salinity_strided(const double *conductivity, size_t conductivity_stride,
+                      const double *temperature, size_t temperature_stride,
+                      const double *pressure, size_t pressure_stride,
+                      double *out, size_t out_stride, size_t n);
+void conductivity_strided(const double *salinity, size_t salinity_stride,
+                          const double *temperature, size_t temperature_stride,
+                          const double *pressure, size_t pressure_stride,
+                          double *out, size_t out_stride, size_t n);
+void specific_volume_anomaly_strided(const double *salinity,
+                                     size_t salinity_stride,
+                                     const double *temperature,
+                                     size_t temperature_stride,
+                                     const double *pressure,
+                                     size_t pressure_stride,
+                                     double *out, size_t out_stride,
+                                     double *sigma, size_t sigma_stride,
+                                     size_t n);
+void depth_strided(const double *pressure, size_t pressure_stride,
+                   const double *latitude, size_t latitude_stride,
+                   double *out, size_t out_stride, size_t n);
+void freezing_point_strided(const double *salinity, size_t salinity_stride,
+                            const double *pressure, size_t pressure_stride,
+                            double *out, size_t out_stride, size_t n);
+void specific_heat_strided(const double *salinity, size_t salinity_stride,
+                           const double *temperature,
+                           size_t temperature_stride,
+                           const double *pressure, size_t pressure_stride,
+                           double *out, size_t out_stride, size_t n);
+void adiabatic_temperature_gradient_strided(const double *salinity,
+                                            size_t salinity_stride,
+                                            const double *temperature,
+                                            size_t temperature_stride,
+                                            const double *pressure,
+                                            size_t pressure_stride,
+                                            double *out, size_t out_stride,
+                                            size_t n);
+void potential_temperature_strided(const double *salinity,
+                                   size_t salinity_stride,
+                                   const double *temperature,
+                                   size_t temperature_stride,
+                                   const double *pressure,
+                                   size_t pressure_stride,
+                                   const double *reference_pressure,
+                                   size_t reference_pressure_stride,
+                                   double *out, size_t out_stride, size_t n);
+void in_situ_temperature_strided(const double *salinity,
+                                 size_t salinity_stride,
+                                 const double *potential_temperature,
+                                 size_t potential_temperature_stride,
+                                 const double *pressure,
+                                 size_t pressure_stride,
+                                 const double *reference_pressure,
+                                 size_t reference_pressure_stride,
+                                 double *out, size_t out_stride, size_t n);
+void sound_speed_strided(const double *salinity, size_t salinity_stride,
+                         const double *temperature, size_t temperature_stride,
+                         const double *pressure, size_t pressure_stride,
+                         double *out, size_t out_stride, size_t n);
+void density_strided(const double *salinity, size_t salinity_stride,
+                     const double *temperature, size_t temperature_stride,
+                     const double *pressure, size_t pressure_stride,
+                     double *out, size_t out_stride, size_t n);
+void potential_density_strided(const double *salinity,
+                               size_t salinity_stride,
+                               const double *temperature,
+                               size_t temperature_stride,
+                               const double *pressure,
+                               size_t pressure_stride,
+                               const double *reference_pressure,
+                               size_t reference_pressure_stride,
+                               double *out, size_t out_stride, size_t n);
+void pressure_from_depth_strided(const double *depth, size_t depth_stride,
+                                 const double *latitude,
+                                 size_t latitude_stride, double *out,
+                                 size_t out_stride, size_t n);
+
+/* Single precision functions.
+ *
+ * The *_f functions compute in float: the vectorized kernels hold twice as
+ * many samples per register as in double. The scalar and the batch functions
+ * give identical results on every instruction set; the maximum deviations
+ * from the double functions are in the function reference.
+ */
+
+float salinity_f(float conductivity, float temperature, float pressure);
+float conductivity_f(float salinity, float temperature, float pressure);
+float specific_volume_anomaly_f(float salinity, float temperature,
+                                float pressure, float *sigma);
+float depth_f(float pressure, float latitude);
+float freezing_point_f(float salinity, float pressure);
+float specific_heat_f(float salinity, float temperature, float pressure);
+float adiabatic_temperature_gradient_f(float salinity, float temperature,
+                                       float pressure);
+float potential_temperature_f(float salinity, float temperature,
+                              float pressure, float reference_pressure);
+float in_situ_temperature_f(float salinity, float potential_temperature,
+                            float pressure, float reference_pressure);
+float sound_speed_f(float salinity, float temperature, float pressure);
+
+void salinity_n_f(const float *conductivity, const float *temperature,
+                  const float *pressure, float *out, size_t n);
+void conductivity_n_f(const float *salinity, const float *temperature,
+                      const float *pressure, float *out, size_t n);
+void specific_volume_anomaly_n_f(const float *salinity,
+                                 const float *temperature,
+                                 const float *pressure, float *out,
+                                 float *sigma, size_t n);
+void depth_n_f(const float *pressure, const float *latitude, float *out,
+               size_t n);
+void freezing_point_n_f(const float *salinity, const float *pressure,
+                        float *out, size_t n);
+void specific_heat_n_f(const float *salinity, const float *temperature,
+                       const float *pressure, float *out, size_t n);
+void adiabatic_temperature_gradient_n_f(const float *salinity,
+                                        const float *temperature,
+                                        const float *pressure, float *out,
+                                        size_t n);
+void potential_temperature_n_f(const float *salinity,
+                               const float *temperature,
+                               const float *pressure,
+                               const float *reference_pressure, float *out,
+                               size_t n);
+void in_situ_temperature_n_f(const float *salinity,
+                             const float *potential_temperature,
+                             const float *pressure,
+                             const float *reference_pressure, float *out,
+                             size_t n);
+void sound_speed_n_f(const float *salinity, const float *temperature,
+                     const float *pressure, float *out, size_t n);
+
+#define svan_f(salinity, temperature, pressure, sigma) \
+        specific_volume_anomaly_f(salinity, temperature, pressure, sigma)
+#define atg_f(salinity, temperature, pressure) \
+        adiabatic_temperature_gradient_f(salinity, temperature, pressure)
+#define theta_f(salinity, temperature, pressure, reference_pressure) \
+        potential_temperature_f(salinity, temperature, pressure, \
+                                reference_pressure)
+#define cpsw_f(salinity, temperature, pressure) \
+        specific_heat_f(salinity, temperature, pressure)
+#define svan_n_f(salinity, temperature, pressure, out, sigma, n) \
+        specific_volume_anomaly_n_f(salinity, temperature, pressure, out, \
+                                    sigma, n)
+#define atg_n_f(salinity, temperature, pressure, out, n) \
+        adiabatic_temperature_gradient_n_f(salinity, temperature, pressure, \
+                                           out, n)
+#define theta_n_f(salinity, temperature, pressure, reference_pressure, out, \
+                  n) \
+        potential_temperature_n_f(salinity, temperature, pressure, \
+                                  reference_pressure, out, n)
+#define cpsw_n_f(salinity, temperature, pressure, out, n) \
+        specific_heat_n_f(salinity, temperature, pressure, out, n)
+
+/* Fused CTD pipeline.
+ *
+ * ctd_derive_n() computes the outputs selected by a mask of
+ * OCEANOGRAPHY_CTD_* flags from conductivity ratio, temperature and pressure,
+ * in a single pass. Only the arrays of the selected outputs are used.
+ */
+
+#define OCEANOGRAPHY_CTD_SALINITY       0x001
+#define OCEANOGRAPHY_CTD_SVAN           0x002
+#define OCEANOGRAPHY_CTD_SIGMA          0x004
+#define OCEANOGRAPHY_CTD_THETA          0x008
+#define OCEANOGRAPHY_CTD_SOUND_SPEED    0x010
+#define OCEANOGRAPHY_CTD_DEPTH          0x020
+#define OCEANOGRAPHY_CTD_CPSW           0x040
+#define OCEANOGRAPHY_CTD_FREEZING_POINT 0x080
+#define OCEANOGRAPHY_CTD_ATG            0x100
+
+struct ctd_outputs {
+    double *salinity;
+    double *svan;
+    double *sigma;
+    double *theta;
+    double *sound_speed;
+    double *depth;
+    double *cpsw;
+    double *freezing_point;
+    double *atg;
+};
+
+void ctd_derive_n(const double *conductivity, const double *temperature,
+                  const double *pressure, double latitude,
+                  double reference_pressure, unsigned int outputs,
+                  const struct ctd_outputs *out, size_t n);
+
+/* Summaries.
+ *
+ * A struct oceanography_summary accumulates the count, mean, variance,
+ * minimum, maximum and an optional histogram of a quantity, without keeping
+ * its samples; summaries of different threads can be merged.
+ * ctd_summarize_n() computes the outputs of ctd_derive_n() a block at a time
+ * and adds them to the summaries, without writing them to memory.
+ */
+
+struct oceanography_summary {
+    unsigned long count;                /* samples, NaN excluded */
+    double mean;
+    double m2;                          /* sum of squared deviations */
+    double min;
+    double max;
+    unsigned long *histogram;           /* bins counts, or NULL */
+    size_t bins;
+    double histogram_min;
+    double histogram_scale;             /* bins per unit */
+    unsigned long below;                /* samples below the histogram */
+    unsigned long above;                /* samples above the histogram */
+};
+
+struct ctd_summaries {
+    struct oceanography_summary *salinity;
+    struct oceanography_summary *svan;
+    struct oceanography_summary *sigma;
+    struct oceanography_summary *theta;
+    struct oceanography_summary *sound_speed;
+    struct oceanography_summary *depth;
+    struct oceanography_summary *cpsw;
+    struct oceanography_summary *freezing_point;
+    struct oceanography_summary *atg;
+};
+
+void oceanography_summary_init(struct oceanography_summary *summary,
+                               unsigned long *histogram, size_t bins,
+                               double min, double max);
+void oceanography_summary_add_n(struct oceanography_summary *summary,
+                                const double *x, size_t n);
+void oceanography_summary_merge(struct oceanography_summary *summary,
+                                const struct oceanography_summary *other);
+double oceanography_summary_variance(
+    const struct oceanography_summary *summary);
+void ctd_summarize_n(const double *conductivity, const double *temperature,
+                     const double *pressure, double latitude,
+                     double reference_pressure, unsigned int outputs,
+                     const struct ctd_summaries *out, size_t n);
+
+/* Batch functions on a pressure level.
+ *
+ * The fields of struct oceanography_level are the terms of the functions
+ * that depend on pressure only: set them with oceanography_level_init(). The
+ * *_level_n functions compute n samples at that pressure.
+ */
+
+struct oceanography_level {
+    double pressure;
+    double sound_speed[14];
+    double svan[17];
+    double cpsw[13];
+    double atg[6];
+    double conductivity;
+};
+
+void oceanography_level_init(struct oceanography_level *level,
+                             double pressure);
+void salinity_level_n(const struct oceanography_level *level,
+                      const double *conductivity, const double *temperature,
+                      double *out, size_t n);
+void conductivity_level_n(const struct oceanography_level *level,
+                          const double *salinity, const double *temperature,
+                          double *out, size_t n);
+void specific_volume_anomaly_level_n(const struct oceanography_level *level,
+                                     const double *salinity,
+                                     const double *temperature, double *out,
+                                     double *sigma, size_t n);
+void freezing_point_level_n(const struct oceanography_level *level,
+                            const double *salinity, double *out, size_t n);
+void specific_heat_level_n(const struct oceanography_level *level,
+                           const double *salinity, const double *temperature,
+                           double *out, size_t n);
+void adiabatic_temperature_gradient_level_n(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, size_t n);
+void sound_speed_level_n(const struct oceanography_level *level,
+                         const double *salinity, const double *temperature,
+                         double *out, size_t n);
+
+#define svan_level_n(level, salinity, temperature, out, sigma, n) \
+        specific_volume_anomaly_level_n(level, salinity, temperature, out, \
+                                        sigma, n)
+#define atg_level_n(level, salinity, temperature, out, n) \
+        adiabatic_temperature_gradient_level_n(level, salinity, temperature, \
+                                               out, n)
+#define cpsw_level_n(level, salinity, temperature, out, n) \
+        specific_heat_level_n(level, salinity, temperature, out, n)
+
+/* Geopotential anomaly along a profile.
+ *
+ * The fields of struct geopotential are the state of the integration: set
+ * them with geopotential_init(). A reference level deeper than the first
+ * sample is applied once a sample reaches it: the outputs of the calls
+ * before the one crossing it are relative to the first sample.
+ */
+
+struct geopotential {
+    double reference_pressure;
+    double pressure;
+    double svan;
+    double anomaly;
+    size_t count;
+    int deep;           /* reference below the samples given so far */
+};
+
+void geopotential_init(struct geopotential *state, double reference_pressure);
+void geopotential_anomaly_n(struct geopotential *state,
+                            const double *salinity, const double *temperature,
+                            const double *pressure, double *out, size_t n);
+void dynamic_height_n(struct geopotential *state, const double *salinity,
+                      const double *temperature, const double *pressure,
+                      double *out, size_t n);
+double geopotential_anomaly(const struct geopotential *state);
+
+/* Buoyancy frequency along a profile.
+ *
+ * The fields of struct buoyancy_frequency are the state of the profile: set
+ * them with buoyancy_frequency_init().
+ */
+
+struct buoyancy_frequency {
+    double gravity;
+    double salinity;
+    double temperature;
+    double pressure;
+    double depth;
+    size_t count;
+};
+
+void buoyancy_frequency_init(struct buoyancy_frequency *state,
+                             double latitude);
+size_t buoyancy_frequency_n(struct buoyancy_frequency *state,
+                            const double *salinity, const double *temperature,
+                            const double *pressure, double *out,
+                            double *out_pressure, size_t n);
+
+/* Regridding of a profile.
+ *
+ * regrid_n() interpolates columns of a profile sorted by increasing pressure
+ * to depths sorted by increasing depth, in a single sweep.
+ */
+
+void regrid_n(const double *pressure, double latitude,
+              const double *const *in, size_t columns, size_t n,
+              const double *depth, size_t levels, double fill,
+              double *const *out);
+
+/* Fast approximations from precomputed tables.
+ *
+ * A table holds piecewise polynomials approximating a function over a box of
+ * (salinity, temperature, pressure); oceanography_table_error() gives the
+ * maximum absolute error against the exact function.
+ */
+
+#define OCEANOGRAPHY_TABLE_MAX_DEGREE 7
+
+enum oceanography_table_function {
+    OCEANOGRAPHY_TABLE_SVAN
+};
+
+struct oceanography_table_spec {
+    enum oceanography_table_function function;
+    double min[3];              /* salinity, temperature, pressure */
+    double max[3];
+    unsigned int cells[3];
+    unsigned int degree[3];
+};
+
+struct oceanography_table;
+
+struct oceanography_table *oceanography_table_create(
+    const struct oceanography_table_spec *spec);
+void oceanography_table_destroy(struct oceanography_table *table);
+double oceanography_table_error(const struct oceanography_table *table);
+double oceanography_table_eval(const struct oceanography_table *table,
+                               double salinity, double temperature,
+                               double pressure);
+void oceanography_table_eval_n(const struct oceanography_table *table,
+                               const double *salinity,
+                               const double *temperature,
+                               const double *pressure, double *out, size_t n);
+size_t oceanography_table_serialize(const struct oceanography_table *table,
+                                    void *buffer, size_t size);
+struct oceanography_table *oceanography_table_deserialize(const void *buffer,
+                                                          size_t size);
+
+/* Sound velocity profiles.
+ *
+ * A profile interpolates the sound speed of a cast along depth with a
+ * monotone cubic spline, answering queries in constant time.
+ */
+
+struct oceanography_svp;
+
+struct oceanography_svp *oceanography_svp_create(const double *salinity,
+                                                 const double *temperature,
+                                                 const double *pressure,
+                                                 double latitude, size_t n);
+void oceanography_svp_destroy(struct oceanography_svp *svp);
+void oceanography_svp_range(const struct oceanography_svp *svp, double *min,
+                            double *max);
+double oceanography_svp_speed(const struct oceanography_svp *svp,
+                              double depth);
+double oceanography_svp_gradient(const struct oceanography_svp *svp,
+                                 double depth);
+void oceanography_svp_eval_n(const struct oceanography_svp *svp,
+                             const double *depth, double *speed,
+                             double *gradient, size_t n);
+
+/* Gridded fields.
+ *
+ * oceanography_grid_derive() computes the outputs selected by a mask of
+ * OCEANOGRAPHY_CTD_* flags on a longitude x latitude x level grid, from
+ * salinity, temperature and pressure. Strides are in elements; a stride of
+ * 0 repeats the same value along a dimension, as for pressure levels or the
+ * latitude of a regular grid.
+ */
+
+struct oceanography_grid {
+    size_t shape[3];            /* longitude, latitude, level */
+    size_t stride[3];           /* salinity, temperature and outputs */
+    size_t pressure_stride[3];
+    size_t latitude_stride[2];  /* longitude, latitude */
+};
+
+int oceanography_grid_derive(const struct oceanography_grid *grid,
+                             const double *salinity,
+                             const double *temperature,
+                             const double *pressure, const double *latitude,
+                             double reference_pressure, unsigned int outputs,
+                             const struct ctd_outputs *out);
+
+/* Instruction sets of the vectorized batch kernels. */
+enum oceanography_isa {
+    OCEANOGRAPHY_ISA_AUTO,
+    OCEANOGRAPHY_ISA_SCALAR,
+    OCEANOGRAPHY_ISA_SSE2,
+    OCEANOGRAPHY_ISA_AVX2,
+    OCEANOGRAPHY_ISA_AVX512
+};
+
+int oceanography_set_isa(enum oceanography_isa isa);
+enum oceanography_isa oceanography_get_isa(void);
+int oceanography_isa_supported(enum oceanography_isa isa);
+const char *oceanography_isa_name(enum oceanography_isa isa);
+
+/* Parallel batch functions.
+ *
+ * The *_parallel functions split the work of the *_n functions among the
+ * threads of a pool. With a NULL pool the default one is used, with the
+ * number of threads set by oceanography_set_threads().
+ */
+
+struct oceanography_pool;
+
+struct oceanography_pool *oceanography_pool_create(unsigned int threads);
+void oceanography_pool_destroy(struct oceanography_pool *pool);
+unsigned int oceanography_pool_threads(const struct oceanography_pool *pool);
+int oceanography_set_threads(unsigned int threads);
+
+void salinity_parallel(struct oceanography_pool *pool,
+                       const double *conductivity, const double *temperature,
+                       const double *pressure, double *out, size_t n);
+void conductivity_parallel(struct oceanography_pool *pool,
+                           const double *salinity, const double *temperature,
+                           const double *pressure, double *out, size_t n);
+void specific_volume_anomaly_parallel(struct oceanography_pool *pool,
+                                      const double *salinity,
+                                      const double *temperature,
+                                      const double *pressure, double *out,
+                                      double *sigma, size_t n);
+void depth_parallel(struct oceanography_pool *pool, const double *pressure,
+                    const double *latitude, double *out, size_t n);
+void freezing_point_parallel(struct oceanography_pool *pool,
+                             const double *salinity, const double *pressure,
+                             double *out, size_t n);
+void specific_heat_parallel(struct oceanography_pool *pool,
+                            const double *salinity, const double *temperature,
+                            const double *pressure, double *out, size_t n);
+void adiabatic_temperature_gradient_parallel(struct oceanography_pool *pool,
+                                             const double *salinity,
+                                             const double *temperature,
+                                             const double *pressure,
+                                             double *out, size_t n);
+void potential_temperature_parallel(struct oceanography_pool *pool,
+                                    const double *salinity,
+                                    const double *temperature,
+                                    const double *pressure,
+                                    const double *reference_pressure,
+                                    double *out, size_t n);
+void sound_speed_parallel(struct oceanography_pool *pool,
+                          const double *salinity, const double *temperature,
+                          const double *pressure, double *out, size_t n);
+void ctd_derive_parallel(struct oceanography_pool *pool,
+                         const double *conductivity,
+                         const double *temperature, const double *pressure,
+                         double latitude, double reference_pressure,
+                         unsigned int outputs, const struct ctd_outputs *out,
+                         size_t n);
+
+/* Streaming of binary CTD files.
+ *
+ * oceanography_stream_file() reads fixed size records holding conductivity
+ * ratio, temperature and pressure at the given offsets, and writes a record
+ * of the outputs selected by a mask of OCEANOGRAPHY_CTD_* flags for each of
+ * them. The input file is mapped a window at a time, so it can be larger
+ * than memory.
+ */
+
+enum oceanography_type {
+    OCEANOGRAPHY_FLOAT32,
+    OCEANOGRAPHY_FLOAT64
+};
+
+struct oceanography_column {
+    size_t offset;                      /* bytes from the record start */
+    enum oceanography_type type;        /* in host byte order */
+};
+
+struct oceanography_stream {
+    size_t header;                      /* bytes before the first record */
+    size_t record_size;                 /* bytes */
+    struct oceanography_column conductivity;
+    struct oceanography_column temperature;
+    struct oceanography_column pressure;
+    double latitude;
+    double reference_pressure;
+    unsigned int outputs;
+    enum oceanography_type output_type;
+};
+
+int oceanography_stream_file(struct oceanography_pool *pool,
+                             const struct oceanography_stream *stream,
+                             const char *input, const char *output);
+
+/* Real time ingestion.
+ *
+ * A struct oceanography_realtime takes the scans of one instrument from a
+ * producer thread through a lock-free single producer, single consumer ring,
+ * and computes the outputs selected by a mask of OCEANOGRAPHY_CTD_* flags in
+ * the consumer thread, keeping running averages in pressure bins. Memory is
+ * allocated by oceanography_realtime_create() only.
+ */
+
+struct oceanography_scan {
+    double conductivity;                /* conductivity ratio */
+    double temperature;
+    double pressure;
+};
+
+struct oceanography_realtime_spec {
+    size_t capacity;                    /* scans, rounded to a power of 2 */
+    double latitude;
+    double reference_pressure;
+    unsigned int outputs;
+    double bin_width;                   /* decibars */
+    size_t bins;                        /* from 0 decibars */
+};
+
+struct oceanography_bin {
+    unsigned long count;                /* scans */
+    double conductivity;                /* averages */
+    double temperature;
+    double pressure;
+    double salinity;
+    double svan;
+    double sigma;
+    double theta;
+    double sound_speed;
+    double depth;
+    double cpsw;
+    double freezing_point;
+    double atg;
+};
+
+struct oceanography_realtime;
+
+struct oceanography_realtime *oceanography_realtime_create(
+    const struct oceanography_realtime_spec *spec);
+void oceanography_realtime_destroy(struct oceanography_realtime *realtime);
+int oceanography_realtime_push(struct oceanography_realtime *realtime,
+                               const struct oceanography_scan *scan);
+size_t oceanography_realtime_process(struct oceanography_realtime *realtime,
+                                     const struct ctd_outputs *out,
+                                     size_t max);
+int oceanography_realtime_bin(const struct oceanography_realtime *realtime,
+                              size_t bin, struct oceanography_bin *average);
+void oceanography_realtime_clear(struct oceanography_realtime *realtime);
+
+/* Profile collections.
+ *
+ * A struct oceanography_collection describes the profiles of an archive
+ * stored as ragged arrays: the samples of all the profiles follow each other
+ * in the columns, and profile k takes the samples from offset[k] to
+ * offset[k + 1]. The functions run on the threads of a pool, a profile at a
+ * time.
+ */
+
+struct oceanography_collection {
+    size_t profiles;
+    const size_t *offset;               /* profiles + 1 elements */
+    const double *salinity;
+    const double *temperature;
+    const double *pressure;
+    const double *latitude;             /* one per profile */
+};
+
+/* Maximum number of columns of oceanography_collection_regrid(). */
+#define OCEANOGRAPHY_REGRID_COLUMNS 16
+
+struct oceanography_profile_metrics {
+    size_t samples;
+    double mixed_layer_depth;           /* meters */
+    double thermocline_depth;           /* meters */
+    double thermocline_gradient;        /* degrees Celsius/meter */
+    double surface_salinity;            /* first sample */
+    double surface_temperature;
+    double surface_pressure;
+    double surface_sigma;               /* sigma-theta */
+    double bottom_salinity;             /* last sample */
+    double bottom_temperature;
+    double bottom_pressure;
+    double bottom_sigma;
+    double bottom_depth;
+};
+
+void oceanography_collection_derive(
+    struct oceanography_pool *pool,
+    const struct oceanography_collection *collection,
+    double reference_pressure, unsigned int outputs,
+    const struct ctd_outputs *out);
+void oceanography_collection_metrics(
+    struct oceanography_pool *pool,
+    const struct oceanography_collection *collection, double threshold,
+    double reference_pressure, struct oceanography_profile_metrics *out);
+void oceanography_collection_regrid(
+    struct oceanography_pool *pool,
+    const struct oceanography_collection *collection,
+    const double *const *in, size_t columns, const double *depth,
+    size_t levels, double fill, double *const *out);
+
+/* Instrumentation.
+ *
+ * When the library is built with OCEANOGRAPHY_STATS, the scalar, batch,
+ * single precision and parallel functions count their calls, samples,
+ * inputs out of the range of the algorithms and elapsed ticks, grouped by
+ * quantity. Counting is off until oceanography_stats_enable() is called or
+ * the OCEANOGRAPHY_STATS environment variable is set to a non zero value.
+ */
+
+enum oceanography_stats_function {
+    OCEANOGRAPHY_STATS_SALINITY,
+    OCEANOGRAPHY_STATS_CONDUCTIVITY,
+    OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY,
+    OCEANOGRAPHY_STATS_DEPTH,
+    OCEANOGRAPHY_STATS_FREEZING_POINT,
+    OCEANOGRAPHY_STATS_SPECIFIC_HEAT,
+    OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT,
+    OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE,
+    OCEANOGRAPHY_STATS_IN_SITU_TEMPERATURE,
+    OCEANOGRAPHY_STATS_SOUND_SPEED,
+    OCEANOGRAPHY_STATS_CTD_DERIVE,
+    OCEANOGRAPHY_STATS_DENSITY_DERIVATIVES,
+    OCEANOGRAPHY_STATS_DENSITY,
+    OCEANOGRAPHY_STATS_POTENTIAL_DENSITY,
+    OCEANOGRAPHY_STATS_PRESSURE_FROM_DEPTH,
+    OCEANOGRAPHY_STATS_SALINITY_FROM_DENSITY,
+    OCEANOGRAPHY_STATS_TEMPERATURE_FROM_SOUND_SPEED,
+    OCEANOGRAPHY_STATS_FUNCTIONS
+};
+
+struct oceanography_stats_counter {
+    unsigned long calls;
+    unsigned long samples;
+    unsigned long out_of_range;         /* samples */
+    double ticks;                       /* CPU cycles, or nanoseconds */
+};
+
+struct oceanography_stats {
+    struct oceanography_stats_counter function[OCEANOGRAPHY_STATS_FUNCTIONS];
+    unsigned long
+        conductivity_iterations[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+};
+
+int oceanography_stats_enable(int enable);
+void oceanography_stats_snapshot(struct oceanography_stats *stats);
+void oceanography_stats_thread_snapshot(struct oceanography_stats *stats);
+void oceanography_stats_reset(void);
+const char *oceanography_stats_name(enum oceanography_stats_function function);
+
+#define svan_n(salinity, temperature, pressure, out, sigma, n) \
+        specific_volume_anomaly_n(salinity, temperature, pressure, out, \
+                                  sigma, n)
+#define atg_n(salinity, temperature, pressure, out, n) \
+        adiabatic_temperature_gradient_n(salinity, temperature, pressure, \
+                                         out, n)
+#define theta_n(salinity, temperature, pressure, reference_pressure, out, n) \
+        potential_temperature_n(salinity, temperature, pressure, \
+                                reference_pressure, out, n)
+#define cpsw_n(salinity, temperature, pressure, out, n) \
+        specific_heat_n(salinity, temperature, pressure, out, n)
+#define svan_parallel(pool, salinity, temperature, pressure, out, sigma, n) \
+        specific_volume_anomaly_parallel(pool, salinity, temperature, \
+                                         pressure, out, sigma, n)
+#define atg_parallel(pool, salinity, temperature, pressure, out, n) \
+        adiabatic_temperature_gradient_parallel(pool, salinity, temperature, \
+                                                pressure, out, n)
+#define theta_parallel(pool, salinity, temperature, pressure, \
+                       reference_pressure, out, n) \
+        potential_temperature_parallel(pool, salinity, temperature, pressure, \
+                                       reference_pressure, out, n)
+#define cpsw_parallel(pool, salinity, temperature, pressure, out, n) \
+        specific_heat_parallel(pool, salinity, temperature, pressure, out, n)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * oceanography.hpp -- Header only C++ interface of liboceanography.
+ *
+ * The functions of namespace oceanography are inline templates over the
+ * type of their arguments, so the compiler can inline them in the caller
+ * and fold the terms of constant arguments. They are instantiated from the
+ * cores of the vectorized kernels (oceanography_cores.h): on double and
+ * float, results are identical to the ones of the C functions and of the
+ * *_f functions, as long as the compiler does not contract multiplications
+ * and additions (-ffp-contract=off).
+ *
+ * Any other type, such as a vector of doubles, can be used by specializing
+ * oceanography::traits for it. Nothing needs to be linked, except for the
+ * C functions declared by oceanography.h.
+ */
+
+#ifndef OCEANOGRAPHY_HPP
+#define OCEANOGRAPHY_HPP
+
+#include <cmath>
+
+#include "oceanography.h"
+
+namespace oceanography {
+
+/* traits -- operations on T that are not C++ operators.
+ *
+ * Types must support +, -, * and / between two values, and traits<T> must
+ * provide:
+ *
+ *     mask                   -- type of the result of a comparison
+ *     set1(double x)         -- x converted to T, in every lane
+ *     sqrt(a), abs(a)
+ *     eq(a, b), le(a, b), gt(a, b)
+ *                            -- lane by lane comparisons
+ *     both(m1, m2)           -- and of two masks
+ *     any(m)                 -- true if any lane of m is set
+ *     select(m, a, b)        -- a where m is set, b elsewhere
+ */
+template <typename T> struct traits;
+
+template <> struct traits<double> {
+    typedef bool mask;
+
+    static double set1(double x) { return x; }
+    static double sqrt(double a) { return std::sqrt(a); }
+    static double abs(double a) { return std::fabs(a); }
+    static bool eq(double a, double b) { return a == b; }
+    static bool le(double a, double b) { return a <= b; }
+    static bool gt(double a, double b) { return a > b; }
+    static bool both(bool m1, bool m2) { return m1 && m2; }
+    static bool any(bool m) { return m; }
+    static double select(bool m, double a, double b) { return m ? a : b; }
+};
+
+/* The square root of a float computed in double and rounded to float is the
+ * correctly rounded single precision one, as in float.c. */
+template <> struct traits<float> {
+    typedef bool mask;
+
+    static float set1(double x) { return (float) x; }
+    static float sqrt(float a) { return (float) std::sqrt((double) a); }
+    static float abs(float a) { return (float) std::fabs((double) a); }
+    static bool eq(float a, float b) { return a == b; }
+    static bool le(float a, float b) { return a <= b; }
+    static bool gt(float a, float b) { return a > b; }
+    static bool both(bool m1, bool m2) { return m1 && m2; }
+    static bool any(bool m) { return m; }
+    static float select(bool m, float a, float b) { return m ? a : b; }
+};
+
+namespace detail {
+
+/* The cores of oceanography_cores.h, as static members on V. */
+template <typename V, typename Traits = traits<V> > struct cores {
+#define V_SET1(x) Traits::set1(x)
+#define V_ADD(a, b) ((a) + (b))
+#define V_SUB(a, b) ((a) - (b))
+#define V_MUL(a, b) ((a) * (b))
+#define V_DIV(a, b) ((a) / (b))
+#define V_SQRT(a) Traits::sqrt(a)
+#define V_ABS(a) Traits::abs(a)
+#define V_MASK typename Traits::mask
+#define V_EQ(a, b) Traits::eq(a, b)
+#define V_LE(a, b) Traits::le(a, b)
+#define V_GT(a, b) Traits::gt(a, b)
+#define V_AND(m1, m2) Traits::both(m1, m2)
+#define V_ANY(m) Traits::any(m)
+#define V_SELECT(m, a, b) Traits::select(m, a, b)
+#define SIMD_NAME(name) name
+
+#include "oceanography_cores.h"
+
+#undef K
+#undef H
+#undef V_SET1
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_DIV
+#undef V_SQRT
+#undef V_ABS
+#undef V_MASK
+#undef V_EQ
+#undef V_LE
+#undef V_GT
+#undef V_AND
+#undef V_ANY
+#undef V_SELECT
+#undef SIMD_NAME
+};
+
+/* The latitude term of the gravity of depth(), as _gravity() in kernels.h. */
+inline double gravity(double latitude)
+{
+    double x;
+
+    x = std::sin(latitude / 57.29578);
+    x = x * x;
+
+    return 9.780318 * (1.0 + (5.2788e-3 + 2.36e-5 * x) * x);
+}
+
+} /* namespace detail */
+
+/* Units of all the functions are the ones of the C functions. The svan,
+ * atg, theta and cpsw macros of oceanography.h work on them too, with all
+ * the arguments. */
+
+template <typename T>
+inline T salinity(T conductivity, T temperature, T pressure)
+{
+    return detail::cores<T>::salinity_core(conductivity, temperature,
+                                           pressure);
+}
+
+template <typename T>
+inline T conductivity(T salinity, T temperature, T pressure)
+{
+    T iterations;
+
+    return detail::cores<T>::conductivity_core(salinity, temperature,
+                                               pressure, &iterations);
+}
+
+/* sigma can be NULL when density anomaly is not needed. */
+template <typename T>
+inline T specific_volume_anomaly(T salinity, T temperature, T pressure,
+                                 T *sigma = 0)
+{
+    T out, sig;
+
+    out = detail::cores<T>::specific_volume_anomaly_sr(
+        salinity, traits<T>::sqrt(traits<T>::abs(salinity)), temperature,
+        pressure / traits<T>::set1(10.), &sig);
+    if (sigma != 0)
+        *sigma = sig;
+
+    return out;
+}
+
+/* The latitude is a double, as the gravity is computed in double also by
+ * depth_f(). */
+template <typename T>
+inline T depth(T pressure, double latitude)
+{
+    return detail::cores<T>::depth_gravity(
+        pressure, traits<T>::set1(detail::gravity(latitude)));
+}
+
+template <typename T>
+inline T freezing_point(T salinity, T pressure)
+{
+    return detail::cores<T>::freezing_point_sr(
+        salinity, traits<T>::sqrt(traits<T>::abs(salinity)), pressure);
+}
+
+template <typename T>
+inline T specific_heat(T salinity, T temperature, T pressure)
+{
+    return detail::cores<T>::specific_heat_sr(
+        salinity, traits<T>::sqrt(traits<T>::abs(salinity)), temperature,
+        pressure / traits<T>::set1(10.0));
+}
+
+template <typename T>
+inline T adiabatic_temperature_gradient(T salinity, T temperature,
+                                        T pressure)
+{
+    return detail::cores<T>::adiabatic_temperature_gradient_core(
+        salinity, temperature, pressure);
+}
+
+template <typename T>
+inline T potential_temperature(T salinity, T temperature, T pressure,
+                               T reference_pressure)
+{
+    return detail::cores<T>::potential_temperature_core(
+        salinity, temperature, pressure, reference_pressure);
+}
+
+template <typename T>
+inline T in_situ_temperature(T salinity, T potential_temperature, T pressure,
+                             T reference_pressure)
+{
+    return detail::cores<T>::in_situ_temperature_core(
+        salinity, potential_temperature, pressure, reference_pressure);
+}
+
+template <typename T>
+inline T sound_speed(T salinity, T temperature, T pressure)
+{
+    return detail::cores<T>::sound_speed_sr(
+        salinity, traits<T>::sqrt(traits<T>::abs(salinity)), temperature,
+        pressure / traits<T>::set1(10.0));
+}
+
+} /* namespace oceanography */
+
+#endif /* OCEANOGRAPHY_HPP */
@@ -0,0 +1,332 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * oceanography_cores.h -- Per-vector cores of the vectorized kernels.
+ *
+ * This file is included by simd_template.h and simd_template_f.h, after
+ * defining the vector macros listed there, and by oceanography.hpp in a
+ * class template. The cores only use those macros, so the same expressions
+ * are compiled on doubles, on floats and on the types of the C++ interface.
+ *
+ * It is installed for oceanography.hpp: do not include it directly.
+ */
+
+#define K(c) V_SET1(c)
+#define H(acc, x, c) V_ADD(V_MUL(acc, x), K(c))
+
+/* Per-vector cores, the vector counterparts of the kernels in kernels.h. The
+ * _sr cores take sr = sqrt(fabs(salinity)) and pressure in bars.
+ */
+
+static V SIMD_NAME(sal)(V xr, V xt)
+{
+    return V_ADD(H(H(H(H(H(K(2.7081), xr, -7.0261), xr, 14.0941), xr,
+                         25.3851), xr, -0.1692), xr, 0.0080),
+                 V_MUL(V_DIV(xt, V_ADD(K(1.0), V_MUL(K(0.0162), xt))),
+                       H(H(H(H(H(K(-0.0144), xr, 0.0636), xr, -0.0375), xr,
+                             -0.0066), xr, -0.0056), xr, 0.0005)));
+}
+
+static V SIMD_NAME(dsal)(V xr, V xt)
+{
+    return V_ADD(H(H(H(H(K(13.5405), xr, -28.1044), xr, 42.2823), xr,
+                     50.7702), xr, -0.1692),
+                 V_MUL(V_DIV(xt, V_ADD(K(1.0), V_MUL(K(0.0162), xt))),
+                       H(H(H(H(K(-0.0720), xr, 0.2544), xr, -0.1125), xr,
+                           -0.0132), xr, -0.0056)));
+}
+
+/* Newton iterations run on all the lanes until every lane has converged;
+ * converged lanes keep their values, so every lane does exactly the
+ * iterations of _conductivity_cp_iterations(), stored in count: none when
+ * salinity is out of range or not a number.
+ */
+static V SIMD_NAME(conductivity_cp)(V s, V t, V cp_pressure, V *count)
+{
+    V dt, u, rt, si, rt1, si1, rtt, cp, bt, r, a, b;
+    V_MASK active;
+    int k;
+
+    dt = V_ADD(t, K(-15.0));
+
+    u = V_SQRT(V_DIV(s, K(35.0)));
+    rt = V_MUL(V_ADD(H(H(H(K(-0.0759721), u, 0.226009), u, -0.329901), u,
+                       1.17997),
+                     V_MUL(V_MUL(K(5.78313e-4), dt), V_SUB(K(1.0), u))),
+               u);
+    si = SIMD_NAME(sal)(rt, dt);
+
+    active = V_GT(s, K(0.02));
+    *count = K(0.0);
+    k = 0;
+    do {
+        rt1 = V_ADD(rt, V_DIV(V_SUB(s, si), SIMD_NAME(dsal)(rt, dt)));
+        si1 = SIMD_NAME(sal)(rt1, dt);
+        rt = V_SELECT(active, rt1, rt);
+        si = V_SELECT(active, si1, si);
+        *count = V_ADD(*count, V_SELECT(active, K(1.0), K(0.0)));
+        active = V_AND(active, V_GT(V_ABS(V_SUB(si, s)), K(1.0e-4)));
+        k++;
+    } while (k < OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS && V_ANY(active));
+
+    a = H(K(-3.107E-3), t, 0.4215);
+    b = H(H(K(4.464e-4), t, 3.426e-2), t, 1.0);
+    rtt = V_MUL(V_MUL(H(H(H(H(K(1.0031e-9), t, -6.9698e-7), t, 1.104259e-4),
+                          t, 2.00564e-2), t, 0.6766097), rt), rt);
+    cp = V_MUL(rtt, V_ADD(cp_pressure, b));
+    bt = V_SUB(b, V_MUL(rtt, a));
+    r = V_SUB(V_SQRT(V_ABS(V_ADD(V_MUL(bt, bt),
+                                 V_MUL(V_MUL(K(4.0), a), cp)))), bt);
+
+    return V_SELECT(V_LE(s, K(0.02)), K(0.0), V_DIV(V_MUL(K(0.5), r), a));
+}
+
+/* C(pressure) of the conductivity ratio, as the C() macro of kernels.h. */
+static V SIMD_NAME(c_pressure)(V p)
+{
+    return V_MUL(H(H(K(3.989e-15), p, -6.370e-10), p, 2.070e-5), p);
+}
+
+static V SIMD_NAME(conductivity_core)(V s, V t, V p, V *count)
+{
+    return SIMD_NAME(conductivity_cp)(s, t, SIMD_NAME(c_pressure)(p), count);
+}
+
+static V SIMD_NAME(salinity_cp)(V c, V t, V cp_pressure)
+{
+    V rt;
+
+    rt = V_DIV(c, V_MUL(H(H(H(H(K(1.0031e-9), t, -6.9698e-7), t,
+                                1.104259e-4), t, 2.00564e-2), t, 0.6766097),
+                        V_ADD(K(1.0),
+                              V_DIV(cp_pressure,
+                                    V_ADD(H(H(K(4.464e-4), t, 3.426e-2), t,
+                                            1.0),
+                                          V_MUL(H(K(-3.107E-3), t, 0.4215),
+                                                c))))));
+    rt = V_SQRT(V_ABS(rt));
+
+    return V_SELECT(V_LE(c, K(5e-4)), K(0.0),
+                    SIMD_NAME(sal)(rt, V_ADD(t, K(-15.0))));
+}
+
+static V SIMD_NAME(salinity_core)(V c, V t, V p)
+{
+    return SIMD_NAME(salinity_cp)(c, t, SIMD_NAME(c_pressure)(p));
+}
+
+static V SIMD_NAME(sigma_sr)(V s, V sr, V t)
+{
+    V r1, r2, r3;
+
+    r1 = H(H(H(H(H(K(6.536332e-9), t, -1.120083e-6), t, 1.001685e-4), t,
+               -9.095290e-3), t, 6.793952e-2), t, -28.263737);
+    r2 = H(H(H(H(K(5.3875e-9), t, -8.2467e-7), t, 7.6438e-5), t,
+             -4.0899e-3), t, 8.24493e-1);
+    r3 = H(H(K(-1.6546e-6), t, 1.0227e-4), t, -5.72466e-3);
+
+    return V_ADD(V_MUL(V_ADD(V_ADD(V_MUL(K(4.8314e-4), s), V_MUL(r3, sr)),
+                             r2), s), r1);
+}
+
+static V SIMD_NAME(specific_volume_anomaly_sr)(V s, V sr, V t, V p,
+                                               V *sigma)
+{
+    V sg, sva, sva0, e, b, c, a, aw, bw;
+    V a1, b1, kw, ko, dk, k35, gam, pk, v350p, dr35p, dvan;
+    V_MASK surface;
+
+    sg = SIMD_NAME(sigma_sr)(s, sr, t);
+    sva0 = V_DIV(V_MUL(sg, K(-(1.0 / 1028.1063))), V_ADD(K(1028.1063), sg));
+
+    e = H(H(K(9.1697e-10), t, 2.0816e-8), t, -9.9348e-7);
+    bw = H(H(K(5.2787e-8), t, -6.12293e-6), t, 3.47718e-5);
+    b = V_ADD(bw, V_MUL(e, s));
+
+    c = H(H(K(-1.6078e-6), t, -1.0981e-5), t, 2.2838e-3);
+    aw = H(H(H(K(-5.77905e-7), t, 1.16092e-4), t, 1.43713e-3), t,
+           -0.1194975);
+    a = V_ADD(V_MUL(V_ADD(V_MUL(K(1.91075e-4), sr), c), s), aw);
+
+    b1 = H(H(K(-5.3009e-4), t, 1.6483e-2), t, 7.944e-2);
+    a1 = H(H(H(K(-6.1670e-5), t, 1.09987e-2), t, -0.603459), t, 54.6746);
+    kw = H(H(H(H(K(-5.155288e-5), t, 1.360477e-2), t, -2.327105), t,
+             148.4206), t, -1930.06);
+    ko = V_ADD(V_MUL(V_ADD(V_MUL(b1, sr), a1), s), kw);
+
+    dk = V_ADD(V_MUL(V_ADD(V_MUL(b, p), a), p), ko);
+    k35 = H(H(K(5.03217e-5), p, 3.359406), p, 21582.27);
+    gam = V_DIV(p, k35);
+    pk = V_SUB(K(1.0), gam);
+    sva = V_ADD(V_MUL(sva0, pk),
+                V_DIV(V_MUL(V_MUL(V_ADD(K(1.0 / 1028.1063), sva0), p), dk),
+                      V_MUL(k35, V_ADD(k35, dk))));
+    v350p = V_MUL(K(1.0 / 1028.1063), pk);
+
+    dr35p = V_DIV(gam, v350p);
+    dvan = V_DIV(sva, V_MUL(v350p, V_ADD(v350p, sva)));
+
+    surface = V_EQ(p, K(0.0));
+    *sigma = V_SELECT(surface, V_ADD(sg, K(28.106331)),
+                      V_SUB(V_ADD(K(28.106331), dr35p), dvan));
+
+    return V_MUL(V_SELECT(surface, sva0, sva), K(1.0e+8));
+}
+
+static V SIMD_NAME(freezing_point_sr)(V s, V sr, V p)
+{
+    return V_SUB(V_MUL(V_SUB(V_ADD(K(-0.0575), V_MUL(K(1.710523e-3), sr)),
+                             V_MUL(K(2.154996e-4), s)), s),
+                 V_MUL(K(7.53e-4), p));
+}
+
+static V SIMD_NAME(specific_heat_sr)(V s, V sr, V t, V p)
+{
+    V a, b, c, cp0, cp1, cp2;
+
+    a = H(H(K(-1.38385e-3), t, 0.1072763), t, -7.643575);
+    b = H(H(K(5.148e-5), t, -4.07718e-3), t, 0.1770383);
+    c = H(H(H(H(K(2.093236e-5), t, -2.654387e-3), t, 0.1412855), t,
+            -3.720283), t, 4217.4);
+    cp0 = V_ADD(V_MUL(V_ADD(V_MUL(b, sr), a), s), c);
+
+    a = H(H(H(H(K(1.7168e-8), t, 2.0357e-6), t, -3.13885e-4), t,
+            1.45747e-2), t, -0.49592);
+    b = H(H(H(H(K(2.2956e-11), t, -4.0027e-9), t, 2.87533e-7), t,
+            -1.08645e-5), t, 2.4931e-4);
+    c = H(H(H(K(6.136e-13), t, -6.5637e-11), t, 2.6380e-9), t, -5.422e-8);
+    cp1 = V_MUL(V_ADD(V_MUL(V_ADD(V_MUL(c, p), b), p), a), p);
+
+    a = H(H(H(H(K(-2.9179e-10), t, 2.5941e-8), t, 9.802e-7), t,
+            -1.28315e-4), t, 4.9247e-3);
+    b = H(H(K(3.122e-8), t, -1.517e-6), t, -1.2331e-4);
+    a = V_MUL(V_ADD(a, V_MUL(b, sr)), s);
+    b = H(H(H(K(1.8448e-11), t, -2.3905e-9), t, 1.17054e-7), t, -2.9558e-6);
+    b = V_MUL(V_ADD(b, V_MUL(K(9.971e-8), sr)), s);
+    c = H(H(K(3.513e-13), t, -1.7682e-11), t, 5.540e-10);
+    c = V_MUL(V_SUB(c, V_MUL(V_MUL(K(1.4300e-12), t), sr)), s);
+    cp2 = V_MUL(V_ADD(V_MUL(V_ADD(V_MUL(c, p), b), p), a), p);
+
+    return V_ADD(V_ADD(cp0, cp1), cp2);
+}
+
+static V SIMD_NAME(adiabatic_temperature_gradient_core)(V s, V t, V p)
+{
+    V x;
+
+    s = V_ADD(s, K(-35.0));
+
+    x = V_ADD(V_ADD(V_MUL(H(K(2.7759e-12), t, -1.1351e-10), s),
+                    V_MUL(H(H(K(-5.4481e-14), t, 8.733e-12), t, -6.7795e-10),
+                          t)),
+              K(1.8741e-8));
+    x = V_ADD(V_MUL(H(H(K(-2.1687e-16), t, 1.8676e-14), t, -4.6206e-13), p),
+              x);
+
+    return V_ADD(V_ADD(V_ADD(V_MUL(x, p),
+                             V_MUL(H(K(-4.2393e-8), t, 1.8932e-6), s)),
+                       V_MUL(H(H(K(6.6228e-10), t, -6.836e-8), t, 8.5258e-6),
+                             t)),
+                 K(3.5803e-5));
+}
+
+static V SIMD_NAME(potential_temperature_atg)(V s, V t, V p, V pr, V atg)
+{
+    V h, xk, q;
+
+    h = V_SUB(pr, p);
+    xk = V_MUL(h, atg);
+    t = V_ADD(t, V_MUL(K(0.5), xk));
+    q = xk;
+    p = V_ADD(p, V_MUL(K(0.5), h));
+    xk = V_MUL(h, SIMD_NAME(adiabatic_temperature_gradient_core)(s, t, p));
+    t = V_ADD(t, V_MUL(K(0.29289322), V_SUB(xk, q)));
+    q = V_ADD(V_MUL(K(0.58578644), xk), V_MUL(K(0.121320344), q));
+    xk = V_MUL(h, SIMD_NAME(adiabatic_temperature_gradient_core)(s, t, p));
+    t = V_ADD(t, V_MUL(K(1.707106781), V_SUB(xk, q)));
+    q = V_SUB(V_MUL(K(3.414213562), xk), V_MUL(K(4.121320344), q));
+    p = V_ADD(p, V_MUL(K(0.5), h));
+    xk = V_MUL(h, SIMD_NAME(adiabatic_temperature_gradient_core)(s, t, p));
+
+    return V_ADD(t, V_DIV(V_SUB(xk, V_MUL(K(2.0), q)), K(0.6)));
+}
+
+static V SIMD_NAME(potential_temperature_core)(V s, V t, V p, V pr)
+{
+    return SIMD_NAME(potential_temperature_atg)(
+        s, t, p, pr, SIMD_NAME(adiabatic_temperature_gradient_core)(s, t, p));
+}
+
+static V SIMD_NAME(in_situ_temperature_core)(V s, V theta, V p, V pr)
+{
+    V t0, t1, t, f0, f1;
+    int k;
+
+    t0 = SIMD_NAME(potential_temperature_core)(s, theta, pr, p);
+    f0 = V_SUB(SIMD_NAME(potential_temperature_core)(s, t0, p, pr), theta);
+    t1 = V_SUB(t0, f0);
+    for (k = 0; k < OCEANOGRAPHY_IN_SITU_ITERATIONS; k++) {
+        f1 = V_SUB(SIMD_NAME(potential_temperature_core)(s, t1, p, pr),
+                   theta);
+        t = V_SELECT(V_EQ(f1, f0), t1,
+                     V_SUB(t1, V_DIV(V_MUL(f1, V_SUB(t1, t0)),
+                                     V_SUB(f1, f0))));
+        t0 = t1;
+        f0 = f1;
+        t1 = t;
+    }
+
+    return t1;
+}
+
+static V SIMD_NAME(sound_speed_sr)(V s, V sr, V t, V p)
+{
+    V a, a0, a1, a2, a3, b, c, c0, c1, c2, c3, d;
+
+    d = V_SUB(K(1.727e-3), V_MUL(K(7.9836e-6), p));
+
+    b = V_ADD(V_SUB(K(-1.922e-2), V_MUL(K(4.42e-5), t)),
+              V_MUL(V_ADD(K(7.3637e-5), V_MUL(K(1.7945e-7), t)), p));
+
+    a3 = H(H(K(-3.389e-13), t, 6.649e-12), t, 1.100e-10);
+    a2 = H(H(H(K(7.988e-12), t, -1.6002e-10), t, 9.1041e-9), t, -3.9064e-7);
+    a1 = H(H(H(H(K(-2.0122e-10), t, 1.0507e-8), t, -6.4885e-8), t,
+             -1.2580e-5), t, 9.4742e-5);
+    a0 = H(H(H(H(K(-3.21e-8), t, 2.006e-6), t, 7.164e-5), t, -1.262e-2), t,
+           1.389);
+    a = V_ADD(V_MUL(V_ADD(V_MUL(V_ADD(V_MUL(a3, p), a2), p), a1), p), a0);
+
+    c3 = H(H(K(-2.3643e-12), t, 3.8504e-10), t, -9.7729e-9);
+    c2 = H(H(H(H(K(1.0405e-12), t, -2.5335e-10), t, 2.5974e-8), t,
+             -1.7107e-6), t, 3.1260e-5);
+    c1 = H(H(H(H(K(-6.1185e-10), t, 1.3621e-7), t, -8.1788e-6), t,
+             6.8982e-4), t, 0.153563);
+    c0 = H(H(H(H(H(K(3.1464e-9), t, -1.47800e-6), t, 3.3420e-4), t,
+               -5.80852e-2), t, 5.03711), t, 1402.388);
+    c = V_ADD(V_MUL(V_ADD(V_MUL(V_ADD(V_MUL(c3, p), c2), p), c1), p), c0);
+
+    return V_ADD(c, V_MUL(V_ADD(V_ADD(a, V_MUL(b, sr)), V_MUL(d, s)), s));
+}
+
+static V SIMD_NAME(depth_gravity)(V p, V gravity)
+{
+    return V_DIV(V_MUL(H(H(H(K(-1.82e-15), p, 2.279e-10), p, -2.2512e-5), p,
+                         9.72659), p),
+                 V_ADD(gravity, V_MUL(K(1.092e-6), p)));
+}
@@ -0,0 +1,726 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * parallel.c -- Thread pool running the batch functions on several cores.
+ *
+ * The samples are split in chunks of CHUNK elements. Every worker starts
+ * with a contiguous range of chunks and takes them from the front; a worker
+ * that runs out of chunks steals the back half of the range of another one.
+ * The calling thread is worker 0, so a pool of n threads starts n - 1
+ * helpers.
+ *
+ * Chunk boundaries depend only on the number of samples and every chunk runs
+ * the same kernels of the *_n functions, so results are bit for bit
+ * identical whatever the number of threads.
+ *
+ * The default pool is created once, by the first call with a NULL pool.
+ * Calls on it hold a read lock, so oceanography_set_threads() replaces it
+ * only when no job is running on it.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "parallel.h"
+#include "simd.h"
+#include "stats.h"
+
+/* Samples per chunk: the input and output arrays of a chunk (up to 160 KiB)
+ * stay in the L2 cache of the worker. */
+#define CHUNK 4096
+
+struct job {
+    void (*run)(const struct job *job, size_t begin, size_t end);
+    const struct simd_kernels *kernels;
+    const double *in[4];
+    double *out[2];
+    double gravity;
+    double reference_pressure;
+    unsigned int outputs;
+    const struct ctd_outputs *ctd;
+    void (*call)(const void *arg, size_t begin, size_t end);
+    const void *arg;
+    size_t n;
+};
+
+struct worker {
+    struct oceanography_pool *pool;
+    unsigned int id;
+    pthread_mutex_t lock;       /* protects next and end */
+    size_t next;                /* chunks [next, end) are not taken yet */
+    size_t end;
+};
+
+struct oceanography_pool {
+    unsigned int threads;
+    unsigned int started;       /* helpers actually running */
+    pthread_t *thread;
+    struct worker *worker;
+    pthread_mutex_t submit;     /* serializes the jobs of different callers */
+    pthread_mutex_t lock;       /* protects the fields below */
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    const struct job *job;
+    unsigned long generation;
+    unsigned int busy;
+    int quit;
+};
+
+static struct oceanography_pool *default_pool = NULL;
+static pthread_rwlock_t default_lock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static void default_pool_create(void);
+
+/* Take a chunk from the range of worker id, or steal from the others. */
+static int take_chunk(struct oceanography_pool *pool, unsigned int id,
+                      size_t *chunk)
+{
+    struct worker *self, *victim;
+    size_t begin = 0, end = 0;
+    unsigned int k;
+    int found = 0;
+
+    self = &pool->worker[id];
+    pthread_mutex_lock(&self->lock);
+    if (self->next < self->end) {
+        *chunk = self->next++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&self->lock);
+
+    if (found)
+        return 1;
+
+    for (k = 1; k < pool->threads && !found; k++) {
+        victim = &pool->worker[(id + k) % pool->threads];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->next < victim->end) {
+            begin = victim->next + (victim->end - victim->next) / 2;
+            end = victim->end;
+            victim->end = begin;
+            found = 1;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+
+    if (!found)
+        return 0;
+
+    /* Run the first stolen chunk, keep the others for later. */
+    *chunk = begin;
+    pthread_mutex_lock(&self->lock);
+    self->next = begin + 1;
+    self->end = end;
+    pthread_mutex_unlock(&self->lock);
+
+    return 1;
+}
+
+static void run_chunks(struct oceanography_pool *pool, unsigned int id,
+                       const struct job *job)
+{
+    size_t chunk, begin, end;
+
+    while (take_chunk(pool, id, &chunk)) {
+        begin = chunk * CHUNK;
+        end = job->n - begin < CHUNK ? job->n : begin + CHUNK;
+        job->run(job, begin, end);
+    }
+}
+
+static void *helper(void *arg)
+{
+    struct worker *self = arg;
+    struct oceanography_pool *pool = self->pool;
+    unsigned long generation = 0;
+    const struct job *job;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->quit && pool->generation == generation)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->quit)
+            break;
+        generation = pool->generation;
+        job = pool->job;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_chunks(pool, self->id, job);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static unsigned int default_threads(void)
+{
+    const char *env;
+    long cpus;
+
+    env = getenv("OCEANOGRAPHY_THREADS");
+    if (env != NULL && atoi(env) > 0)
+        return (unsigned int) atoi(env);
+
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return cpus > 0 ? (unsigned int) cpus : 1;
+}
+
+/* oceanography_pool_create -- create a pool of threads for the *_parallel
+ * functions.
+ *
+ * With 0 threads the OCEANOGRAPHY_THREADS environment variable is used, or
+ * one thread for every online CPU.
+ *
+ * Returns NULL if the pool can not be created.
+ */
+
+struct oceanography_pool *oceanography_pool_create(unsigned int threads)
+{
+    struct oceanography_pool *pool;
+    unsigned int i;
+
+    if (threads == 0)
+        threads = default_threads();
+
+    pool = calloc(1, sizeof(*pool));
+    if (pool == NULL)
+        return NULL;
+
+    pool->threads = threads;
+    pool->worker = calloc(threads, sizeof(*pool->worker));
+    pool->thread = calloc(threads, sizeof(*pool->thread));
+    if (pool->worker == NULL || pool->thread == NULL) {
+        free(pool->worker);
+        free(pool->thread);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->submit, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i = 0; i < threads; i++) {
+        pool->worker[i].pool = pool;
+        pool->worker[i].id = i;
+        pthread_mutex_init(&pool->worker[i].lock, NULL);
+    }
+
+    for (i = 1; i < threads; i++) {
+        if (pthread_create(&pool->thread[i], NULL, helper,
+                           &pool->worker[i]) != 0) {
+            oceanography_pool_destroy(pool);
+            return NULL;
+        }
+        pool->started++;
+    }
+
+    return pool;
+}
+
+/* oceanography_pool_destroy -- stop the threads of pool and free it.
+ *
+ * pool must not be running any job.
+ */
+
+void oceanography_pool_destroy(struct oceanography_pool *pool)
+{
+    unsigned int i;
+
+    if (pool == NULL)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 1; i <= pool->started; i++)
+        pthread_join(pool->thread[i], NULL);
+
+    for (i = 0; i < pool->threads; i++)
+        pthread_mutex_destroy(&pool->worker[i].lock);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->submit);
+
+    free(pool->thread);
+    free(pool->worker);
+    free(pool);
+}
+
+/* oceanography_pool_threads -- get the number of threads of pool, or of the
+ * default pool if NULL: 1 if the default pool can not be created.
+ */
+
+unsigned int oceanography_pool_threads(const struct oceanography_pool *pool)
+{
+    unsigned int threads;
+
+    if (pool != NULL)
+        return pool->threads;
+
+    pthread_once(&default_once, default_pool_create);
+    pthread_rwlock_rdlock(&default_lock);
+    threads = default_pool != NULL ? default_pool->threads : 1;
+    pthread_rwlock_unlock(&default_lock);
+
+    return threads;
+}
+
+/* oceanography_set_threads -- set the number of threads of the pool used by
+ * the *_parallel functions when they are called with a NULL pool.
+ *
+ * 0 threads has the same meaning of oceanography_pool_create(). The previous
+ * default pool is destroyed after the *_parallel calls running on it, in
+ * other threads, return.
+ *
+ * Returns 0 on success, -1 if the pool can not be created.
+ */
+
+int oceanography_set_threads(unsigned int threads)
+{
+    struct oceanography_pool *pool, *previous;
+
+    pool = oceanography_pool_create(threads);
+    if (pool == NULL)
+        return -1;
+
+    pthread_rwlock_wrlock(&default_lock);
+    previous = default_pool;
+    default_pool = pool;
+    pthread_rwlock_unlock(&default_lock);
+
+    oceanography_pool_destroy(previous);
+
+    return 0;
+}
+
+/* Run job on pool, split in chunks. The caller works as worker 0. */
+static void run_job(struct oceanography_pool *pool, struct job *job)
+{
+    size_t chunks, share, extra;
+    unsigned int i;
+
+    job->kernels = simd_select();
+    chunks = job->n / CHUNK + (job->n % CHUNK != 0);
+
+    if (pool == NULL || pool->threads == 1 || chunks <= 1) {
+        if (job->n > 0)
+            job->run(job, 0, job->n);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->submit);
+
+    /* Every worker starts with a contiguous range of chunks. */
+    share = chunks / pool->threads;
+    extra = chunks % pool->threads;
+    for (i = 0; i < pool->threads; i++) {
+        pool->worker[i].next = i * share + (i < extra ? i : extra);
+        pool->worker[i].end = pool->worker[i].next + share + (i < extra);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->busy = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool, 0, job);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->submit);
+}
+
+/* Create the default pool, unless oceanography_set_threads() did. If it
+ * can not be created, calls with a NULL pool run in the calling thread. */
+static void default_pool_create(void)
+{
+    struct oceanography_pool *pool = oceanography_pool_create(0);
+
+    pthread_rwlock_wrlock(&default_lock);
+    if (default_pool == NULL) {
+        default_pool = pool;
+        pool = NULL;
+    }
+    pthread_rwlock_unlock(&default_lock);
+
+    oceanography_pool_destroy(pool);
+}
+
+/* Run job on pool, or on the default pool if NULL. */
+static void pool_run(struct oceanography_pool *pool, struct job *job)
+{
+    if (pool != NULL) {
+        run_job(pool, job);
+        return;
+    }
+
+    pthread_once(&default_once, default_pool_create);
+    pthread_rwlock_rdlock(&default_lock);
+    run_job(default_pool, job);
+    pthread_rwlock_unlock(&default_lock);
+}
+
+static void job_init(struct job *job,
+                     void (*run)(const struct job *, size_t, size_t),
+                     const double *in0, const double *in1, const double *in2,
+                     double *out, size_t n)
+{
+    job->run = run;
+    job->kernels = NULL;
+    job->in[0] = in0;
+    job->in[1] = in1;
+    job->in[2] = in2;
+    job->in[3] = NULL;
+    job->out[0] = out;
+    job->out[1] = NULL;
+    job->gravity = 0.0;
+    job->reference_pressure = 0.0;
+    job->outputs = 0;
+    job->ctd = NULL;
+    job->call = NULL;
+    job->arg = NULL;
+    job->n = n;
+}
+
+/* Pointer to element begin of an optional array. */
+#define OFFSET(array, begin) ((array) != NULL ? (array) + (begin) : NULL)
+
+static void salinity_chunk(const struct job *job, size_t begin, size_t end)
+{
+    job->kernels->salinity(job->in[0] + begin, job->in[1] + begin,
+                           job->in[2] + begin, job->out[0] + begin,
+                           end - begin);
+}
+
+static void conductivity_chunk(const struct job *job, size_t begin,
+                               size_t end)
+{
+    unsigned long counts[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+    unsigned long *histogram = stats_histogram(counts);
+
+    job->kernels->conductivity(job->in[0] + begin, job->in[1] + begin,
+                               job->in[2] + begin, job->out[0] + begin,
+                               histogram, end - begin);
+    stats_add_histogram(histogram);
+}
+
+static void specific_volume_anomaly_chunk(const struct job *job,
+                                          size_t begin, size_t end)
+{
+    job->kernels->specific_volume_anomaly(job->in[0] + begin,
+                                          job->in[1] + begin,
+                                          job->in[2] + begin,
+                                          job->out[0] + begin,
+                                          OFFSET(job->out[1], begin),
+                                          end - begin);
+}
+
+static void depth_chunk(const struct job *job, size_t begin, size_t end)
+{
+    size_t i;
+
+    for (i = begin; i < end; i++)
+        job->out[0][i] = _depth(job->in[0][i], job->in[1][i]);
+}
+
+static void freezing_point_chunk(const struct job *job, size_t begin,
+                                 size_t end)
+{
+    job->kernels->freezing_point(job->in[0] + begin, job->in[1] + begin,
+                                 job->out[0] + begin, end - begin);
+}
+
+static void specific_heat_chunk(const struct job *job, size_t begin,
+                                size_t end)
+{
+    job->kernels->specific_heat(job->in[0] + begin, job->in[1] + begin,
+                                job->in[2] + begin, job->out[0] + begin,
+                                end - begin);
+}
+
+static void adiabatic_temperature_gradient_chunk(const struct job *job,
+                                                 size_t begin, size_t end)
+{
+    job->kernels->adiabatic_temperature_gradient(job->in[0] + begin,
+                                                 job->in[1] + begin,
+                                                 job->in[2] + begin,
+                                                 job->out[0] + begin,
+                                                 end - begin);
+}
+
+static void potential_temperature_chunk(const struct job *job, size_t begin,
+                                        size_t end)
+{
+    job->kernels->potential_temperature(job->in[0] + begin,
+                                        job->in[1] + begin,
+                                        job->in[2] + begin,
+                                        job->in[3] + begin,
+                                        job->out[0] + begin, end - begin);
+}
+
+static void sound_speed_chunk(const struct job *job, size_t begin, size_t end)
+{
+    job->kernels->sound_speed(job->in[0] + begin, job->in[1] + begin,
+                              job->in[2] + begin, job->out[0] + begin,
+                              end - begin);
+}
+
+static void ctd_derive_chunk(const struct job *job, size_t begin, size_t end)
+{
+    struct ctd_outputs out;
+
+    out.salinity = OFFSET(job->ctd->salinity, begin);
+    out.svan = OFFSET(job->ctd->svan, begin);
+    out.sigma = OFFSET(job->ctd->sigma, begin);
+    out.theta = OFFSET(job->ctd->theta, begin);
+    out.sound_speed = OFFSET(job->ctd->sound_speed, begin);
+    out.depth = OFFSET(job->ctd->depth, begin);
+    out.cpsw = OFFSET(job->ctd->cpsw, begin);
+    out.freezing_point = OFFSET(job->ctd->freezing_point, begin);
+    out.atg = OFFSET(job->ctd->atg, begin);
+
+    job->kernels->ctd_derive(OFFSET(job->in[0], begin), job->in[1] + begin,
+                             job->in[2] + begin, job->gravity,
+                             job->reference_pressure, job->outputs, &out,
+                             end - begin);
+}
+
+static void call_chunk(const struct job *job, size_t begin, size_t end)
+{
+    job->call(job->arg, begin, end);
+}
+
+/* Run run(arg, begin, end) on the chunks of [0, n) on pool, or on the
+ * default pool if NULL. */
+void parallel_run(struct oceanography_pool *pool,
+                  void (*run)(const void *arg, size_t begin, size_t end),
+                  const void *arg, size_t n)
+{
+    struct job job;
+
+    job_init(&job, call_chunk, NULL, NULL, NULL, NULL, n);
+    job.call = run;
+    job.arg = arg;
+    pool_run(pool, &job);
+}
+
+/* salinity_parallel -- parallel version of salinity_n().
+ *
+ * All the *_parallel functions run on pool, or on the pool set by
+ * oceanography_set_threads() if pool is NULL. Results are the same of the
+ * *_n functions.
+ */
+
+void salinity_parallel(struct oceanography_pool *pool,
+                       const double *conductivity, const double *temperature,
+                       const double *pressure, double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+    job_init(&job, salinity_chunk, conductivity, temperature, pressure, out,
+             n);
+    pool_run(pool, &job);
+    STATS_END(n, conductivity, 1, temperature, 1, pressure, 1);
+}
+
+/* conductivity_parallel -- parallel version of conductivity_n(). */
+
+void conductivity_parallel(struct oceanography_pool *pool,
+                           const double *salinity, const double *temperature,
+                           const double *pressure, double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CONDUCTIVITY);
+    job_init(&job, conductivity_chunk, salinity, temperature, pressure, out,
+             n);
+    pool_run(pool, &job);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* specific_volume_anomaly_parallel -- parallel version of
+ * specific_volume_anomaly_n().
+ */
+
+void specific_volume_anomaly_parallel(struct oceanography_pool *pool,
+                                      const double *salinity,
+                                      const double *temperature,
+                                      const double *pressure, double *out,
+                                      double *sigma, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_VOLUME_ANOMALY);
+    job_init(&job, specific_volume_anomaly_chunk, salinity, temperature,
+             pressure, out, n);
+    job.out[1] = sigma;
+    pool_run(pool, &job);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* depth_parallel -- parallel version of depth_n(). */
+
+void depth_parallel(struct oceanography_pool *pool, const double *pressure,
+                    const double *latitude, double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_DEPTH);
+    job_init(&job, depth_chunk, pressure, latitude, NULL, out, n);
+    pool_run(pool, &job);
+    STATS_END(n, pressure, 1, latitude, 1, NULL, 0);
+}
+
+/* freezing_point_parallel -- parallel version of freezing_point_n(). */
+
+void freezing_point_parallel(struct oceanography_pool *pool,
+                             const double *salinity, const double *pressure,
+                             double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_FREEZING_POINT);
+    job_init(&job, freezing_point_chunk, salinity, pressure, NULL, out, n);
+    pool_run(pool, &job);
+    STATS_END(n, salinity, 1, pressure, 1, NULL, 0);
+}
+
+/* specific_heat_parallel -- parallel version of specific_heat_n(). */
+
+void specific_heat_parallel(struct oceanography_pool *pool,
+                            const double *salinity, const double *temperature,
+                            const double *pressure, double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SPECIFIC_HEAT);
+    job_init(&job, specific_heat_chunk, salinity, temperature, pressure, out,
+             n);
+    pool_run(pool, &job);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* adiabatic_temperature_gradient_parallel -- parallel version of
+ * adiabatic_temperature_gradient_n().
+ */
+
+void adiabatic_temperature_gradient_parallel(struct oceanography_pool *pool,
+                                             const double *salinity,
+                                             const double *temperature,
+                                             const double *pressure,
+                                             double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_ADIABATIC_TEMPERATURE_GRADIENT);
+    job_init(&job, adiabatic_temperature_gradient_chunk, salinity,
+             temperature, pressure, out, n);
+    pool_run(pool, &job);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* potential_temperature_parallel -- parallel version of
+ * potential_temperature_n().
+ */
+
+void potential_temperature_parallel(struct oceanography_pool *pool,
+                                    const double *salinity,
+                                    const double *temperature,
+                                    const double *pressure,
+                                    const double *reference_pressure,
+                                    double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_POTENTIAL_TEMPERATURE);
+    job_init(&job, potential_temperature_chunk, salinity, temperature,
+             pressure, out, n);
+    job.in[3] = reference_pressure;
+    pool_run(pool, &job);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* sound_speed_parallel -- parallel version of sound_speed_n(). */
+
+void sound_speed_parallel(struct oceanography_pool *pool,
+                          const double *salinity, const double *temperature,
+                          const double *pressure, double *out, size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_SOUND_SPEED);
+    job_init(&job, sound_speed_chunk, salinity, temperature, pressure, out,
+             n);
+    pool_run(pool, &job);
+    STATS_END(n, salinity, 1, temperature, 1, pressure, 1);
+}
+
+/* ctd_derive_parallel -- parallel version of ctd_derive_n(). */
+
+void ctd_derive_parallel(struct oceanography_pool *pool,
+                         const double *conductivity,
+                         const double *temperature, const double *pressure,
+                         double latitude, double reference_pressure,
+                         unsigned int outputs, const struct ctd_outputs *out,
+                         size_t n)
+{
+    struct job job;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CTD_DERIVE);
+    job_init(&job, ctd_derive_chunk, conductivity, temperature, pressure,
+             NULL, n);
+    job.gravity = _gravity(latitude);
+    job.reference_pressure = reference_pressure;
+    job.outputs = outputs;
+    job.ctd = out;
+    pool_run(pool, &job);
+    STATS_END(n, outputs & CTD_SALINITY_OUTPUTS ? conductivity : NULL, 1,
+              temperature, 1, pressure, 1);
+}
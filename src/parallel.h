@@ -0,0 +1,40 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * parallel.h -- Private interface of the thread pool.
+ *
+ * parallel_run() runs a function on the chunks of samples [0, n) on the
+ * threads of a pool, for the functions of the library that are not a
+ * single batch kernel.
+ *
+ * This header is not installed.
+ */
+
+#ifndef OCEANOGRAPHY_PARALLEL_H
+#define OCEANOGRAPHY_PARALLEL_H
+
+#include <stddef.h>
+
+#include "oceanography.h"
+
+void parallel_run(struct oceanography_pool *pool,
+                  void (*run)(const void *arg, size_t begin, size_t end),
+                  const void *arg, size_t n);
+
+#endif /* OCEANOGRAPHY_PARALLEL_H */
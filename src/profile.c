@@ -0,0 +1,332 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * profile.c -- Functions integrating or differentiating along a profile.
+ *
+ * Samples are taken in the order they arrive: a struct keeps the state of
+ * the profile, so it can be extended with new scans without recomputing the
+ * prefix.
+ */
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+
+/* Samples whose specific volume anomaly, or density derivatives, are
+ * computed at once by the vectorized kernels. */
+#define BLOCK 256
+
+/* 1.0e-8 m^3/Kg times decibars to J/Kg. */
+#define SVAN_DBAR 1.0e-4
+
+/* geopotential_init -- start the integration of a profile.
+ *
+ * The integration starts from reference_pressure, in decibars. When it is
+ * not deeper than the first sample, the specific volume anomaly of the first
+ * sample is used between them. When it is deeper, the integration starts
+ * from the first sample, and the anomaly at the reference level, with the
+ * specific volume anomaly interpolated linearly between the samples around
+ * it, is subtracted once the level is crossed.
+ */
+
+void geopotential_init(struct geopotential *state, double reference_pressure)
+{
+    state->reference_pressure = reference_pressure;
+    state->pressure = reference_pressure;
+    state->svan = 0.0;
+    state->anomaly = 0.0;
+    state->count = 0;
+    state->deep = 0;
+}
+
+/* Anomaly at the reference level, from anomaly at the last sample of
+ * state and the next sample, of specific volume anomaly svan at pressure
+ * p. */
+static double reference_anomaly(const struct geopotential *state,
+                                double anomaly, double svan, double p)
+{
+    double dp = state->reference_pressure - state->pressure;
+    double v = state->svan + (svan - state->svan) * dp /
+               (p - state->pressure);
+
+    return anomaly + 0.5 * (state->svan + v) * dp * SVAN_DBAR;
+}
+
+/* Integrate n samples with the trapezoidal rule, writing the geopotential
+ * anomaly multiplied by scale. */
+static void integrate(struct geopotential *state, const double *salinity,
+                      const double *temperature, const double *pressure,
+                      double *out, double scale, size_t n)
+{
+    const struct simd_kernels *kernels = simd_select();
+    double svan[BLOCK];
+    double p, anomaly, reference;
+    size_t i, j, k, m;
+
+    for (i = 0; i < n; i += m) {
+        m = n - i < BLOCK ? n - i : BLOCK;
+        kernels->specific_volume_anomaly(salinity + i, temperature + i,
+                                         pressure + i, svan, NULL, m);
+
+        if (state->count == 0) {
+            state->svan = svan[0];
+            if (pressure[0] < state->reference_pressure) {
+                state->pressure = pressure[0];
+                state->deep = 1;
+            }
+        }
+
+        anomaly = state->anomaly;
+        for (j = 0; j < m; j++) {
+            /* Read pressure before writing out, that may alias it. */
+            p = pressure[i + j];
+            reference = anomaly;
+            anomaly += 0.5 * (state->svan + svan[j]) *
+                       (p - state->pressure) * SVAN_DBAR;
+            if (state->deep && p >= state->reference_pressure) {
+                /* Crossing the reference level: the samples of this call
+                 * before it are moved to the reference too. */
+                reference = p == state->reference_pressure ? anomaly :
+                            reference_anomaly(state, reference, svan[j], p);
+                for (k = 0; k < i + j; k++)
+                    out[k] -= reference * scale;
+                anomaly -= reference;
+                state->deep = 0;
+            }
+            state->svan = svan[j];
+            state->pressure = p;
+            out[i + j] = anomaly * scale;
+        }
+        state->anomaly = anomaly;
+        state->count += m;
+    }
+}
+
+/* geopotential_anomaly_n -- integrate the specific volume anomaly of n more
+ * samples of a profile.
+ *
+ * out[i] is the geopotential anomaly between the reference level and the
+ * pressure of sample i, accumulated from all the samples given to state
+ * since geopotential_init(). With a reference level deeper than the first
+ * sample, out is relative to the first sample until a call crosses the
+ * reference level, whose earlier samples are then corrected too. out can be
+ * the same array of salinity, temperature or pressure.
+ *
+ * Units:
+ *     salinity -- PSS-78
+ *     temperature -- degrees Celsius
+ *     pressure  -- decibars
+ *
+ * Writes geopotential anomaly as J/Kg (m^2/s^2).
+ */
+
+void geopotential_anomaly_n(struct geopotential *state,
+                            const double *salinity, const double *temperature,
+                            const double *pressure, double *out, size_t n)
+{
+    integrate(state, salinity, temperature, pressure, out, 1.0, n);
+}
+
+/* dynamic_height_n -- same as geopotential_anomaly_n(), writing dynamic
+ * height.
+ *
+ * Writes dynamic height as dynamic meters (10 J/Kg).
+ */
+
+void dynamic_height_n(struct geopotential *state, const double *salinity,
+                      const double *temperature, const double *pressure,
+                      double *out, size_t n)
+{
+    integrate(state, salinity, temperature, pressure, out, 0.1, n);
+}
+
+/* geopotential_anomaly -- get the geopotential anomaly at the last sample
+ * given to state, as J/Kg.
+ */
+
+double geopotential_anomaly(const struct geopotential *state)
+{
+    return state->anomaly;
+}
+
+/* buoyancy_frequency_init -- start the buoyancy frequency of a profile at
+ * latitude, in degrees.
+ */
+
+void buoyancy_frequency_init(struct buoyancy_frequency *state,
+                             double latitude)
+{
+    state->gravity = _gravity(latitude);
+    state->salinity = 0.0;
+    state->temperature = 0.0;
+    state->pressure = 0.0;
+    state->depth = 0.0;
+    state->count = 0;
+}
+
+/* buoyancy_frequency_n -- compute the squared buoyancy (Brunt-Vaisala)
+ * frequency between the consecutive samples of n more samples of a profile.
+ *
+ * Every sample after the first one given to state since
+ * buoyancy_frequency_init() writes to out the squared buoyancy frequency
+ * between it and the sample before, and to out_pressure, if not NULL, the
+ * pressure midway between them. Pressure must be increasing. out and
+ * out_pressure must not overlap the inputs.
+ *
+ * At the midpoint, N^2 = g * (beta * dS - alpha * (dT - atg * dp)) / dz,
+ * with the thermal expansion and haline contraction coefficients of
+ * density_derivatives() and the adiabatic temperature gradient, so that the
+ * in situ temperature difference is taken relative to an adiabatic
+ * displacement. g is the local gravity and dz the difference of the depths
+ * of the samples.
+ *
+ * Units:
+ *     salinity -- PSS-78
+ *     temperature -- degrees Celsius
+ *     pressure  -- decibars
+ *
+ * Writes squared buoyancy frequency as 1/s^2 and pressure as decibars.
+ * Returns the number of values written: n, or n - 1 if the profile starts
+ * with these samples.
+ */
+
+size_t buoyancy_frequency_n(struct buoyancy_frequency *state,
+                            const double *salinity, const double *temperature,
+                            const double *pressure, double *out,
+                            double *out_pressure, size_t n)
+{
+    const struct simd_kernels *kernels = simd_select();
+    double s[BLOCK], t[BLOCK], p[BLOCK], alpha[BLOCK], beta[BLOCK];
+    double gradient[BLOCK];
+    double ds[BLOCK], dt[BLOCK], dp[BLOCK], dz[BLOCK];
+    double z;
+    size_t i, j, m, written;
+
+    if (n == 0)
+        return 0;
+
+    i = 0;
+    written = 0;
+    if (state->count == 0) {
+        state->salinity = salinity[0];
+        state->temperature = temperature[0];
+        state->pressure = pressure[0];
+        state->depth = _depth_gravity(pressure[0], state->gravity);
+        state->count = 1;
+        i = 1;
+    }
+
+    for (; i < n; i += m) {
+        m = n - i < BLOCK ? n - i : BLOCK;
+
+        /* Midpoints and differences of the pairs of samples. */
+        for (j = 0; j < m; j++) {
+            z = _depth_gravity(pressure[i + j], state->gravity);
+            s[j] = 0.5 * (state->salinity + salinity[i + j]);
+            t[j] = 0.5 * (state->temperature + temperature[i + j]);
+            p[j] = 0.5 * (state->pressure + pressure[i + j]);
+            ds[j] = salinity[i + j] - state->salinity;
+            dt[j] = temperature[i + j] - state->temperature;
+            dp[j] = pressure[i + j] - state->pressure;
+            dz[j] = z - state->depth;
+            state->salinity = salinity[i + j];
+            state->temperature = temperature[i + j];
+            state->pressure = pressure[i + j];
+            state->depth = z;
+        }
+
+        kernels->density_derivatives(s, t, p, NULL, alpha, beta, NULL, m);
+        kernels->adiabatic_temperature_gradient(s, t, p, gradient, m);
+
+        /* Gravity grows by 2.184e-6 m/s^2 per decibar: depth uses its mean
+         * over the water column, half of it. */
+        for (j = 0; j < m; j++) {
+            out[written + j] = (state->gravity + 2.184e-6 * p[j]) *
+                               (beta[j] * ds[j] - alpha[j] *
+                                (dt[j] - gradient[j] * dp[j])) / dz[j];
+            if (out_pressure != NULL)
+                out_pressure[written + j] = p[j];
+        }
+        written += m;
+        state->count += m;
+    }
+
+    return written;
+}
+
+/* regrid_n -- interpolate the columns of a profile to standard depths.
+ *
+ * in[c][i], for c from 0 to columns - 1, is the value of column c at sample
+ * i, of pressure pressure[i]; samples must be sorted by increasing pressure.
+ * depth holds levels depths, sorted by increasing depth, whose pressures
+ * at latitude are computed as in pressure_from_depth(). out[c][l] receives
+ * column c interpolated linearly in pressure at level l, or fill if the
+ * level is above the first sample or below the last one.
+ *
+ * Samples and levels are merged in a single sweep, without searching the
+ * samples around every level.
+ *
+ * Units:
+ *     pressure  -- decibars
+ *     latitude -- degrees
+ *     depth -- meters
+ */
+
+void regrid_n(const double *pressure, double latitude,
+              const double *const *in, size_t columns, size_t n,
+              const double *depth, size_t levels, double fill,
+              double *const *out)
+{
+    const struct simd_kernels *kernels = simd_select();
+    double target[BLOCK], gravity[BLOCK];
+    double g, p, w;
+    size_t i, j, l, m, c;
+
+    g = _gravity(latitude);
+    for (j = 0; j < BLOCK; j++)
+        gravity[j] = g;
+
+    i = 0;
+    for (l = 0; l < levels; l += m) {
+        m = levels - l < BLOCK ? levels - l : BLOCK;
+        kernels->pressure_from_depth(depth + l, gravity, target, m);
+
+        for (j = 0; j < m; j++) {
+            p = target[j];
+            if (n == 0 || !(p >= pressure[0] && p <= pressure[n - 1])) {
+                for (c = 0; c < columns; c++)
+                    out[c][l + j] = fill;
+                continue;
+            }
+
+            /* The pair of samples around the level: pressure[i] <= p <=
+             * pressure[i + 1]. */
+            while (i + 2 < n && pressure[i + 1] < p)
+                i++;
+            if (i + 1 < n && pressure[i + 1] > pressure[i]) {
+                w = (p - pressure[i]) / (pressure[i + 1] - pressure[i]);
+                for (c = 0; c < columns; c++)
+                    out[c][l + j] = in[c][i] + w * (in[c][i + 1] - in[c][i]);
+            } else {
+                for (c = 0; c < columns; c++)
+                    out[c][l + j] = in[c][i];
+            }
+        }
+    }
+}
@@ -0,0 +1,409 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * realtime.c -- Real time ingestion of the scans of an instrument.
+ *
+ * The ring is a single producer, single consumer queue: the producer only
+ * writes head, the consumer only writes tail, and each side publishes its
+ * index with a release store after touching the slots, so no lock is taken.
+ * Each side keeps the last index of the other one it has seen, and loads it
+ * again only when the ring looks full or empty, and the two sides live on
+ * different cache lines.
+ *
+ * The consumer copies the scans a block at a time to columns, runs the
+ * ctd_derive kernel on them and adds the columns to the sums of the pressure
+ * bins. A call never takes more than max scans, so its latency is bounded by
+ * the caller, and nothing is allocated after oceanography_realtime_create().
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+
+/* Without the atomic builtins of GCC and Clang the indexes are read and
+ * written under a mutex: still correct, but no longer lock-free. */
+#ifdef __ATOMIC_ACQUIRE
+#define LOAD_ACQUIRE(realtime, index) \
+        __atomic_load_n(&(realtime)->index, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(realtime, index, value) \
+        __atomic_store_n(&(realtime)->index, value, __ATOMIC_RELEASE)
+#else
+#include <pthread.h>
+#define LOAD_ACQUIRE(realtime, index) \
+        locked_load(realtime, &(realtime)->index)
+#define STORE_RELEASE(realtime, index, value) \
+        locked_store(realtime, &(realtime)->index, value)
+#endif
+
+/* Scans per call of the kernel: the columns of a block take 6 KiB. */
+#define BLOCK 64
+
+#define CACHE_LINE 64
+
+/* Columns of a block and of the sums of a bin: conductivity ratio,
+ * temperature and pressure, then the outputs in the order of the
+ * OCEANOGRAPHY_CTD_* flags. */
+#define CTD_OUTPUTS 9
+#define COLUMNS (3 + CTD_OUTPUTS)
+
+struct oceanography_realtime {
+    /* Read only after oceanography_realtime_create(). */
+    struct oceanography_scan *ring;
+    size_t mask;                        /* slots - 1 */
+    double gravity;
+    double reference_pressure;
+    unsigned int outputs;
+    double scale;                       /* bins per decibar */
+    double limit;                       /* bins */
+    size_t bins;
+#ifndef __ATOMIC_ACQUIRE
+    pthread_mutex_t lock;
+#endif
+    char shared_pad[CACHE_LINE];
+
+    /* Producer. */
+    size_t head;                        /* next slot to write */
+    size_t tail_cache;                  /* tail as last seen */
+    char producer_pad[CACHE_LINE];
+
+    /* Consumer. */
+    size_t tail;                        /* next slot to read */
+    size_t head_cache;                  /* head as last seen */
+    struct ctd_outputs ctd;             /* outputs of the block */
+    size_t columns;                     /* selected columns */
+    unsigned int column[COLUMNS];
+    double block[COLUMNS][BLOCK];
+    double *sum;                        /* COLUMNS per bin */
+    unsigned long *count;
+};
+
+#ifndef __ATOMIC_ACQUIRE
+static size_t locked_load(struct oceanography_realtime *realtime,
+                          const size_t *index)
+{
+    size_t value;
+
+    pthread_mutex_lock(&realtime->lock);
+    value = *index;
+    pthread_mutex_unlock(&realtime->lock);
+
+    return value;
+}
+
+static void locked_store(struct oceanography_realtime *realtime,
+                         size_t *index, size_t value)
+{
+    pthread_mutex_lock(&realtime->lock);
+    *index = value;
+    pthread_mutex_unlock(&realtime->lock);
+}
+#endif
+
+/* oceanography_realtime_create -- create the ring and the pressure bins of
+ * an instrument.
+ *
+ * The ring holds spec->capacity scans, rounded up to a power of 2. The
+ * outputs selected by spec->outputs are computed at spec->latitude and
+ * spec->reference_pressure, as by ctd_derive_n. Bin k averages the scans
+ * with pressure in [k * bin_width, (k + 1) * bin_width), for k lower than
+ * spec->bins.
+ *
+ * Units: latitude degrees, reference_pressure and bin_width decibars.
+ *
+ * Returns NULL if the spec is not valid or memory is not enough.
+ */
+
+struct oceanography_realtime *oceanography_realtime_create(
+    const struct oceanography_realtime_spec *spec)
+{
+    struct oceanography_realtime *realtime;
+    double *columns[CTD_OUTPUTS];
+    size_t slots;
+    unsigned int k;
+
+    if (spec->capacity == 0 ||
+        spec->capacity > ((size_t) -1 / 2 + 1) / sizeof(*realtime->ring) ||
+        (spec->outputs & ~((1u << CTD_OUTPUTS) - 1)) != 0 ||
+        !(spec->bin_width > 0.0) ||
+        spec->bins > (size_t) -1 / (COLUMNS * sizeof(double)))
+        return NULL;
+
+    for (slots = 1; slots < spec->capacity; slots *= 2)
+        ;
+
+    realtime = malloc(sizeof(*realtime));
+    if (realtime == NULL)
+        return NULL;
+
+    realtime->sum = NULL;
+    realtime->count = NULL;
+    realtime->ring = malloc(slots * sizeof(*realtime->ring));
+    if (realtime->ring == NULL) {
+        free(realtime);
+        return NULL;
+    }
+    /* calloc() of 0 bins may return NULL. */
+    if (spec->bins > 0) {
+        realtime->sum = calloc(spec->bins * COLUMNS, sizeof(double));
+        realtime->count = calloc(spec->bins, sizeof(unsigned long));
+        if (realtime->sum == NULL || realtime->count == NULL) {
+            free(realtime->count);
+            free(realtime->sum);
+            free(realtime->ring);
+            free(realtime);
+            return NULL;
+        }
+    }
+
+    realtime->mask = slots - 1;
+    realtime->gravity = _gravity(spec->latitude);
+    realtime->reference_pressure = spec->reference_pressure;
+    realtime->outputs = spec->outputs;
+    realtime->scale = 1.0 / spec->bin_width;
+    realtime->limit = (double) spec->bins;
+    realtime->bins = spec->bins;
+    realtime->head = 0;
+    realtime->tail_cache = 0;
+    realtime->tail = 0;
+    realtime->head_cache = 0;
+#ifndef __ATOMIC_ACQUIRE
+    pthread_mutex_init(&realtime->lock, NULL);
+#endif
+
+    /* The inputs are always averaged, the outputs only if selected. */
+    realtime->columns = 0;
+    for (k = 0; k < COLUMNS; k++)
+        if (k < 3 || spec->outputs & (1u << (k - 3)))
+            realtime->column[realtime->columns++] = k;
+    for (k = 0; k < CTD_OUTPUTS; k++)
+        columns[k] = spec->outputs & (1u << k) ?
+                     realtime->block[3 + k] : NULL;
+    realtime->ctd.salinity = columns[0];
+    realtime->ctd.svan = columns[1];
+    realtime->ctd.sigma = columns[2];
+    realtime->ctd.theta = columns[3];
+    realtime->ctd.sound_speed = columns[4];
+    realtime->ctd.depth = columns[5];
+    realtime->ctd.cpsw = columns[6];
+    realtime->ctd.freezing_point = columns[7];
+    realtime->ctd.atg = columns[8];
+
+    return realtime;
+}
+
+/* oceanography_realtime_destroy -- free the ring and the bins. */
+
+void oceanography_realtime_destroy(struct oceanography_realtime *realtime)
+{
+    if (realtime == NULL)
+        return;
+
+#ifndef __ATOMIC_ACQUIRE
+    pthread_mutex_destroy(&realtime->lock);
+#endif
+    free(realtime->count);
+    free(realtime->sum);
+    free(realtime->ring);
+    free(realtime);
+}
+
+/* oceanography_realtime_push -- append a scan to the ring.
+ *
+ * Called by the producer thread only.
+ *
+ * Returns 0, or -1 if the ring is full and the scan is dropped.
+ */
+
+int oceanography_realtime_push(struct oceanography_realtime *realtime,
+                               const struct oceanography_scan *scan)
+{
+    size_t head = realtime->head;
+
+    if (head - realtime->tail_cache > realtime->mask) {
+        realtime->tail_cache = LOAD_ACQUIRE(realtime, tail);
+        if (head - realtime->tail_cache > realtime->mask)
+            return -1;
+    }
+
+    realtime->ring[head & realtime->mask] = *scan;
+    STORE_RELEASE(realtime, head, head + 1);
+
+    return 0;
+}
+
+/* Add the m scans of the block to the sums of their bins. Pressures out of
+ * the bins, and NaN, are skipped. */
+static void add_to_bins(struct oceanography_realtime *realtime, size_t m)
+{
+    const double *pressure = realtime->block[2];
+    double *sum, x;
+    size_t j, k, bin;
+
+    for (j = 0; j < m; j++) {
+        x = pressure[j] * realtime->scale;
+        if (!(x >= 0.0 && x < realtime->limit))
+            continue;
+        bin = (size_t) x;
+        realtime->count[bin]++;
+        sum = realtime->sum + bin * COLUMNS;
+        for (k = 0; k < realtime->columns; k++)
+            sum[realtime->column[k]] +=
+                realtime->block[realtime->column[k]][j];
+    }
+}
+
+/* Copy the m outputs of the block to the selected arrays of out, from
+ * index begin. */
+static void copy_outputs(const struct oceanography_realtime *realtime,
+                         const struct ctd_outputs *out, size_t begin,
+                         size_t m)
+{
+    double *columns[CTD_OUTPUTS];
+    unsigned int k;
+
+    columns[0] = out->salinity;
+    columns[1] = out->svan;
+    columns[2] = out->sigma;
+    columns[3] = out->theta;
+    columns[4] = out->sound_speed;
+    columns[5] = out->depth;
+    columns[6] = out->cpsw;
+    columns[7] = out->freezing_point;
+    columns[8] = out->atg;
+
+    for (k = 0; k < CTD_OUTPUTS; k++)
+        if (realtime->outputs & (1u << k) && columns[k] != NULL)
+            memcpy(columns[k] + begin, realtime->block[3 + k],
+                   m * sizeof(double));
+}
+
+/* oceanography_realtime_process -- compute the outputs of the scans in the
+ * ring and add them to the pressure bins.
+ *
+ * Called by the consumer thread only. At most max scans are taken, in the
+ * order they were pushed; their selected outputs are written to the arrays
+ * of out, that must hold max elements, or not written if out or an array is
+ * NULL. Outputs are identical to the ones of ctd_derive_n.
+ *
+ * Returns the number of scans taken.
+ */
+
+size_t oceanography_realtime_process(struct oceanography_realtime *realtime,
+                                     const struct ctd_outputs *out,
+                                     size_t max)
+{
+    const struct simd_kernels *kernels = simd_select();
+    const struct oceanography_scan *scan;
+    size_t done, m, j, tail;
+
+    for (done = 0; done < max; done += m) {
+        tail = realtime->tail;
+        if (realtime->head_cache == tail) {
+            realtime->head_cache = LOAD_ACQUIRE(realtime, head);
+            if (realtime->head_cache == tail)
+                break;
+        }
+
+        m = realtime->head_cache - tail;
+        if (m > max - done)
+            m = max - done;
+        if (m > BLOCK)
+            m = BLOCK;
+
+        for (j = 0; j < m; j++) {
+            scan = &realtime->ring[(tail + j) & realtime->mask];
+            realtime->block[0][j] = scan->conductivity;
+            realtime->block[1][j] = scan->temperature;
+            realtime->block[2][j] = scan->pressure;
+        }
+        /* The slots are free as soon as they are copied. */
+        STORE_RELEASE(realtime, tail, tail + m);
+
+        kernels->ctd_derive(realtime->block[0], realtime->block[1],
+                            realtime->block[2], realtime->gravity,
+                            realtime->reference_pressure, realtime->outputs,
+                            &realtime->ctd, m);
+        if (realtime->bins > 0)
+            add_to_bins(realtime, m);
+        if (out != NULL)
+            copy_outputs(realtime, out, done, m);
+    }
+
+    return done;
+}
+
+/* oceanography_realtime_bin -- get the averages of a pressure bin.
+ *
+ * Called by the consumer thread only. The averages of the outputs that are
+ * not selected, and all of them for an empty bin, are 0.
+ *
+ * Returns 0, or -1 if bin is not lower than the number of bins.
+ */
+
+int oceanography_realtime_bin(const struct oceanography_realtime *realtime,
+                              size_t bin, struct oceanography_bin *average)
+{
+    double mean[COLUMNS];
+    const double *sum;
+    unsigned int k;
+
+    if (bin >= realtime->bins)
+        return -1;
+
+    sum = realtime->sum + bin * COLUMNS;
+    for (k = 0; k < COLUMNS; k++)
+        mean[k] = realtime->count[bin] > 0 ?
+                  sum[k] / realtime->count[bin] : 0.0;
+
+    average->count = realtime->count[bin];
+    average->conductivity = mean[0];
+    average->temperature = mean[1];
+    average->pressure = mean[2];
+    average->salinity = mean[3];
+    average->svan = mean[4];
+    average->sigma = mean[5];
+    average->theta = mean[6];
+    average->sound_speed = mean[7];
+    average->depth = mean[8];
+    average->cpsw = mean[9];
+    average->freezing_point = mean[10];
+    average->atg = mean[11];
+
+    return 0;
+}
+
+/* oceanography_realtime_clear -- empty the pressure bins, for a new cast.
+ *
+ * Called by the consumer thread only. The scans in the ring are kept.
+ */
+
+void oceanography_realtime_clear(struct oceanography_realtime *realtime)
+{
+    size_t k;
+
+    for (k = 0; k < realtime->bins * COLUMNS; k++)
+        realtime->sum[k] = 0.0;
+    for (k = 0; k < realtime->bins; k++)
+        realtime->count[k] = 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * simd.h -- Private interface of the vectorized kernels.
+ *
+ * Every instruction set compiled into the library provides a table of batch
+ * kernels (see simd_template.h), and one of single precision kernels (see
+ * simd_template_f.h); simd_select() and simd_select_f() return the tables
+ * selected at runtime by dispatch.c.
+ *
+ * This header is not installed.
+ */
+
+#ifndef OCEANOGRAPHY_SIMD_H
+#define OCEANOGRAPHY_SIMD_H
+
+#include <stddef.h>
+
+#include "oceanography.h"
+
+struct table_layout;
+
+struct simd_kernels {
+    void (*salinity)(const double *conductivity, const double *temperature,
+                     const double *pressure, double *out, size_t n);
+    void (*conductivity)(const double *salinity, const double *temperature,
+                         const double *pressure, double *out,
+                         unsigned long *histogram, size_t n);
+    void (*specific_volume_anomaly)(const double *salinity,
+                                    const double *temperature,
+                                    const double *pressure, double *out,
+                                    double *sigma, size_t n);
+    void (*freezing_point)(const double *salinity, const double *pressure,
+                           double *out, size_t n);
+    void (*specific_heat)(const double *salinity, const double *temperature,
+                          const double *pressure, double *out, size_t n);
+    void (*adiabatic_temperature_gradient)(const double *salinity,
+                                           const double *temperature,
+                                           const double *pressure,
+                                           double *out, size_t n);
+    void (*potential_temperature)(const double *salinity,
+                                  const double *temperature,
+                                  const double *pressure,
+                                  const double *reference_pressure,
+                                  double *out, size_t n);
+    void (*potential_temperature_multi)(const double *salinity,
+                                        const double *temperature,
+                                        const double *pressure,
+                                        const double *reference_pressure,
+                                        size_t references, double *const *out,
+                                        size_t n);
+    void (*in_situ_temperature)(const double *salinity, const double *theta,
+                                const double *pressure,
+                                const double *reference_pressure,
+                                double *out, size_t n);
+    void (*sound_speed)(const double *salinity, const double *temperature,
+                        const double *pressure, double *out, size_t n);
+    void (*ctd_derive)(const double *conductivity, const double *temperature,
+                       const double *pressure, double gravity,
+                       double reference_pressure, unsigned int outputs,
+                       const struct ctd_outputs *out, size_t n);
+    void (*density_derivatives)(const double *salinity,
+                                const double *temperature,
+                                const double *pressure, double *sigma,
+                                double *alpha, double *beta, double *kappa,
+                                size_t n);
+    void (*density)(const double *salinity, const double *temperature,
+                    const double *pressure, double *out, size_t n);
+    void (*potential_density)(const double *salinity,
+                              const double *temperature,
+                              const double *pressure,
+                              const double *reference_pressure, double *out,
+                              size_t n);
+    void (*potential_density_multi)(const double *salinity,
+                                    const double *temperature,
+                                    const double *pressure,
+                                    const double *reference_pressure,
+                                    size_t references, double *sigma,
+                                    double *const *out, size_t n);
+    void (*pressure_from_depth)(const double *depth, const double *gravity,
+                                double *out, size_t n);
+    void (*salinity_from_density)(const double *sigma,
+                                  const double *temperature,
+                                  const double *pressure, double *out,
+                                  double *residual, size_t n);
+    void (*temperature_from_sound_speed)(const double *sound_speed,
+                                         const double *salinity,
+                                         const double *pressure, double *out,
+                                         double *residual, size_t n);
+    void (*salinity_level)(const struct oceanography_level *level,
+                           const double *conductivity,
+                           const double *temperature, double *out, size_t n);
+    void (*conductivity_level)(const struct oceanography_level *level,
+                               const double *salinity,
+                               const double *temperature, double *out,
+                               unsigned long *histogram, size_t n);
+    void (*specific_volume_anomaly_level)(
+        const struct oceanography_level *level, const double *salinity,
+        const double *temperature, double *out, double *sigma, size_t n);
+    void (*freezing_point_level)(const struct oceanography_level *level,
+                                 const double *salinity, double *out,
+                                 size_t n);
+    void (*specific_heat_level)(const struct oceanography_level *level,
+                                const double *salinity,
+                                const double *temperature, double *out,
+                                size_t n);
+    void (*adiabatic_temperature_gradient_level)(
+        const struct oceanography_level *level, const double *salinity,
+        const double *temperature, double *out, size_t n);
+    void (*sound_speed_level)(const struct oceanography_level *level,
+                              const double *salinity,
+                              const double *temperature, double *out,
+                              size_t n);
+    void (*table)(const struct table_layout *table, const double *salinity,
+                  const double *temperature, const double *pressure,
+                  double *out, size_t n);
+};
+
+struct simd_kernels_f {
+    void (*salinity)(const float *conductivity, const float *temperature,
+                     const float *pressure, float *out, size_t n);
+    void (*conductivity)(const float *salinity, const float *temperature,
+                         const float *pressure, float *out,
+                         unsigned long *histogram, size_t n);
+    void (*specific_volume_anomaly)(const float *salinity,
+                                    const float *temperature,
+                                    const float *pressure, float *out,
+                                    float *sigma, size_t n);
+    void (*depth)(const float *pressure, const float *latitude, float *out,
+                  size_t n);
+    void (*freezing_point)(const float *salinity, const float *pressure,
+                           float *out, size_t n);
+    void (*specific_heat)(const float *salinity, const float *temperature,
+                          const float *pressure, float *out, size_t n);
+    void (*adiabatic_temperature_gradient)(const float *salinity,
+                                           const float *temperature,
+                                           const float *pressure, float *out,
+                                           size_t n);
+    void (*potential_temperature)(const float *salinity,
+                                  const float *temperature,
+                                  const float *pressure,
+                                  const float *reference_pressure,
+                                  float *out, size_t n);
+    void (*in_situ_temperature)(const float *salinity, const float *theta,
+                                const float *pressure,
+                                const float *reference_pressure, float *out,
+                                size_t n);
+    void (*sound_speed)(const float *salinity, const float *temperature,
+                        const float *pressure, float *out, size_t n);
+};
+
+extern const struct simd_kernels simd_kernels_scalar;
+#ifdef OCEANOGRAPHY_HAVE_SSE2
+extern const struct simd_kernels simd_kernels_sse2;
+#endif
+#ifdef OCEANOGRAPHY_HAVE_AVX2
+extern const struct simd_kernels simd_kernels_avx2;
+#endif
+#ifdef OCEANOGRAPHY_HAVE_AVX512
+extern const struct simd_kernels simd_kernels_avx512;
+#endif
+
+extern const struct simd_kernels_f simd_kernels_f_scalar;
+#ifdef OCEANOGRAPHY_HAVE_SSE2
+extern const struct simd_kernels_f simd_kernels_f_sse2;
+#endif
+#ifdef OCEANOGRAPHY_HAVE_AVX2
+extern const struct simd_kernels_f simd_kernels_f_avx2;
+#endif
+#ifdef OCEANOGRAPHY_HAVE_AVX512
+extern const struct simd_kernels_f simd_kernels_f_avx512;
+#endif
+
+const struct simd_kernels *simd_select(void);
+const struct simd_kernels_f *simd_select_f(void);
+
+#endif /* OCEANOGRAPHY_SIMD_H */
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * simd_avx2.c -- AVX2 batch kernels.
+ *
+ * This file is compiled with -mavx2 and its kernels are only called
+ * when dispatch.c finds AVX2 on the host CPU.
+ */
+
+#include <immintrin.h>
+
+#define V __m256d
+#define V_WIDTH 4
+#define V_SET1(x) _mm256_set1_pd(x)
+#define V_LOADU(p) _mm256_loadu_pd(p)
+#define V_STOREU(p, v) _mm256_storeu_pd(p, v)
+#define V_ADD(a, b) _mm256_add_pd(a, b)
+#define V_SUB(a, b) _mm256_sub_pd(a, b)
+#define V_MUL(a, b) _mm256_mul_pd(a, b)
+#define V_DIV(a, b) _mm256_div_pd(a, b)
+#define V_SQRT(a) _mm256_sqrt_pd(a)
+#define V_ABS(a) _mm256_andnot_pd(_mm256_set1_pd(-0.0), a)
+#define V_MASK __m256d
+#define V_EQ(a, b) _mm256_cmp_pd(a, b, _CMP_EQ_OQ)
+#define V_LE(a, b) _mm256_cmp_pd(a, b, _CMP_LE_OQ)
+#define V_GT(a, b) _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+#define V_AND(m1, m2) _mm256_and_pd(m1, m2)
+#define V_ANY(m) (_mm256_movemask_pd(m) != 0)
+#define V_SELECT(m, a, b) _mm256_blendv_pd(b, a, m)
+#define V_MIN(a, b) _mm256_min_pd(a, b)
+#define V_FLOOR(a) _mm256_floor_pd(a)
+
+#define SIMD_NAME(name) name##_avx2
+
+#include "simd_template.h"
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * simd_avx512_f.c -- AVX-512 single precision batch kernels.
+ *
+ * This file is compiled with -mavx512f and its kernels are only called
+ * when dispatch.c finds AVX-512 on the host CPU.
+ */
+
+#include <immintrin.h>
+
+#define V __m512
+#define V_WIDTH 16
+#define V_SET1(x) _mm512_set1_ps((float) (x))
+#define V_LOADU(p) _mm512_loadu_ps(p)
+#define V_STOREU(p, v) _mm512_storeu_ps(p, v)
+#define V_ADD(a, b) _mm512_add_ps(a, b)
+#define V_SUB(a, b) _mm512_sub_ps(a, b)
+#define V_MUL(a, b) _mm512_mul_ps(a, b)
+#define V_DIV(a, b) _mm512_div_ps(a, b)
+#define V_SQRT(a) _mm512_sqrt_ps(a)
+#define V_ABS(a) _mm512_abs_ps(a)
+#define V_MASK __mmask16
+#define V_EQ(a, b) _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)
+#define V_LE(a, b) _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ)
+#define V_GT(a, b) _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ)
+#define V_AND(m1, m2) ((__mmask16) ((m1) & (m2)))
+#define V_ANY(m) ((m) != 0)
+#define V_SELECT(m, a, b) _mm512_mask_blend_ps(m, b, a)
+
+#define SIMD_NAME(name) name##_avx512
+
+#include "simd_template_f.h"
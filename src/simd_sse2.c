@@ -0,0 +1,68 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * simd_sse2.c -- SSE2 batch kernels.
+ *
+ * This file is compiled with -msse2 and its kernels are only called
+ * when dispatch.c finds SSE2 on the host CPU.
+ */
+
+#include <immintrin.h>
+
+#define V __m128d
+#define V_WIDTH 2
+#define V_SET1(x) _mm_set1_pd(x)
+#define V_LOADU(p) _mm_loadu_pd(p)
+#define V_STOREU(p, v) _mm_storeu_pd(p, v)
+#define V_ADD(a, b) _mm_add_pd(a, b)
+#define V_SUB(a, b) _mm_sub_pd(a, b)
+#define V_MUL(a, b) _mm_mul_pd(a, b)
+#define V_DIV(a, b) _mm_div_pd(a, b)
+#define V_SQRT(a) _mm_sqrt_pd(a)
+#define V_ABS(a) _mm_andnot_pd(_mm_set1_pd(-0.0), a)
+#define V_MASK __m128d
+#define V_EQ(a, b) _mm_cmpeq_pd(a, b)
+#define V_LE(a, b) _mm_cmple_pd(a, b)
+#define V_GT(a, b) _mm_cmpgt_pd(a, b)
+#define V_AND(m1, m2) _mm_and_pd(m1, m2)
+#define V_ANY(m) (_mm_movemask_pd(m) != 0)
+#define V_SELECT(m, a, b) _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b))
+#define V_MIN(a, b) _mm_min_pd(a, b)
+#define V_FLOOR(a) floor_sse2(a)
+
+/* SSE2 has no rounding instruction: adding and subtracting 2^52 rounds the
+ * magnitude to an integer, and the result steps back if it rounded up.
+ * Magnitudes from 2^52 on, infinities and NaN are integers already. */
+static __m128d floor_sse2(__m128d a)
+{
+    const __m128d big = _mm_set1_pd(4503599627370496.0);
+    __m128d sign = _mm_and_pd(a, _mm_set1_pd(-0.0));
+    __m128d magnitude = _mm_xor_pd(a, sign);
+    __m128d small = _mm_cmplt_pd(magnitude, big);
+    __m128d r;
+
+    r = _mm_or_pd(_mm_sub_pd(_mm_add_pd(magnitude, big), big), sign);
+    r = _mm_sub_pd(r, _mm_and_pd(_mm_cmpgt_pd(r, a), _mm_set1_pd(1.0)));
+
+    return V_SELECT(small, r, a);
+}
+
+#define SIMD_NAME(name) name##_sse2
+
+#include "simd_template.h"
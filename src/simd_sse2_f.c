@@ -0,0 +1,49 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * simd_sse2_f.c -- SSE2 single precision batch kernels.
+ *
+ * This file is compiled with -msse2 and its kernels are only called
+ * when dispatch.c finds SSE2 on the host CPU.
+ */
+
+#include <immintrin.h>
+
+#define V __m128
+#define V_WIDTH 4
+#define V_SET1(x) _mm_set1_ps((float) (x))
+#define V_LOADU(p) _mm_loadu_ps(p)
+#define V_STOREU(p, v) _mm_storeu_ps(p, v)
+#define V_ADD(a, b) _mm_add_ps(a, b)
+#define V_SUB(a, b) _mm_sub_ps(a, b)
+#define V_MUL(a, b) _mm_mul_ps(a, b)
+#define V_DIV(a, b) _mm_div_ps(a, b)
+#define V_SQRT(a) _mm_sqrt_ps(a)
+#define V_ABS(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+#define V_MASK __m128
+#define V_EQ(a, b) _mm_cmpeq_ps(a, b)
+#define V_LE(a, b) _mm_cmple_ps(a, b)
+#define V_GT(a, b) _mm_cmpgt_ps(a, b)
+#define V_AND(m1, m2) _mm_and_ps(m1, m2)
+#define V_ANY(m) (_mm_movemask_ps(m) != 0)
+#define V_SELECT(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+
+#define SIMD_NAME(name) name##_sse2
+
+#include "simd_template_f.h"
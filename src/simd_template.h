@@ -0,0 +1,1146 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * simd_template.h -- Vectorized batch kernels, written once for every
+ * instruction set.
+ *
+ * This file is included by simd_<isa>.c after defining:
+ *
+ *     V                      -- vector type
+ *     V_WIDTH                -- number of doubles in V
+ *     V_SET1(x)              -- broadcast a double
+ *     V_LOADU(p), V_STOREU(p, v)
+ *     V_ADD, V_SUB, V_MUL, V_DIV, V_SQRT, V_ABS
+ *     V_MASK                 -- type of the result of a comparison
+ *     V_EQ, V_LE, V_GT       -- lane by lane comparisons
+ *     V_AND(m1, m2)          -- and of two masks
+ *     V_ANY(m)               -- nonzero if any lane of m is set
+ *     V_SELECT(m, a, b)      -- a where m is set, b elsewhere
+ *     SIMD_NAME(name)        -- name with the instruction set suffix
+ *
+ * Every kernel performs the same operations, in the same order, of its
+ * scalar counterpart in kernels.h, so results are bit for bit identical.
+ * Subtractions of a constant are written as additions of the opposite
+ * constant, which is exact. The last n % V_WIDTH samples are handled by the
+ * scalar kernels.
+ */
+
+#include "kernels.h"
+#include "simd.h"
+#include "oceanography_cores.h"
+
+/* Batch kernels. */
+
+static void SIMD_NAME(conductivity)(const double *salinity,
+                                    const double *temperature,
+                                    const double *pressure, double *out,
+                                    unsigned long *histogram, size_t n)
+{
+    size_t i;
+    int j, iterations;
+    double counts[V_WIDTH];
+    V count;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        V_STOREU(out + i, SIMD_NAME(conductivity_core)(
+                     V_LOADU(salinity + i), V_LOADU(temperature + i),
+                     V_LOADU(pressure + i), &count));
+
+        if (histogram != NULL) {
+            V_STOREU(counts, count);
+            for (j = 0; j < V_WIDTH; j++)
+                histogram[(int) counts[j]]++;
+        }
+    }
+
+    for (; i < n; i++) {
+        out[i] = _conductivity_iterations(salinity[i], temperature[i],
+                                          pressure[i], &iterations);
+        if (histogram != NULL)
+            histogram[iterations]++;
+    }
+}
+
+static void SIMD_NAME(salinity)(const double *conductivity,
+                                const double *temperature,
+                                const double *pressure, double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH)
+        V_STOREU(out + i, SIMD_NAME(salinity_core)(V_LOADU(conductivity + i),
+                                                   V_LOADU(temperature + i),
+                                                   V_LOADU(pressure + i)));
+
+    for (; i < n; i++)
+        out[i] = _salinity(conductivity[i], temperature[i], pressure[i]);
+}
+
+static void SIMD_NAME(specific_volume_anomaly)(const double *salinity,
+                                               const double *temperature,
+                                               const double *pressure,
+                                               double *out, double *sigma,
+                                               size_t n)
+{
+    size_t i;
+    double sig;
+    V s, sg;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(specific_volume_anomaly_sr)(
+                     s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i),
+                     V_DIV(V_LOADU(pressure + i), K(10.)), &sg));
+        if (sigma != NULL)
+            V_STOREU(sigma + i, sg);
+    }
+
+    for (; i < n; i++) {
+        out[i] = _specific_volume_anomaly(salinity[i], temperature[i],
+                                          pressure[i], &sig);
+        if (sigma != NULL)
+            sigma[i] = sig;
+    }
+}
+
+static void SIMD_NAME(freezing_point)(const double *salinity,
+                                      const double *pressure, double *out,
+                                      size_t n)
+{
+    size_t i;
+    V s;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(freezing_point_sr)(
+                     s, V_SQRT(V_ABS(s)), V_LOADU(pressure + i)));
+    }
+
+    for (; i < n; i++)
+        out[i] = _freezing_point(salinity[i], pressure[i]);
+}
+
+static void SIMD_NAME(specific_heat)(const double *salinity,
+                                     const double *temperature,
+                                     const double *pressure, double *out,
+                                     size_t n)
+{
+    size_t i;
+    V s;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(specific_heat_sr)(
+                     s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i),
+                     V_DIV(V_LOADU(pressure + i), K(10.0))));
+    }
+
+    for (; i < n; i++)
+        out[i] = _specific_heat(salinity[i], temperature[i], pressure[i]);
+}
+
+static void SIMD_NAME(adiabatic_temperature_gradient)(const double *salinity,
+                                                      const double *temperature,
+                                                      const double *pressure,
+                                                      double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH)
+        V_STOREU(out + i, SIMD_NAME(adiabatic_temperature_gradient_core)(
+                     V_LOADU(salinity + i), V_LOADU(temperature + i),
+                     V_LOADU(pressure + i)));
+
+    for (; i < n; i++)
+        out[i] = _adiabatic_temperature_gradient(salinity[i], temperature[i],
+                                                 pressure[i]);
+}
+
+static void SIMD_NAME(potential_temperature)(const double *salinity,
+                                             const double *temperature,
+                                             const double *pressure,
+                                             const double *reference_pressure,
+                                             double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH)
+        V_STOREU(out + i, SIMD_NAME(potential_temperature_core)(
+                     V_LOADU(salinity + i), V_LOADU(temperature + i),
+                     V_LOADU(pressure + i), V_LOADU(reference_pressure + i)));
+
+    for (; i < n; i++)
+        out[i] = _potential_temperature(salinity[i], temperature[i],
+                                        pressure[i], reference_pressure[i]);
+}
+
+/* The first adiabatic temperature gradient of the Runge-Kutta integration
+ * does not depend on the reference pressure: it is computed once for all of
+ * them. */
+static void SIMD_NAME(potential_temperature_multi)(
+    const double *salinity, const double *temperature, const double *pressure,
+    const double *reference_pressure, size_t references, double *const *out,
+    size_t n)
+{
+    size_t i, r;
+    double atg;
+    V s, t, p, gradient;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        t = V_LOADU(temperature + i);
+        p = V_LOADU(pressure + i);
+        gradient = SIMD_NAME(adiabatic_temperature_gradient_core)(s, t, p);
+        for (r = 0; r < references; r++)
+            V_STOREU(out[r] + i, SIMD_NAME(potential_temperature_atg)(
+                         s, t, p, K(reference_pressure[r]), gradient));
+    }
+
+    for (; i < n; i++) {
+        atg = _adiabatic_temperature_gradient(salinity[i], temperature[i],
+                                              pressure[i]);
+        for (r = 0; r < references; r++)
+            out[r][i] = _potential_temperature_atg(salinity[i],
+                                                   temperature[i],
+                                                   pressure[i],
+                                                   reference_pressure[r],
+                                                   atg);
+    }
+}
+
+static void SIMD_NAME(in_situ_temperature)(const double *salinity,
+                                           const double *theta,
+                                           const double *pressure,
+                                           const double *reference_pressure,
+                                           double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH)
+        V_STOREU(out + i, SIMD_NAME(in_situ_temperature_core)(
+                     V_LOADU(salinity + i), V_LOADU(theta + i),
+                     V_LOADU(pressure + i), V_LOADU(reference_pressure + i)));
+
+    for (; i < n; i++)
+        out[i] = _in_situ_temperature(salinity[i], theta[i], pressure[i],
+                                      reference_pressure[i]);
+}
+
+static void SIMD_NAME(sound_speed)(const double *salinity,
+                                   const double *temperature,
+                                   const double *pressure, double *out,
+                                   size_t n)
+{
+    size_t i;
+    V s;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(sound_speed_sr)(
+                     s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i),
+                     V_DIV(V_LOADU(pressure + i), K(10.0))));
+    }
+
+    for (; i < n; i++)
+        out[i] = _sound_speed(salinity[i], temperature[i], pressure[i]);
+}
+
+/* The fused pipeline: salinity, sqrt(fabs(salinity)), pressure in bars and
+ * the first adiabatic temperature gradient are computed once per vector and
+ * shared by all the requested outputs.
+ */
+static void SIMD_NAME(ctd_derive)(const double *conductivity,
+                                  const double *temperature,
+                                  const double *pressure, double gravity,
+                                  double reference_pressure,
+                                  unsigned int outputs,
+                                  const struct ctd_outputs *out, size_t n)
+{
+    size_t i;
+    V s, sr, t, p, p10, sg, v, atg;
+
+    s = sr = K(0.0);
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        t = V_LOADU(temperature + i);
+        p = V_LOADU(pressure + i);
+        p10 = V_DIV(p, K(10.0));
+
+        if (outputs & CTD_SALINITY_OUTPUTS) {
+            s = SIMD_NAME(salinity_core)(V_LOADU(conductivity + i), t, p);
+            sr = V_SQRT(V_ABS(s));
+        }
+        if (outputs & OCEANOGRAPHY_CTD_SALINITY)
+            V_STOREU(out->salinity + i, s);
+        if (outputs & (OCEANOGRAPHY_CTD_SVAN | OCEANOGRAPHY_CTD_SIGMA)) {
+            v = SIMD_NAME(specific_volume_anomaly_sr)(s, sr, t, p10, &sg);
+            if (outputs & OCEANOGRAPHY_CTD_SVAN)
+                V_STOREU(out->svan + i, v);
+            if (outputs & OCEANOGRAPHY_CTD_SIGMA)
+                V_STOREU(out->sigma + i, sg);
+        }
+        if (outputs & (OCEANOGRAPHY_CTD_ATG | OCEANOGRAPHY_CTD_THETA)) {
+            atg = SIMD_NAME(adiabatic_temperature_gradient_core)(s, t, p);
+            if (outputs & OCEANOGRAPHY_CTD_ATG)
+                V_STOREU(out->atg + i, atg);
+            if (outputs & OCEANOGRAPHY_CTD_THETA)
+                V_STOREU(out->theta + i, SIMD_NAME(potential_temperature_atg)(
+                             s, t, p, K(reference_pressure), atg));
+        }
+        if (outputs & OCEANOGRAPHY_CTD_SOUND_SPEED)
+            V_STOREU(out->sound_speed + i,
+                     SIMD_NAME(sound_speed_sr)(s, sr, t, p10));
+        if (outputs & OCEANOGRAPHY_CTD_CPSW)
+            V_STOREU(out->cpsw + i,
+                     SIMD_NAME(specific_heat_sr)(s, sr, t, p10));
+        if (outputs & OCEANOGRAPHY_CTD_FREEZING_POINT)
+            V_STOREU(out->freezing_point + i,
+                     SIMD_NAME(freezing_point_sr)(s, sr, p));
+        if (outputs & OCEANOGRAPHY_CTD_DEPTH)
+            V_STOREU(out->depth + i,
+                     SIMD_NAME(depth_gravity)(p, K(gravity)));
+    }
+
+    for (; i < n; i++)
+        _ctd_derive(conductivity, temperature, pressure, gravity,
+                    reference_pressure, outputs, out, i);
+}
+
+/* The vector counterpart of _density_derivatives_sr(): only double
+ * precision has it. */
+static V SIMD_NAME(density_derivatives_sr)(V s, V sr, V t, V p, V *alpha,
+                                           V *beta, V *kappa)
+{
+    V rho0, sig_t, sig_s, r2, r3, e, b, c, a, aw, bw, a1, b1, kw, ko;
+    V e_t, bw_t, c_t, aw_t, a1_t, b1_t, kw_t, k, k_t, k_s, k_p, q, g;
+
+    rho0 = V_ADD(K(1028.1063), SIMD_NAME(sigma_sr)(s, sr, t));
+    r2 = H(H(H(H(K(5.3875e-9), t, -8.2467e-7), t, 7.6438e-5), t,
+             -4.0899e-3), t, 8.24493e-1);
+    r3 = H(H(K(-1.6546e-6), t, 1.0227e-4), t, -5.72466e-3);
+    sig_t = V_ADD(H(H(H(H(K(3.268166e-8), t, -4.480332e-6), t, 3.005055e-4),
+                      t, -1.819058e-2), t, 6.793952e-2),
+                  V_MUL(V_ADD(H(H(H(K(2.155e-8), t, -2.47401e-6), t,
+                                  1.52876e-4), t, -4.0899e-3),
+                              V_MUL(H(K(-3.3092e-6), t, 1.0227e-4), sr)),
+                        s));
+    sig_s = V_ADD(V_ADD(V_MUL(K(9.6628e-4), s), V_MUL(V_MUL(K(1.5), r3), sr)),
+                  r2);
+
+    e = H(H(K(9.1697e-10), t, 2.0816e-8), t, -9.9348e-7);
+    bw = H(H(K(5.2787e-8), t, -6.12293e-6), t, 3.47718e-5);
+    b = V_ADD(bw, V_MUL(e, s));
+    c = H(H(K(-1.6078e-6), t, -1.0981e-5), t, 2.2838e-3);
+    aw = H(H(H(K(-5.77905e-7), t, 1.16092e-4), t, 1.43713e-3), t,
+           -0.1194975);
+    a = V_ADD(V_MUL(V_ADD(V_MUL(K(1.91075e-4), sr), c), s), aw);
+    b1 = H(H(K(-5.3009e-4), t, 1.6483e-2), t, 7.944e-2);
+    a1 = H(H(H(K(-6.1670e-5), t, 1.09987e-2), t, -0.603459), t, 54.6746);
+    kw = H(H(H(H(K(-5.155288e-5), t, 1.360477e-2), t, -2.327105), t,
+             148.4206), t, -1930.06);
+    ko = V_ADD(V_MUL(V_ADD(V_MUL(b1, sr), a1), s), kw);
+    k = V_ADD(V_ADD(V_MUL(V_ADD(V_MUL(b, p), a), p), ko),
+              H(H(K(5.03217e-5), p, 3.359406), p, 21582.27));
+
+    e_t = H(K(1.83394e-9), t, 2.0816e-8);
+    bw_t = H(K(1.05574e-7), t, -6.12293e-6);
+    c_t = H(K(-3.2156e-6), t, -1.0981e-5);
+    aw_t = H(H(K(-1.733715e-6), t, 2.32184e-4), t, 1.43713e-3);
+    b1_t = H(K(-1.06018e-3), t, 1.6483e-2);
+    a1_t = H(H(K(-1.8501e-4), t, 2.19974e-2), t, -0.603459);
+    kw_t = H(H(H(K(-2.0621152e-4), t, 4.081431e-2), t, -4.65421), t,
+             148.4206);
+    k_t = V_ADD(V_MUL(V_ADD(V_MUL(V_ADD(bw_t, V_MUL(e_t, s)), p),
+                            V_ADD(V_MUL(c_t, s), aw_t)), p),
+                V_ADD(V_MUL(V_ADD(V_MUL(b1_t, sr), a1_t), s), kw_t));
+    k_s = V_ADD(V_MUL(V_ADD(V_MUL(e, p),
+                            V_ADD(V_MUL(K(2.866125e-4), sr), c)), p),
+                V_ADD(V_MUL(V_MUL(K(1.5), b1), sr), a1));
+    k_p = V_ADD(V_ADD(V_MUL(V_MUL(K(2.0), b), p), a),
+                H(K(1.006434e-4), p, 3.359406));
+
+    q = V_SUB(K(1.0), V_DIV(p, k));
+    g = V_DIV(p, V_MUL(V_MUL(q, k), k));
+    *alpha = V_SUB(V_MUL(g, k_t), V_DIV(sig_t, rho0));
+    *beta = V_SUB(V_DIV(sig_s, rho0), V_MUL(g, k_s));
+    *kappa = V_DIV(V_SUB(k, V_MUL(p, k_p)), V_MUL(V_MUL(q, k), k));
+
+    return V_SUB(V_DIV(rho0, q), K(1028.1063 - 28.106331));
+}
+
+static void SIMD_NAME(density_derivatives)(const double *salinity,
+                                           const double *temperature,
+                                           const double *pressure,
+                                           double *sigma, double *alpha,
+                                           double *beta, double *kappa,
+                                           size_t n)
+{
+    size_t i;
+    double a, b, k, sg;
+    V s, sgv, av, bv, kv;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        sgv = SIMD_NAME(density_derivatives_sr)(
+            s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i),
+            V_DIV(V_LOADU(pressure + i), K(10.0)), &av, &bv, &kv);
+        if (sigma != NULL)
+            V_STOREU(sigma + i, sgv);
+        if (alpha != NULL)
+            V_STOREU(alpha + i, av);
+        if (beta != NULL)
+            V_STOREU(beta + i, bv);
+        if (kappa != NULL)
+            V_STOREU(kappa + i, V_DIV(kv, K(10.0)));
+    }
+
+    for (; i < n; i++) {
+        sg = _density_derivatives(salinity[i], temperature[i], pressure[i],
+                                  &a, &b, &k);
+        if (sigma != NULL)
+            sigma[i] = sg;
+        if (alpha != NULL)
+            alpha[i] = a;
+        if (beta != NULL)
+            beta[i] = b;
+        if (kappa != NULL)
+            kappa[i] = k;
+    }
+}
+
+/* The vector counterparts of _density_sr(): density_surface_sr() is the
+ * result at zero pressure, for the reference pressures that are known to be
+ * zero. */
+static V SIMD_NAME(density_surface_sr)(V s, V sr, V t)
+{
+    return V_SUB(V_ADD(K(1028.1063), SIMD_NAME(sigma_sr)(s, sr, t)),
+                 K(1028.1063 - 28.106331));
+}
+
+static V SIMD_NAME(density_sr)(V s, V sr, V t, V p)
+{
+    V rho0, e, b, c, a, aw, bw, a1, b1, kw, ko, k;
+
+    rho0 = V_ADD(K(1028.1063), SIMD_NAME(sigma_sr)(s, sr, t));
+    e = H(H(K(9.1697e-10), t, 2.0816e-8), t, -9.9348e-7);
+    bw = H(H(K(5.2787e-8), t, -6.12293e-6), t, 3.47718e-5);
+    b = V_ADD(bw, V_MUL(e, s));
+    c = H(H(K(-1.6078e-6), t, -1.0981e-5), t, 2.2838e-3);
+    aw = H(H(H(K(-5.77905e-7), t, 1.16092e-4), t, 1.43713e-3), t,
+           -0.1194975);
+    a = V_ADD(V_MUL(V_ADD(V_MUL(K(1.91075e-4), sr), c), s), aw);
+    b1 = H(H(K(-5.3009e-4), t, 1.6483e-2), t, 7.944e-2);
+    a1 = H(H(H(K(-6.1670e-5), t, 1.09987e-2), t, -0.603459), t, 54.6746);
+    kw = H(H(H(H(K(-5.155288e-5), t, 1.360477e-2), t, -2.327105), t,
+             148.4206), t, -1930.06);
+    ko = V_ADD(V_MUL(V_ADD(V_MUL(b1, sr), a1), s), kw);
+    k = V_ADD(V_ADD(V_MUL(V_ADD(V_MUL(b, p), a), p), ko),
+              H(H(K(5.03217e-5), p, 3.359406), p, 21582.27));
+
+    return V_SUB(V_DIV(rho0, V_SUB(K(1.0), V_DIV(p, k))),
+                 K(1028.1063 - 28.106331));
+}
+
+static void SIMD_NAME(density)(const double *salinity,
+                               const double *temperature,
+                               const double *pressure, double *out, size_t n)
+{
+    size_t i;
+    V s;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(density_sr)(
+                     s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i),
+                     V_DIV(V_LOADU(pressure + i), K(10.0))));
+    }
+
+    for (; i < n; i++)
+        out[i] = _density(salinity[i], temperature[i], pressure[i]);
+}
+
+static void SIMD_NAME(potential_density)(const double *salinity,
+                                         const double *temperature,
+                                         const double *pressure,
+                                         const double *reference_pressure,
+                                         double *out, size_t n)
+{
+    size_t i;
+    V s, t, p, pr;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        t = V_LOADU(temperature + i);
+        p = V_LOADU(pressure + i);
+        pr = V_LOADU(reference_pressure + i);
+        V_STOREU(out + i, SIMD_NAME(density_sr)(
+                     s, V_SQRT(V_ABS(s)),
+                     SIMD_NAME(potential_temperature_core)(s, t, p, pr),
+                     V_DIV(pr, K(10.0))));
+    }
+
+    for (; i < n; i++)
+        out[i] = _potential_density(salinity[i], temperature[i], pressure[i],
+                                    reference_pressure[i]);
+}
+
+/* sqrt(fabs(salinity)) and the first adiabatic temperature gradient of the
+ * potential temperatures are shared by all the outputs; the secant bulk
+ * modulus is skipped for a zero reference pressure. */
+static void SIMD_NAME(potential_density_multi)(
+    const double *salinity, const double *temperature, const double *pressure,
+    const double *reference_pressure, size_t references, double *sigma,
+    double *const *out, size_t n)
+{
+    size_t i, r;
+    double sr, atg;
+    V s, vsr, t, p, gradient, theta;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        vsr = V_SQRT(V_ABS(s));
+        t = V_LOADU(temperature + i);
+        p = V_LOADU(pressure + i);
+        if (sigma != NULL)
+            V_STOREU(sigma + i, SIMD_NAME(density_sr)(
+                         s, vsr, t, V_DIV(p, K(10.0))));
+        if (references == 0)
+            continue;
+        gradient = SIMD_NAME(adiabatic_temperature_gradient_core)(s, t, p);
+        for (r = 0; r < references; r++) {
+            theta = SIMD_NAME(potential_temperature_atg)(
+                s, t, p, K(reference_pressure[r]), gradient);
+            V_STOREU(out[r] + i, reference_pressure[r] == 0.0 ?
+                     SIMD_NAME(density_surface_sr)(s, vsr, theta) :
+                     SIMD_NAME(density_sr)(
+                         s, vsr, theta, K(reference_pressure[r] / 10.0)));
+        }
+    }
+
+    for (; i < n; i++) {
+        sr = sqrt(fabs(salinity[i]));
+        if (sigma != NULL)
+            sigma[i] = _density_sr(salinity[i], sr, temperature[i],
+                                   pressure[i] / 10.0);
+        atg = _adiabatic_temperature_gradient(salinity[i], temperature[i],
+                                              pressure[i]);
+        for (r = 0; r < references; r++)
+            out[r][i] = _potential_density_atg(salinity[i], sr,
+                                               temperature[i], pressure[i],
+                                               reference_pressure[r], atg);
+    }
+}
+
+/* Cores on a pressure level, the vector counterparts of the _*_level
+ * kernels in kernels.h: only double precision has them. */
+
+static V SIMD_NAME(poly)(const double *c, int degree, V x)
+{
+    V r = K(c[degree]);
+
+    while (degree-- > 0)
+        r = H(r, x, c[degree]);
+
+    return r;
+}
+
+static V SIMD_NAME(specific_volume_anomaly_level_core)(
+    const struct oceanography_level *level, V s, V sr, V t, V *sigma)
+{
+    const double *k = level->svan;
+    V sg, sva, dk, dvan;
+
+    sg = SIMD_NAME(sigma_sr)(s, sr, t);
+    sva = V_DIV(V_MUL(sg, K(-(1.0 / 1028.1063))), V_ADD(K(1028.1063), sg));
+
+    if (k[12] == 0.0) {
+        *sigma = V_ADD(sg, K(28.106331));
+        return V_MUL(sva, K(1.0e+8));
+    }
+
+    dk = V_ADD(SIMD_NAME(poly)(k, 4, t),
+               V_MUL(V_ADD(SIMD_NAME(poly)(k + 5, 3, t),
+                           V_MUL(SIMD_NAME(poly)(k + 9, 2, t), sr)), s));
+    sva = V_ADD(V_MUL(sva, K(k[14])),
+                V_DIV(V_MUL(V_MUL(V_ADD(K(1.0 / 1028.1063), sva), K(k[12])),
+                            dk),
+                      V_MUL(K(k[13]), V_ADD(K(k[13]), dk))));
+    dvan = V_DIV(sva, V_MUL(K(k[15]), V_ADD(K(k[15]), sva)));
+    *sigma = V_SUB(V_ADD(K(28.106331), K(k[16])), dvan);
+
+    return V_MUL(sva, K(1.0e+8));
+}
+
+static V SIMD_NAME(specific_heat_level_core)(
+    const struct oceanography_level *level, V s, V sr, V t)
+{
+    const double *k = level->cpsw;
+
+    return V_ADD(SIMD_NAME(poly)(k, 4, t),
+                 V_MUL(V_ADD(SIMD_NAME(poly)(k + 5, 4, t),
+                             V_MUL(SIMD_NAME(poly)(k + 10, 2, t), sr)), s));
+}
+
+static V SIMD_NAME(adiabatic_temperature_gradient_level_core)(
+    const struct oceanography_level *level, V s, V t)
+{
+    const double *k = level->atg;
+
+    return V_ADD(SIMD_NAME(poly)(k, 3, t),
+                 V_MUL(SIMD_NAME(poly)(k + 4, 1, t), V_ADD(s, K(-35.0))));
+}
+
+static V SIMD_NAME(sound_speed_level_core)(
+    const struct oceanography_level *level, V s, V sr, V t)
+{
+    const double *k = level->sound_speed;
+
+    return V_ADD(SIMD_NAME(poly)(k, 5, t),
+                 V_MUL(V_ADD(V_ADD(SIMD_NAME(poly)(k + 6, 4, t),
+                                   V_MUL(SIMD_NAME(poly)(k + 11, 1, t), sr)),
+                             V_MUL(K(k[13]), s)), s));
+}
+
+/* Same operations of _pressure_gravity(). */
+static V SIMD_NAME(pressure_gravity)(V z, V gravity)
+{
+    V b, c, p, h, dh;
+    int k;
+
+    b = V_SUB(K(9.72659), V_MUL(K(1.092e-6), z));
+    c = V_MUL(z, gravity);
+    p = V_MUL(c, K(1.0 / 9.72659));
+    p = V_MUL(H(p, K(2.2512e-5 / 9.72659), 1.0), p);
+    for (k = 0; k < 2; k++) {
+        h = V_SUB(V_MUL(V_ADD(V_MUL(H(H(K(-1.82e-15), p, 2.279e-10), p,
+                                      -2.2512e-5), p), b), p), c);
+        dh = V_ADD(V_MUL(H(H(K(-7.28e-15), p, 6.837e-10), p, -4.5024e-5), p),
+                   b);
+        p = V_SUB(p, V_DIV(h, dh));
+    }
+
+    return p;
+}
+
+static void SIMD_NAME(pressure_from_depth)(const double *depth,
+                                           const double *gravity,
+                                           double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH)
+        V_STOREU(out + i, SIMD_NAME(pressure_gravity)(V_LOADU(depth + i),
+                                                      V_LOADU(gravity + i)));
+
+    for (; i < n; i++)
+        out[i] = _pressure_gravity(depth[i], gravity[i]);
+}
+
+/* Same operations of _salinity_density_sr(). Newton iterations run on all
+ * the lanes until every lane has converged; converged lanes keep their
+ * values, so every lane does exactly the iterations of the scalar kernel.
+ */
+static V SIMD_NAME(salinity_density_sr)(V sigma, V t, V p)
+{
+    V s, sig, alpha, beta, kappa, step;
+    V_MASK active;
+    int k = 0;
+
+    s = K(35.0);
+    active = V_EQ(K(0.0), K(0.0));
+    do {
+        sig = SIMD_NAME(density_derivatives_sr)(s, V_SQRT(V_ABS(s)), t, p,
+                                                &alpha, &beta, &kappa);
+        step = V_DIV(V_SUB(sig, sigma),
+                     V_MUL(beta, V_ADD(sig, K(1028.1063 - 28.106331))));
+        s = V_SELECT(active, V_SUB(s, step), s);
+        active = V_AND(active, V_GT(V_ABS(step), K(1.0e-8)));
+        k++;
+    } while (k < OCEANOGRAPHY_INVERSE_ITERATIONS && V_ANY(active));
+
+    return s;
+}
+
+static void SIMD_NAME(salinity_from_density)(const double *sigma,
+                                             const double *temperature,
+                                             const double *pressure,
+                                             double *out, double *residual,
+                                             size_t n)
+{
+    size_t i;
+    double r;
+    V sg, s, t, p;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        sg = V_LOADU(sigma + i);
+        t = V_LOADU(temperature + i);
+        p = V_DIV(V_LOADU(pressure + i), K(10.0));
+        s = SIMD_NAME(salinity_density_sr)(sg, t, p);
+        V_STOREU(out + i, s);
+        if (residual != NULL)
+            V_STOREU(residual + i,
+                     V_SUB(SIMD_NAME(density_sr)(s, V_SQRT(V_ABS(s)), t, p),
+                           sg));
+    }
+
+    for (; i < n; i++) {
+        out[i] = _salinity_from_density(sigma[i], temperature[i],
+                                        pressure[i], &r);
+        if (residual != NULL)
+            residual[i] = r;
+    }
+}
+
+/* Same operations of _sound_speed_dt_sr(). */
+static V SIMD_NAME(sound_speed_dt_sr)(V s, V sr, V t, V p)
+{
+    V a, a0, a1, a2, a3, b, c, c0, c1, c2, c3;
+
+    b = V_ADD(K(-4.42e-5), V_MUL(K(1.7945e-7), p));
+
+    a3 = H(K(-6.778e-13), t, 6.649e-12);
+    a2 = H(H(K(2.3964e-11), t, -3.2004e-10), t, 9.1041e-9);
+    a1 = H(H(H(K(-8.0488e-10), t, 3.1521e-8), t, -1.2977e-7), t, -1.2580e-5);
+    a0 = H(H(H(K(-1.284e-7), t, 6.018e-6), t, 1.4328e-4), t, -1.262e-2);
+    a = V_ADD(V_MUL(V_ADD(V_MUL(V_ADD(V_MUL(a3, p), a2), p), a1), p), a0);
+
+    c3 = H(K(-4.7286e-12), t, 3.8504e-10);
+    c2 = H(H(H(K(4.162e-12), t, -7.6005e-10), t, 5.1948e-8), t, -1.7107e-6);
+    c1 = H(H(H(K(-2.4474e-9), t, 4.0863e-7), t, -1.63576e-5), t, 6.8982e-4);
+    c0 = H(H(H(H(K(1.5732e-8), t, -5.912e-6), t, 1.0026e-3), t, -0.1161704),
+           t, 5.03711);
+    c = V_ADD(V_MUL(V_ADD(V_MUL(V_ADD(V_MUL(c3, p), c2), p), c1), p), c0);
+
+    return V_ADD(c, V_MUL(V_ADD(a, V_MUL(b, sr)), s));
+}
+
+/* Same operations of _temperature_sound_speed_sr(), with the iterations of
+ * SIMD_NAME(salinity_density_sr)(). */
+static V SIMD_NAME(temperature_sound_speed_sr)(V c, V s, V sr, V p)
+{
+    V x, t, step;
+    V_MASK active;
+    int k = 0;
+
+    x = V_DIV(V_SUB(c, SIMD_NAME(sound_speed_sr)(s, sr, K(0.0), p)),
+              SIMD_NAME(sound_speed_dt_sr)(s, sr, K(0.0), p));
+    t = V_MUL(H(H(H(K(3.1423e-5), x, -5.027e-4), x, 1.6249e-2), x, 1.0), x);
+    active = V_EQ(K(0.0), K(0.0));
+    do {
+        step = V_DIV(V_SUB(SIMD_NAME(sound_speed_sr)(s, sr, t, p), c),
+                     SIMD_NAME(sound_speed_dt_sr)(s, sr, t, p));
+        t = V_SELECT(active, V_SUB(t, step), t);
+        active = V_AND(active, V_GT(V_ABS(step), K(1.0e-8)));
+        k++;
+    } while (k < OCEANOGRAPHY_INVERSE_ITERATIONS && V_ANY(active));
+
+    return t;
+}
+
+static void SIMD_NAME(temperature_from_sound_speed)(
+    const double *sound_speed, const double *salinity,
+    const double *pressure, double *out, double *residual, size_t n)
+{
+    size_t i;
+    double r;
+    V c, s, sr, t, p;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        c = V_LOADU(sound_speed + i);
+        s = V_LOADU(salinity + i);
+        sr = V_SQRT(V_ABS(s));
+        p = V_DIV(V_LOADU(pressure + i), K(10.0));
+        t = SIMD_NAME(temperature_sound_speed_sr)(c, s, sr, p);
+        V_STOREU(out + i, t);
+        if (residual != NULL)
+            V_STOREU(residual + i,
+                     V_SUB(SIMD_NAME(sound_speed_sr)(s, sr, t, p), c));
+    }
+
+    for (; i < n; i++) {
+        out[i] = _temperature_from_sound_speed(sound_speed[i], salinity[i],
+                                               pressure[i], &r);
+        if (residual != NULL)
+            residual[i] = r;
+    }
+}
+
+/* Batch kernels on a pressure level: the terms of the level are broadcast
+ * once per call. */
+
+static void SIMD_NAME(salinity_level)(const struct oceanography_level *level,
+                                      const double *conductivity,
+                                      const double *temperature, double *out,
+                                      size_t n)
+{
+    size_t i;
+    V cp;
+
+    cp = K(level->conductivity);
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH)
+        V_STOREU(out + i, SIMD_NAME(salinity_cp)(V_LOADU(conductivity + i),
+                                                 V_LOADU(temperature + i),
+                                                 cp));
+
+    for (; i < n; i++)
+        out[i] = _salinity_cp(conductivity[i], temperature[i],
+                              level->conductivity);
+}
+
+static void SIMD_NAME(conductivity_level)(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, unsigned long *histogram,
+    size_t n)
+{
+    size_t i;
+    int j, iterations;
+    double counts[V_WIDTH];
+    V cp, count;
+
+    cp = K(level->conductivity);
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        V_STOREU(out + i, SIMD_NAME(conductivity_cp)(
+                     V_LOADU(salinity + i), V_LOADU(temperature + i), cp,
+                     &count));
+
+        if (histogram != NULL) {
+            V_STOREU(counts, count);
+            for (j = 0; j < V_WIDTH; j++)
+                histogram[(int) counts[j]]++;
+        }
+    }
+
+    for (; i < n; i++) {
+        out[i] = _conductivity_cp_iterations(salinity[i], temperature[i],
+                                             level->conductivity,
+                                             &iterations);
+        if (histogram != NULL)
+            histogram[iterations]++;
+    }
+}
+
+static void SIMD_NAME(specific_volume_anomaly_level)(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, double *sigma, size_t n)
+{
+    size_t i;
+    double sig;
+    V s, sg;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(specific_volume_anomaly_level_core)(
+                     level, s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i),
+                     &sg));
+        if (sigma != NULL)
+            V_STOREU(sigma + i, sg);
+    }
+
+    for (; i < n; i++) {
+        out[i] = _specific_volume_anomaly_level(level, salinity[i],
+                                                sqrt(fabs(salinity[i])),
+                                                temperature[i], &sig);
+        if (sigma != NULL)
+            sigma[i] = sig;
+    }
+}
+
+static void SIMD_NAME(freezing_point_level)(
+    const struct oceanography_level *level, const double *salinity,
+    double *out, size_t n)
+{
+    size_t i;
+    V s, p;
+
+    p = K(level->pressure);
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(freezing_point_sr)(s, V_SQRT(V_ABS(s)),
+                                                       p));
+    }
+
+    for (; i < n; i++)
+        out[i] = _freezing_point(salinity[i], level->pressure);
+}
+
+static void SIMD_NAME(specific_heat_level)(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, size_t n)
+{
+    size_t i;
+    V s;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(specific_heat_level_core)(
+                     level, s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i)));
+    }
+
+    for (; i < n; i++)
+        out[i] = _specific_heat_level(level, salinity[i],
+                                      sqrt(fabs(salinity[i])),
+                                      temperature[i]);
+}
+
+static void SIMD_NAME(adiabatic_temperature_gradient_level)(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH)
+        V_STOREU(out + i, SIMD_NAME(adiabatic_temperature_gradient_level_core)(
+                     level, V_LOADU(salinity + i), V_LOADU(temperature + i)));
+
+    for (; i < n; i++)
+        out[i] = _adiabatic_temperature_gradient_level(level, salinity[i],
+                                                       temperature[i]);
+}
+
+static void SIMD_NAME(sound_speed_level)(
+    const struct oceanography_level *level, const double *salinity,
+    const double *temperature, double *out, size_t n)
+{
+    size_t i;
+    V s;
+
+    for (i = 0; i + V_WIDTH <= n; i += V_WIDTH) {
+        s = V_LOADU(salinity + i);
+        V_STOREU(out + i, SIMD_NAME(sound_speed_level_core)(
+                     level, s, V_SQRT(V_ABS(s)), V_LOADU(temperature + i)));
+    }
+
+    for (; i < n; i++)
+        out[i] = _sound_speed_level(level, salinity[i],
+                                    sqrt(fabs(salinity[i])), temperature[i]);
+}
+
+/* Cell of x along dimension dim, set to c, as in _table_locate(). */
+static V SIMD_NAME(table_locate)(const struct table_layout *table, int dim,
+                                 V x, V *c)
+{
+    V f;
+
+    f = V_MUL(V_SUB(x, K(table->min[dim])), K(table->scale[dim]));
+    *c = V_MIN(V_FLOOR(f), K(table->cells[dim] - 1.0));
+
+    return V_SUB(f, *c);
+}
+
+/* Polynomial of a cell, as in _table_horner(). */
+static V SIMD_NAME(table_horner)(const struct table_layout *table,
+                                 size_t cell, V us, V ut, V up)
+{
+    const unsigned int *n = table->order;
+    const double *a = table->coefficients + table->stride * (cell + 1);
+    unsigned int i, j, k;
+    V r, rt, rs;
+
+    r = K(0.0);
+    for (k = 0; k < n[2]; k++) {
+        rt = K(0.0);
+        for (j = 0; j < n[1]; j++) {
+            rs = K(*--a);
+            for (i = 1; i < n[0]; i++)
+                rs = H(rs, us, *--a);
+            rt = V_ADD(V_MUL(rt, ut), rs);
+        }
+        r = V_ADD(V_MUL(r, up), rt);
+    }
+
+    return r;
+}
+
+/* Two vectors, possibly in different cells, with local coordinates u[0]
+ * to u[2] and u[3] to u[5]. Their chains of multiplications and additions
+ * are independent and overlap, halving the latency of each one. */
+static void SIMD_NAME(table_horner_pair)(const struct table_layout *table,
+                                         const size_t *cell, const V *u,
+                                         V *r)
+{
+    const unsigned int *n = table->order;
+    const double *a = table->coefficients + table->stride * (cell[0] + 1);
+    const double *b = table->coefficients + table->stride * (cell[1] + 1);
+    unsigned int i, j, k;
+    V ra, rta, rsa, rb, rtb, rsb;
+
+    ra = rb = K(0.0);
+    for (k = 0; k < n[2]; k++) {
+        rta = rtb = K(0.0);
+        for (j = 0; j < n[1]; j++) {
+            rsa = K(*--a);
+            rsb = K(*--b);
+            for (i = 1; i < n[0]; i++) {
+                rsa = H(rsa, u[0], *--a);
+                rsb = H(rsb, u[3], *--b);
+            }
+            rta = V_ADD(V_MUL(rta, u[1]), rsa);
+            rtb = V_ADD(V_MUL(rtb, u[4]), rsb);
+        }
+        ra = V_ADD(V_MUL(ra, u[2]), rta);
+        rb = V_ADD(V_MUL(rb, u[5]), rtb);
+    }
+    r[0] = ra;
+    r[1] = rb;
+}
+
+/* Local coordinates of a vector of samples, set to u[0], u[1] and u[2], and
+ * cells of the lanes, stored to cells. Returns nonzero if all the lanes are
+ * inside the box, in the cell of the first one. */
+static int SIMD_NAME(table_cells)(const struct table_layout *table,
+                                  const double *salinity,
+                                  const double *temperature,
+                                  const double *pressure, V *u,
+                                  double *cells, double *state)
+{
+    V s, t, p, cs, ct, cp, cell, inside;
+    V_MASK m;
+
+    s = V_LOADU(salinity);
+    t = V_LOADU(temperature);
+    p = V_LOADU(pressure);
+    m = V_AND(V_AND(V_AND(V_LE(K(table->min[0]), s),
+                          V_LE(s, K(table->max[0]))),
+                    V_AND(V_LE(K(table->min[1]), t),
+                          V_LE(t, K(table->max[1])))),
+              V_AND(V_LE(K(table->min[2]), p), V_LE(p, K(table->max[2]))));
+    inside = V_SELECT(m, K(1.0), K(0.0));
+
+    u[0] = SIMD_NAME(table_locate)(table, 0, s, &cs);
+    u[1] = SIMD_NAME(table_locate)(table, 1, t, &ct);
+    u[2] = SIMD_NAME(table_locate)(table, 2, p, &cp);
+    cell = V_ADD(V_MUL(V_ADD(V_MUL(cp, K(table->cells[1])), ct),
+                       K(table->cells[0])), cs);
+    V_STOREU(cells, cell);
+    V_STOREU(state, inside);
+
+    return !V_ANY(V_GT(K(1.0), V_SELECT(V_EQ(cell, K(cells[0])), inside,
+                                        K(0.0))));
+}
+
+/* Every distinct cell of the lanes of a vector evaluated on the whole
+ * vector and blended in. Lanes outside the box get the exact function. */
+static void SIMD_NAME(table_blend)(const struct table_layout *table,
+                                   const double *salinity,
+                                   const double *temperature,
+                                   const double *pressure, const V *u,
+                                   const double *cells, double *state,
+                                   double *out)
+{
+    int j, k;
+    V cell, r;
+
+    cell = V_LOADU(cells);
+    r = K(0.0);
+    for (j = 0; j < V_WIDTH; j++) {
+        if (state[j] != 1.0)
+            continue;
+        r = V_SELECT(V_EQ(cell, K(cells[j])),
+                     SIMD_NAME(table_horner)(table, (size_t) cells[j], u[0],
+                                             u[1], u[2]), r);
+        for (k = j; k < V_WIDTH; k++)
+            if (state[k] == 1.0 && cells[k] == cells[j])
+                state[k] = 2.0;
+    }
+    V_STOREU(out, r);
+
+    for (j = 0; j < V_WIDTH; j++)
+        if (state[j] == 0.0)
+            out[j] = _table_exact(salinity[j], temperature[j], pressure[j]);
+}
+
+/* Samples are evaluated in pairs of vectors. A vector lying in a single
+ * cell, as in the common case of samples following a profile, takes one
+ * polynomial, overlapped with the other one of the pair if it does too; the
+ * others are blended cell by cell. */
+static void SIMD_NAME(table)(const struct table_layout *table,
+                             const double *salinity,
+                             const double *temperature,
+                             const double *pressure, double *out, size_t n)
+{
+    size_t i, o, cell[2];
+    int same[2], j;
+    double cells[2][V_WIDTH], state[2][V_WIDTH];
+    V u[6], r[2];
+
+    for (i = 0; i + 2 * V_WIDTH <= n; i += 2 * V_WIDTH) {
+        for (j = 0; j < 2; j++) {
+            o = i + j * V_WIDTH;
+            same[j] = SIMD_NAME(table_cells)(table, salinity + o,
+                                             temperature + o, pressure + o,
+                                             u + 3 * j, cells[j], state[j]);
+        }
+
+        if (same[0] && same[1]) {
+            cell[0] = (size_t) cells[0][0];
+            cell[1] = (size_t) cells[1][0];
+            SIMD_NAME(table_horner_pair)(table, cell, u, r);
+            V_STOREU(out + i, r[0]);
+            V_STOREU(out + i + V_WIDTH, r[1]);
+            continue;
+        }
+
+        for (j = 0; j < 2; j++) {
+            o = i + j * V_WIDTH;
+            if (same[j])
+                V_STOREU(out + o, SIMD_NAME(table_horner)(
+                             table, (size_t) cells[j][0], u[3 * j],
+                             u[3 * j + 1], u[3 * j + 2]));
+            else
+                SIMD_NAME(table_blend)(table, salinity + o, temperature + o,
+                                       pressure + o, u + 3 * j, cells[j],
+                                       state[j], out + o);
+        }
+    }
+
+    for (; i < n; i++)
+        out[i] = _table_eval(table, salinity[i], temperature[i],
+                             pressure[i]);
+}
+
+const struct simd_kernels SIMD_NAME(simd_kernels) = {
+    SIMD_NAME(salinity),
+    SIMD_NAME(conductivity),
+    SIMD_NAME(specific_volume_anomaly),
+    SIMD_NAME(freezing_point),
+    SIMD_NAME(specific_heat),
+    SIMD_NAME(adiabatic_temperature_gradient),
+    SIMD_NAME(potential_temperature),
+    SIMD_NAME(potential_temperature_multi),
+    SIMD_NAME(in_situ_temperature),
+    SIMD_NAME(sound_speed),
+    SIMD_NAME(ctd_derive),
+    SIMD_NAME(density_derivatives),
+    SIMD_NAME(density),
+    SIMD_NAME(potential_density),
+    SIMD_NAME(potential_density_multi),
+    SIMD_NAME(pressure_from_depth),
+    SIMD_NAME(salinity_from_density),
+    SIMD_NAME(temperature_from_sound_speed),
+    SIMD_NAME(salinity_level),
+    SIMD_NAME(conductivity_level),
+    SIMD_NAME(specific_volume_anomaly_level),
+    SIMD_NAME(freezing_point_level),
+    SIMD_NAME(specific_heat_level),
+    SIMD_NAME(adiabatic_temperature_gradient_level),
+    SIMD_NAME(sound_speed_level),
+    SIMD_NAME(table)
+};
+
+#undef K
+#undef H
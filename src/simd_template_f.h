@@ -0,0 +1,271 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * simd_template_f.h -- Single precision batch kernels, written once for
+ * every instruction set.
+ *
+ * This file is included by simd_<isa>_f.c, and by float.c on plain floats,
+ * after defining the macros listed in simd_template.h for a vector of
+ * V_WIDTH floats. The cores are the ones of oceanography_cores.h, so every
+ * lane performs the operations of the double kernels, rounded to float.
+ *
+ * There are no scalar tails: the last n % V_WIDTH samples are loaded in a
+ * vector padded with zeros, so they go through the same operations of the
+ * other samples and results do not depend on the instruction set.
+ */
+
+#include "kernels.h"
+#include "simd.h"
+#include "oceanography_cores.h"
+
+/* Load the m samples from p, padding the lanes past the end with zeros. */
+static V SIMD_NAME(load)(const float *p, size_t m)
+{
+    float pad[V_WIDTH];
+    size_t j;
+
+    if (m >= V_WIDTH)
+        return V_LOADU(p);
+
+    for (j = 0; j < V_WIDTH; j++)
+        pad[j] = j < m ? p[j] : 0.0f;
+
+    return V_LOADU(pad);
+}
+
+/* Store the first m lanes of v to p. */
+static void SIMD_NAME(store)(float *p, V v, size_t m)
+{
+    float pad[V_WIDTH];
+    size_t j;
+
+    if (m >= V_WIDTH) {
+        V_STOREU(p, v);
+        return;
+    }
+
+    V_STOREU(pad, v);
+    for (j = 0; j < m; j++)
+        p[j] = pad[j];
+}
+
+/* Batch kernels. m is the number of samples left from i. */
+
+static void SIMD_NAME(conductivity)(const float *salinity,
+                                    const float *temperature,
+                                    const float *pressure, float *out,
+                                    unsigned long *histogram, size_t n)
+{
+    size_t i, j, m;
+    float counts[V_WIDTH];
+    V count;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        SIMD_NAME(store)(out + i, SIMD_NAME(conductivity_core)(
+                             SIMD_NAME(load)(salinity + i, m),
+                             SIMD_NAME(load)(temperature + i, m),
+                             SIMD_NAME(load)(pressure + i, m), &count), m);
+
+        if (histogram != NULL) {
+            V_STOREU(counts, count);
+            for (j = 0; j < V_WIDTH && j < m; j++)
+                histogram[(int) counts[j]]++;
+        }
+    }
+}
+
+static void SIMD_NAME(salinity)(const float *conductivity,
+                                const float *temperature,
+                                const float *pressure, float *out, size_t n)
+{
+    size_t i, m;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        SIMD_NAME(store)(out + i, SIMD_NAME(salinity_core)(
+                             SIMD_NAME(load)(conductivity + i, m),
+                             SIMD_NAME(load)(temperature + i, m),
+                             SIMD_NAME(load)(pressure + i, m)), m);
+    }
+}
+
+static void SIMD_NAME(specific_volume_anomaly)(const float *salinity,
+                                               const float *temperature,
+                                               const float *pressure,
+                                               float *out, float *sigma,
+                                               size_t n)
+{
+    size_t i, m;
+    V s, sg;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        s = SIMD_NAME(load)(salinity + i, m);
+        SIMD_NAME(store)(out + i, SIMD_NAME(specific_volume_anomaly_sr)(
+                             s, V_SQRT(V_ABS(s)),
+                             SIMD_NAME(load)(temperature + i, m),
+                             V_DIV(SIMD_NAME(load)(pressure + i, m), K(10.)),
+                             &sg), m);
+        if (sigma != NULL)
+            SIMD_NAME(store)(sigma + i, sg, m);
+    }
+}
+
+/* The latitude term of gravity is computed in double by _gravity(), since
+ * there is no vector sine: it is a small part of the cost. The padded lanes
+ * get a gravity of 1, to not divide zero by zero. */
+static void SIMD_NAME(depth)(const float *pressure, const float *latitude,
+                             float *out, size_t n)
+{
+    size_t i, j, m;
+    float gravity[V_WIDTH];
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        for (j = 0; j < V_WIDTH; j++)
+            gravity[j] = j < m ? (float) _gravity(latitude[i + j]) : 1.0f;
+        SIMD_NAME(store)(out + i, SIMD_NAME(depth_gravity)(
+                             SIMD_NAME(load)(pressure + i, m),
+                             V_LOADU(gravity)), m);
+    }
+}
+
+static void SIMD_NAME(freezing_point)(const float *salinity,
+                                      const float *pressure, float *out,
+                                      size_t n)
+{
+    size_t i, m;
+    V s;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        s = SIMD_NAME(load)(salinity + i, m);
+        SIMD_NAME(store)(out + i, SIMD_NAME(freezing_point_sr)(
+                             s, V_SQRT(V_ABS(s)),
+                             SIMD_NAME(load)(pressure + i, m)), m);
+    }
+}
+
+static void SIMD_NAME(specific_heat)(const float *salinity,
+                                     const float *temperature,
+                                     const float *pressure, float *out,
+                                     size_t n)
+{
+    size_t i, m;
+    V s;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        s = SIMD_NAME(load)(salinity + i, m);
+        SIMD_NAME(store)(out + i, SIMD_NAME(specific_heat_sr)(
+                             s, V_SQRT(V_ABS(s)),
+                             SIMD_NAME(load)(temperature + i, m),
+                             V_DIV(SIMD_NAME(load)(pressure + i, m),
+                                   K(10.0))), m);
+    }
+}
+
+static void SIMD_NAME(adiabatic_temperature_gradient)(const float *salinity,
+                                                      const float *temperature,
+                                                      const float *pressure,
+                                                      float *out, size_t n)
+{
+    size_t i, m;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        SIMD_NAME(store)(
+            out + i, SIMD_NAME(adiabatic_temperature_gradient_core)(
+                SIMD_NAME(load)(salinity + i, m),
+                SIMD_NAME(load)(temperature + i, m),
+                SIMD_NAME(load)(pressure + i, m)), m);
+    }
+}
+
+static void SIMD_NAME(potential_temperature)(const float *salinity,
+                                             const float *temperature,
+                                             const float *pressure,
+                                             const float *reference_pressure,
+                                             float *out, size_t n)
+{
+    size_t i, m;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        SIMD_NAME(store)(out + i, SIMD_NAME(potential_temperature_core)(
+                             SIMD_NAME(load)(salinity + i, m),
+                             SIMD_NAME(load)(temperature + i, m),
+                             SIMD_NAME(load)(pressure + i, m),
+                             SIMD_NAME(load)(reference_pressure + i, m)), m);
+    }
+}
+
+static void SIMD_NAME(in_situ_temperature)(const float *salinity,
+                                           const float *theta,
+                                           const float *pressure,
+                                           const float *reference_pressure,
+                                           float *out, size_t n)
+{
+    size_t i, m;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        SIMD_NAME(store)(out + i, SIMD_NAME(in_situ_temperature_core)(
+                             SIMD_NAME(load)(salinity + i, m),
+                             SIMD_NAME(load)(theta + i, m),
+                             SIMD_NAME(load)(pressure + i, m),
+                             SIMD_NAME(load)(reference_pressure + i, m)), m);
+    }
+}
+
+static void SIMD_NAME(sound_speed)(const float *salinity,
+                                   const float *temperature,
+                                   const float *pressure, float *out,
+                                   size_t n)
+{
+    size_t i, m;
+    V s;
+
+    for (i = 0; i < n; i += V_WIDTH) {
+        m = n - i;
+        s = SIMD_NAME(load)(salinity + i, m);
+        SIMD_NAME(store)(out + i, SIMD_NAME(sound_speed_sr)(
+                             s, V_SQRT(V_ABS(s)),
+                             SIMD_NAME(load)(temperature + i, m),
+                             V_DIV(SIMD_NAME(load)(pressure + i, m),
+                                   K(10.0))), m);
+    }
+}
+
+const struct simd_kernels_f SIMD_NAME(simd_kernels_f) = {
+    SIMD_NAME(salinity),
+    SIMD_NAME(conductivity),
+    SIMD_NAME(specific_volume_anomaly),
+    SIMD_NAME(depth),
+    SIMD_NAME(freezing_point),
+    SIMD_NAME(specific_heat),
+    SIMD_NAME(adiabatic_temperature_gradient),
+    SIMD_NAME(potential_temperature),
+    SIMD_NAME(in_situ_temperature),
+    SIMD_NAME(sound_speed)
+};
+
+#undef K
+#undef H
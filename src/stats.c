@@ -0,0 +1,588 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * stats.c -- Instrumentation of the functions.
+ *
+ * Every thread counts in its own block, allocated at its first instrumented
+ * call, with relaxed atomic additions, so counting takes no lock and threads
+ * do not share cache lines. A call counts the iterations of conductivity in
+ * its own histogram, added to the block at its end.
+ * Blocks are linked in a list to be summed by oceanography_stats_snapshot();
+ * when a thread exits its counts are moved to the retired totals.
+ *
+ * oceanography_stats_reset() does not clear the blocks, that are written
+ * without locks by their threads: it records the current totals as a
+ * baseline, subtracted by the snapshots.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <float.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oceanography.h"
+#include "stats.h"
+
+static const char *function_names[] = {
+    "salinity",
+    "conductivity",
+    "specific_volume_anomaly",
+    "depth",
+    "freezing_point",
+    "specific_heat",
+    "adiabatic_temperature_gradient",
+    "potential_temperature",
+    "in_situ_temperature",
+    "sound_speed",
+    "ctd_derive",
+    "density_derivatives",
+    "density",
+    "potential_density",
+    "pressure_from_depth",
+    "salinity_from_density",
+    "temperature_from_sound_speed"
+};
+
+/* oceanography_stats_name -- name of an instrumented function, or NULL. */
+
+const char *oceanography_stats_name(enum oceanography_stats_function function)
+{
+    if ((unsigned int) function >= OCEANOGRAPHY_STATS_FUNCTIONS)
+        return NULL;
+
+    return function_names[function];
+}
+
+#ifdef OCEANOGRAPHY_STATS
+
+/* Range of validity of an input; the minimum is excluded if open. */
+struct range {
+    double min;
+    double max;
+    int open;
+};
+
+#define SALINITY {0.0, 42.0, 0}
+#define TEMPERATURE {-2.0, 40.0, 0}
+#define PRESSURE {0.0, 10000.0, 0}
+#define LATITUDE {-90.0, 90.0, 0}
+/* Depth of 10000 decibars at the equator, where it is deepest. */
+#define DEPTH {0.0, 9726.0, 0}
+/* Density anomalies and sound speeds over the ranges of salinity,
+ * temperature and pressure. */
+#define SIGMA {-7.75, 76.71, 0}
+#define SOUND_SPEED {1392.0, 1733.5, 0}
+#define ANY {-DBL_MAX, DBL_MAX, 0}
+/* Conductivity ratios below this make salinity() return 0. */
+#define CONDUCTIVITY {5.0e-4, DBL_MAX, 1}
+/* Salinities below this make conductivity() return 0. */
+#define CONDUCTIVITY_SALINITY {0.02, 42.0, 1}
+
+/* Ranges of the first three inputs of every function: the ones of the
+ * UNESCO formulas, 0 to 42 for salinity, -2 to 40 degrees Celsius and 0 to
+ * 10000 decibars. */
+static const struct range ranges[OCEANOGRAPHY_STATS_FUNCTIONS][3] = {
+    {CONDUCTIVITY, TEMPERATURE, PRESSURE},
+    {CONDUCTIVITY_SALINITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {PRESSURE, LATITUDE, ANY},
+    {SALINITY, PRESSURE, ANY},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {CONDUCTIVITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {SALINITY, TEMPERATURE, PRESSURE},
+    {DEPTH, LATITUDE, ANY},
+    {SIGMA, TEMPERATURE, PRESSURE},
+    {SOUND_SPEED, SALINITY, PRESSURE}
+};
+
+static const struct range any = ANY;
+
+struct stats_block {
+    struct oceanography_stats stats;
+    struct oceanography_stats baseline; /* at the last reset */
+    struct stats_block *prev;
+    struct stats_block *next;
+};
+
+int stats_enabled = -1;
+
+static pthread_once_t environment_once = PTHREAD_ONCE_INIT;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+static int key_error = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct stats_block *blocks = NULL;
+static struct oceanography_stats retired;
+static struct oceanography_stats baseline;
+
+/* The counters of a block are written by its thread and read by the
+ * snapshots of any thread: with relaxed atomics where available, under the
+ * lock elsewhere. ticks, a double, has no atomic addition, but a single
+ * writer can load, add and store it. */
+#ifdef __ATOMIC_RELAXED
+#define COUNT_LOCK() ((void) 0)
+#define COUNT_UNLOCK() ((void) 0)
+#define COUNT(x, n) ((void) __atomic_fetch_add(&(x), (n), __ATOMIC_RELAXED))
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#else
+#define COUNT_LOCK() pthread_mutex_lock(&lock)
+#define COUNT_UNLOCK() pthread_mutex_unlock(&lock)
+#define COUNT(x, n) ((void) ((x) += (n)))
+#define LOAD(x) (x)
+#endif
+
+static void count_ticks(double *ticks, double elapsed)
+{
+#ifdef __ATOMIC_RELAXED
+    double value;
+
+    __atomic_load(ticks, &value, __ATOMIC_RELAXED);
+    value += elapsed;
+    __atomic_store(ticks, &value, __ATOMIC_RELAXED);
+#else
+    *ticks += elapsed;
+#endif
+}
+
+static double load_ticks(const double *ticks)
+{
+#ifdef __ATOMIC_RELAXED
+    double value;
+
+    __atomic_load(ticks, &value, __ATOMIC_RELAXED);
+
+    return value;
+#else
+    return *ticks;
+#endif
+}
+
+/* Copy the counters of a block, that its thread may be writing. */
+static void load(struct oceanography_stats *to,
+                 const struct oceanography_stats *from)
+{
+    int i;
+
+    for (i = 0; i < OCEANOGRAPHY_STATS_FUNCTIONS; i++) {
+        to->function[i].calls = LOAD(from->function[i].calls);
+        to->function[i].samples = LOAD(from->function[i].samples);
+        to->function[i].out_of_range = LOAD(from->function[i].out_of_range);
+        to->function[i].ticks = load_ticks(&from->function[i].ticks);
+    }
+    for (i = 0; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+        to->conductivity_iterations[i] =
+            LOAD(from->conductivity_iterations[i]);
+}
+
+/* Add the iterations counted in histogram to stats. */
+static void count_iterations(struct oceanography_stats *stats,
+                             const unsigned long *histogram)
+{
+    int i;
+
+    for (i = 0; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+        if (histogram[i] != 0)
+            COUNT(stats->conductivity_iterations[i], histogram[i]);
+}
+
+/* Count a call of n samples, out_of_range of them outside the ranges. */
+static void count_call(const struct stats_call *call, unsigned long elapsed,
+                       size_t n, unsigned long out_of_range)
+{
+    struct oceanography_stats_counter *counter;
+
+    counter = &call->stats->function[call->function];
+
+    COUNT_LOCK();
+    COUNT(counter->calls, 1);
+    COUNT(counter->samples, n);
+    COUNT(counter->out_of_range, out_of_range);
+    count_ticks(&counter->ticks, (double) elapsed);
+    count_iterations(call->stats, call->iterations);
+    COUNT_UNLOCK();
+}
+
+static void add(struct oceanography_stats *to,
+                const struct oceanography_stats *from)
+{
+    int i;
+
+    for (i = 0; i < OCEANOGRAPHY_STATS_FUNCTIONS; i++) {
+        to->function[i].calls += from->function[i].calls;
+        to->function[i].samples += from->function[i].samples;
+        to->function[i].out_of_range += from->function[i].out_of_range;
+        to->function[i].ticks += from->function[i].ticks;
+    }
+    for (i = 0; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+        to->conductivity_iterations[i] += from->conductivity_iterations[i];
+}
+
+static void subtract(struct oceanography_stats *to,
+                     const struct oceanography_stats *from)
+{
+    int i;
+
+    for (i = 0; i < OCEANOGRAPHY_STATS_FUNCTIONS; i++) {
+        to->function[i].calls -= from->function[i].calls;
+        to->function[i].samples -= from->function[i].samples;
+        to->function[i].out_of_range -= from->function[i].out_of_range;
+        to->function[i].ticks -= from->function[i].ticks;
+    }
+    for (i = 0; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+        to->conductivity_iterations[i] -= from->conductivity_iterations[i];
+}
+
+/* Destructor of the block of an exiting thread. */
+static void retire(void *arg)
+{
+    struct stats_block *block = arg;
+
+    pthread_mutex_lock(&lock);
+    add(&retired, &block->stats);
+    if (block->prev != NULL)
+        block->prev->next = block->next;
+    else
+        blocks = block->next;
+    if (block->next != NULL)
+        block->next->prev = block->prev;
+    pthread_mutex_unlock(&lock);
+
+    free(block);
+}
+
+static void create_key(void)
+{
+    if (pthread_key_create(&key, retire) != 0)
+        key_error = 1;
+}
+
+/* Block of the calling thread, allocated at the first call. Returns NULL if
+ * it can not be allocated. */
+static struct stats_block *thread_block(void)
+{
+    struct stats_block *block;
+
+    pthread_once(&key_once, create_key);
+    if (key_error)
+        return NULL;
+
+    block = pthread_getspecific(key);
+    if (block != NULL)
+        return block;
+
+    block = calloc(1, sizeof(*block));
+    if (block == NULL)
+        return NULL;
+    if (pthread_setspecific(key, block) != 0) {
+        free(block);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&lock);
+    block->next = blocks;
+    if (blocks != NULL)
+        blocks->prev = block;
+    blocks = block;
+    pthread_mutex_unlock(&lock);
+
+    return block;
+}
+
+/* Read OCEANOGRAPHY_STATS, unless oceanography_stats_enable() came
+ * first. */
+static void read_environment(void)
+{
+    const char *env = getenv("OCEANOGRAPHY_STATS");
+    int value = env != NULL && atoi(env) != 0, unset = -1;
+
+#ifdef __ATOMIC_RELAXED
+    __atomic_compare_exchange_n(&stats_enabled, &unset, value, 0,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#else
+    pthread_mutex_lock(&lock);
+    if (stats_enabled == unset)
+        stats_enabled = value;
+    pthread_mutex_unlock(&lock);
+#endif
+}
+
+static int enabled(void)
+{
+    if (STATS_ENABLED() < 0)
+        pthread_once(&environment_once, read_environment);
+
+    return STATS_ENABLED();
+}
+
+/* CPU cycles where there is a time stamp counter, nanoseconds elsewhere. */
+static unsigned long ticks(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return (unsigned long) __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned long) now.tv_sec * 1000000000UL +
+        (unsigned long) now.tv_nsec;
+#endif
+}
+
+static int outside(double x, const struct range *range)
+{
+    return !((x > range->min || (x == range->min && !range->open)) &&
+             x <= range->max);
+}
+
+struct oceanography_stats *stats_begin(struct stats_call *call)
+{
+    struct stats_block *block;
+
+    if (!enabled())
+        return NULL;
+
+    block = thread_block();
+    if (block == NULL)
+        return NULL;
+
+    memset(call->iterations, 0, sizeof(call->iterations));
+    call->start = ticks();
+
+    return &block->stats;
+}
+
+void stats_end(const struct stats_call *call, size_t n,
+               const double *a, size_t a_stride,
+               const double *b, size_t b_stride,
+               const double *c, size_t c_stride)
+{
+    static const double zero = 0.0;
+    const struct range *range[3];
+    unsigned long elapsed, out_of_range = 0;
+    size_t i;
+
+    elapsed = ticks() - call->start;
+
+    /* Inputs not to check are replaced by a 0 in any range. */
+    for (i = 0; i < 3; i++)
+        range[i] = &ranges[call->function][i];
+    if (a == NULL) {
+        a = &zero;
+        a_stride = 0;
+        range[0] = &any;
+    }
+    if (b == NULL) {
+        b = &zero;
+        b_stride = 0;
+        range[1] = &any;
+    }
+    if (c == NULL) {
+        c = &zero;
+        c_stride = 0;
+        range[2] = &any;
+    }
+
+    for (i = 0; i < n; i++)
+        out_of_range += outside(a[i * a_stride], range[0]) |
+            outside(b[i * b_stride], range[1]) |
+            outside(c[i * c_stride], range[2]);
+    count_call(call, elapsed, n, out_of_range);
+}
+
+void stats_end_f(const struct stats_call *call, size_t n,
+                 const float *a, size_t a_stride,
+                 const float *b, size_t b_stride,
+                 const float *c, size_t c_stride)
+{
+    static const float zero = 0.0f;
+    const struct range *range[3];
+    unsigned long elapsed, out_of_range = 0;
+    size_t i;
+
+    elapsed = ticks() - call->start;
+
+    /* Inputs not to check are replaced by a 0 in any range. */
+    for (i = 0; i < 3; i++)
+        range[i] = &ranges[call->function][i];
+    if (a == NULL) {
+        a = &zero;
+        a_stride = 0;
+        range[0] = &any;
+    }
+    if (b == NULL) {
+        b = &zero;
+        b_stride = 0;
+        range[1] = &any;
+    }
+    if (c == NULL) {
+        c = &zero;
+        c_stride = 0;
+        range[2] = &any;
+    }
+
+    for (i = 0; i < n; i++)
+        out_of_range += outside(a[i * a_stride], range[0]) |
+            outside(b[i * b_stride], range[1]) |
+            outside(c[i * c_stride], range[2]);
+    count_call(call, elapsed, n, out_of_range);
+}
+
+/* For the kernels run by the threads of a pool, that count the iterations of
+ * conductivity in histogram, cleared here, and then add them to the block of
+ * their thread with stats_add_histogram(). Returns NULL if disabled. */
+unsigned long *stats_histogram(unsigned long *histogram)
+{
+    if (!enabled())
+        return NULL;
+
+    memset(histogram, 0, (OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1) *
+           sizeof(*histogram));
+
+    return histogram;
+}
+
+void stats_add_histogram(const unsigned long *histogram)
+{
+    struct stats_block *block;
+
+    if (histogram == NULL)
+        return;
+
+    block = thread_block();
+    if (block == NULL)
+        return;
+
+    COUNT_LOCK();
+    count_iterations(&block->stats, histogram);
+    COUNT_UNLOCK();
+}
+
+/* oceanography_stats_enable -- enable (non zero) or disable counting.
+ *
+ * Returns 0, or -1 if the library was built without OCEANOGRAPHY_STATS.
+ */
+
+int oceanography_stats_enable(int enable)
+{
+#ifdef __ATOMIC_RELAXED
+    __atomic_store_n(&stats_enabled, enable != 0, __ATOMIC_RELAXED);
+#else
+    pthread_mutex_lock(&lock);
+    stats_enabled = enable != 0;
+    pthread_mutex_unlock(&lock);
+#endif
+
+    return 0;
+}
+
+/* oceanography_stats_snapshot -- sum the counters of all the threads since
+ * the last oceanography_stats_reset().
+ *
+ * Calls still running in other threads may be missing.
+ */
+
+void oceanography_stats_snapshot(struct oceanography_stats *stats)
+{
+    struct oceanography_stats counts;
+    struct stats_block *block;
+
+    pthread_mutex_lock(&lock);
+    *stats = retired;
+    for (block = blocks; block != NULL; block = block->next) {
+        load(&counts, &block->stats);
+        add(stats, &counts);
+    }
+    subtract(stats, &baseline);
+    pthread_mutex_unlock(&lock);
+}
+
+/* oceanography_stats_thread_snapshot -- counters of the calling thread since
+ * the last oceanography_stats_reset().
+ */
+
+void oceanography_stats_thread_snapshot(struct oceanography_stats *stats)
+{
+    struct stats_block *block;
+
+    memset(stats, 0, sizeof(*stats));
+
+    pthread_once(&key_once, create_key);
+    if (key_error)
+        return;
+
+    block = pthread_getspecific(key);
+    if (block == NULL)
+        return;
+
+    pthread_mutex_lock(&lock);
+    load(stats, &block->stats);
+    subtract(stats, &block->baseline);
+    pthread_mutex_unlock(&lock);
+}
+
+/* oceanography_stats_reset -- restart the counters of all the threads. */
+
+void oceanography_stats_reset(void)
+{
+    struct stats_block *block;
+
+    pthread_mutex_lock(&lock);
+    baseline = retired;
+    for (block = blocks; block != NULL; block = block->next) {
+        load(&block->baseline, &block->stats);
+        add(&baseline, &block->baseline);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+#else
+
+int oceanography_stats_enable(int enable)
+{
+    (void) enable;
+
+    return -1;
+}
+
+void oceanography_stats_snapshot(struct oceanography_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void oceanography_stats_thread_snapshot(struct oceanography_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void oceanography_stats_reset(void)
+{
+}
+
+#endif /* OCEANOGRAPHY_STATS */
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * stats.h -- Private interface of the instrumentation.
+ *
+ * An instrumented entry point declares STATS_CALL after its other
+ * declarations, and wraps the computation in STATS_BEGIN() and STATS_END():
+ *
+ *     STATS_BEGIN(OCEANOGRAPHY_STATS_SALINITY);
+ *     salinity kernel;
+ *     STATS_END(n, conductivity, 1, temperature, 1, pressure, 1);
+ *
+ * STATS_END() takes the number of samples and up to three input arrays with
+ * their strides, in the order of the arguments of the function (NULL for the
+ * ones not to check). Inputs are only read when counting is enabled, so the
+ * cost of a disabled call is a test of stats_enabled. Without
+ * OCEANOGRAPHY_STATS the macros expand to nothing.
+ *
+ * This header is not installed.
+ */
+
+#ifndef OCEANOGRAPHY_STATS_H
+#define OCEANOGRAPHY_STATS_H
+
+#include <stddef.h>
+
+#include "oceanography.h"
+
+#ifdef OCEANOGRAPHY_STATS
+
+struct stats_call {
+    struct oceanography_stats *stats;   /* of the thread, NULL if disabled */
+    enum oceanography_stats_function function;
+    unsigned long start;
+    unsigned long iterations[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+};
+
+/* 1 if enabled, 0 if disabled, -1 until OCEANOGRAPHY_STATS is read. Read
+ * and written by any thread, through STATS_ENABLED() and atomic stores. */
+extern int stats_enabled;
+
+#ifdef __ATOMIC_RELAXED
+#define STATS_ENABLED() __atomic_load_n(&stats_enabled, __ATOMIC_RELAXED)
+#else
+#define STATS_ENABLED() stats_enabled
+#endif
+
+struct oceanography_stats *stats_begin(struct stats_call *call);
+void stats_end(const struct stats_call *call, size_t n,
+               const double *a, size_t a_stride,
+               const double *b, size_t b_stride,
+               const double *c, size_t c_stride);
+void stats_end_f(const struct stats_call *call, size_t n,
+                 const float *a, size_t a_stride,
+                 const float *b, size_t b_stride,
+                 const float *c, size_t c_stride);
+unsigned long *stats_histogram(unsigned long *histogram);
+void stats_add_histogram(const unsigned long *histogram);
+
+#define STATS_CALL struct stats_call stats_call
+
+#define STATS_BEGIN(f)                                                      \
+    do {                                                                    \
+        stats_call.stats = STATS_ENABLED() ? stats_begin(&stats_call)       \
+                                           : NULL;                          \
+        stats_call.function = (f);                                          \
+    } while (0)
+
+#define STATS_END(n, a, a_stride, b, b_stride, c, c_stride)                \
+    do {                                                                    \
+        if (stats_call.stats != NULL)                                       \
+            stats_end(&stats_call, n, a, a_stride, b, b_stride, c,          \
+                      c_stride);                                            \
+    } while (0)
+
+#define STATS_END_F(n, a, a_stride, b, b_stride, c, c_stride)              \
+    do {                                                                    \
+        if (stats_call.stats != NULL)                                       \
+            stats_end_f(&stats_call, n, a, a_stride, b, b_stride, c,        \
+                        c_stride);                                          \
+    } while (0)
+
+/* Conductivity iteration histogram of the call, added to the counters of
+ * the thread by STATS_END(), or NULL. */
+#define STATS_HISTOGRAM()                                                   \
+    (stats_call.stats != NULL ? stats_call.iterations : NULL)
+
+/* Count a sample of conductivity that took k iterations. */
+#define STATS_ITERATIONS(k)                                                 \
+    do {                                                                    \
+        if (stats_call.stats != NULL)                                       \
+            stats_call.iterations[k]++;                                     \
+    } while (0)
+
+#else
+
+#define STATS_CALL
+#define STATS_BEGIN(f) ((void) 0)
+#define STATS_END(n, a, a_stride, b, b_stride, c, c_stride) ((void) 0)
+#define STATS_END_F(n, a, a_stride, b, b_stride, c, c_stride) ((void) 0)
+#define STATS_HISTOGRAM() NULL
+#define STATS_ITERATIONS(k) ((void) 0)
+#define stats_histogram(histogram) ((void) (histogram), NULL)
+#define stats_add_histogram(histogram) ((void) (histogram))
+
+#endif /* OCEANOGRAPHY_STATS */
+
+#endif /* OCEANOGRAPHY_STATS_H */
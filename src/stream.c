@@ -0,0 +1,267 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ *
+ * stream.c -- Streaming of binary CTD files through the fused pipeline.
+ *
+ * The input file is mapped a window of records at a time, so memory use
+ * does not depend on its size. The columns of a window are converted to
+ * double in place of the batch arrays, the outputs are computed by
+ * ctd_derive_parallel() and written as records to the output file.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "oceanography.h"
+
+/* Records per window: the batch arrays of a window (up to 96 bytes per
+ * record) take 6 MiB, and a window has enough chunks to keep the threads of
+ * the pool busy. */
+#define WINDOW 65536
+
+#define CTD_OUTPUTS 9
+
+static size_t type_size(enum oceanography_type type)
+{
+    return type == OCEANOGRAPHY_FLOAT32 ? sizeof(float) : sizeof(double);
+}
+
+static int valid_column(const struct oceanography_column *column,
+                        size_t record_size)
+{
+    return (column->type == OCEANOGRAPHY_FLOAT32 ||
+            column->type == OCEANOGRAPHY_FLOAT64) &&
+           column->offset <= record_size &&
+           type_size(column->type) <= record_size - column->offset;
+}
+
+/* Convert a column of n records to double. Values are read with memcpy(),
+ * that compiles to a plain load, since records need not be aligned. */
+static void gather(const unsigned char *record, size_t record_size,
+                   const struct oceanography_column *column, double *out,
+                   size_t n)
+{
+    const unsigned char *q = record + column->offset;
+    size_t i;
+    float f;
+    double d;
+
+    if (column->type == OCEANOGRAPHY_FLOAT32)
+        for (i = 0; i < n; i++, q += record_size) {
+            memcpy(&f, q, sizeof(f));
+            out[i] = f;
+        }
+    else
+        for (i = 0; i < n; i++, q += record_size) {
+            memcpy(&d, q, sizeof(d));
+            out[i] = d;
+        }
+}
+
+/* Store n values as a column of the output records. */
+static void scatter(const double *in, enum oceanography_type type,
+                    unsigned char *record, size_t record_size, size_t n)
+{
+    size_t i;
+    float f;
+
+    if (type == OCEANOGRAPHY_FLOAT32)
+        for (i = 0; i < n; i++, record += record_size) {
+            f = (float) in[i];
+            memcpy(record, &f, sizeof(f));
+        }
+    else
+        for (i = 0; i < n; i++, record += record_size)
+            memcpy(record, &in[i], sizeof(in[i]));
+}
+
+static int write_all(int fd, const unsigned char *buffer, size_t size)
+{
+    ssize_t written;
+
+    while (size > 0) {
+        written = write(fd, buffer, size);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buffer += written;
+        size -= (size_t) written;
+    }
+
+    return 0;
+}
+
+/* Stream the records of in_fd to out_fd, a window at a time. arrays holds
+ * the input columns and the columns of the outputs, buffer a window of
+ * output records. */
+static int stream_records(struct oceanography_pool *pool,
+                          const struct oceanography_stream *stream,
+                          int in_fd, int out_fd, double *arrays,
+                          unsigned char *buffer)
+{
+    struct ctd_outputs ctd;
+    struct stat st;
+    double *columns[CTD_OUTPUTS];
+    unsigned char *map;
+    size_t records, r, m, begin, aligned, length, size, record_size, page;
+    int k, selected;
+
+    /* The outputs that are not selected are never written. */
+    for (k = 0, selected = 0; k < CTD_OUTPUTS; k++)
+        columns[k] = stream->outputs & (1u << k) ?
+                     arrays + (3 + selected++) * WINDOW : NULL;
+    ctd.salinity = columns[0];
+    ctd.svan = columns[1];
+    ctd.sigma = columns[2];
+    ctd.theta = columns[3];
+    ctd.sound_speed = columns[4];
+    ctd.depth = columns[5];
+    ctd.cpsw = columns[6];
+    ctd.freezing_point = columns[7];
+    ctd.atg = columns[8];
+
+    size = type_size(stream->output_type);
+    record_size = selected * size;
+    page = (size_t) sysconf(_SC_PAGESIZE);
+
+    if (fstat(in_fd, &st) < 0)
+        return -1;
+    records = (size_t) st.st_size > stream->header ?
+              ((size_t) st.st_size - stream->header) / stream->record_size :
+              0;
+
+    for (r = 0; r < records; r += m) {
+        m = records - r < WINDOW ? records - r : WINDOW;
+        begin = stream->header + r * stream->record_size;
+        aligned = begin - begin % page;
+        length = begin + m * stream->record_size - aligned;
+
+        map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, in_fd,
+                   (off_t) aligned);
+        if (map == MAP_FAILED)
+            return -1;
+        /* Read the window ahead instead of faulting it in page by page:
+         * more than twice faster than POSIX_MADV_SEQUENTIAL. */
+        posix_madvise(map, length, POSIX_MADV_WILLNEED);
+
+        gather(map + (begin - aligned), stream->record_size,
+               &stream->conductivity, arrays, m);
+        gather(map + (begin - aligned), stream->record_size,
+               &stream->temperature, arrays + WINDOW, m);
+        gather(map + (begin - aligned), stream->record_size,
+               &stream->pressure, arrays + 2 * WINDOW, m);
+        munmap(map, length);
+
+        ctd_derive_parallel(pool, arrays, arrays + WINDOW, arrays + 2 * WINDOW,
+                            stream->latitude, stream->reference_pressure,
+                            stream->outputs, &ctd, m);
+
+        for (k = 0, selected = 0; k < CTD_OUTPUTS; k++)
+            if (columns[k] != NULL)
+                scatter(columns[k], stream->output_type,
+                        buffer + size * selected++, record_size, m);
+
+        if (write_all(out_fd, buffer, m * record_size) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/* oceanography_stream_file -- compute the outputs selected by stream->outputs
+ * for every record of the input file, writing them to the output file.
+ *
+ * Input records start after stream->header bytes and take
+ * stream->record_size bytes each; bytes after the last whole record are
+ * ignored. Every output record holds the selected outputs, in the order of
+ * the OCEANOGRAPHY_CTD_* flags, as values of stream->output_type. The
+ * output file is created or truncated. With a NULL pool the default one is
+ * used.
+ *
+ * Units are the same of ctd_derive_n().
+ *
+ * Returns 0 on success, -1 on failure with errno set: EINVAL for an invalid
+ * stream. On failure the output file can be incomplete.
+ */
+
+int oceanography_stream_file(struct oceanography_pool *pool,
+                             const struct oceanography_stream *stream,
+                             const char *input, const char *output)
+{
+    double *arrays;
+    unsigned char *buffer;
+    int in_fd, out_fd, k, selected = 0, result, saved;
+
+    if (stream->record_size == 0 || stream->outputs == 0 ||
+        (stream->outputs & ~((1u << CTD_OUTPUTS) - 1)) != 0 ||
+        (stream->output_type != OCEANOGRAPHY_FLOAT32 &&
+         stream->output_type != OCEANOGRAPHY_FLOAT64) ||
+        !valid_column(&stream->conductivity, stream->record_size) ||
+        !valid_column(&stream->temperature, stream->record_size) ||
+        !valid_column(&stream->pressure, stream->record_size)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (k = 0; k < CTD_OUTPUTS; k++)
+        if (stream->outputs & (1u << k))
+            selected++;
+
+    in_fd = open(input, O_RDONLY);
+    if (in_fd < 0)
+        return -1;
+    out_fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (out_fd < 0) {
+        saved = errno;
+        close(in_fd);
+        errno = saved;
+        return -1;
+    }
+
+    arrays = malloc((3 + selected) * WINDOW * sizeof(double));
+    buffer = malloc(WINDOW * selected * type_size(stream->output_type));
+    if (arrays == NULL || buffer == NULL) {
+        errno = ENOMEM;
+        result = -1;
+    } else {
+        result = stream_records(pool, stream, in_fd, out_fd, arrays, buffer);
+    }
+
+    saved = errno;
+    free(arrays);
+    free(buffer);
+    close(in_fd);
+    if (close(out_fd) < 0 && result == 0) {
+        saved = errno;
+        result = -1;
+    }
+    errno = saved;
+
+    return result;
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * summary.c -- Summaries of derived quantities.
+ *
+ * Samples are added a block at a time. The count, mean and sum of squared
+ * deviations of a block are computed by the corrected two pass algorithm,
+ * while the block is in the L1 cache, and merged into the summary with the
+ * pairwise update of Chan, Golub and LeVeque: the update of Welford
+ * generalized to sets of samples, that does not lose precision when the
+ * mean is large compared to the deviation, as the sum of squares does. The
+ * same update merges the summaries of different threads.
+ */
+
+#include <math.h>
+#include <stddef.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+#include "stats.h"
+
+/* Samples per block: the outputs of a block of ctd_summarize_n() take
+ * 18 KiB. */
+#define BLOCK 256
+
+#define CTD_OUTPUTS 9
+
+/* Merge count samples of mean, sum of squared deviations m2, minimum min
+ * and maximum max into summary. */
+static void merge(struct oceanography_summary *summary, unsigned long count,
+                  double mean, double m2, double min, double max)
+{
+    double delta, total;
+
+    if (count == 0)
+        return;
+
+    if (summary->count == 0) {
+        summary->mean = mean;
+        summary->m2 = m2;
+    } else {
+        total = (double) summary->count + (double) count;
+        delta = mean - summary->mean;
+        summary->mean += delta * (count / total);
+        summary->m2 += m2 + delta * delta * (summary->count / total) * count;
+    }
+    summary->count += count;
+    if (min < summary->min)
+        summary->min = min;
+    if (max > summary->max)
+        summary->max = max;
+}
+
+/* Add the m samples of a block to the histogram of summary. */
+static void add_histogram(struct oceanography_summary *summary,
+                          const double *x, size_t m)
+{
+    double limit = (double) summary->bins;
+    double bin;
+    size_t j;
+
+    for (j = 0; j < m; j++) {
+        bin = (x[j] - summary->histogram_min) * summary->histogram_scale;
+        if (bin < 0.0)
+            summary->below++;
+        else if (bin >= limit)
+            summary->above++;
+        else if (bin == bin)
+            summary->histogram[(size_t) bin]++;
+    }
+}
+
+static void add_block(struct oceanography_summary *summary, const double *x,
+                      size_t m);
+
+/* Add the samples of a block that are not NaN to summary. Returns 0, and
+ * adds nothing, if there are none to skip. Kept apart from add_block(),
+ * whose loops do not need the buffer. */
+static int add_numbers(struct oceanography_summary *summary,
+                       const double *x, size_t m)
+{
+    double buffer[BLOCK];
+    size_t j, count;
+
+    for (j = 0, count = 0; j < m; j++)
+        if (x[j] == x[j])
+            buffer[count++] = x[j];
+    if (count == m)
+        return 0;
+    if (count > 0)
+        add_block(summary, buffer, count);
+    return 1;
+}
+
+/* Add the m samples of a block to summary. Every sum has four
+ * accumulators, so consecutive additions do not wait for each other. */
+static void add_block(struct oceanography_summary *summary, const double *x,
+                      size_t m)
+{
+    double sum[4], min[4], max[4], d[4], q[4];
+    double total, mean, deviation, m2;
+    size_t j, k;
+
+    for (k = 0; k < 4; k++) {
+        sum[k] = d[k] = q[k] = 0.0;
+        min[k] = HUGE_VAL;
+        max[k] = -HUGE_VAL;
+    }
+    for (j = 0; j + 4 <= m; j += 4)
+        for (k = 0; k < 4; k++) {
+            sum[k] += x[j + k];
+            min[k] = x[j + k] < min[k] ? x[j + k] : min[k];
+            max[k] = x[j + k] > max[k] ? x[j + k] : max[k];
+        }
+    for (k = 0; j < m; j++, k++) {
+        sum[k] += x[j];
+        min[k] = x[j] < min[k] ? x[j] : min[k];
+        max[k] = x[j] > max[k] ? x[j] : max[k];
+    }
+    total = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+
+    /* NaN samples make the sum NaN: the block is added again without
+     * them. */
+    if (total != total && add_numbers(summary, x, m))
+        return;
+
+    /* The sum of the deviations, zero in exact arithmetic, corrects the
+     * rounding of the mean. */
+    mean = total / m;
+    for (j = 0; j + 4 <= m; j += 4)
+        for (k = 0; k < 4; k++) {
+            d[k] += x[j + k] - mean;
+            q[k] += (x[j + k] - mean) * (x[j + k] - mean);
+        }
+    for (k = 0; j < m; j++, k++) {
+        d[k] += x[j] - mean;
+        q[k] += (x[j] - mean) * (x[j] - mean);
+    }
+    deviation = (d[0] + d[1]) + (d[2] + d[3]);
+    m2 = (q[0] + q[1]) + (q[2] + q[3]) - deviation * deviation / m;
+    mean += deviation / m;
+
+    for (k = 1; k < 4; k++) {
+        min[0] = min[k] < min[0] ? min[k] : min[0];
+        max[0] = max[k] > max[0] ? max[k] : max[0];
+    }
+
+    merge(summary, m, mean, m2, min[0], max[0]);
+    if (summary->histogram != NULL)
+        add_histogram(summary, x, m);
+}
+
+/* oceanography_summary_init -- start an empty summary.
+ *
+ * If histogram is not NULL, its bins elements are cleared and count the
+ * samples in [min, max), split in bins of equal width; the samples below
+ * min and not below max are counted in summary->below and summary->above.
+ */
+
+void oceanography_summary_init(struct oceanography_summary *summary,
+                               unsigned long *histogram, size_t bins,
+                               double min, double max)
+{
+    size_t k;
+
+    summary->count = 0;
+    summary->mean = 0.0;
+    summary->m2 = 0.0;
+    summary->min = HUGE_VAL;
+    summary->max = -HUGE_VAL;
+    summary->histogram = bins > 0 ? histogram : NULL;
+    summary->bins = summary->histogram != NULL ? bins : 0;
+    summary->histogram_min = min;
+    summary->histogram_scale = summary->bins / (max - min);
+    summary->below = 0;
+    summary->above = 0;
+
+    for (k = 0; k < summary->bins; k++)
+        histogram[k] = 0;
+}
+
+/* oceanography_summary_add_n -- add n samples to a summary.
+ *
+ * NaN samples are skipped.
+ */
+
+void oceanography_summary_add_n(struct oceanography_summary *summary,
+                                const double *x, size_t n)
+{
+    size_t i, m;
+
+    for (i = 0; i < n; i += m) {
+        m = n - i < BLOCK ? n - i : BLOCK;
+        add_block(summary, x + i, m);
+    }
+}
+
+/* oceanography_summary_merge -- add the samples of other to summary.
+ *
+ * The histograms are merged if both summaries have one with the same
+ * number of bins, that must have the same range.
+ */
+
+void oceanography_summary_merge(struct oceanography_summary *summary,
+                                const struct oceanography_summary *other)
+{
+    size_t k;
+
+    merge(summary, other->count, other->mean, other->m2, other->min,
+          other->max);
+
+    if (summary->histogram != NULL && other->histogram != NULL &&
+        summary->bins == other->bins) {
+        for (k = 0; k < summary->bins; k++)
+            summary->histogram[k] += other->histogram[k];
+        summary->below += other->below;
+        summary->above += other->above;
+    }
+}
+
+/* oceanography_summary_variance -- get the sample variance of a summary.
+ *
+ * Returns the variance, with Bessel's correction, or 0 for less than two
+ * samples.
+ */
+
+double oceanography_summary_variance(
+    const struct oceanography_summary *summary)
+{
+    if (summary->count < 2)
+        return 0.0;
+
+    return summary->m2 / (summary->count - 1);
+}
+
+/* ctd_summarize_n -- add the outputs selected by the mask of
+ * OCEANOGRAPHY_CTD_* flags in outputs, from n conductivity ratios,
+ * temperatures and pressures, to the summaries of out.
+ *
+ * The outputs are the ones of ctd_derive_n(), computed a block at a time in
+ * buffers that stay in the L1 cache: the summaries are the ones of the
+ * output arrays, without writing and reading them. The summaries of out
+ * selected by the mask must not be NULL.
+ */
+
+void ctd_summarize_n(const double *conductivity, const double *temperature,
+                     const double *pressure, double latitude,
+                     double reference_pressure, unsigned int outputs,
+                     const struct ctd_summaries *out, size_t n)
+{
+    const struct simd_kernels *kernels = simd_select();
+    double block[CTD_OUTPUTS][BLOCK];
+    double *columns[CTD_OUTPUTS];
+    struct oceanography_summary *summaries[CTD_OUTPUTS];
+    struct ctd_outputs ctd;
+    double gravity = _gravity(latitude);
+    size_t i, m;
+    int k;
+    STATS_CALL;
+
+    STATS_BEGIN(OCEANOGRAPHY_STATS_CTD_DERIVE);
+    for (k = 0; k < CTD_OUTPUTS; k++)
+        columns[k] = outputs & (1u << k) ? block[k] : NULL;
+    ctd.salinity = columns[0];
+    ctd.svan = columns[1];
+    ctd.sigma = columns[2];
+    ctd.theta = columns[3];
+    ctd.sound_speed = columns[4];
+    ctd.depth = columns[5];
+    ctd.cpsw = columns[6];
+    ctd.freezing_point = columns[7];
+    ctd.atg = columns[8];
+    summaries[0] = out->salinity;
+    summaries[1] = out->svan;
+    summaries[2] = out->sigma;
+    summaries[3] = out->theta;
+    summaries[4] = out->sound_speed;
+    summaries[5] = out->depth;
+    summaries[6] = out->cpsw;
+    summaries[7] = out->freezing_point;
+    summaries[8] = out->atg;
+
+    for (i = 0; i < n; i += m) {
+        m = n - i < BLOCK ? n - i : BLOCK;
+        /* conductivity may be NULL if only depth is asked. */
+        kernels->ctd_derive(outputs & CTD_SALINITY_OUTPUTS ?
+                            conductivity + i : NULL, temperature + i,
+                            pressure + i, gravity, reference_pressure,
+                            outputs, &ctd, m);
+        for (k = 0; k < CTD_OUTPUTS; k++)
+            if (columns[k] != NULL)
+                add_block(summaries[k], columns[k], m);
+    }
+    STATS_END(n, outputs & CTD_SALINITY_OUTPUTS ? conductivity : NULL, 1,
+              temperature, 1, pressure, 1);
+}
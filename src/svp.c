@@ -0,0 +1,347 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * svp.c -- Sound velocity profiles.
+ *
+ * Sound speed is computed at the depth of every sample of a cast and
+ * interpolated with a monotone piecewise cubic Hermite spline (Fritsch and
+ * Butland slopes), that does not overshoot the samples: a ray tracer never
+ * sees a speed outside the ones measured around it.
+ *
+ * The depth range is split in buckets of equal width, each one holding the
+ * first segment it overlaps. Buckets are not wider than the closest samples,
+ * unless that takes more than BUCKETS per segment, so a query walks at most
+ * one segment from the start of its bucket.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+
+/* Maximum number of buckets per segment of the spline. */
+#define BUCKETS 16
+
+/* A segment of the spline: speed at z + h is
+ * a[0] + h * (a[1] + h * (a[2] + h * a[3])). */
+struct svp_segment {
+    double z;
+    double a[4];
+};
+
+struct oceanography_svp {
+    size_t n;                   /* samples */
+    double min, max;            /* depth range */
+    double scale;               /* buckets per meter */
+    size_t buckets;
+    size_t *bucket;             /* first segment of every bucket */
+    struct svp_segment *segment;
+    struct svp_segment top, bottom;
+};
+
+/* Slope of the spline at the first sample, from the secants d0 and d1 of
+ * the first two segments, of width h0 and h1. */
+static double end_slope(double h0, double h1, double d0, double d1)
+{
+    double d;
+
+    d = ((2.0 * h0 + h1) * d0 - h0 * d1) / (h0 + h1);
+    if (d * d0 <= 0.0)
+        return 0.0;
+    if (d0 * d1 <= 0.0 && fabs(d) > fabs(3.0 * d0))
+        return 3.0 * d0;
+
+    return d;
+}
+
+/* Fill the coefficients of the segments from the speed in a[0]. */
+static void fit(struct svp_segment *segment, size_t n)
+{
+    double h0, h1, d0, d1, slope, next;
+    size_t k;
+
+    if (n == 2) {
+        d0 = (segment[1].a[0] - segment[0].a[0]) /
+             (segment[1].z - segment[0].z);
+        segment[0].a[1] = d0;
+        segment[0].a[2] = 0.0;
+        segment[0].a[3] = 0.0;
+        segment[1].a[1] = d0;
+        return;
+    }
+
+    h0 = segment[1].z - segment[0].z;
+    h1 = segment[2].z - segment[1].z;
+    d0 = (segment[1].a[0] - segment[0].a[0]) / h0;
+    d1 = (segment[2].a[0] - segment[1].a[0]) / h1;
+    segment[0].a[1] = end_slope(h0, h1, d0, d1);
+
+    /* Weighted harmonic mean of the secants, zero at the extrema. */
+    for (k = 1; k < n - 1; k++) {
+        h0 = segment[k].z - segment[k - 1].z;
+        h1 = segment[k + 1].z - segment[k].z;
+        d0 = (segment[k].a[0] - segment[k - 1].a[0]) / h0;
+        d1 = (segment[k + 1].a[0] - segment[k].a[0]) / h1;
+        if (d0 * d1 <= 0.0)
+            segment[k].a[1] = 0.0;
+        else
+            segment[k].a[1] = (3.0 * h0 + 3.0 * h1) /
+                              ((2.0 * h1 + h0) / d0 + (h1 + 2.0 * h0) / d1);
+    }
+
+    h0 = segment[n - 1].z - segment[n - 2].z;
+    h1 = segment[n - 2].z - segment[n - 3].z;
+    d0 = (segment[n - 1].a[0] - segment[n - 2].a[0]) / h0;
+    d1 = (segment[n - 2].a[0] - segment[n - 3].a[0]) / h1;
+    segment[n - 1].a[1] = end_slope(h0, h1, d0, d1);
+
+    for (k = 0; k < n - 1; k++) {
+        h0 = segment[k + 1].z - segment[k].z;
+        d0 = (segment[k + 1].a[0] - segment[k].a[0]) / h0;
+        slope = segment[k].a[1];
+        next = segment[k + 1].a[1];
+        segment[k].a[2] = (3.0 * d0 - 2.0 * slope - next) / h0;
+        segment[k].a[3] = (slope + next - 2.0 * d0) / (h0 * h0);
+    }
+}
+
+/* Bucket of depth z, in the range of the profile. */
+#define BUCKET(svp, z) ((size_t) (((z) - (svp)->min) * (svp)->scale))
+
+/* Buckets for the profile: as many as fit the closest samples, at most
+ * BUCKETS per segment. */
+static size_t bucket_count(const struct svp_segment *segment, size_t n)
+{
+    double closest, count;
+    size_t k;
+
+    closest = segment[1].z - segment[0].z;
+    for (k = 2; k < n; k++)
+        if (segment[k].z - segment[k - 1].z < closest)
+            closest = segment[k].z - segment[k - 1].z;
+
+    count = ceil((segment[n - 1].z - segment[0].z) / closest);
+    if (count > (double) BUCKETS * (n - 1))
+        count = (double) BUCKETS * (n - 1);
+
+    return count < 1.0 ? 1 : (size_t) count;
+}
+
+/* oceanography_svp_create -- build the sound velocity profile of a cast.
+ *
+ * The n samples of the cast, at least 2, must be sorted by increasing
+ * pressure. Depth is computed at latitude.
+ *
+ * Units: salinity PSS-78, temperature degrees Celsius, pressure decibars,
+ *        latitude degrees.
+ *
+ * Returns NULL if the samples are not valid or memory is not enough.
+ */
+
+struct oceanography_svp *oceanography_svp_create(const double *salinity,
+                                                 const double *temperature,
+                                                 const double *pressure,
+                                                 double latitude, size_t n)
+{
+    struct oceanography_svp *svp;
+    size_t b, k;
+
+    if (n < 2 || n > (size_t) -1 / (BUCKETS * sizeof(size_t)))
+        return NULL;
+
+    svp = malloc(sizeof(*svp));
+    if (svp == NULL)
+        return NULL;
+
+    svp->n = n;
+    svp->bucket = NULL;
+    svp->segment = malloc(n * sizeof(*svp->segment));
+    if (svp->segment == NULL) {
+        oceanography_svp_destroy(svp);
+        return NULL;
+    }
+
+    for (k = 0; k < n; k++) {
+        svp->segment[k].z = _depth(pressure[k], latitude);
+        svp->segment[k].a[0] = _sound_speed(salinity[k], temperature[k],
+                                            pressure[k]);
+        svp->segment[k].a[2] = 0.0;
+        svp->segment[k].a[3] = 0.0;
+        if (svp->segment[k].a[0] != svp->segment[k].a[0] ||
+            (k > 0 && !(svp->segment[k].z > svp->segment[k - 1].z))) {
+            oceanography_svp_destroy(svp);
+            return NULL;
+        }
+    }
+    fit(svp->segment, n);
+
+    svp->min = svp->segment[0].z;
+    svp->max = svp->segment[n - 1].z;
+    svp->top = svp->segment[0];
+    svp->bottom = svp->segment[n - 1];
+    svp->top.a[1] = 0.0;
+    svp->bottom.a[1] = 0.0;
+    svp->buckets = bucket_count(svp->segment, n);
+    svp->scale = svp->buckets / (svp->max - svp->min);
+
+    /* One more bucket for the depths rounded up to the last one. */
+    svp->bucket = malloc((svp->buckets + 1) * sizeof(*svp->bucket));
+    if (svp->bucket == NULL) {
+        oceanography_svp_destroy(svp);
+        return NULL;
+    }
+
+    /* The first segment of bucket b is the last one starting in a bucket
+     * before b, with the same rounding of the queries. */
+    k = 0;
+    for (b = 0; b <= svp->buckets; b++) {
+        while (k + 2 < n && BUCKET(svp, svp->segment[k + 1].z) < b)
+            k++;
+        svp->bucket[b] = k;
+    }
+
+    return svp;
+}
+
+/* oceanography_svp_destroy -- free a sound velocity profile. */
+
+void oceanography_svp_destroy(struct oceanography_svp *svp)
+{
+    if (svp == NULL)
+        return;
+
+    free(svp->bucket);
+    free(svp->segment);
+    free(svp);
+}
+
+/* oceanography_svp_range -- get the depth of the first and of the last
+ * sample of a profile.
+ *
+ * Units: depth meters.
+ */
+
+void oceanography_svp_range(const struct oceanography_svp *svp, double *min,
+                            double *max)
+{
+    *min = svp->min;
+    *max = svp->max;
+}
+
+/* Segment of depth z and its offset h from the segment start. Above the
+ * first sample and below the last one the segment is flat, with the speed
+ * of the nearest sample. */
+static const struct svp_segment *locate(const struct oceanography_svp *svp,
+                                        double z, double *h)
+{
+    const struct svp_segment *segment;
+
+    if (z < svp->min) {
+        *h = 0.0;
+        return &svp->top;
+    }
+    if (z >= svp->max) {
+        *h = 0.0;
+        return &svp->bottom;
+    }
+
+    segment = svp->segment + svp->bucket[BUCKET(svp, z)];
+    while (z >= segment[1].z)
+        segment++;
+    *h = z - segment->z;
+
+    return segment;
+}
+
+/* oceanography_svp_speed -- interpolate sound speed at depth.
+ *
+ * Units: depth meters, sound speed meters/second.
+ */
+
+double oceanography_svp_speed(const struct oceanography_svp *svp,
+                              double depth)
+{
+    const struct svp_segment *segment;
+    double h;
+
+    if (depth != depth)
+        return depth;
+
+    segment = locate(svp, depth, &h);
+
+    return segment->a[0] + h * (segment->a[1] + h * (segment->a[2] +
+                                                     h * segment->a[3]));
+}
+
+/* oceanography_svp_gradient -- interpolate the vertical gradient of sound
+ * speed at depth, positive when speed increases with depth.
+ *
+ * Units: depth meters, gradient (meters/second)/meter.
+ */
+
+double oceanography_svp_gradient(const struct oceanography_svp *svp,
+                                 double depth)
+{
+    const struct svp_segment *segment;
+    double h;
+
+    if (depth != depth)
+        return depth;
+
+    segment = locate(svp, depth, &h);
+
+    return segment->a[1] + h * (2.0 * segment->a[2] + h * 3.0 *
+                                segment->a[3]);
+}
+
+/* oceanography_svp_eval_n -- interpolate sound speed and its gradient at n
+ * depths.
+ *
+ * speed or gradient can be NULL when not needed.
+ */
+
+void oceanography_svp_eval_n(const struct oceanography_svp *svp,
+                             const double *depth, double *speed,
+                             double *gradient, size_t n)
+{
+    const struct svp_segment *segment;
+    double z, h;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        z = depth[i];
+        if (z != z) {
+            if (speed != NULL)
+                speed[i] = z;
+            if (gradient != NULL)
+                gradient[i] = z;
+            continue;
+        }
+
+        segment = locate(svp, z, &h);
+        if (speed != NULL)
+            speed[i] = segment->a[0] +
+                       h * (segment->a[1] + h * (segment->a[2] +
+                                                 h * segment->a[3]));
+        if (gradient != NULL)
+            gradient[i] = segment->a[1] + h * (2.0 * segment->a[2] +
+                                               h * 3.0 * segment->a[3]);
+    }
+}
@@ -0,0 +1,454 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * table.c -- Approximations of the functions from precomputed tables.
+ *
+ * A (salinity, temperature, pressure) box is split in cells. In every cell
+ * the function is interpolated at the tensor Chebyshev nodes, and the
+ * Chebyshev coefficients are converted to a polynomial in the local
+ * coordinates of the cell, in [0, 1], evaluated with Horner's method.
+ *
+ * The maximum error is measured against the exact functions on a grid
+ * denser than the nodes, covering the edges of every cell.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oceanography.h"
+#include "kernels.h"
+#include "simd.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TABLE_MAGIC "OCNTABLE"
+#define TABLE_VERSION 2
+#define TABLE_BYTE_ORDER 0x01020304UL
+
+/* Points per dimension and per cell used to measure the error. */
+#define CHECK_POINTS(order) (2 * (order) + 1)
+
+/* Elements of a (degree + 1) x (degree + 1) matrix. */
+#define MATRIX ((OCEANOGRAPHY_TABLE_MAX_DEGREE + 1) * \
+                (OCEANOGRAPHY_TABLE_MAX_DEGREE + 1))
+
+struct oceanography_table {
+    struct table_layout layout;
+    double error;
+    double *coefficients;
+};
+
+/* Serialized header: everything but the coefficients. */
+struct table_header {
+    char magic[8];
+    unsigned long byte_order;
+    unsigned long version;
+    unsigned long function;
+    unsigned long degree[3];
+    unsigned long cells[3];
+    double min[3];
+    double max[3];
+    double error;
+};
+
+/* Fill m[k * n + i] with the weight of the value at node i in the
+ * coefficient of T_k, for the n Chebyshev nodes ordered from u = 1 to
+ * u = -1. */
+static void chebyshev_transform(unsigned int n, double *m)
+{
+    unsigned int k, i;
+
+    for (k = 0; k < n; k++)
+        for (i = 0; i < n; i++)
+            m[k * n + i] = (k == 0 ? 1.0 : 2.0) / n *
+                           cos(M_PI * k * (i + 0.5) / n);
+}
+
+/* Fill m[i * n + k] with the coefficient of v^i in T_k(2v - 1), the
+ * Chebyshev polynomial shifted to v = (u + 1) / 2 in [0, 1]. */
+static void chebyshev_powers(unsigned int n, double *m)
+{
+    unsigned int k, i;
+
+    memset(m, 0, n * n * sizeof(double));
+    m[0] = 1.0;
+    if (n > 1) {
+        m[1] = -1.0;
+        m[n + 1] = 2.0;
+    }
+    for (k = 2; k < n; k++)
+        for (i = 0; i <= k; i++)
+            m[i * n + k] = (i > 0 ? 4.0 * m[(i - 1) * n + k - 1] : 0.0) -
+                           2.0 * m[i * n + k - 1] - m[i * n + k - 2];
+}
+
+/* Multiply the tensor in by the n[dim] x n[dim] matrix m along dimension
+ * dim: out[.., i, ..] = sum_k m[i][k] in[.., k, ..]. */
+static void tensor_apply(const unsigned int *n, int dim, const double *m,
+                         const double *in, double *out)
+{
+    size_t step, outer, inner, a, b, base;
+    unsigned int i, k;
+    double sum;
+
+    step = dim == 0 ? 1 : dim == 1 ? n[0] : n[0] * n[1];
+    inner = step;
+    outer = (size_t) n[0] * n[1] * n[2] / (step * n[dim]);
+
+    for (a = 0; a < outer; a++)
+        for (b = 0; b < inner; b++) {
+            base = a * step * n[dim] + b;
+            for (i = 0; i < n[dim]; i++) {
+                sum = 0.0;
+                for (k = 0; k < n[dim]; k++)
+                    sum += m[i * n[dim] + k] * in[base + k * step];
+                out[base + i * step] = sum;
+            }
+        }
+}
+
+static void fit_cell(const struct oceanography_table *table,
+                     const unsigned int *c, double transform[3][MATRIX],
+                     double powers[3][MATRIX], double *work, double *out)
+{
+    const unsigned int *n = table->layout.order;
+    double node[3][OCEANOGRAPHY_TABLE_MAX_DEGREE + 1], width;
+    double *values = work, *tmp = work + table->layout.stride;
+    unsigned int i, j, k;
+    int dim;
+
+    for (dim = 0; dim < 3; dim++) {
+        width = 1.0 / table->layout.scale[dim];
+        for (i = 0; i < n[dim]; i++)
+            node[dim][i] = table->layout.min[dim] + width *
+                (c[dim] + 0.5 * (1.0 + cos(M_PI * (i + 0.5) / n[dim])));
+    }
+
+    for (k = 0; k < n[2]; k++)
+        for (j = 0; j < n[1]; j++)
+            for (i = 0; i < n[0]; i++)
+                values[(k * n[1] + j) * n[0] + i] =
+                    _table_exact(node[0][i], node[1][j], node[2][k]);
+
+    /* Values at the nodes to Chebyshev coefficients, then to powers. */
+    tensor_apply(n, 0, transform[0], values, tmp);
+    tensor_apply(n, 1, transform[1], tmp, values);
+    tensor_apply(n, 2, transform[2], values, tmp);
+    tensor_apply(n, 0, powers[0], tmp, values);
+    tensor_apply(n, 1, powers[1], values, tmp);
+    tensor_apply(n, 2, powers[2], tmp, out);
+}
+
+static double cell_error(const struct oceanography_table *table,
+                         const unsigned int *c)
+{
+    unsigned int m[3], q[3];
+    double x[3], err, max = 0.0;
+    int dim;
+
+    for (dim = 0; dim < 3; dim++)
+        m[dim] = CHECK_POINTS(table->layout.order[dim]);
+
+    for (q[2] = 0; q[2] < m[2]; q[2]++)
+        for (q[1] = 0; q[1] < m[1]; q[1]++)
+            for (q[0] = 0; q[0] < m[0]; q[0]++) {
+                for (dim = 0; dim < 3; dim++) {
+                    x[dim] = table->layout.min[dim] +
+                             (c[dim] + (double) q[dim] / (m[dim] - 1)) /
+                             table->layout.scale[dim];
+                    if (x[dim] > table->layout.max[dim])
+                        x[dim] = table->layout.max[dim];
+                }
+                err = fabs(_table_eval(&table->layout, x[0], x[1], x[2]) -
+                           _table_exact(x[0], x[1], x[2]));
+                if (err > max)
+                    max = err;
+            }
+
+    return max;
+}
+
+/* Number of coefficients of a table, 0 if the table is not valid or too
+ * large. */
+static size_t table_coefficients(enum oceanography_table_function function,
+                                 const unsigned int *degree,
+                                 const unsigned int *cells,
+                                 const double *min, const double *max)
+{
+    size_t count = 1, limit;
+    int dim;
+
+    if (function != OCEANOGRAPHY_TABLE_SVAN)
+        return 0;
+
+    limit = (size_t) -1 / sizeof(double);
+    for (dim = 0; dim < 3; dim++) {
+        if (degree[dim] > OCEANOGRAPHY_TABLE_MAX_DEGREE || cells[dim] == 0 ||
+            !(min[dim] < max[dim]) ||
+            count > limit / ((size_t) cells[dim] * (degree[dim] + 1)))
+            return 0;
+        count *= (size_t) cells[dim] * (degree[dim] + 1);
+    }
+
+    return count;
+}
+
+static struct oceanography_table *table_alloc(
+    enum oceanography_table_function function, const unsigned int *degree,
+    const unsigned int *cells, const double *min, const double *max)
+{
+    struct oceanography_table *table;
+    size_t count;
+    int dim;
+
+    count = table_coefficients(function, degree, cells, min, max);
+    if (count == 0)
+        return NULL;
+
+    table = malloc(sizeof(*table));
+    if (table == NULL)
+        return NULL;
+
+    table->layout.function = function;
+    table->layout.stride = 1;
+    table->error = 0.0;
+    for (dim = 0; dim < 3; dim++) {
+        table->layout.order[dim] = degree[dim] + 1;
+        table->layout.stride *= table->layout.order[dim];
+        table->layout.cells[dim] = cells[dim];
+        table->layout.min[dim] = min[dim];
+        table->layout.max[dim] = max[dim];
+        table->layout.scale[dim] = cells[dim] / (max[dim] - min[dim]);
+    }
+
+    table->coefficients = malloc(count * sizeof(double));
+    if (table->coefficients == NULL) {
+        free(table);
+        return NULL;
+    }
+    table->layout.coefficients = table->coefficients;
+
+    return table;
+}
+
+/* Number of cells of a table. */
+static size_t table_cells(const struct oceanography_table *table)
+{
+    const unsigned int *cells = table->layout.cells;
+
+    return (size_t) cells[0] * cells[1] * cells[2];
+}
+
+/* oceanography_table_create -- build the table of a function over a box.
+ *
+ * The box spans spec->min[i] to spec->max[i] of salinity (i = 0),
+ * temperature (i = 1) and pressure (i = 2), with the same units of the
+ * function. It is split in spec->cells[i] cells along every dimension, each
+ * one holding a polynomial of degree spec->degree[i] in variable i.
+ *
+ * Returns NULL if spec is not valid or memory is not enough.
+ */
+
+struct oceanography_table *oceanography_table_create(
+    const struct oceanography_table_spec *spec)
+{
+    struct oceanography_table *table;
+    double transform[3][MATRIX], powers[3][MATRIX];
+    double *work, *coefficients, err;
+    unsigned int c[3];
+    int dim;
+
+    table = table_alloc(spec->function, spec->degree, spec->cells, spec->min,
+                        spec->max);
+    if (table == NULL)
+        return NULL;
+
+    work = malloc(2 * table->layout.stride * sizeof(double));
+    if (work == NULL) {
+        oceanography_table_destroy(table);
+        return NULL;
+    }
+
+    for (dim = 0; dim < 3; dim++) {
+        chebyshev_transform(table->layout.order[dim], transform[dim]);
+        chebyshev_powers(table->layout.order[dim], powers[dim]);
+    }
+
+    coefficients = table->coefficients;
+    for (c[2] = 0; c[2] < table->layout.cells[2]; c[2]++)
+        for (c[1] = 0; c[1] < table->layout.cells[1]; c[1]++)
+            for (c[0] = 0; c[0] < table->layout.cells[0]; c[0]++) {
+                fit_cell(table, c, transform, powers, work, coefficients);
+                coefficients += table->layout.stride;
+            }
+    free(work);
+
+    for (c[2] = 0; c[2] < table->layout.cells[2]; c[2]++)
+        for (c[1] = 0; c[1] < table->layout.cells[1]; c[1]++)
+            for (c[0] = 0; c[0] < table->layout.cells[0]; c[0]++) {
+                err = cell_error(table, c);
+                if (err > table->error)
+                    table->error = err;
+            }
+
+    return table;
+}
+
+/* oceanography_table_destroy -- free a table. */
+
+void oceanography_table_destroy(struct oceanography_table *table)
+{
+    if (table == NULL)
+        return;
+
+    free(table->coefficients);
+    free(table);
+}
+
+/* oceanography_table_error -- get the maximum absolute error of a table
+ * against the exact function, with the units of the function.
+ */
+
+double oceanography_table_error(const struct oceanography_table *table)
+{
+    return table->error;
+}
+
+/* oceanography_table_eval -- evaluate a table.
+ *
+ * Outside the box of the table the exact function is computed.
+ */
+
+double oceanography_table_eval(const struct oceanography_table *table,
+                               double salinity, double temperature,
+                               double pressure)
+{
+    return _table_eval(&table->layout, salinity, temperature, pressure);
+}
+
+/* oceanography_table_eval_n -- evaluate a table on n samples.
+ *
+ * Consecutive samples in the same cell are evaluated together by the
+ * vectorized kernels.
+ */
+
+void oceanography_table_eval_n(const struct oceanography_table *table,
+                               const double *salinity,
+                               const double *temperature,
+                               const double *pressure, double *out, size_t n)
+{
+    simd_select()->table(&table->layout, salinity, temperature, pressure,
+                         out, n);
+}
+
+/* oceanography_table_serialize -- write a table to buffer.
+ *
+ * Nothing is written if size is less than the size of the serialized table.
+ * The format depends on the byte order and on the size of the types of the
+ * host.
+ *
+ * Returns the size of the serialized table.
+ */
+
+size_t oceanography_table_serialize(const struct oceanography_table *table,
+                                    void *buffer, size_t size)
+{
+    struct table_header header;
+    size_t coefficients, needed;
+    int dim;
+
+    coefficients = table->layout.stride * table_cells(table);
+    needed = sizeof(header) + coefficients * sizeof(double);
+    if (buffer == NULL || size < needed)
+        return needed;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+    header.byte_order = TABLE_BYTE_ORDER;
+    header.version = TABLE_VERSION;
+    header.function = table->layout.function;
+    for (dim = 0; dim < 3; dim++) {
+        header.degree[dim] = table->layout.order[dim] - 1;
+        header.cells[dim] = table->layout.cells[dim];
+        header.min[dim] = table->layout.min[dim];
+        header.max[dim] = table->layout.max[dim];
+    }
+    header.error = table->error;
+
+    memcpy(buffer, &header, sizeof(header));
+    memcpy((char *) buffer + sizeof(header), table->coefficients,
+           coefficients * sizeof(double));
+
+    return needed;
+}
+
+/* oceanography_table_deserialize -- read a table written by
+ * oceanography_table_serialize().
+ *
+ * Returns NULL if buffer does not hold a valid table for this host.
+ */
+
+struct oceanography_table *oceanography_table_deserialize(const void *buffer,
+                                                          size_t size)
+{
+    struct oceanography_table *table;
+    struct table_header header;
+    unsigned int degree[3], cells[3];
+    size_t coefficients;
+    int dim;
+
+    if (size < sizeof(header))
+        return NULL;
+
+    memcpy(&header, buffer, sizeof(header));
+    if (memcmp(header.magic, TABLE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.byte_order != TABLE_BYTE_ORDER ||
+        header.version != TABLE_VERSION ||
+        header.function > OCEANOGRAPHY_TABLE_SVAN)
+        return NULL;
+
+    for (dim = 0; dim < 3; dim++) {
+        if (header.degree[dim] > OCEANOGRAPHY_TABLE_MAX_DEGREE ||
+            header.cells[dim] > (unsigned int) -1)
+            return NULL;
+        degree[dim] = (unsigned int) header.degree[dim];
+        cells[dim] = (unsigned int) header.cells[dim];
+    }
+
+    coefficients = table_coefficients(
+        (enum oceanography_table_function) header.function, degree, cells,
+        header.min, header.max);
+    if (coefficients == 0 ||
+        (size - sizeof(header)) / sizeof(double) < coefficients)
+        return NULL;
+
+    table = table_alloc((enum oceanography_table_function) header.function,
+                        degree, cells, header.min, header.max);
+    if (table == NULL)
+        return NULL;
+
+    memcpy(table->coefficients, (const char *) buffer + sizeof(header),
+           coefficients * sizeof(double));
+    table->error = header.error;
+
+    return table;
+}
@@ -0,0 +1,599 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_batch.c -- Unit tests for the batch functions of liboceanography.
+ *
+ * The check values are the same of test_oceanography.c.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+#define EPSILON 0.00001
+
+/* Samples of the grid used to compare batch and scalar results. */
+#define GRID 343
+
+
+static int cmp_double(double x, double y)
+{
+    return fabs(x - y) < EPSILON;
+}
+
+/* Fill s, t and p with a 7x7x7 grid covering the UNESCO range. */
+static void fill_grid(double *s, double *t, double *p)
+{
+    int i, j, k, n = 0;
+
+    for (i = 0; i < 7; i++)
+        for (j = 0; j < 7; j++)
+            for (k = 0; k < 7; k++) {
+                s[n] = i * 7.0;
+                t[n] = j * 6.5 - 2.0;
+                p[n] = k * 1666.0;
+                n++;
+            }
+}
+
+
+START_TEST(test_salinity_n)
+{
+    double c[] = {1, 1.2, 0.65, 1.888091, 5e-5};
+    double t[] = {15, 20, 5, 40, 15};
+    double p[] = {0, 2000, 1500, 10000, 0};
+    double out[5];
+
+    salinity_n(c, t, p, out, 5);
+
+    ck_assert(cmp_double(out[0], 35.0));
+    ck_assert(cmp_double(out[1], 37.245628));
+    ck_assert(cmp_double(out[2], 27.995347));
+    ck_assert(cmp_double(out[3], 40.0));
+    ck_assert(cmp_double(out[4], 0.0));
+}
+END_TEST
+
+START_TEST(test_conductivity_n)
+{
+    double s[] = {35.0, 37.245628, 27.995347, 40.0, 0.02};
+    double t[] = {15, 20, 5, 40, 15};
+    double p[] = {0, 2000, 1500, 10000, 0};
+    double out[5];
+
+    conductivity_n(s, t, p, out, 5);
+
+    ck_assert(cmp_double(out[0], 1.0));
+    ck_assert(cmp_double(out[1], 1.2));
+    ck_assert(cmp_double(out[2], 0.65));
+    ck_assert(cmp_double(out[3], 1.888091));
+    ck_assert(cmp_double(out[4], 0.0));
+}
+END_TEST
+
+START_TEST(test_conductivity_histogram_n)
+{
+    double s[GRID], t[GRID], p[GRID], out[GRID];
+    unsigned long histogram[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+    unsigned long total = 0;
+    int i;
+
+    fill_grid(s, t, p);
+    for (i = 0; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+        histogram[i] = 0;
+
+    conductivity_histogram_n(s, t, p, out, histogram, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == conductivity(s[i], t[i], p[i]));
+        ck_assert(fabs(salinity(out[i], t[i], p[i]) - s[i]) <= 1.0e-4);
+    }
+
+    /* The 49 samples with salinity 0 need no iterations, the others
+     * converge in one or two. */
+    ck_assert(histogram[0] == 49);
+    for (i = 0; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+        total += histogram[i];
+    ck_assert(total == GRID);
+    ck_assert(histogram[1] + histogram[2] == GRID - 49);
+    ck_assert(histogram[1] > histogram[2]);
+
+    /* The histogram is accumulated. */
+    conductivity_histogram_n(s, t, p, out, histogram, 1);
+    ck_assert(histogram[0] == 50);
+}
+END_TEST
+
+START_TEST(test_specific_volume_anomaly_n)
+{
+    double s[] = {0, 0, 40, 40};
+    double t[] = {0, 0, 0, 40};
+    double p[] = {0, 1000, 0, 10000};
+    double out[4], sigma[4];
+
+    specific_volume_anomaly_n(s, t, p, out, sigma, 4);
+
+    ck_assert(cmp_double(out[0], 2749.539368));
+    ck_assert(cmp_double(sigma[0], -0.1574));
+    ck_assert(cmp_double(out[1], 2692.644915));
+    ck_assert(cmp_double(sigma[1], 4.872729));
+    ck_assert(cmp_double(out[2], -380.789102));
+    ck_assert(cmp_double(sigma[2], 32.147101));
+    ck_assert(cmp_double(out[3], 981.301907));
+    ck_assert(cmp_double(sigma[3], 59.820375));
+
+    /* sigma is optional. */
+    svan_n(s, t, p, out, NULL, 4);
+    ck_assert(cmp_double(out[0], 2749.539368));
+    ck_assert(cmp_double(out[3], 981.301907));
+}
+END_TEST
+
+START_TEST(test_depth_n)
+{
+    double p[] = {500, 10000, 10000};
+    double lat[] = {0, 30, 90};
+    double out[3];
+
+    depth_n(p, lat, out, 3);
+
+    ck_assert(cmp_double(out[0], 496.652992));
+    ck_assert(cmp_double(out[1], 9712.653072));
+    ck_assert(cmp_double(out[2], 9674.231441));
+}
+END_TEST
+
+START_TEST(test_freezing_point_n)
+{
+    double s[] = {5, 20, 40};
+    double p[] = {0, 300, 500};
+    double out[3];
+
+    freezing_point_n(s, p, out, 3);
+
+    ck_assert(cmp_double(out[0], -0.273763));
+    ck_assert(cmp_double(out[1], -1.309106));
+    ck_assert(cmp_double(out[2], -2.588567));
+}
+END_TEST
+
+START_TEST(test_specific_heat_n)
+{
+    double s[] = {25, 35, 40};
+    double t[] = {0, 20, 40};
+    double p[] = {0, 5000, 10000};
+    double out[3];
+
+    specific_heat_n(s, t, p, out, 3);
+
+    ck_assert(cmp_double(out[0], 4048.440412));
+    ck_assert(cmp_double(out[1], 3894.992770));
+    ck_assert(cmp_double(out[2], 3849.499481));
+
+    cpsw_n(s, t, p, out, 1);
+    ck_assert(cmp_double(out[0], 4048.440412));
+}
+END_TEST
+
+START_TEST(test_adiabatic_temperature_gradient_n)
+{
+    double s[] = {25, 30, 40};
+    double t[] = {0, 20, 40};
+    double p[] = {0, 9000, 10000};
+    double out[3];
+
+    adiabatic_temperature_gradient_n(s, t, p, out, 3);
+
+    ck_assert(cmp_double(out[0], 1.687100e-05));
+    ck_assert(cmp_double(out[1], 2.416120e-04));
+    ck_assert(cmp_double(out[2], 3.255976e-04));
+
+    atg_n(s, t, p, out, 1);
+    ck_assert(cmp_double(out[0], 1.687100e-05));
+}
+END_TEST
+
+START_TEST(test_potential_temperature_n)
+{
+    double s[] = {25, 25, 30, 40};
+    double t[] = {0, 40, 20, 40};
+    double p[] = {0, 0, 9000, 10000};
+    double pr[] = {0, 0, 0, 0};
+    double out[4];
+
+    potential_temperature_n(s, t, p, pr, out, 4);
+
+    ck_assert(cmp_double(out[0], 0));
+    ck_assert(cmp_double(out[1], 40.000000));
+    ck_assert(cmp_double(out[2], 18.296537));
+    ck_assert(cmp_double(out[3], 36.998992));
+
+    theta_n(s, t, p, pr, out, 1);
+    ck_assert(cmp_double(out[0], 0));
+}
+END_TEST
+
+START_TEST(test_potential_temperature_multi_n)
+{
+    double s[GRID], t[GRID], p[GRID], th[4][GRID];
+    double pr[] = {0, 1000, 2000, 4000};
+    double *out[4];
+    int i, r;
+
+    fill_grid(s, t, p);
+    for (r = 0; r < 4; r++)
+        out[r] = th[r];
+
+    potential_temperature_multi_n(s, t, p, pr, 4, out, GRID);
+    for (r = 0; r < 4; r++)
+        for (i = 0; i < GRID; i++)
+            ck_assert(th[r][i] == theta(s[i], t[i], p[i], pr[r]));
+
+    ck_assert(cmp_double(th[0][GRID - 1], theta(42.0, 37.0, 9996.0, 0)));
+}
+END_TEST
+
+START_TEST(test_potential_density_multi_n)
+{
+    double s[GRID], t[GRID], p[GRID], sigma[GRID], rho[4][GRID];
+    double pr[] = {0, 1000, 2000, 4000};
+    double *out[4];
+    int i, r;
+
+    fill_grid(s, t, p);
+    for (r = 0; r < 4; r++)
+        out[r] = rho[r];
+
+    potential_density_multi_n(s, t, p, pr, 4, sigma, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(sigma[i] == density(s[i], t[i], p[i]));
+    for (r = 0; r < 4; r++)
+        for (i = 0; i < GRID; i++)
+            ck_assert(rho[r][i] == potential_density(s[i], t[i], p[i],
+                                                     pr[r]));
+
+    potential_density_multi_n(s, t, p, pr, 2, NULL, out + 2, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(rho[2][i] == rho[0][i] && rho[3][i] == rho[1][i]);
+}
+END_TEST
+
+START_TEST(test_in_situ_temperature_n)
+{
+    double s[GRID], t[GRID], p[GRID], th[GRID], pr[GRID], out[GRID];
+    int i;
+
+    fill_grid(s, t, p);
+    for (i = 0; i < GRID; i++) {
+        pr[i] = (i % 3) * 2000.0;
+        th[i] = theta(s[i], t[i], p[i], pr[i]);
+    }
+
+    in_situ_temperature_n(s, th, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == in_situ_temperature(s[i], th[i], p[i], pr[i]));
+        ck_assert(fabs(out[i] - t[i]) < 1.0e-12);
+    }
+
+    in_situ_temperature_strided(s, 1, th, 1, p, 1, pr, 0, out, 1, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == in_situ_temperature(s[i], th[i], p[i], pr[0]));
+}
+END_TEST
+
+START_TEST(test_sound_speed_n)
+{
+    double s[] = {25, 35, 40};
+    double t[] = {0, 20, 40};
+    double p[] = {0, 5000, 10000};
+    double out[3];
+
+    sound_speed_n(s, t, p, out, 3);
+
+    ck_assert(cmp_double(out[0], 1435.789875));
+    ck_assert(cmp_double(out[1], 1604.476282));
+    ck_assert(cmp_double(out[2], 1731.995394));
+}
+END_TEST
+
+START_TEST(test_bitwise_scalar)
+{
+    double s[GRID], t[GRID], p[GRID], c[GRID], lat[GRID], pr[GRID];
+    double out[GRID], sigma[GRID], sig;
+    double alpha[GRID], beta[GRID], kappa[GRID], a, b, k;
+    int i;
+
+    fill_grid(s, t, p);
+    for (i = 0; i < GRID; i++) {
+        c[i] = s[i] / 35.0;
+        lat[i] = t[i] * 2.0;
+        pr[i] = p[i] / 2.0;
+    }
+
+    salinity_n(c, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == salinity(c[i], t[i], p[i]));
+
+    conductivity_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == conductivity(s[i], t[i], p[i]));
+
+    specific_volume_anomaly_n(s, t, p, out, sigma, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == specific_volume_anomaly(s[i], t[i], p[i], &sig));
+        ck_assert(sigma[i] == sig);
+    }
+
+    depth_n(p, lat, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == depth(p[i], lat[i]));
+
+    pressure_from_depth_n(p, lat, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == pressure_from_depth(p[i], lat[i]));
+
+    /* sigma holds density anomalies, c sound speeds. */
+    density_n(s, t, p, sigma, GRID);
+    salinity_from_density_n(sigma, t, p, out, alpha, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == salinity_from_density(sigma[i], t[i], p[i], &a));
+        ck_assert(alpha[i] == a);
+    }
+
+    sound_speed_n(s, t, p, c, GRID);
+    temperature_from_sound_speed_n(c, s, p, out, alpha, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == temperature_from_sound_speed(c[i], s[i], p[i],
+                                                         &a));
+        ck_assert(alpha[i] == a);
+    }
+    temperature_from_sound_speed_n(c, s, p, out, NULL, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == temperature_from_sound_speed(c[i], s[i], p[i],
+                                                         NULL));
+    for (i = 0; i < GRID; i++)
+        c[i] = s[i] / 35.0;
+
+    freezing_point_n(s, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == freezing_point(s[i], p[i]));
+
+    specific_heat_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == specific_heat(s[i], t[i], p[i]));
+
+    adiabatic_temperature_gradient_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == adiabatic_temperature_gradient(s[i], t[i], p[i]));
+
+    potential_temperature_n(s, t, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == potential_temperature(s[i], t[i], p[i], pr[i]));
+
+    sound_speed_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == sound_speed(s[i], t[i], p[i]));
+
+    density_derivatives_n(s, t, p, out, alpha, beta, kappa, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == density_derivatives(s[i], t[i], p[i], &a, &b,
+                                                &k));
+        ck_assert(alpha[i] == a && beta[i] == b && kappa[i] == k);
+    }
+    density_derivatives_n(s, t, p, NULL, NULL, sigma, NULL, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(sigma[i] == beta[i]);
+
+    density_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == density(s[i], t[i], p[i]));
+
+    potential_density_n(s, t, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == potential_density(s[i], t[i], p[i], pr[i]));
+}
+END_TEST
+
+START_TEST(test_ctd_derive_n)
+{
+    double s[GRID], t[GRID], p[GRID], c[GRID];
+    double sal[GRID], sva[GRID], sigma[GRID], th[GRID], ss[GRID], z[GRID];
+    double cp[GRID], fp[GRID], gradient[GRID], sig;
+    struct ctd_outputs out;
+    int i;
+
+    fill_grid(s, t, p);
+    for (i = 0; i < GRID; i++)
+        c[i] = conductivity(s[i], t[i], p[i]);
+
+    out.salinity = sal;
+    out.svan = sva;
+    out.sigma = sigma;
+    out.theta = th;
+    out.sound_speed = ss;
+    out.depth = z;
+    out.cpsw = cp;
+    out.freezing_point = fp;
+    out.atg = gradient;
+
+    ctd_derive_n(c, t, p, 45.0, 1000.0,
+                 OCEANOGRAPHY_CTD_SALINITY | OCEANOGRAPHY_CTD_SVAN |
+                 OCEANOGRAPHY_CTD_SIGMA | OCEANOGRAPHY_CTD_THETA |
+                 OCEANOGRAPHY_CTD_SOUND_SPEED | OCEANOGRAPHY_CTD_DEPTH |
+                 OCEANOGRAPHY_CTD_CPSW | OCEANOGRAPHY_CTD_FREEZING_POINT |
+                 OCEANOGRAPHY_CTD_ATG, &out, GRID);
+
+    for (i = 0; i < GRID; i++) {
+        double si = salinity(c[i], t[i], p[i]);
+
+        ck_assert(sal[i] == si);
+        ck_assert(sva[i] == svan(si, t[i], p[i], &sig));
+        ck_assert(sigma[i] == sig);
+        ck_assert(th[i] == theta(si, t[i], p[i], 1000.0));
+        ck_assert(ss[i] == sound_speed(si, t[i], p[i]));
+        ck_assert(z[i] == depth(p[i], 45.0));
+        ck_assert(cp[i] == cpsw(si, t[i], p[i]));
+        ck_assert(fp[i] == freezing_point(si, p[i]));
+        ck_assert(gradient[i] == atg(si, t[i], p[i]));
+    }
+
+    /* Only the selected outputs are used. */
+    out.salinity = out.svan = out.theta = out.depth = out.cpsw = NULL;
+    out.freezing_point = out.atg = NULL;
+    for (i = 0; i < GRID; i++)
+        sigma[i] = ss[i] = 0.0;
+
+    ctd_derive_n(c, t, p, 45.0, 0.0,
+                 OCEANOGRAPHY_CTD_SIGMA | OCEANOGRAPHY_CTD_SOUND_SPEED, &out,
+                 GRID);
+    for (i = 0; i < GRID; i++) {
+        double si = salinity(c[i], t[i], p[i]);
+
+        svan(si, t[i], p[i], &sig);
+        ck_assert(sigma[i] == sig);
+        ck_assert(ss[i] == sound_speed(si, t[i], p[i]));
+    }
+
+    /* Depth does not need conductivity. */
+    out.sigma = out.sound_speed = NULL;
+    out.depth = z;
+    ctd_derive_n(NULL, t, p, -30.0, 0.0, OCEANOGRAPHY_CTD_DEPTH, &out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(z[i] == depth(p[i], -30.0));
+}
+END_TEST
+
+START_TEST(test_strided)
+{
+    /* Interleaved CTD records: conductivity, temperature, pressure. */
+    double records[] = {1, 15, 0,
+                        1.2, 20, 2000,
+                        0.65, 5, 1500,
+                        1.888091, 40, 10000};
+    double out[8], sigma[8], s[4], zero = 0.0;
+    int i;
+
+    salinity_strided(&records[0], 3, &records[1], 3, &records[2], 3,
+                     out, 2, 4);
+    ck_assert(cmp_double(out[0], 35.0));
+    ck_assert(cmp_double(out[2], 37.245628));
+    ck_assert(cmp_double(out[4], 27.995347));
+    ck_assert(cmp_double(out[6], 40.0));
+
+    for (i = 0; i < 4; i++)
+        s[i] = out[2 * i];
+
+    conductivity_strided(s, 1, &records[1], 3, &records[2], 3, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(cmp_double(out[i], records[3 * i]));
+
+    /* A stride of 0 broadcasts the same value. */
+    specific_volume_anomaly_strided(s, 1, &records[1], 3, &zero, 0,
+                                    out, 1, sigma, 2, 4);
+    for (i = 0; i < 4; i++) {
+        double sig;
+        ck_assert(out[i] == svan(s[i], records[3 * i + 1], 0, &sig));
+        ck_assert(sigma[2 * i] == sig);
+    }
+
+    depth_strided(&records[2], 3, &zero, 0, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == depth(records[3 * i + 2], 0));
+
+    pressure_from_depth_strided(&records[2], 3, &zero, 0, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == pressure_from_depth(records[3 * i + 2], 0));
+
+    freezing_point_strided(s, 1, &records[2], 3, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == freezing_point(s[i], records[3 * i + 2]));
+
+    specific_heat_strided(s, 1, &records[1], 3, &records[2], 3, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == specific_heat(s[i], records[3 * i + 1],
+                                          records[3 * i + 2]));
+
+    adiabatic_temperature_gradient_strided(s, 1, &records[1], 3,
+                                           &records[2], 3, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == atg(s[i], records[3 * i + 1],
+                                records[3 * i + 2]));
+
+    potential_temperature_strided(s, 1, &records[1], 3, &records[2], 3,
+                                  &zero, 0, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == theta(s[i], records[3 * i + 1],
+                                  records[3 * i + 2], 0));
+
+    sound_speed_strided(s, 1, &records[1], 3, &records[2], 3, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == sound_speed(s[i], records[3 * i + 1],
+                                        records[3 * i + 2]));
+
+    density_strided(s, 1, &records[1], 3, &records[2], 3, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == density(s[i], records[3 * i + 1],
+                                    records[3 * i + 2]));
+
+    potential_density_strided(s, 1, &records[1], 3, &records[2], 3,
+                              &zero, 0, out, 1, 4);
+    for (i = 0; i < 4; i++)
+        ck_assert(out[i] == potential_density(s[i], records[3 * i + 1],
+                                              records[3 * i + 2], 0));
+}
+END_TEST
+
+
+Suite *batch_suite(void)
+{
+    Suite *s = suite_create("Batch");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_salinity_n);
+    tcase_add_test(tc_core, test_conductivity_n);
+    tcase_add_test(tc_core, test_conductivity_histogram_n);
+    tcase_add_test(tc_core, test_specific_volume_anomaly_n);
+    tcase_add_test(tc_core, test_depth_n);
+    tcase_add_test(tc_core, test_freezing_point_n);
+    tcase_add_test(tc_core, test_specific_heat_n);
+    tcase_add_test(tc_core, test_adiabatic_temperature_gradient_n);
+    tcase_add_test(tc_core, test_potential_temperature_n);
+    tcase_add_test(tc_core, test_potential_temperature_multi_n);
+    tcase_add_test(tc_core, test_potential_density_multi_n);
+    tcase_add_test(tc_core, test_in_situ_temperature_n);
+    tcase_add_test(tc_core, test_sound_speed_n);
+    tcase_add_test(tc_core, test_bitwise_scalar);
+    tcase_add_test(tc_core, test_ctd_derive_n);
+    tcase_add_test(tc_core, test_strided);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = batch_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_collection.c -- Unit tests for the collections of profiles.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* Profiles of 0 to more than a block of samples, several chunks of the
+ * thread pool in all. */
+#define PROFILES 40
+#define SAMPLES 20000
+
+#define ALL_OUTPUTS 0x1ff
+
+static size_t offset[PROFILES + 1];
+static double s[SAMPLES], t[SAMPLES], p[SAMPLES], lat[PROFILES];
+static struct oceanography_collection collection;
+
+static void setup(void)
+{
+    size_t i, j, k, n;
+    double thermocline;
+
+    /* Mixed layer at 20 degrees Celsius down to about the thermocline,
+     * then 8 degrees Celsius colder; the last profile is empty. */
+    i = 0;
+    for (k = 0; k < PROFILES; k++) {
+        offset[k] = i;
+        lat[k] = -80.0 + 4.0 * k;
+        n = k == 0 ? 0 : k == 1 ? 1 : k == PROFILES - 1 ? 0 : 100 + k * 17;
+        thermocline = 50.0 + 10.0 * (k % 9);
+        for (j = 0; j < n; j++, i++) {
+            p[i] = 1.0 + 2.0 * j;
+            t[i] = 12.0 - 8.0 * tanh((p[i] - thermocline) / 20.0);
+            s[i] = 35.0 + 0.001 * (k % 5);
+        }
+    }
+    offset[PROFILES] = i;
+
+    collection.profiles = PROFILES;
+    collection.offset = offset;
+    collection.salinity = s;
+    collection.temperature = t;
+    collection.pressure = p;
+    collection.latitude = lat;
+}
+
+START_TEST(test_derive)
+{
+    static double out[9][SAMPLES], expected[9][SAMPLES], l[SAMPLES];
+    struct oceanography_pool *pool;
+    struct ctd_outputs ctd;
+    double reference[SAMPLES];
+    size_t i, k, n;
+    unsigned int threads;
+
+    n = offset[PROFILES];
+    for (k = 0; k < PROFILES; k++)
+        for (i = offset[k]; i < offset[k + 1]; i++)
+            l[i] = lat[k];
+    for (i = 0; i < n; i++)
+        reference[i] = 1000.0;
+
+    specific_volume_anomaly_n(s, t, p, expected[1], expected[2], n);
+    potential_temperature_n(s, t, p, reference, expected[3], n);
+    sound_speed_n(s, t, p, expected[4], n);
+    depth_n(p, l, expected[5], n);
+    specific_heat_n(s, t, p, expected[6], n);
+    freezing_point_n(s, p, expected[7], n);
+    adiabatic_temperature_gradient_n(s, t, p, expected[8], n);
+
+    ctd.salinity = out[0];
+    ctd.svan = out[1];
+    ctd.sigma = out[2];
+    ctd.theta = out[3];
+    ctd.sound_speed = out[4];
+    ctd.depth = out[5];
+    ctd.cpsw = out[6];
+    ctd.freezing_point = out[7];
+    ctd.atg = out[8];
+
+    for (threads = 1; threads <= 3; threads += 2) {
+        pool = oceanography_pool_create(threads);
+        ck_assert(pool != NULL);
+        oceanography_collection_derive(pool, &collection, 1000.0,
+                                       ALL_OUTPUTS, &ctd);
+        for (i = 0; i < n; i++) {
+            ck_assert(out[0][i] == s[i]);
+            for (k = 1; k < 9; k++)
+                ck_assert(out[k][i] == expected[k][i]);
+        }
+        oceanography_pool_destroy(pool);
+    }
+
+    /* Only sigma, svan is not written. */
+    out[1][0] = -1.0;
+    out[2][0] = 0.0;
+    oceanography_collection_derive(NULL, &collection, 0.0,
+                                   OCEANOGRAPHY_CTD_SIGMA, &ctd);
+    ck_assert(out[1][0] == -1.0 && out[2][0] == expected[2][0]);
+}
+END_TEST
+
+START_TEST(test_metrics)
+{
+    struct oceanography_profile_metrics metrics[PROFILES];
+    struct oceanography_profile_metrics *m;
+    double sigma, target, previous, z, previous_z, gradient;
+    size_t i, k, last, thermocline;
+
+    oceanography_collection_metrics(NULL, &collection, 0.03, 10.0, metrics);
+
+    for (k = 0; k < PROFILES; k++) {
+        m = &metrics[k];
+        ck_assert(m->samples == offset[k + 1] - offset[k]);
+        if (m->samples == 0) {
+            ck_assert(m->mixed_layer_depth == 0.0 &&
+                      m->bottom_depth == 0.0 && m->surface_sigma == 0.0);
+            continue;
+        }
+
+        i = offset[k];
+        last = offset[k + 1] - 1;
+        ck_assert(m->surface_salinity == s[i]);
+        ck_assert(m->surface_temperature == t[i]);
+        ck_assert(m->surface_pressure == p[i]);
+        ck_assert(m->surface_sigma == potential_density(s[i], t[i], p[i],
+                                                        0.0));
+        ck_assert(m->bottom_salinity == s[last]);
+        ck_assert(m->bottom_temperature == t[last]);
+        ck_assert(m->bottom_pressure == p[last]);
+        ck_assert(m->bottom_sigma == potential_density(s[last], t[last],
+                                                       p[last], 0.0));
+        ck_assert(m->bottom_depth == depth(p[last], lat[k]));
+
+        if (m->samples == 1) {
+            /* Shallower than the reference pressure. */
+            ck_assert(m->mixed_layer_depth == m->bottom_depth);
+            ck_assert(m->thermocline_depth == m->bottom_depth);
+            ck_assert(m->thermocline_gradient == 0.0);
+            continue;
+        }
+
+        /* Reference at 11 decibars, the sixth sample. */
+        previous = potential_density(s[i + 5], t[i + 5], p[i + 5], 0.0);
+        target = previous + 0.03;
+        sigma = previous;
+        for (i = offset[k] + 6; i <= last; i++) {
+            sigma = potential_density(s[i], t[i], p[i], 0.0);
+            if (sigma >= target)
+                break;
+            previous = sigma;
+        }
+        ck_assert(i <= last);
+        z = depth(p[i], lat[k]);
+        previous_z = depth(p[i - 1], lat[k]);
+        ck_assert(fabs(m->mixed_layer_depth -
+                       (previous_z + (target - previous) / (sigma - previous) *
+                        (z - previous_z))) < 1.0e-9);
+
+        /* The steepest pair of samples. */
+        thermocline = offset[k] + 1;
+        for (i = offset[k] + 1; i <= last; i++)
+            if (t[i - 1] - t[i] > t[thermocline - 1] - t[thermocline])
+                thermocline = i;
+        z = depth(p[thermocline], lat[k]);
+        previous_z = depth(p[thermocline - 1], lat[k]);
+        gradient = (t[thermocline - 1] - t[thermocline]) / (z - previous_z);
+        ck_assert(fabs(m->thermocline_depth - 0.5 * (z + previous_z)) <
+                  1.0e-9);
+        ck_assert(fabs(m->thermocline_gradient - gradient) <
+                  1.0e-6 * gradient);
+        ck_assert(m->mixed_layer_depth < m->thermocline_depth);
+    }
+}
+END_TEST
+
+START_TEST(test_regrid)
+{
+    static double out[2][PROFILES * 50], expected[2][50];
+    const double *in[2];
+    double *levels[2], *profile[2];
+    double z[50];
+    struct oceanography_pool *pool;
+    size_t k, l;
+
+    for (l = 0; l < 50; l++)
+        z[l] = 20.0 * l;
+    in[0] = t;
+    in[1] = s;
+    levels[0] = out[0];
+    levels[1] = out[1];
+    profile[0] = expected[0];
+    profile[1] = expected[1];
+
+    pool = oceanography_pool_create(3);
+    ck_assert(pool != NULL);
+    oceanography_collection_regrid(pool, &collection, in, 2, z, 50, -99.0,
+                                   levels);
+    oceanography_pool_destroy(pool);
+
+    /* Every profile as regrid_n() at its latitude. */
+    for (k = 0; k < PROFILES; k++) {
+        in[0] = t + offset[k];
+        in[1] = s + offset[k];
+        regrid_n(p + offset[k], lat[k], in, 2, offset[k + 1] - offset[k], z,
+                 50, -99.0, profile);
+        in[0] = t;
+        in[1] = s;
+        for (l = 0; l < 50; l++) {
+            ck_assert(out[0][k * 50 + l] == expected[0][l]);
+            ck_assert(out[1][k * 50 + l] == expected[1][l]);
+        }
+    }
+
+    /* The surface is above the first sample of profile 10, 500 meters
+     * within it; the last profile is empty. */
+    ck_assert(out[0][10 * 50] == -99.0);
+    ck_assert(out[0][10 * 50 + 25] >= 4.0 && out[0][10 * 50 + 25] < 12.0);
+    ck_assert(out[0][(PROFILES - 1) * 50 + 25] == -99.0);
+}
+END_TEST
+
+START_TEST(test_threads)
+{
+    static struct oceanography_profile_metrics metrics[3][PROFILES];
+    struct oceanography_collection part;
+    struct oceanography_pool *pool;
+    size_t k;
+
+    pool = oceanography_pool_create(4);
+    ck_assert(pool != NULL);
+    oceanography_collection_metrics(NULL, &collection, 0.03, 10.0,
+                                    metrics[0]);
+    oceanography_collection_metrics(pool, &collection, 0.03, 10.0,
+                                    metrics[1]);
+    oceanography_pool_destroy(pool);
+
+    /* Profiles 5 to 9 on their own. */
+    part = collection;
+    part.profiles = 5;
+    part.offset = offset + 5;
+    part.latitude = lat + 5;
+    oceanography_collection_metrics(NULL, &part, 0.03, 10.0, metrics[2]);
+
+    for (k = 0; k < PROFILES; k++) {
+        ck_assert(metrics[1][k].mixed_layer_depth ==
+                  metrics[0][k].mixed_layer_depth);
+        ck_assert(metrics[1][k].thermocline_depth ==
+                  metrics[0][k].thermocline_depth);
+        ck_assert(metrics[1][k].bottom_sigma == metrics[0][k].bottom_sigma);
+    }
+    for (k = 0; k < 5; k++) {
+        ck_assert(metrics[2][k].samples == metrics[0][k + 5].samples);
+        ck_assert(metrics[2][k].mixed_layer_depth ==
+                  metrics[0][k + 5].mixed_layer_depth);
+    }
+
+    /* A collection of empty profiles. */
+    part.profiles = 1;
+    part.offset = offset;
+    oceanography_collection_metrics(NULL, &part, 0.03, 10.0, metrics[2]);
+    ck_assert(metrics[2][0].samples == 0);
+}
+END_TEST
+
+
+Suite *collection_suite(void)
+{
+    Suite *s = suite_create("Collection");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, test_derive);
+    tcase_add_test(tc_core, test_metrics);
+    tcase_add_test(tc_core, test_regrid);
+    tcase_add_test(tc_core, test_threads);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = collection_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_cxx.cpp -- Unit tests for the C++ interface of liboceanography.
+ *
+ * The templates must give the results of the C functions bit for bit, on
+ * double, on float and on a vector type.
+ */
+
+#include <cmath>
+#include <cstdlib>
+
+#include <check.h>
+
+#include "oceanography.hpp"
+
+/* Grid over the range of the UNESCO formulas, with some samples out of it. */
+#define GRID 347
+
+static double s[GRID], t[GRID], p[GRID], pr[GRID], c[GRID], lat[GRID];
+
+static void setup(void)
+{
+    int i;
+
+    for (i = 0; i < GRID; i++) {
+        s[i] = (i % 45) * 1.0 - 1.0 + i * 1.0e-3;
+        t[i] = (i % 43) - 2.0 + i * 1.0e-3;
+        p[i] = (i % 53) * 200.0;
+        pr[i] = (i % 3) * 1000.0;
+        c[i] = (i % 29) * 0.05;
+        lat[i] = (i % 181) - 90.0;
+    }
+}
+
+/* Bitwise equality, so that NaN equals NaN. */
+static bool same(double a, double b)
+{
+    return a == b || (a != a && b != b);
+}
+
+static bool same_f(float a, float b)
+{
+    return a == b || (a != a && b != b);
+}
+
+START_TEST(test_double)
+{
+    double sigma, sigma_cxx;
+    int i;
+
+    for (i = 0; i < GRID; i++) {
+        ck_assert(same(oceanography::salinity(c[i], t[i], p[i]),
+                       salinity(c[i], t[i], p[i])));
+        ck_assert(same(oceanography::conductivity(s[i], t[i], p[i]),
+                       conductivity(s[i], t[i], p[i])));
+        ck_assert(same(oceanography::specific_volume_anomaly(s[i], t[i], p[i],
+                                                             &sigma_cxx),
+                       specific_volume_anomaly(s[i], t[i], p[i], &sigma)));
+        ck_assert(same(sigma_cxx, sigma));
+        ck_assert(same(oceanography::depth(p[i], lat[i]),
+                       depth(p[i], lat[i])));
+        ck_assert(same(oceanography::freezing_point(s[i], p[i]),
+                       freezing_point(s[i], p[i])));
+        ck_assert(same(oceanography::specific_heat(s[i], t[i], p[i]),
+                       specific_heat(s[i], t[i], p[i])));
+        ck_assert(same(oceanography::adiabatic_temperature_gradient(s[i], t[i],
+                                                                    p[i]),
+                       adiabatic_temperature_gradient(s[i], t[i], p[i])));
+        ck_assert(same(oceanography::potential_temperature(s[i], t[i], p[i],
+                                                           pr[i]),
+                       potential_temperature(s[i], t[i], p[i], pr[i])));
+        ck_assert(same(oceanography::in_situ_temperature(s[i], t[i], p[i],
+                                                         pr[i]),
+                       in_situ_temperature(s[i], t[i], p[i], pr[i])));
+        ck_assert(same(oceanography::sound_speed(s[i], t[i], p[i]),
+                       sound_speed(s[i], t[i], p[i])));
+    }
+}
+END_TEST
+
+START_TEST(test_float)
+{
+    float sf, tf, pf, prf, cf, latf, sigma, sigma_cxx;
+    int i;
+
+    for (i = 0; i < GRID; i++) {
+        sf = (float) s[i];
+        tf = (float) t[i];
+        pf = (float) p[i];
+        prf = (float) pr[i];
+        cf = (float) c[i];
+        latf = (float) lat[i];
+        ck_assert(same_f(oceanography::salinity(cf, tf, pf),
+                         salinity_f(cf, tf, pf)));
+        ck_assert(same_f(oceanography::conductivity(sf, tf, pf),
+                         conductivity_f(sf, tf, pf)));
+        ck_assert(same_f(oceanography::specific_volume_anomaly(sf, tf, pf,
+                                                               &sigma_cxx),
+                         specific_volume_anomaly_f(sf, tf, pf, &sigma)));
+        ck_assert(same_f(sigma_cxx, sigma));
+        ck_assert(same_f(oceanography::depth(pf, (double) latf),
+                         depth_f(pf, latf)));
+        ck_assert(same_f(oceanography::freezing_point(sf, pf),
+                         freezing_point_f(sf, pf)));
+        ck_assert(same_f(oceanography::specific_heat(sf, tf, pf),
+                         specific_heat_f(sf, tf, pf)));
+        ck_assert(same_f(oceanography::adiabatic_temperature_gradient(sf, tf,
+                                                                      pf),
+                         adiabatic_temperature_gradient_f(sf, tf, pf)));
+        ck_assert(same_f(oceanography::potential_temperature(sf, tf, pf, prf),
+                         potential_temperature_f(sf, tf, pf, prf)));
+        ck_assert(same_f(oceanography::in_situ_temperature(sf, tf, pf, prf),
+                         in_situ_temperature_f(sf, tf, pf, prf)));
+        ck_assert(same_f(oceanography::sound_speed(sf, tf, pf),
+                         sound_speed_f(sf, tf, pf)));
+    }
+}
+END_TEST
+
+START_TEST(test_constants)
+{
+    /* Check values of the UNESCO paper, with constant arguments. */
+    ck_assert(std::fabs(oceanography::theta(40.0, 40.0, 10000.0, 0.0) -
+                        36.998992) < 1.0e-6);
+    ck_assert(std::fabs(oceanography::svan(40.0, 40.0, 10000.0,
+                                           (double *) 0) - 981.301907) <
+              1.0e-6);
+    ck_assert(std::fabs(oceanography::depth(10000.0, 90.0) - 9674.231441) <
+              1.0e-6);
+}
+END_TEST
+
+#ifdef __GNUC__
+
+/* Two doubles, with the vector extensions of GCC. */
+typedef double v2 __attribute__((vector_size(16)));
+typedef __typeof__(v2() < v2()) m2;
+
+namespace oceanography {
+
+template <> struct traits<v2> {
+    typedef m2 mask;
+
+    static v2 set1(double x)
+    {
+        v2 r = {x, x};
+
+        return r;
+    }
+
+    static v2 sqrt(v2 a)
+    {
+        int j;
+
+        for (j = 0; j < 2; j++)
+            a[j] = std::sqrt(a[j]);
+
+        return a;
+    }
+
+    static v2 abs(v2 a)
+    {
+        int j;
+
+        for (j = 0; j < 2; j++)
+            a[j] = std::fabs(a[j]);
+
+        return a;
+    }
+
+    static m2 eq(v2 a, v2 b) { return a == b; }
+    static m2 le(v2 a, v2 b) { return a <= b; }
+    static m2 gt(v2 a, v2 b) { return a > b; }
+    static m2 both(m2 a, m2 b) { return a & b; }
+
+    static bool any(m2 m)
+    {
+        return m[0] || m[1];
+    }
+
+    static v2 select(m2 m, v2 a, v2 b) { return m ? a : b; }
+};
+
+}
+
+START_TEST(test_vector)
+{
+    v2 vs, vt, vp, vpr, vc, sig, out[6];
+    double sigma;
+    int i, j;
+
+    for (i = 0; i + 2 <= GRID; i += 2) {
+        for (j = 0; j < 2; j++) {
+            vs[j] = s[i + j];
+            vt[j] = t[i + j];
+            vp[j] = p[i + j];
+            vpr[j] = pr[i + j];
+            vc[j] = c[i + j];
+        }
+        out[0] = oceanography::salinity(vc, vt, vp);
+        out[1] = oceanography::conductivity(vs, vt, vp);
+        out[2] = oceanography::specific_volume_anomaly(vs, vt, vp, &sig);
+        out[3] = oceanography::depth(vp, 45.0);
+        out[4] = oceanography::in_situ_temperature(vs, vt, vp, vpr);
+        out[5] = oceanography::sound_speed(vs, vt, vp);
+        for (j = 0; j < 2; j++) {
+            ck_assert(same(out[0][j], salinity(c[i + j], t[i + j],
+                                               p[i + j])));
+            ck_assert(same(out[1][j], conductivity(s[i + j], t[i + j],
+                                                   p[i + j])));
+            ck_assert(same(out[2][j],
+                           specific_volume_anomaly(s[i + j], t[i + j],
+                                                   p[i + j], &sigma)));
+            ck_assert(same(sig[j], sigma));
+            ck_assert(same(out[3][j], depth(p[i + j], 45.0)));
+            ck_assert(same(out[4][j],
+                           in_situ_temperature(s[i + j], t[i + j], p[i + j],
+                                               pr[i + j])));
+            ck_assert(same(out[5][j], sound_speed(s[i + j], t[i + j],
+                                                  p[i + j])));
+        }
+    }
+}
+END_TEST
+
+#endif
+
+
+Suite *cxx_suite(void)
+{
+    Suite *s = suite_create("C++");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, test_double);
+    tcase_add_test(tc_core, test_float);
+    tcase_add_test(tc_core, test_constants);
+#ifdef __GNUC__
+    tcase_add_test(tc_core, test_vector);
+#endif
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = cxx_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_float.c -- Unit tests for the single precision functions.
+ *
+ * The float functions are compared with the double ones on the check values
+ * of test_oceanography.c, within the deviations given in the function
+ * reference, and the batch functions of every instruction set supported by
+ * the host are compared bit for bit with the scalar ones.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* Not a multiple of any vector width, to exercise the padded tail. */
+#define GRID 347
+
+
+static int near(float x, double y, double deviation)
+{
+    return fabs(x - y) <= deviation;
+}
+
+/* Fill s, t and p with a 7x7x7 grid covering the UNESCO range, followed by
+ * a few samples at the edges.
+ */
+static void fill_grid(float *s, float *t, float *p)
+{
+    int i, j, k, n = 0;
+
+    for (i = 0; i < 7; i++)
+        for (j = 0; j < 7; j++)
+            for (k = 0; k < 7; k++) {
+                s[n] = i * 7.0f;
+                t[n] = j * 6.5f - 2.0f;
+                p[n] = k * 1666.0f;
+                n++;
+            }
+
+    s[n] = -1.0f; t[n] = 0.0f; p[n] = 0.0f; n++;
+    s[n] = 35.0f; t[n] = 15.0f; p[n] = 1e-30f; n++;
+    s[n] = 40.0f; t[n] = 40.0f; p[n] = 10000.0f; n++;
+    s[n] = 0.0f; t[n] = -2.0f; p[n] = 0.0f;
+}
+
+static void check_isa(enum oceanography_isa isa)
+{
+    float s[GRID], t[GRID], p[GRID], out[GRID], sigma[GRID], sig;
+    float c[GRID], pr[GRID], latitude[GRID];
+    int i;
+
+    fill_grid(s, t, p);
+    for (i = 0; i < GRID; i++) {
+        pr[i] = (i % 4) * 1000.0f;
+        latitude[i] = (i % 10) * 9.0f;
+    }
+
+    ck_assert(oceanography_set_isa(isa) == 0);
+
+    conductivity_n_f(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == conductivity_f(s[i], t[i], p[i]));
+
+    salinity_n_f(out, t, p, c, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(c[i] == salinity_f(out[i], t[i], p[i]));
+
+    specific_volume_anomaly_n_f(s, t, p, out, sigma, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == specific_volume_anomaly_f(s[i], t[i], p[i],
+                                                      &sig));
+        ck_assert(sigma[i] == sig);
+    }
+    specific_volume_anomaly_n_f(s, t, p, out, NULL, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == svan_f(s[i], t[i], p[i], &sig));
+
+    depth_n_f(p, latitude, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == depth_f(p[i], latitude[i]));
+
+    freezing_point_n_f(s, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == freezing_point_f(s[i], p[i]));
+
+    specific_heat_n_f(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == cpsw_f(s[i], t[i], p[i]));
+
+    adiabatic_temperature_gradient_n_f(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == atg_f(s[i], t[i], p[i]));
+
+    potential_temperature_n_f(s, t, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == theta_f(s[i], t[i], p[i], pr[i]));
+
+    in_situ_temperature_n_f(s, t, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == in_situ_temperature_f(s[i], t[i], p[i], pr[i]));
+
+    sound_speed_n_f(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == sound_speed_f(s[i], t[i], p[i]));
+
+    ck_assert(oceanography_set_isa(OCEANOGRAPHY_ISA_AUTO) == 0);
+}
+
+
+START_TEST(test_salinity_f)
+{
+    ck_assert(near(salinity_f(1, 15, 0), salinity(1, 15, 0), 1e-5));
+    ck_assert(near(salinity_f(1.2f, 20, 2000), salinity(1.2, 20, 2000),
+                   1e-5));
+    ck_assert(near(salinity_f(0.65f, 5, 1500), salinity(0.65, 5, 1500),
+                   1e-5));
+    ck_assert(near(salinity_f(1.888091f, 40, 10000),
+                   salinity(1.888091, 40, 10000), 1e-5));
+    ck_assert(salinity_f(5e-5f, 15, 0) == 0.0f);
+}
+END_TEST
+
+START_TEST(test_conductivity_f)
+{
+    ck_assert(near(conductivity_f(35, 15, 0), 1.0, 1e-6));
+    ck_assert(near(conductivity_f(37.245628f, 20, 2000),
+                   conductivity(37.245628, 20, 2000), 1e-6));
+    ck_assert(near(conductivity_f(27.995347f, 5, 1500),
+                   conductivity(27.995347, 5, 1500), 1e-6));
+    ck_assert(near(conductivity_f(40, 40, 10000),
+                   conductivity(40, 40, 10000), 1e-6));
+    ck_assert(conductivity_f(0.02f, 15, 0) == 0.0f);
+}
+END_TEST
+
+START_TEST(test_specific_volume_anomaly_f)
+{
+    float sigma;
+    double sig;
+
+    ck_assert(near(specific_volume_anomaly_f(0, 0, 0, &sigma),
+                   specific_volume_anomaly(0, 0, 0, &sig), 5e-4));
+    ck_assert(near(sigma, sig, 5e-6));
+    ck_assert(near(specific_volume_anomaly_f(0, 0, 1000, &sigma),
+                   specific_volume_anomaly(0, 0, 1000, &sig), 5e-4));
+    ck_assert(near(sigma, sig, 5e-6));
+    ck_assert(near(specific_volume_anomaly_f(40, 0, 0, &sigma),
+                   specific_volume_anomaly(40, 0, 0, &sig), 5e-4));
+    ck_assert(near(sigma, sig, 5e-6));
+    ck_assert(near(svan_f(40, 40, 10000, &sigma),
+                   svan(40, 40, 10000, &sig), 5e-4));
+    ck_assert(near(sigma, sig, 5e-6));
+}
+END_TEST
+
+START_TEST(test_depth_f)
+{
+    ck_assert(near(depth_f(500, 0), depth(500, 0), 5e-4));
+    ck_assert(near(depth_f(10000, 30), depth(10000, 30), 5e-4));
+    ck_assert(near(depth_f(10000, 90), depth(10000, 90), 5e-4));
+}
+END_TEST
+
+START_TEST(test_freezing_point_f)
+{
+    ck_assert(near(freezing_point_f(5, 0), freezing_point(5, 0), 1e-6));
+    ck_assert(near(freezing_point_f(20, 300), freezing_point(20, 300),
+                   1e-6));
+    ck_assert(near(freezing_point_f(40, 500), freezing_point(40, 500),
+                   1e-6));
+}
+END_TEST
+
+START_TEST(test_specific_heat_f)
+{
+    ck_assert(near(specific_heat_f(25, 0, 0), specific_heat(25, 0, 0),
+                   5e-4));
+    ck_assert(near(specific_heat_f(35, 20, 5000),
+                   specific_heat(35, 20, 5000), 5e-4));
+    ck_assert(near(cpsw_f(40, 40, 10000), cpsw(40, 40, 10000), 5e-4));
+}
+END_TEST
+
+START_TEST(test_adiabatic_temperature_gradient_f)
+{
+    ck_assert(near(adiabatic_temperature_gradient_f(25, 0, 0),
+                   adiabatic_temperature_gradient(25, 0, 0), 1e-10));
+    ck_assert(near(atg_f(30, 20, 9000), atg(30, 20, 9000), 1e-10));
+    ck_assert(near(atg_f(40, 40, 10000), atg(40, 40, 10000), 1e-10));
+}
+END_TEST
+
+START_TEST(test_potential_temperature_f)
+{
+    ck_assert(potential_temperature_f(25, 0, 0, 0) == 0.0f);
+    ck_assert(potential_temperature_f(25, 40, 0, 0) == 40.0f);
+    ck_assert(near(theta_f(30, 20, 9000, 0), theta(30, 20, 9000, 0), 1e-5));
+    ck_assert(near(theta_f(40, 40, 10000, 0), theta(40, 40, 10000, 0),
+                   1e-5));
+}
+END_TEST
+
+START_TEST(test_in_situ_temperature_f)
+{
+    ck_assert(in_situ_temperature_f(25, 0, 0, 0) == 0.0f);
+    ck_assert(near(in_situ_temperature_f(30, 18.296537f, 9000, 0),
+                   in_situ_temperature(30, 18.296537, 9000, 0), 1e-5));
+    ck_assert(near(in_situ_temperature_f(40, 36.998992f, 10000, 0),
+                   in_situ_temperature(40, 36.998992, 10000, 0), 1e-5));
+}
+END_TEST
+
+START_TEST(test_sound_speed_f)
+{
+    ck_assert(near(sound_speed_f(25, 0, 0), sound_speed(25, 0, 0), 5e-4));
+    ck_assert(near(sound_speed_f(35, 20, 5000), sound_speed(35, 20, 5000),
+                   5e-4));
+    ck_assert(near(sound_speed_f(40, 40, 10000), sound_speed(40, 40, 10000),
+                   5e-4));
+}
+END_TEST
+
+START_TEST(test_scalar)
+{
+    check_isa(OCEANOGRAPHY_ISA_SCALAR);
+}
+END_TEST
+
+START_TEST(test_sse2)
+{
+    if (oceanography_isa_supported(OCEANOGRAPHY_ISA_SSE2))
+        check_isa(OCEANOGRAPHY_ISA_SSE2);
+}
+END_TEST
+
+START_TEST(test_avx2)
+{
+    if (oceanography_isa_supported(OCEANOGRAPHY_ISA_AVX2))
+        check_isa(OCEANOGRAPHY_ISA_AVX2);
+}
+END_TEST
+
+START_TEST(test_avx512)
+{
+    if (oceanography_isa_supported(OCEANOGRAPHY_ISA_AVX512))
+        check_isa(OCEANOGRAPHY_ISA_AVX512);
+}
+END_TEST
+
+
+Suite *float_suite(void)
+{
+    Suite *s = suite_create("Float");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_salinity_f);
+    tcase_add_test(tc_core, test_conductivity_f);
+    tcase_add_test(tc_core, test_specific_volume_anomaly_f);
+    tcase_add_test(tc_core, test_depth_f);
+    tcase_add_test(tc_core, test_freezing_point_f);
+    tcase_add_test(tc_core, test_specific_heat_f);
+    tcase_add_test(tc_core, test_adiabatic_temperature_gradient_f);
+    tcase_add_test(tc_core, test_potential_temperature_f);
+    tcase_add_test(tc_core, test_in_situ_temperature_f);
+    tcase_add_test(tc_core, test_sound_speed_f);
+    tcase_add_test(tc_core, test_scalar);
+    tcase_add_test(tc_core, test_sse2);
+    tcase_add_test(tc_core, test_avx2);
+    tcase_add_test(tc_core, test_avx512);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = float_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
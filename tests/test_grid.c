@@ -0,0 +1,254 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_grid.c -- Unit tests for the gridded fields of liboceanography.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* More longitudes than a tile. */
+#define NLON 300
+#define NLAT 7
+#define NLEV 5
+#define POINTS (NLON * NLAT * NLEV)
+
+/* Fields are interleaved in pairs in the strided test. */
+#define SIZE (2 * POINTS)
+
+#define REFERENCE_PRESSURE 1000.0
+
+#define ALL_OUTPUTS (OCEANOGRAPHY_CTD_SALINITY | OCEANOGRAPHY_CTD_SVAN | \
+                     OCEANOGRAPHY_CTD_SIGMA | OCEANOGRAPHY_CTD_THETA | \
+                     OCEANOGRAPHY_CTD_SOUND_SPEED | OCEANOGRAPHY_CTD_DEPTH | \
+                     OCEANOGRAPHY_CTD_CPSW | \
+                     OCEANOGRAPHY_CTD_FREEZING_POINT | OCEANOGRAPHY_CTD_ATG)
+
+static double s[SIZE], t[SIZE], p[SIZE], lat[2 * NLON * NLAT];
+static double fields[9][SIZE];
+static struct ctd_outputs out;
+
+static void setup(void)
+{
+    int i;
+
+    for (i = 0; i < SIZE; i++) {
+        s[i] = 33.0 + (i % 37) * 0.1;
+        t[i] = -1.0 + (i % 29);
+        p[i] = (i % 41) * 150.0;
+    }
+    for (i = 0; i < 2 * NLON * NLAT; i++)
+        lat[i] = -80.0 + (i % 161);
+
+    memset(fields, 0, sizeof(fields));
+    out.salinity = fields[0];
+    out.svan = fields[1];
+    out.sigma = fields[2];
+    out.theta = fields[3];
+    out.sound_speed = fields[4];
+    out.depth = fields[5];
+    out.cpsw = fields[6];
+    out.freezing_point = fields[7];
+    out.atg = fields[8];
+}
+
+/* Check point (i, j, k) against the scalar functions, or the ones on a
+ * level if pressure varies along level only and tiles run across levels. */
+static void check_point(const struct oceanography_grid *grid, size_t i,
+                        size_t j, size_t k)
+{
+    struct oceanography_level level;
+    size_t f, fp, fl;
+    double sigma, v, c, cp, atg;
+
+    f = i * grid->stride[0] + j * grid->stride[1] + k * grid->stride[2];
+    fp = i * grid->pressure_stride[0] + j * grid->pressure_stride[1] +
+         k * grid->pressure_stride[2];
+    fl = i * grid->latitude_stride[0] + j * grid->latitude_stride[1];
+
+    if (grid->pressure_stride[0] == 0 && grid->pressure_stride[1] == 0 &&
+        grid->stride[2] != 1) {
+        oceanography_level_init(&level, p[fp]);
+        svan_level_n(&level, &s[f], &t[f], &v, &sigma, 1);
+        sound_speed_level_n(&level, &s[f], &t[f], &c, 1);
+        cpsw_level_n(&level, &s[f], &t[f], &cp, 1);
+        atg_level_n(&level, &s[f], &t[f], &atg, 1);
+    } else {
+        v = specific_volume_anomaly(s[f], t[f], p[fp], &sigma);
+        c = sound_speed(s[f], t[f], p[fp]);
+        cp = specific_heat(s[f], t[f], p[fp]);
+        atg = adiabatic_temperature_gradient(s[f], t[f], p[fp]);
+    }
+
+    ck_assert(out.salinity[f] == s[f]);
+    ck_assert(out.svan[f] == v);
+    ck_assert(out.sigma[f] == sigma);
+    ck_assert(out.theta[f] == potential_temperature(s[f], t[f], p[fp],
+                                                    REFERENCE_PRESSURE));
+    ck_assert(out.sound_speed[f] == c);
+    ck_assert(out.depth[f] == depth(p[fp], lat[fl]));
+    ck_assert(out.cpsw[f] == cp);
+    ck_assert(out.freezing_point[f] == freezing_point(s[f], p[fp]));
+    ck_assert(out.atg[f] == atg);
+}
+
+static void check_grid(const struct oceanography_grid *grid)
+{
+    size_t i, j, k;
+
+    ck_assert(oceanography_grid_derive(grid, s, t, p, lat,
+                                       REFERENCE_PRESSURE, ALL_OUTPUTS,
+                                       &out) == 0);
+    for (k = 0; k < grid->shape[2]; k++)
+        for (j = 0; j < grid->shape[1]; j++)
+            for (i = 0; i < grid->shape[0]; i++)
+                check_point(grid, i, j, k);
+}
+
+static void set(size_t *v, size_t a, size_t b, size_t c)
+{
+    v[0] = a;
+    v[1] = b;
+    v[2] = c;
+}
+
+START_TEST(test_levels)
+{
+    struct oceanography_grid grid;
+
+    /* Longitude varies fastest, pressure levels, regular latitude. */
+    set(grid.shape, NLON, NLAT, NLEV);
+    set(grid.stride, 1, NLON, NLON * NLAT);
+    set(grid.pressure_stride, 0, 0, 1);
+    grid.latitude_stride[0] = 0;
+    grid.latitude_stride[1] = 1;
+    check_grid(&grid);
+}
+END_TEST
+
+START_TEST(test_single_latitude)
+{
+    struct oceanography_grid grid;
+
+    /* A single latitude, whose stride of 0 is not the one of the tiles. */
+    set(grid.shape, NLON, 1, NLEV);
+    set(grid.stride, NLEV, 0, 1);
+    set(grid.pressure_stride, 0, 0, 1);
+    grid.latitude_stride[0] = 1;
+    grid.latitude_stride[1] = 0;
+    check_grid(&grid);
+
+    set(grid.stride, 1, 0, NLON);
+    check_grid(&grid);
+}
+END_TEST
+
+START_TEST(test_columns)
+{
+    struct oceanography_grid grid;
+
+    /* Level varies fastest, pressure at every point, curvilinear
+     * latitude. */
+    set(grid.shape, NLON, NLAT, NLEV);
+    set(grid.stride, NLEV * NLAT, NLEV, 1);
+    set(grid.pressure_stride, NLEV * NLAT, NLEV, 1);
+    grid.latitude_stride[0] = 1;
+    grid.latitude_stride[1] = NLON;
+    check_grid(&grid);
+}
+END_TEST
+
+START_TEST(test_strided)
+{
+    struct oceanography_grid grid;
+    size_t i;
+
+    /* Interleaved fields, latitude varying along longitude only. */
+    set(grid.shape, NLON, NLAT, NLEV);
+    set(grid.stride, 2, 2 * NLON, 2 * NLON * NLAT);
+    set(grid.pressure_stride, 2, 2 * NLON, 2 * NLON * NLAT);
+    grid.latitude_stride[0] = 1;
+    grid.latitude_stride[1] = 0;
+    check_grid(&grid);
+
+    /* The points in between are not written. */
+    for (i = 1; i < SIZE; i += 2)
+        ck_assert(out.sound_speed[i] == 0.0 && out.depth[i] == 0.0);
+}
+END_TEST
+
+START_TEST(test_depth)
+{
+    struct oceanography_grid grid;
+    size_t i, j, k;
+
+    /* Salinity and temperature are not needed for depth. */
+    set(grid.shape, NLON, NLAT, NLEV);
+    set(grid.stride, 1, NLON, NLON * NLAT);
+    set(grid.pressure_stride, 0, 0, 1);
+    grid.latitude_stride[0] = 0;
+    grid.latitude_stride[1] = 1;
+    ck_assert(oceanography_grid_derive(&grid, NULL, NULL, p, lat, 0.0,
+                                       OCEANOGRAPHY_CTD_DEPTH, &out) == 0);
+    for (k = 0; k < NLEV; k++)
+        for (j = 0; j < NLAT; j++)
+            for (i = 0; i < NLON; i++)
+                ck_assert(out.depth[(k * NLAT + j) * NLON + i] ==
+                          depth(p[k], lat[j]));
+    ck_assert(out.sound_speed[0] == 0.0);
+
+    /* An empty grid writes nothing. */
+    grid.shape[1] = 0;
+    out.depth[0] = 0.0;
+    ck_assert(oceanography_grid_derive(&grid, NULL, NULL, p, lat, 0.0,
+                                       OCEANOGRAPHY_CTD_DEPTH, &out) == 0);
+    ck_assert(out.depth[0] == 0.0);
+}
+END_TEST
+
+
+Suite *grid_suite(void)
+{
+    Suite *s = suite_create("Grid");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, test_levels);
+    tcase_add_test(tc_core, test_single_latitude);
+    tcase_add_test(tc_core, test_columns);
+    tcase_add_test(tc_core, test_strided);
+    tcase_add_test(tc_core, test_depth);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = grid_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_level.c -- Unit tests for the batch functions on a pressure level.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* Not a multiple of any vector width, to exercise the scalar tail. */
+#define SAMPLES 347
+
+#define LEVELS 6
+
+static const double levels[LEVELS] = {0.0, 1e-300, 10.0, 1000.0, 5000.0,
+                                      10000.0};
+
+static double s[SAMPLES], t[SAMPLES], c[SAMPLES];
+
+static void setup(void)
+{
+    int i;
+
+    for (i = 0; i < SAMPLES; i++) {
+        s[i] = (i % 43) * 1.0;
+        t[i] = -2.0 + (i % 23) * 42.0 / 22.0;
+        c[i] = (i % 31) * 0.05;
+    }
+}
+
+/* x and y differ by rounding only: relative error smaller than 1e-12 of
+ * scale. */
+static int near(double x, double y, double scale)
+{
+    return fabs(x - y) <= 1.0e-12 * scale;
+}
+
+START_TEST(test_exact)
+{
+    struct oceanography_level level;
+    double p[SAMPLES], expected[SAMPLES], out[SAMPLES];
+    int i, k;
+
+    for (k = 0; k < LEVELS; k++) {
+        oceanography_level_init(&level, levels[k]);
+        ck_assert(level.pressure == levels[k]);
+        for (i = 0; i < SAMPLES; i++)
+            p[i] = levels[k];
+
+        salinity_n(c, t, p, expected, SAMPLES);
+        salinity_level_n(&level, c, t, out, SAMPLES);
+        for (i = 0; i < SAMPLES; i++)
+            ck_assert(out[i] == expected[i]);
+
+        conductivity_n(s, t, p, expected, SAMPLES);
+        conductivity_level_n(&level, s, t, out, SAMPLES);
+        for (i = 0; i < SAMPLES; i++)
+            ck_assert(out[i] == expected[i]);
+
+        freezing_point_n(s, p, expected, SAMPLES);
+        freezing_point_level_n(&level, s, out, SAMPLES);
+        for (i = 0; i < SAMPLES; i++)
+            ck_assert(out[i] == expected[i]);
+    }
+}
+END_TEST
+
+START_TEST(test_rounding)
+{
+    struct oceanography_level level;
+    double p[SAMPLES], expected[SAMPLES], out[SAMPLES];
+    double sigma[SAMPLES], expected_sigma[SAMPLES];
+    int i, k;
+
+    for (k = 0; k < LEVELS; k++) {
+        oceanography_level_init(&level, levels[k]);
+        for (i = 0; i < SAMPLES; i++)
+            p[i] = levels[k];
+
+        specific_volume_anomaly_n(s, t, p, expected, expected_sigma,
+                                  SAMPLES);
+        specific_volume_anomaly_level_n(&level, s, t, out, sigma, SAMPLES);
+        for (i = 0; i < SAMPLES; i++) {
+            ck_assert(near(out[i], expected[i], 3000.0));
+            ck_assert(near(sigma[i], expected_sigma[i], 70.0));
+            if (levels[k] == 0.0)
+                ck_assert(out[i] == expected[i] &&
+                          sigma[i] == expected_sigma[i]);
+        }
+
+        specific_heat_n(s, t, p, expected, SAMPLES);
+        specific_heat_level_n(&level, s, t, out, SAMPLES);
+        for (i = 0; i < SAMPLES; i++)
+            ck_assert(near(out[i], expected[i], 4300.0));
+
+        adiabatic_temperature_gradient_n(s, t, p, expected, SAMPLES);
+        adiabatic_temperature_gradient_level_n(&level, s, t, out, SAMPLES);
+        for (i = 0; i < SAMPLES; i++)
+            ck_assert(near(out[i], expected[i], 5.0e-4));
+
+        sound_speed_n(s, t, p, expected, SAMPLES);
+        sound_speed_level_n(&level, s, t, out, SAMPLES);
+        for (i = 0; i < SAMPLES; i++)
+            ck_assert(near(out[i], expected[i], 1800.0));
+    }
+}
+END_TEST
+
+START_TEST(test_isa)
+{
+    struct oceanography_level level;
+    double scalar[8][SAMPLES], out[8][SAMPLES];
+    enum oceanography_isa isa;
+    int i, j;
+
+    /* Every instruction set gives the results of the scalar kernels. */
+    oceanography_level_init(&level, 3000.0);
+    for (isa = OCEANOGRAPHY_ISA_SCALAR; isa <= OCEANOGRAPHY_ISA_AVX512;
+         isa++) {
+        if (!oceanography_isa_supported(isa))
+            continue;
+        ck_assert(oceanography_set_isa(isa) == 0);
+
+        salinity_level_n(&level, c, t, out[0], SAMPLES);
+        conductivity_level_n(&level, s, t, out[1], SAMPLES);
+        svan_level_n(&level, s, t, out[2], out[3], SAMPLES);
+        freezing_point_level_n(&level, s, out[4], SAMPLES);
+        cpsw_level_n(&level, s, t, out[5], SAMPLES);
+        atg_level_n(&level, s, t, out[6], SAMPLES);
+        sound_speed_level_n(&level, s, t, out[7], SAMPLES);
+
+        for (j = 0; j < 8; j++)
+            for (i = 0; i < SAMPLES; i++) {
+                if (isa == OCEANOGRAPHY_ISA_SCALAR)
+                    scalar[j][i] = out[j][i];
+                ck_assert(out[j][i] == scalar[j][i]);
+            }
+    }
+    ck_assert(oceanography_set_isa(OCEANOGRAPHY_ISA_AUTO) == 0);
+}
+END_TEST
+
+
+Suite *level_suite(void)
+{
+    Suite *s = suite_create("Level");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, test_exact);
+    tcase_add_test(tc_core, test_rounding);
+    tcase_add_test(tc_core, test_isa);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = level_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -92,6 +92,29 @@ START_TEST(test_depth)
 }
 END_TEST
 
+START_TEST(test_pressure_from_depth)
+{
+    double lat[] = {0, 30, 60, 90};
+    double p, z;
+    int i, k;
+
+    ck_assert(cmp_double(pressure_from_depth(496.652992, 0), 500.0));
+    ck_assert(cmp_double(pressure_from_depth(9712.653072, 30), 10000.0));
+    ck_assert(pressure_from_depth(0, 45) == 0.0);
+
+    /* The inverse of depth within rounding. */
+    for (k = 0; k < 4; k++)
+        for (i = 1; i <= 12000; i += 7) {
+            p = i;
+            z = depth(p, lat[k]);
+            ck_assert(fabs(pressure_from_depth(z, lat[k]) - p) <
+                      1.0e-12 * p);
+            ck_assert(fabs(depth(pressure_from_depth(z, lat[k]), lat[k]) -
+                           z) < 1.0e-12 * z);
+        }
+}
+END_TEST
+
 START_TEST(test_freezing_point)
 {
     ck_assert(cmp_double(freezing_point(5, 0), -0.273763));
@@ -139,6 +162,20 @@ START_TEST(test_potential_temperature)
 }
 END_TEST
 
+START_TEST(test_in_situ_temperature)
+{
+    ck_assert(cmp_double(in_situ_temperature(25, 0, 0, 0), 0));
+    ck_assert(cmp_double(in_situ_temperature(30, 18.296537, 9000, 0), 20));
+    ck_assert(cmp_double(in_situ_temperature(40, 36.998992, 10000, 0), 40));
+
+    /* Inverse of potential_temperature(), at any reference pressure. */
+    ck_assert(fabs(in_situ_temperature(35, theta(35, 2, 5000, 1000), 5000,
+                                       1000) - 2) < 1.0e-12);
+    ck_assert(fabs(in_situ_temperature(35, theta(35, 25, 0, 4000), 0,
+                                       4000) - 25) < 1.0e-12);
+}
+END_TEST
+
 START_TEST(test_sound_speed)
 {
     ck_assert(cmp_double(sound_speed(25, 0, 0), 1435.789875));
@@ -147,6 +184,115 @@ START_TEST(test_sound_speed)
 }
 END_TEST
 
+START_TEST(test_density_derivatives)
+{
+    double s[] = {5, 35, 35, 40, 20};
+    double t[] = {0, 2, 20, 40, 10};
+    double p[] = {0, 5000, 0, 10000, 1000};
+    double sigma, alpha, beta, kappa, sg0, sg1, rho, dt, ds, dp;
+    int i;
+
+    dt = 1.0e-4;
+    ds = 1.0e-4;
+    dp = 1.0e-2;
+    for (i = 0; i < 5; i++) {
+        sigma = density_derivatives(s[i], t[i], p[i], &alpha, &beta, &kappa);
+        svan(s[i], t[i], p[i], &sg0);
+        ck_assert(fabs(sigma - sg0) < 1.0e-10);
+        rho = 1000.0 + sigma;
+
+        /* The derivatives of the density of svan, by central differences. */
+        svan(s[i], t[i] + dt, p[i], &sg1);
+        svan(s[i], t[i] - dt, p[i], &sg0);
+        ck_assert(fabs(alpha + (sg1 - sg0) / (2.0 * dt) / rho) < 1.0e-10);
+        svan(s[i] + ds, t[i], p[i], &sg1);
+        svan(s[i] - ds, t[i], p[i], &sg0);
+        ck_assert(fabs(beta - (sg1 - sg0) / (2.0 * ds) / rho) < 1.0e-10);
+        svan(s[i], t[i], p[i] + dp, &sg1);
+        svan(s[i], t[i], p[i] - dp, &sg0);
+        ck_assert(fabs(kappa - (sg1 - sg0) / (2.0 * dp) / rho) < 1.0e-12);
+    }
+
+    /* Seawater expands with temperature, except cold fresh water. */
+    density_derivatives(35, 10, 0, &alpha, &beta, NULL);
+    ck_assert(alpha > 1.0e-4 && alpha < 2.0e-4);
+    ck_assert(beta > 7.0e-4 && beta < 8.0e-4);
+    density_derivatives(0, 2, 0, &alpha, &beta, &kappa);
+    ck_assert(alpha < 0.0);
+}
+END_TEST
+
+START_TEST(test_density)
+{
+    double s[] = {5, 35, 35, 40, 20};
+    double t[] = {0, 2, 20, 40, 10};
+    double p[] = {0, 5000, 0, 10000, 1000};
+    double sigma, alpha, beta, kappa;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        svan(s[i], t[i], p[i], &sigma);
+        ck_assert(fabs(density(s[i], t[i], p[i]) - sigma) < 1.0e-10);
+        ck_assert(density(s[i], t[i], p[i]) ==
+                  density_derivatives(s[i], t[i], p[i], &alpha, &beta,
+                                      &kappa));
+
+        /* Density of the potential temperature, at reference pressure. */
+        ck_assert(potential_density(s[i], t[i], p[i], 0) ==
+                  density(s[i], theta(s[i], t[i], p[i], 0), 0));
+        ck_assert(potential_density(s[i], t[i], p[i], 2000) ==
+                  density(s[i], theta(s[i], t[i], p[i], 2000), 2000));
+        ck_assert(potential_density(s[i], t[i], p[i], p[i]) ==
+                  density(s[i], t[i], p[i]));
+    }
+
+    /* A deep parcel is denser in situ than at the surface. */
+    ck_assert(density(35, 2, 5000) - potential_density(35, 2, 5000, 0) >
+              20.0);
+}
+END_TEST
+
+START_TEST(test_salinity_from_density)
+{
+    double sigma, r;
+    double s, t, p;
+
+    ck_assert(cmp_double(salinity_from_density(density(35, 15, 0), 15, 0,
+                                               NULL), 35.0));
+
+    /* The inverse of density within rounding, over the UNESCO ranges. */
+    for (p = 0; p <= 10000; p += 1250)
+        for (t = -2; t <= 40; t += 3.5)
+            for (s = 0; s <= 42; s += 1.5) {
+                sigma = density(s, t, p);
+                ck_assert(fabs(salinity_from_density(sigma, t, p, &r) - s) <
+                          1.0e-11);
+                ck_assert(fabs(r) < 1.0e-11);
+            }
+}
+END_TEST
+
+START_TEST(test_temperature_from_sound_speed)
+{
+    double c, r;
+    double s, t, p;
+
+    ck_assert(cmp_double(temperature_from_sound_speed(1435.789875, 25, 0,
+                                                      NULL), 0.0));
+    ck_assert(cmp_double(temperature_from_sound_speed(1731.995394, 40, 10000,
+                                                      NULL), 40.0));
+
+    for (p = 0; p <= 10000; p += 1250)
+        for (t = -2; t <= 40; t += 3.5)
+            for (s = 0; s <= 42; s += 1.5) {
+                c = sound_speed(s, t, p);
+                ck_assert(fabs(temperature_from_sound_speed(c, s, p, &r) -
+                               t) < 1.0e-11);
+                ck_assert(fabs(r) < 1.0e-10);
+            }
+}
+END_TEST
+
 
 Suite *oceanography_suite(void)
 {
@@ -156,11 +302,17 @@ Suite *oceanography_suite(void)
     tcase_add_test(tc_core, test_conductivity);
     tcase_add_test(tc_core, test_specific_volume_anomaly);
     tcase_add_test(tc_core, test_depth);
+    tcase_add_test(tc_core, test_pressure_from_depth);
     tcase_add_test(tc_core, test_freezing_point);
     tcase_add_test(tc_core, test_specific_heat);
     tcase_add_test(tc_core, test_adiabatic_temperature_gradient);
     tcase_add_test(tc_core, test_potential_temperature);
+    tcase_add_test(tc_core, test_in_situ_temperature);
     tcase_add_test(tc_core, test_sound_speed);
+    tcase_add_test(tc_core, test_density_derivatives);
+    tcase_add_test(tc_core, test_density);
+    tcase_add_test(tc_core, test_salinity_from_density);
+    tcase_add_test(tc_core, test_temperature_from_sound_speed);
     suite_add_tcase(s, tc_core);
 
     return s;
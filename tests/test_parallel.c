@@ -0,0 +1,281 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_parallel.c -- Unit tests for the parallel batch functions of
+ * liboceanography.
+ *
+ * Results of the *_parallel functions must be bit for bit identical to the
+ * ones of the *_n functions, whatever the number of threads.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* Samples: several chunks plus a partial one. */
+#define SAMPLES 30011
+
+/* Threads calling the *_parallel functions with the default pool. */
+#define CALLERS 4
+
+
+static double *s, *t, *p, *c, *pr, *lat;
+static double *expected, *expected_sigma, *out, *sigma;
+
+static void setup(void)
+{
+    int i;
+
+    s = malloc(SAMPLES * sizeof(double));
+    t = malloc(SAMPLES * sizeof(double));
+    p = malloc(SAMPLES * sizeof(double));
+    c = malloc(SAMPLES * sizeof(double));
+    pr = malloc(SAMPLES * sizeof(double));
+    lat = malloc(SAMPLES * sizeof(double));
+    expected = malloc(SAMPLES * sizeof(double));
+    expected_sigma = malloc(SAMPLES * sizeof(double));
+    out = malloc(SAMPLES * sizeof(double));
+    sigma = malloc(SAMPLES * sizeof(double));
+
+    for (i = 0; i < SAMPLES; i++) {
+        s[i] = (i % 41) * 1.0;
+        t[i] = (i % 43) - 2.0;
+        p[i] = (i % 47) * 200.0;
+        pr[i] = (i % 3) * 500.0;
+        lat[i] = (i % 181) - 90.0;
+    }
+    conductivity_n(s, t, p, c, SAMPLES);
+}
+
+static void teardown(void)
+{
+    free(s);
+    free(t);
+    free(p);
+    free(c);
+    free(pr);
+    free(lat);
+    free(expected);
+    free(expected_sigma);
+    free(out);
+    free(sigma);
+}
+
+static int same(const double *x, const double *y, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        if (x[i] != y[i])
+            return 0;
+
+    return 1;
+}
+
+/* Compare every parallel function with the batch one on pool. */
+static void check_pool(struct oceanography_pool *pool)
+{
+    salinity_n(c, t, p, expected, SAMPLES);
+    salinity_parallel(pool, c, t, p, out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    conductivity_parallel(pool, s, t, p, out, SAMPLES);
+    ck_assert(same(out, c, SAMPLES));
+
+    specific_volume_anomaly_n(s, t, p, expected, expected_sigma, SAMPLES);
+    specific_volume_anomaly_parallel(pool, s, t, p, out, sigma, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+    ck_assert(same(sigma, expected_sigma, SAMPLES));
+    svan_parallel(pool, s, t, p, out, NULL, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    depth_n(p, lat, expected, SAMPLES);
+    depth_parallel(pool, p, lat, out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    freezing_point_n(s, p, expected, SAMPLES);
+    freezing_point_parallel(pool, s, p, out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    specific_heat_n(s, t, p, expected, SAMPLES);
+    specific_heat_parallel(pool, s, t, p, out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    adiabatic_temperature_gradient_n(s, t, p, expected, SAMPLES);
+    adiabatic_temperature_gradient_parallel(pool, s, t, p, out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    potential_temperature_n(s, t, p, pr, expected, SAMPLES);
+    potential_temperature_parallel(pool, s, t, p, pr, out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    sound_speed_n(s, t, p, expected, SAMPLES);
+    sound_speed_parallel(pool, s, t, p, out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+
+    /* Partial chunks and empty arrays. */
+    sound_speed_parallel(pool, s, t, p, out, 5);
+    ck_assert(same(out, expected, 5));
+    sound_speed_parallel(pool, s, t, p, out, 0);
+}
+
+START_TEST(test_threads)
+{
+    unsigned int threads[] = {1, 2, 3, 8};
+    struct oceanography_pool *pool;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        pool = oceanography_pool_create(threads[i]);
+        ck_assert(pool != NULL);
+        ck_assert(oceanography_pool_threads(pool) == threads[i]);
+        check_pool(pool);
+        oceanography_pool_destroy(pool);
+    }
+}
+END_TEST
+
+START_TEST(test_default_pool)
+{
+    ck_assert(oceanography_pool_threads(NULL) >= 1);
+    check_pool(NULL);
+
+    ck_assert(oceanography_set_threads(4) == 0);
+    ck_assert(oceanography_pool_threads(NULL) == 4);
+    check_pool(NULL);
+
+    ck_assert(oceanography_set_threads(0) == 0);
+    check_pool(NULL);
+}
+END_TEST
+
+struct caller {
+    unsigned int id;
+    double out[SAMPLES];
+    int same;
+};
+
+/* Start on the default pool at the same time as the other callers, while
+ * the first one replaces it. */
+static void *call(void *arg)
+{
+    struct caller *caller = arg;
+    int k;
+
+    caller->same = 1;
+    for (k = 0; k < 10; k++) {
+        sound_speed_parallel(NULL, s, t, p, caller->out, SAMPLES);
+        caller->same = caller->same && same(caller->out, expected, SAMPLES);
+        if (caller->id == 0 && k % 3 == 1)
+            oceanography_set_threads(k % 2 + 2);
+    }
+
+    return NULL;
+}
+
+START_TEST(test_default_pool_callers)
+{
+    static struct caller callers[CALLERS];
+    pthread_t threads[CALLERS];
+    unsigned int k;
+
+    sound_speed_n(s, t, p, expected, SAMPLES);
+    for (k = 0; k < CALLERS; k++) {
+        callers[k].id = k;
+        ck_assert(pthread_create(&threads[k], NULL, call, &callers[k]) == 0);
+    }
+    for (k = 0; k < CALLERS; k++)
+        pthread_join(threads[k], NULL);
+
+    for (k = 0; k < CALLERS; k++)
+        ck_assert(callers[k].same);
+}
+END_TEST
+
+START_TEST(test_ctd_derive_parallel)
+{
+    struct oceanography_pool *pool;
+    struct ctd_outputs expected_out, parallel_out;
+    double *th;
+
+    th = malloc(SAMPLES * sizeof(double));
+    expected_out.salinity = expected;
+    expected_out.sigma = expected_sigma;
+    expected_out.theta = th;
+    expected_out.svan = expected_out.sound_speed = expected_out.depth = NULL;
+    expected_out.cpsw = expected_out.freezing_point = NULL;
+    expected_out.atg = NULL;
+    parallel_out = expected_out;
+    parallel_out.salinity = out;
+    parallel_out.sigma = sigma;
+    parallel_out.theta = pr;
+
+    ctd_derive_n(c, t, p, 30.0, 1000.0,
+                 OCEANOGRAPHY_CTD_SALINITY | OCEANOGRAPHY_CTD_SIGMA |
+                 OCEANOGRAPHY_CTD_THETA, &expected_out, SAMPLES);
+
+    pool = oceanography_pool_create(3);
+    ck_assert(pool != NULL);
+    ctd_derive_parallel(pool, c, t, p, 30.0, 1000.0,
+                        OCEANOGRAPHY_CTD_SALINITY | OCEANOGRAPHY_CTD_SIGMA |
+                        OCEANOGRAPHY_CTD_THETA, &parallel_out, SAMPLES);
+    ck_assert(same(out, expected, SAMPLES));
+    ck_assert(same(sigma, expected_sigma, SAMPLES));
+    ck_assert(same(pr, th, SAMPLES));
+
+    /* Depth does not need conductivity. */
+    parallel_out.salinity = parallel_out.sigma = parallel_out.theta = NULL;
+    parallel_out.depth = out;
+    ctd_derive_parallel(pool, NULL, t, p, 30.0, 0.0, OCEANOGRAPHY_CTD_DEPTH,
+                        &parallel_out, SAMPLES);
+    ck_assert(out[SAMPLES - 1] == depth(p[SAMPLES - 1], 30.0));
+
+    oceanography_pool_destroy(pool);
+    free(th);
+}
+END_TEST
+
+
+Suite *parallel_suite(void)
+{
+    Suite *s = suite_create("Parallel");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, test_threads);
+    tcase_add_test(tc_core, test_default_pool);
+    tcase_add_test(tc_core, test_default_pool_callers);
+    tcase_add_test(tc_core, test_ctd_derive_parallel);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = parallel_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
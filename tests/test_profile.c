@@ -0,0 +1,323 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_profile.c -- Unit tests for the profile functions of liboceanography.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+#define EPSILON 0.00001
+
+/* Samples of the test profile, every 2 decibars from 10 decibars. */
+#define LEVELS 1000
+
+
+static int cmp_double(double x, double y)
+{
+    return fabs(x - y) < EPSILON;
+}
+
+/* A thermocline profile: warm and fresh at the surface. */
+static void fill_profile(double *s, double *t, double *p)
+{
+    int i;
+
+    for (i = 0; i < LEVELS; i++) {
+        p[i] = 10.0 + 2.0 * i;
+        t[i] = 4.0 + 16.0 * exp(-p[i] / 300.0);
+        s[i] = 34.9 - 1.5 * exp(-p[i] / 500.0);
+    }
+}
+
+
+START_TEST(test_geopotential_anomaly_n)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], out[LEVELS];
+    double svan0, svan1, expected, sigma;
+    struct geopotential state;
+    int i;
+
+    fill_profile(s, t, p);
+    geopotential_init(&state, 0.0);
+    geopotential_anomaly_n(&state, s, t, p, out, LEVELS);
+
+    /* From the reference level to the first sample svan is constant. */
+    svan0 = svan(s[0], t[0], p[0], &sigma);
+    expected = svan0 * p[0] * 1.0e-4;
+    ck_assert(cmp_double(out[0], expected));
+
+    for (i = 1; i < LEVELS; i++) {
+        svan1 = svan(s[i], t[i], p[i], &sigma);
+        expected += 0.5 * (svan0 + svan1) * (p[i] - p[i - 1]) * 1.0e-4;
+        svan0 = svan1;
+        ck_assert(cmp_double(out[i], expected));
+    }
+
+    ck_assert(geopotential_anomaly(&state) == out[LEVELS - 1]);
+    ck_assert(state.count == LEVELS);
+
+    /* Warm surface water is lighter: anomaly grows with pressure. */
+    ck_assert(out[LEVELS - 1] > out[LEVELS / 2]);
+    ck_assert(out[LEVELS - 1] > 0.0);
+}
+END_TEST
+
+START_TEST(test_geopotential_incremental)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], out[LEVELS], parts[LEVELS];
+    struct geopotential state;
+    int i;
+
+    fill_profile(s, t, p);
+    geopotential_init(&state, 5.0);
+    geopotential_anomaly_n(&state, s, t, p, out, LEVELS);
+
+    /* Extending a profile scan by scan gives the same results. */
+    geopotential_init(&state, 5.0);
+    geopotential_anomaly_n(&state, s, t, p, parts, 1);
+    geopotential_anomaly_n(&state, s + 1, t + 1, p + 1, parts + 1, 300);
+    geopotential_anomaly_n(&state, s + 301, t + 301, p + 301, parts + 301, 0);
+    geopotential_anomaly_n(&state, s + 301, t + 301, p + 301, parts + 301,
+                           LEVELS - 301);
+
+    for (i = 0; i < LEVELS; i++)
+        ck_assert(parts[i] == out[i]);
+}
+END_TEST
+
+START_TEST(test_geopotential_deep_reference)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], out[LEVELS], shallow[LEVELS];
+    double parts[LEVELS], reference;
+    struct geopotential state;
+    int i, k = 495;
+
+    fill_profile(s, t, p);
+    geopotential_init(&state, 0.0);
+    geopotential_anomaly_n(&state, s, t, p, shallow, LEVELS);
+
+    /* A reference at a sample inside the profile. */
+    ck_assert(p[k] == 1000.0);
+    geopotential_init(&state, 1000.0);
+    geopotential_anomaly_n(&state, s, t, p, out, LEVELS);
+    ck_assert(out[k] == 0.0);
+    for (i = 0; i < LEVELS; i++)
+        ck_assert(cmp_double(out[i], shallow[i] - shallow[k]));
+    ck_assert(geopotential_anomaly(&state) == out[LEVELS - 1]);
+
+    /* Crossed in a later call: the results of that call are the same. */
+    geopotential_init(&state, 1000.0);
+    geopotential_anomaly_n(&state, s, t, p, parts, 100);
+    geopotential_anomaly_n(&state, s + 100, t + 100, p + 100, parts + 100,
+                           LEVELS - 100);
+    for (i = 100; i < LEVELS; i++)
+        ck_assert(cmp_double(parts[i], out[i]));
+
+    /* A reference between two samples, interpolated. */
+    geopotential_init(&state, 1001.0);
+    geopotential_anomaly_n(&state, s, t, p, out, LEVELS);
+    reference = 0.5 * (shallow[k] + shallow[k + 1]);
+    ck_assert(out[k] < 0.0 && out[k + 1] > 0.0);
+    for (i = 0; i < LEVELS; i++)
+        ck_assert(cmp_double(out[i], shallow[i] - reference));
+}
+END_TEST
+
+START_TEST(test_geopotential_in_place)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], out[LEVELS];
+    struct geopotential state;
+    int i;
+
+    fill_profile(s, t, p);
+    geopotential_init(&state, 10.0);
+    geopotential_anomaly_n(&state, s, t, p, out, LEVELS);
+    ck_assert(out[0] == 0.0);
+
+    geopotential_init(&state, 10.0);
+    geopotential_anomaly_n(&state, s, t, p, p, LEVELS);
+    for (i = 0; i < LEVELS; i++)
+        ck_assert(p[i] == out[i]);
+}
+END_TEST
+
+START_TEST(test_dynamic_height_n)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], out[LEVELS], height[LEVELS];
+    struct geopotential state;
+    int i;
+
+    fill_profile(s, t, p);
+    geopotential_init(&state, 0.0);
+    geopotential_anomaly_n(&state, s, t, p, out, LEVELS);
+    geopotential_init(&state, 0.0);
+    dynamic_height_n(&state, s, t, p, height, LEVELS);
+
+    for (i = 0; i < LEVELS; i++)
+        ck_assert(cmp_double(height[i], out[i] / 10.0));
+}
+END_TEST
+
+START_TEST(test_buoyancy_frequency_n)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], out[LEVELS], mid[LEVELS];
+    double pm, t0, t1, sg0, sg1, g, expected;
+    struct buoyancy_frequency state;
+    int i;
+
+    fill_profile(s, t, p);
+    buoyancy_frequency_init(&state, 45.0);
+    ck_assert(buoyancy_frequency_n(&state, s, t, p, out, mid, LEVELS) ==
+              LEVELS - 1);
+    ck_assert(state.count == LEVELS);
+
+    /* Against the density difference of the two samples moved
+     * adiabatically to their midpoint. */
+    for (i = 0; i < LEVELS - 1; i++) {
+        pm = 0.5 * (p[i] + p[i + 1]);
+        ck_assert(mid[i] == pm);
+        t0 = in_situ_temperature(s[i], t[i], pm, p[i]);
+        t1 = in_situ_temperature(s[i + 1], t[i + 1], pm, p[i + 1]);
+        svan(s[i], t0, pm, &sg0);
+        svan(s[i + 1], t1, pm, &sg1);
+        g = state.gravity + 2.184e-6 * pm;
+        expected = g * (sg1 - sg0) / (1000.0 + 0.5 * (sg0 + sg1)) /
+                   (depth(p[i + 1], 45.0) - depth(p[i], 45.0));
+        ck_assert(out[i] > 0.0);
+        ck_assert(fabs(out[i] - expected) < 1.0e-3 * expected);
+    }
+
+    /* The thermocline is more stable than the deep water. */
+    ck_assert(out[10] > 10.0 * out[LEVELS - 2]);
+}
+END_TEST
+
+START_TEST(test_buoyancy_frequency_incremental)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], out[LEVELS], parts[LEVELS];
+    struct buoyancy_frequency state;
+    size_t n;
+    int i;
+
+    fill_profile(s, t, p);
+    buoyancy_frequency_init(&state, 0.0);
+    buoyancy_frequency_n(&state, s, t, p, out, NULL, LEVELS);
+
+    /* Extending a profile scan by scan gives the same results. */
+    buoyancy_frequency_init(&state, 0.0);
+    n = buoyancy_frequency_n(&state, s, t, p, parts, NULL, 0);
+    ck_assert(n == 0);
+    n += buoyancy_frequency_n(&state, s, t, p, parts + n, NULL, 1);
+    ck_assert(n == 0);
+    n += buoyancy_frequency_n(&state, s + 1, t + 1, p + 1, parts + n, NULL,
+                              300);
+    ck_assert(n == 300);
+    n += buoyancy_frequency_n(&state, s + 301, t + 301, p + 301, parts + n,
+                              NULL, LEVELS - 301);
+    ck_assert(n == LEVELS - 1);
+
+    for (i = 0; i < LEVELS - 1; i++)
+        ck_assert(parts[i] == out[i]);
+}
+END_TEST
+
+START_TEST(test_regrid_n)
+{
+    double s[LEVELS], t[LEVELS], p[LEVELS], line[LEVELS];
+    double z[300], out[3][300], w;
+    const double *in[3];
+    double *levels[3];
+    double target;
+    int i, k;
+
+    fill_profile(s, t, p);
+    for (i = 0; i < LEVELS; i++)
+        line[i] = 3.0 * p[i] + 1.0;
+    for (k = 0; k < 300; k++)
+        z[k] = 10.0 * k;
+    in[0] = s;
+    in[1] = t;
+    in[2] = line;
+    for (k = 0; k < 3; k++)
+        levels[k] = out[k];
+
+    regrid_n(p, 45.0, in, 3, LEVELS, z, 300, -99.0, levels);
+
+    for (k = 0; k < 300; k++) {
+        target = pressure_from_depth(z[k], 45.0);
+
+        /* Above the first sample or below the last one. */
+        if (target < p[0] || target > p[LEVELS - 1]) {
+            ck_assert(out[0][k] == -99.0 && out[1][k] == -99.0 &&
+                      out[2][k] == -99.0);
+            continue;
+        }
+
+        ck_assert(fabs(out[2][k] - (3.0 * target + 1.0)) < 1.0e-10);
+        for (i = 0; p[i + 1] < target; i++)
+            ;
+        w = (target - p[i]) / (p[i + 1] - p[i]);
+        ck_assert(fabs(out[1][k] - (t[i] + w * (t[i + 1] - t[i]))) <
+                  1.0e-12);
+        ck_assert(fabs(out[0][k] - (s[i] + w * (s[i + 1] - s[i]))) <
+                  1.0e-12);
+    }
+    ck_assert(out[2][0] == -99.0 && out[2][100] != -99.0 &&
+              out[2][299] == -99.0);
+
+    /* An empty profile. */
+    regrid_n(p, 45.0, in, 3, 0, z, 300, -99.0, levels);
+    for (k = 0; k < 300; k++)
+        ck_assert(out[1][k] == -99.0);
+}
+END_TEST
+
+
+Suite *profile_suite(void)
+{
+    Suite *s = suite_create("Profile");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_geopotential_anomaly_n);
+    tcase_add_test(tc_core, test_geopotential_incremental);
+    tcase_add_test(tc_core, test_geopotential_deep_reference);
+    tcase_add_test(tc_core, test_geopotential_in_place);
+    tcase_add_test(tc_core, test_dynamic_height_n);
+    tcase_add_test(tc_core, test_buoyancy_frequency_n);
+    tcase_add_test(tc_core, test_buoyancy_frequency_incremental);
+    tcase_add_test(tc_core, test_regrid_n);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = profile_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
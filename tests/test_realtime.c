@@ -0,0 +1,279 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_realtime.c -- Unit tests for the real time ingestion.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* Not a multiple of the block of the consumer. */
+#define SCANS 1000
+
+#define ALL_OUTPUTS 0x1ff
+
+static double c[SCANS], t[SCANS], p[SCANS];
+
+static void setup(void)
+{
+    int i;
+
+    /* A cast down to 100 decibars. */
+    for (i = 0; i < SCANS; i++) {
+        c[i] = 0.8 + (i % 37) * 0.01;
+        t[i] = 20.0 - (i % 29) * 0.5;
+        p[i] = i / 10.0;
+    }
+}
+
+static struct oceanography_realtime *create(size_t capacity, size_t bins)
+{
+    struct oceanography_realtime_spec spec;
+
+    spec.capacity = capacity;
+    spec.latitude = 45.0;
+    spec.reference_pressure = 0.0;
+    spec.outputs = ALL_OUTPUTS;
+    spec.bin_width = 1.0;
+    spec.bins = bins;
+
+    return oceanography_realtime_create(&spec);
+}
+
+static void push(struct oceanography_realtime *realtime, int i)
+{
+    struct oceanography_scan scan;
+
+    scan.conductivity = c[i];
+    scan.temperature = t[i];
+    scan.pressure = p[i];
+    while (oceanography_realtime_push(realtime, &scan) != 0)
+        ;
+}
+
+/* Point the outputs to the columns, from index begin. */
+static void outputs(struct ctd_outputs *out, double (*column)[SCANS],
+                    size_t begin)
+{
+    out->salinity = column[0] + begin;
+    out->svan = column[1] + begin;
+    out->sigma = column[2] + begin;
+    out->theta = column[3] + begin;
+    out->sound_speed = column[4] + begin;
+    out->depth = column[5] + begin;
+    out->cpsw = column[6] + begin;
+    out->freezing_point = column[7] + begin;
+    out->atg = column[8] + begin;
+}
+
+/* The outputs of the scans taken from the ring are identical to the ones of
+ * ctd_derive_n. */
+static void check_outputs(double (*column)[SCANS])
+{
+    static double expected[9][SCANS];
+    struct ctd_outputs out;
+    int i, k;
+
+    outputs(&out, expected, 0);
+    ctd_derive_n(c, t, p, 45.0, 0.0, ALL_OUTPUTS, &out, SCANS);
+    for (k = 0; k < 9; k++)
+        for (i = 0; i < SCANS; i++)
+            ck_assert(column[k][i] == expected[k][i]);
+}
+
+START_TEST(test_process)
+{
+    static double column[9][SCANS];
+    struct oceanography_realtime *realtime;
+    struct ctd_outputs out;
+    int i;
+
+    realtime = create(SCANS, 0);
+    ck_assert(realtime != NULL);
+    outputs(&out, column, 0);
+
+    ck_assert(oceanography_realtime_process(realtime, &out, SCANS) == 0);
+    for (i = 0; i < SCANS; i++)
+        push(realtime, i);
+    ck_assert(oceanography_realtime_process(realtime, &out, SCANS) == SCANS);
+    ck_assert(oceanography_realtime_process(realtime, &out, SCANS) == 0);
+    check_outputs(column);
+
+    oceanography_realtime_destroy(realtime);
+}
+END_TEST
+
+START_TEST(test_full)
+{
+    struct oceanography_realtime *realtime;
+    struct oceanography_scan scan;
+    int i;
+
+    /* The capacity is rounded up to 8 scans. */
+    realtime = create(5, 0);
+    ck_assert(realtime != NULL);
+    scan.conductivity = 1.0;
+    scan.temperature = 15.0;
+    scan.pressure = 0.0;
+
+    for (i = 0; i < 8; i++)
+        ck_assert(oceanography_realtime_push(realtime, &scan) == 0);
+    ck_assert(oceanography_realtime_push(realtime, &scan) == -1);
+    ck_assert(oceanography_realtime_process(realtime, NULL, 3) == 3);
+    for (i = 0; i < 3; i++)
+        ck_assert(oceanography_realtime_push(realtime, &scan) == 0);
+    ck_assert(oceanography_realtime_push(realtime, &scan) == -1);
+    ck_assert(oceanography_realtime_process(realtime, NULL, 100) == 8);
+
+    oceanography_realtime_destroy(realtime);
+}
+END_TEST
+
+START_TEST(test_bins)
+{
+    static double column[9][SCANS];
+    struct oceanography_realtime *realtime;
+    struct oceanography_bin bin;
+    struct ctd_outputs out;
+    double sum[12];
+    int i, j, k;
+
+    /* The last 100 scans are deeper than the bins. */
+    realtime = create(64, 90);
+    ck_assert(realtime != NULL);
+
+    /* Small calls, keeping the ring from filling. */
+    for (i = 0; i < SCANS; i += 7) {
+        for (j = i; j < i + 7 && j < SCANS; j++)
+            push(realtime, j);
+        outputs(&out, column, i);
+        ck_assert(oceanography_realtime_process(realtime, &out, 7) ==
+                  (size_t) (j - i));
+    }
+
+    for (k = 0; k < 90; k++) {
+        ck_assert(oceanography_realtime_bin(realtime, k, &bin) == 0);
+        ck_assert(bin.count == 10);
+        for (j = 0; j < 12; j++)
+            sum[j] = 0.0;
+        for (i = 10 * k; i < 10 * k + 10; i++) {
+            sum[0] += c[i];
+            sum[1] += t[i];
+            sum[2] += p[i];
+            for (j = 0; j < 9; j++)
+                sum[3 + j] += column[j][i];
+        }
+        ck_assert(fabs(bin.conductivity - sum[0] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.temperature - sum[1] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.pressure - sum[2] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.salinity - sum[3] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.svan - sum[4] / 10) < 1.0e-9);
+        ck_assert(fabs(bin.sigma - sum[5] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.theta - sum[6] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.sound_speed - sum[7] / 10) < 1.0e-9);
+        ck_assert(fabs(bin.depth - sum[8] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.cpsw - sum[9] / 10) < 1.0e-9);
+        ck_assert(fabs(bin.freezing_point - sum[10] / 10) < 1.0e-12);
+        ck_assert(fabs(bin.atg - sum[11] / 10) < 1.0e-12);
+    }
+    ck_assert(oceanography_realtime_bin(realtime, 90, &bin) == -1);
+    check_outputs(column);
+
+    oceanography_realtime_clear(realtime);
+    ck_assert(oceanography_realtime_bin(realtime, 0, &bin) == 0);
+    ck_assert(bin.count == 0 && bin.salinity == 0.0);
+
+    oceanography_realtime_destroy(realtime);
+}
+END_TEST
+
+static void *produce(void *realtime)
+{
+    int i;
+
+    for (i = 0; i < SCANS; i++)
+        push(realtime, i);
+
+    return NULL;
+}
+
+START_TEST(test_threads)
+{
+    static double column[9][SCANS];
+    struct oceanography_realtime *realtime;
+    struct ctd_outputs out;
+    pthread_t producer;
+    size_t done;
+
+    /* A ring smaller than the scans: the producer waits for the
+     * consumer. */
+    realtime = create(16, 0);
+    ck_assert(realtime != NULL);
+
+    ck_assert(pthread_create(&producer, NULL, produce, realtime) == 0);
+    for (done = 0; done < SCANS;) {
+        outputs(&out, column, done);
+        done += oceanography_realtime_process(realtime, &out, SCANS - done);
+    }
+    pthread_join(producer, NULL);
+    check_outputs(column);
+
+    oceanography_realtime_destroy(realtime);
+}
+END_TEST
+
+START_TEST(test_invalid)
+{
+    ck_assert(create(0, 10) == NULL);
+    ck_assert(create((size_t) -1, 10) == NULL);
+    ck_assert(create(16, (size_t) -1) == NULL);
+}
+END_TEST
+
+
+Suite *realtime_suite(void)
+{
+    Suite *s = suite_create("Realtime");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, test_process);
+    tcase_add_test(tc_core, test_full);
+    tcase_add_test(tc_core, test_bins);
+    tcase_add_test(tc_core, test_threads);
+    tcase_add_test(tc_core, test_invalid);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = realtime_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
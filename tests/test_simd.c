@@ -0,0 +1,372 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_simd.c -- Unit tests for the vectorized batch kernels.
+ *
+ * Every instruction set supported by the host is forced in turn and its
+ * results are compared bit for bit with the scalar functions.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+#define EPSILON 0.00001
+
+/* Not a multiple of any vector width, to exercise the scalar tail. */
+#define GRID 347
+
+
+static int cmp_double(double x, double y)
+{
+    return fabs(x - y) < EPSILON;
+}
+
+/* Fill s, t and p with a 7x7x7 grid covering the UNESCO range, followed by
+ * a few samples at the edges.
+ */
+static void fill_grid(double *s, double *t, double *p)
+{
+    int i, j, k, n = 0;
+
+    for (i = 0; i < 7; i++)
+        for (j = 0; j < 7; j++)
+            for (k = 0; k < 7; k++) {
+                s[n] = i * 7.0;
+                t[n] = j * 6.5 - 2.0;
+                p[n] = k * 1666.0;
+                n++;
+            }
+
+    s[n] = -1.0; t[n] = 0.0; p[n] = 0.0; n++;
+    s[n] = 35.0; t[n] = 15.0; p[n] = 1e-300; n++;
+    s[n] = 40.0; t[n] = 40.0; p[n] = 10000.0; n++;
+    s[n] = 0.0; t[n] = -2.0; p[n] = 0.0;
+}
+
+static void check_isa(enum oceanography_isa isa)
+{
+    double s[GRID], t[GRID], p[GRID], out[GRID], sigma[GRID], sig;
+    double c[GRID], all[9][GRID], pr[GRID], *multi[4];
+    double alpha, beta, kappa, r;
+    double references[] = {0.0, 1000.0, 2000.0, 4000.0};
+    struct ctd_outputs ctd;
+    unsigned long histogram[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+    unsigned long expected[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+    int i;
+
+    fill_grid(s, t, p);
+
+    memset(expected, 0, sizeof(expected));
+    ck_assert(oceanography_set_isa(OCEANOGRAPHY_ISA_SCALAR) == 0);
+    conductivity_histogram_n(s, t, p, out, expected, GRID);
+
+    ck_assert(oceanography_set_isa(isa) == 0);
+    ck_assert(oceanography_get_isa() == isa);
+
+    conductivity_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == conductivity(s[i], t[i], p[i]));
+
+    salinity_n(out, t, p, c, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(c[i] == salinity(out[i], t[i], p[i]));
+
+    memset(histogram, 0, sizeof(histogram));
+    conductivity_histogram_n(s, t, p, out, histogram, GRID);
+    for (i = 0; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+        ck_assert(histogram[i] == expected[i]);
+
+    specific_volume_anomaly_n(s, t, p, out, sigma, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == specific_volume_anomaly(s[i], t[i], p[i], &sig));
+        ck_assert(sigma[i] == sig);
+    }
+    specific_volume_anomaly_n(s, t, p, out, NULL, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == specific_volume_anomaly(s[i], t[i], p[i], &sig));
+
+    freezing_point_n(s, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == freezing_point(s[i], p[i]));
+
+    specific_heat_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == specific_heat(s[i], t[i], p[i]));
+
+    adiabatic_temperature_gradient_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == adiabatic_temperature_gradient(s[i], t[i], p[i]));
+
+    for (i = 0; i < GRID; i++)
+        pr[i] = references[i % 4];
+    potential_temperature_n(s, t, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == theta(s[i], t[i], p[i], pr[i]));
+
+    in_situ_temperature_n(s, t, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == in_situ_temperature(s[i], t[i], p[i], pr[i]));
+
+    for (i = 0; i < 4; i++)
+        multi[i] = all[i];
+    potential_temperature_multi_n(s, t, p, references, 4, multi, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(all[0][i] == theta(s[i], t[i], p[i], 0.0));
+        ck_assert(all[3][i] == theta(s[i], t[i], p[i], 4000.0));
+    }
+
+    sound_speed_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == sound_speed(s[i], t[i], p[i]));
+
+    density_derivatives_n(s, t, p, out, all[0], all[1], all[2], GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == density_derivatives(s[i], t[i], p[i], &alpha,
+                                                &beta, &kappa));
+        ck_assert(all[0][i] == alpha && all[1][i] == beta &&
+                  all[2][i] == kappa);
+    }
+
+    density_n(s, t, p, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == density(s[i], t[i], p[i]));
+
+    potential_density_n(s, t, p, pr, out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == potential_density(s[i], t[i], p[i], pr[i]));
+
+    potential_density_multi_n(s, t, p, references, 4, out, multi, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == density(s[i], t[i], p[i]));
+        ck_assert(all[0][i] == potential_density(s[i], t[i], p[i], 0.0));
+        ck_assert(all[2][i] == potential_density(s[i], t[i], p[i], 2000.0));
+    }
+
+    /* p as depths, all[3] as latitudes. */
+    for (i = 0; i < GRID; i++)
+        all[3][i] = t[i] * 2.0;
+    pressure_from_depth_n(p, all[3], out, GRID);
+    for (i = 0; i < GRID; i++)
+        ck_assert(out[i] == pressure_from_depth(p[i], all[3][i]));
+
+    /* all[0] as density anomalies, all[1] as sound speeds, all[2] as
+     * residuals. */
+    density_n(s, t, p, all[0], GRID);
+    salinity_from_density_n(all[0], t, p, out, all[2], GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == salinity_from_density(all[0][i], t[i], p[i], &r));
+        ck_assert(all[2][i] == r);
+    }
+    sound_speed_n(s, t, p, all[1], GRID);
+    temperature_from_sound_speed_n(all[1], s, p, out, all[2], GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(out[i] == temperature_from_sound_speed(all[1][i], s[i],
+                                                         p[i], &r));
+        ck_assert(all[2][i] == r);
+    }
+
+    /* c holds salinities, out their conductivities. */
+    ctd.salinity = all[0];
+    ctd.svan = all[1];
+    ctd.sigma = all[2];
+    ctd.theta = all[3];
+    ctd.sound_speed = all[4];
+    ctd.depth = all[5];
+    ctd.cpsw = all[6];
+    ctd.freezing_point = all[7];
+    ctd.atg = all[8];
+    conductivity_n(s, t, p, out, GRID);
+    ctd_derive_n(out, t, p, 60.0, 2000.0, 0x1ff, &ctd, GRID);
+    for (i = 0; i < GRID; i++) {
+        ck_assert(all[0][i] == salinity(out[i], t[i], p[i]));
+        ck_assert(all[1][i] == svan(all[0][i], t[i], p[i], &sig));
+        ck_assert(all[2][i] == sig);
+        ck_assert(all[3][i] == theta(all[0][i], t[i], p[i], 2000.0));
+        ck_assert(all[4][i] == sound_speed(all[0][i], t[i], p[i]));
+        ck_assert(all[5][i] == depth(p[i], 60.0));
+        ck_assert(all[6][i] == cpsw(all[0][i], t[i], p[i]));
+        ck_assert(all[7][i] == freezing_point(all[0][i], p[i]));
+        ck_assert(all[8][i] == atg(all[0][i], t[i], p[i]));
+    }
+
+    ck_assert(oceanography_set_isa(OCEANOGRAPHY_ISA_AUTO) == 0);
+}
+
+
+START_TEST(test_isa_selection)
+{
+    ck_assert(oceanography_isa_supported(OCEANOGRAPHY_ISA_AUTO));
+    ck_assert(oceanography_isa_supported(OCEANOGRAPHY_ISA_SCALAR));
+
+    ck_assert(oceanography_set_isa(OCEANOGRAPHY_ISA_AUTO) == 0);
+    ck_assert(oceanography_get_isa() != OCEANOGRAPHY_ISA_AUTO);
+    ck_assert(oceanography_isa_supported(oceanography_get_isa()));
+
+    ck_assert(oceanography_set_isa((enum oceanography_isa) 42) == -1);
+    ck_assert(oceanography_isa_supported(oceanography_get_isa()));
+}
+END_TEST
+
+START_TEST(test_isa_name)
+{
+    ck_assert(strcmp(oceanography_isa_name(OCEANOGRAPHY_ISA_SCALAR),
+                     "scalar") == 0);
+    ck_assert(strcmp(oceanography_isa_name(OCEANOGRAPHY_ISA_AVX512),
+                     "avx512") == 0);
+    ck_assert(strcmp(oceanography_isa_name((enum oceanography_isa) 42),
+                     "unknown") == 0);
+}
+END_TEST
+
+START_TEST(test_check_values)
+{
+    double s[] = {25, 35, 40, 40, 40, 40, 40, 40};
+    double t[] = {0, 20, 40, 40, 40, 40, 40, 40};
+    double p[] = {0, 5000, 10000, 10000, 10000, 10000, 10000, 10000};
+    double out[8];
+    int isa;
+
+    for (isa = OCEANOGRAPHY_ISA_SCALAR; isa <= OCEANOGRAPHY_ISA_AVX512;
+         isa++) {
+        if (!oceanography_isa_supported((enum oceanography_isa) isa))
+            continue;
+        oceanography_set_isa((enum oceanography_isa) isa);
+
+        sound_speed_n(s, t, p, out, 8);
+        ck_assert(cmp_double(out[0], 1435.789875));
+        ck_assert(cmp_double(out[1], 1604.476282));
+        ck_assert(cmp_double(out[7], 1731.995394));
+
+        specific_heat_n(s, t, p, out, 8);
+        ck_assert(cmp_double(out[0], 4048.440412));
+        ck_assert(cmp_double(out[1], 3894.992770));
+        ck_assert(cmp_double(out[7], 3849.499481));
+    }
+
+    oceanography_set_isa(OCEANOGRAPHY_ISA_AUTO);
+}
+END_TEST
+
+/* Salinities out of range or not a number take no iteration and a
+ * temperature that is not a number takes one, in the vector lanes as in the
+ * scalar tail, so the histogram does not depend on the instruction set.
+ */
+START_TEST(test_histogram_out_of_range)
+{
+    double s[19], t[19], p[19], out[19], nan;
+    unsigned long histogram[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+    int i, isa;
+
+    nan = 0.0;
+    nan /= nan;
+    for (i = 0; i < 19; i++) {
+        switch (i % 4) {
+        case 0: s[i] = nan; break;
+        case 1: s[i] = -1.0; break;
+        case 2: s[i] = 0.02; break;
+        default: s[i] = 35.0; break;
+        }
+        t[i] = i % 4 == 3 ? nan : 15.0;
+        p[i] = 1000.0;
+    }
+
+    for (isa = OCEANOGRAPHY_ISA_SCALAR; isa <= OCEANOGRAPHY_ISA_AVX512;
+         isa++) {
+        if (!oceanography_isa_supported((enum oceanography_isa) isa))
+            continue;
+        ck_assert(oceanography_set_isa((enum oceanography_isa) isa) == 0);
+
+        memset(histogram, 0, sizeof(histogram));
+        conductivity_histogram_n(s, t, p, out, histogram, 19);
+        ck_assert_int_eq(histogram[0], 15);
+        ck_assert_int_eq(histogram[1], 4);
+        for (i = 2; i <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; i++)
+            ck_assert_int_eq(histogram[i], 0);
+
+        for (i = 0; i < 19; i++)
+            if (i % 4 == 1 || i % 4 == 2)
+                ck_assert(out[i] == 0.0);
+            else
+                ck_assert(out[i] != out[i]);
+    }
+
+    oceanography_set_isa(OCEANOGRAPHY_ISA_AUTO);
+}
+END_TEST
+
+START_TEST(test_scalar)
+{
+    check_isa(OCEANOGRAPHY_ISA_SCALAR);
+}
+END_TEST
+
+START_TEST(test_sse2)
+{
+    if (oceanography_isa_supported(OCEANOGRAPHY_ISA_SSE2))
+        check_isa(OCEANOGRAPHY_ISA_SSE2);
+}
+END_TEST
+
+START_TEST(test_avx2)
+{
+    if (oceanography_isa_supported(OCEANOGRAPHY_ISA_AVX2))
+        check_isa(OCEANOGRAPHY_ISA_AVX2);
+}
+END_TEST
+
+START_TEST(test_avx512)
+{
+    if (oceanography_isa_supported(OCEANOGRAPHY_ISA_AVX512))
+        check_isa(OCEANOGRAPHY_ISA_AVX512);
+}
+END_TEST
+
+
+Suite *simd_suite(void)
+{
+    Suite *s = suite_create("SIMD");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_isa_selection);
+    tcase_add_test(tc_core, test_isa_name);
+    tcase_add_test(tc_core, test_check_values);
+    tcase_add_test(tc_core, test_histogram_out_of_range);
+    tcase_add_test(tc_core, test_scalar);
+    tcase_add_test(tc_core, test_sse2);
+    tcase_add_test(tc_core, test_avx2);
+    tcase_add_test(tc_core, test_avx512);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = simd_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_stats.c -- Unit tests for the instrumentation of liboceanography.
+ *
+ * Built only when the library is built with OCEANOGRAPHY_STATS.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+#define SAMPLES 1001
+
+static double s[SAMPLES], t[SAMPLES], p[SAMPLES], out[SAMPLES];
+static float sf[SAMPLES], tf[SAMPLES], pf[SAMPLES], outf[SAMPLES];
+
+static void setup(void)
+{
+    int i;
+
+    for (i = 0; i < SAMPLES; i++) {
+        s[i] = (i % 41) * 1.0;
+        t[i] = (i % 43) - 2.0;
+        p[i] = (i % 47) * 200.0;
+        sf[i] = (float) s[i];
+        tf[i] = (float) t[i];
+        pf[i] = (float) p[i];
+    }
+
+    oceanography_stats_enable(1);
+    oceanography_stats_reset();
+}
+
+static void teardown(void)
+{
+    oceanography_stats_enable(0);
+}
+
+static unsigned long total(const unsigned long *histogram)
+{
+    unsigned long sum = 0;
+    int k;
+
+    for (k = 0; k <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; k++)
+        sum += histogram[k];
+
+    return sum;
+}
+
+START_TEST(test_counters)
+{
+    struct oceanography_stats stats;
+    struct oceanography_stats_counter *counter;
+
+    salinity(1.0, 10.0, 0.0);
+    salinity_n(s, t, p, out, SAMPLES);
+    salinity_strided(s, 1, t, 0, p, 1, out, 1, 10);
+    salinity_f(1.0f, 10.0f, 0.0f);
+    salinity_n_f(sf, tf, pf, outf, SAMPLES);
+    depth(1000.0, 30.0);
+
+    oceanography_stats_snapshot(&stats);
+    counter = &stats.function[OCEANOGRAPHY_STATS_SALINITY];
+    ck_assert(counter->calls == 5);
+    ck_assert(counter->samples == 2 + 2 * SAMPLES + 10);
+    ck_assert(counter->ticks > 0.0);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_DEPTH].calls == 1);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SOUND_SPEED].calls == 0);
+
+    ck_assert(strcmp(oceanography_stats_name(OCEANOGRAPHY_STATS_SALINITY),
+                     "salinity") == 0);
+    ck_assert(strcmp(oceanography_stats_name(OCEANOGRAPHY_STATS_CTD_DERIVE),
+                     "ctd_derive") == 0);
+    ck_assert(oceanography_stats_name(OCEANOGRAPHY_STATS_FUNCTIONS) == NULL);
+}
+END_TEST
+
+START_TEST(test_disabled)
+{
+    struct oceanography_stats stats, zero;
+
+    oceanography_stats_enable(0);
+    salinity(1.0, 10.0, 0.0);
+    conductivity_n(s, t, p, out, SAMPLES);
+
+    memset(&zero, 0, sizeof(zero));
+    oceanography_stats_snapshot(&stats);
+    ck_assert(memcmp(&stats, &zero, sizeof(stats)) == 0);
+}
+END_TEST
+
+START_TEST(test_out_of_range)
+{
+    struct oceanography_stats stats;
+    double nan = 0.0;
+
+    nan /= nan;
+    salinity(5.0e-4, 10.0, 0.0);
+    salinity(1.0, 45.0, 0.0);
+    salinity(1.0, 10.0, 0.0);
+    conductivity(0.02, 10.0, 0.0);
+    conductivity(35.0, 10.0, -1.0);
+    depth(1000.0, 91.0);
+    sound_speed(nan, 10.0, 0.0);
+    /* s[0] is 0, out of range for conductivity only. */
+    conductivity_n(s, t, p, out, SAMPLES);
+    specific_heat_n(s, t, p, out, SAMPLES);
+
+    oceanography_stats_snapshot(&stats);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SALINITY].out_of_range == 2);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_CONDUCTIVITY].out_of_range ==
+              2 + (SAMPLES + 40) / 41);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_DEPTH].out_of_range == 1);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SOUND_SPEED].out_of_range ==
+              1);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SPECIFIC_HEAT].out_of_range ==
+              0);
+}
+END_TEST
+
+START_TEST(test_iterations)
+{
+    struct oceanography_stats stats;
+    unsigned long histogram[OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS + 1];
+    int k;
+
+    memset(histogram, 0, sizeof(histogram));
+    conductivity_histogram_n(s, t, p, out, histogram, SAMPLES);
+    oceanography_stats_reset();
+
+    conductivity_n(s, t, p, out, SAMPLES);
+    oceanography_stats_snapshot(&stats);
+    for (k = 0; k <= OCEANOGRAPHY_CONDUCTIVITY_ITERATIONS; k++)
+        ck_assert(stats.conductivity_iterations[k] == histogram[k]);
+
+    conductivity(35.0, 10.0, 0.0);
+    conductivity_strided(s, 1, t, 1, p, 1, out, 1, SAMPLES);
+    conductivity_f(35.0f, 10.0f, 0.0f);
+    conductivity_n_f(sf, tf, pf, outf, SAMPLES);
+    oceanography_stats_snapshot(&stats);
+    ck_assert(total(stats.conductivity_iterations) == 3 * SAMPLES + 2);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_CONDUCTIVITY].samples ==
+              3 * SAMPLES + 2);
+}
+END_TEST
+
+static void *call_salinity(void *arg)
+{
+    int i;
+
+    (void) arg;
+    for (i = 0; i < 5; i++)
+        salinity(1.0, 10.0, 0.0);
+
+    return NULL;
+}
+
+START_TEST(test_threads)
+{
+    struct oceanography_stats stats;
+    struct oceanography_pool *pool;
+    pthread_t thread;
+
+    /* The counts of a thread are kept after it exits. */
+    pthread_create(&thread, NULL, call_salinity, NULL);
+    pthread_join(thread, NULL);
+    salinity(1.0, 10.0, 0.0);
+
+    oceanography_stats_snapshot(&stats);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SALINITY].calls == 6);
+    oceanography_stats_thread_snapshot(&stats);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SALINITY].calls == 1);
+
+    /* The workers of a pool count the iterations of conductivity. */
+    pool = oceanography_pool_create(3);
+    conductivity_parallel(pool, s, t, p, out, SAMPLES);
+    oceanography_stats_snapshot(&stats);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_CONDUCTIVITY].calls == 1);
+    ck_assert(total(stats.conductivity_iterations) == SAMPLES);
+    oceanography_pool_destroy(pool);
+
+    oceanography_stats_snapshot(&stats);
+    ck_assert(total(stats.conductivity_iterations) == SAMPLES);
+}
+END_TEST
+
+START_TEST(test_reset)
+{
+    struct oceanography_stats stats, zero;
+    struct ctd_outputs ctd;
+
+    memset(&ctd, 0, sizeof(ctd));
+    ctd.depth = out;
+    salinity_n(s, t, p, out, SAMPLES);
+    /* Depth does not need conductivity. */
+    ctd_derive_n(NULL, t, p, 30.0, 0.0, OCEANOGRAPHY_CTD_DEPTH, &ctd,
+                 SAMPLES);
+    oceanography_stats_reset();
+
+    memset(&zero, 0, sizeof(zero));
+    oceanography_stats_snapshot(&stats);
+    ck_assert(memcmp(&stats, &zero, sizeof(stats)) == 0);
+    oceanography_stats_thread_snapshot(&stats);
+    ck_assert(memcmp(&stats, &zero, sizeof(stats)) == 0);
+
+    salinity(1.0, 10.0, 0.0);
+    oceanography_stats_snapshot(&stats);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SALINITY].calls == 1);
+    ck_assert(stats.function[OCEANOGRAPHY_STATS_SALINITY].samples == 1);
+}
+END_TEST
+
+
+Suite *stats_suite(void)
+{
+    Suite *s = suite_create("Stats");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, test_counters);
+    tcase_add_test(tc_core, test_disabled);
+    tcase_add_test(tc_core, test_out_of_range);
+    tcase_add_test(tc_core, test_iterations);
+    tcase_add_test(tc_core, test_threads);
+    tcase_add_test(tc_core, test_reset);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = stats_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_stream.c -- Unit tests for the streaming of binary CTD files.
+ *
+ * A file of unaligned records with mixed types is streamed and the output
+ * records are compared bit for bit with the ones of ctd_derive_n().
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* Records: more than two windows, plus a partial one. */
+#define RECORDS 150001
+
+#define INPUT "test_stream.in"
+#define OUTPUT "test_stream.out"
+
+/* Header and record layout of the input file: temperature as float32 at 0,
+ * pressure as float64 at 4, conductivity as float64 at 12 and a flag byte.
+ */
+#define HEADER "CTD ARCHIVE\n"
+#define RECORD 21
+
+#define ALL_OUTPUTS 0x1ff
+
+
+static double *c, *t, *p, *expected[9];
+
+static void write_input(size_t records, size_t trailing)
+{
+    FILE *f;
+    unsigned char record[RECORD];
+    float temperature;
+    size_t i;
+
+    f = fopen(INPUT, "wb");
+    ck_assert(f != NULL);
+    fwrite(HEADER, 1, strlen(HEADER), f);
+    memset(record, 0x55, sizeof(record));
+    for (i = 0; i < records; i++) {
+        temperature = (float) t[i];
+        memcpy(record, &temperature, sizeof(temperature));
+        memcpy(record + 4, &p[i], sizeof(p[i]));
+        memcpy(record + 12, &c[i], sizeof(c[i]));
+        fwrite(record, 1, RECORD, f);
+    }
+    fwrite(record, 1, trailing, f);
+    ck_assert(fclose(f) == 0);
+}
+
+static void stream_init(struct oceanography_stream *stream,
+                        unsigned int outputs, enum oceanography_type type)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->header = strlen(HEADER);
+    stream->record_size = RECORD;
+    stream->temperature.offset = 0;
+    stream->temperature.type = OCEANOGRAPHY_FLOAT32;
+    stream->pressure.offset = 4;
+    stream->pressure.type = OCEANOGRAPHY_FLOAT64;
+    stream->conductivity.offset = 12;
+    stream->conductivity.type = OCEANOGRAPHY_FLOAT64;
+    stream->latitude = 30.0;
+    stream->reference_pressure = 1000.0;
+    stream->outputs = outputs;
+    stream->output_type = type;
+}
+
+/* Read the output file, checking its size. */
+static void *read_output(size_t size)
+{
+    FILE *f;
+    void *data;
+
+    data = malloc(size + 1);
+    f = fopen(OUTPUT, "rb");
+    ck_assert(data != NULL && f != NULL);
+    ck_assert(fread(data, 1, size + 1, f) == size);
+    fclose(f);
+
+    return data;
+}
+
+static void setup(void)
+{
+    struct ctd_outputs out;
+    double *s;
+    int i;
+
+    s = malloc(RECORDS * sizeof(double));
+    c = malloc(RECORDS * sizeof(double));
+    t = malloc(RECORDS * sizeof(double));
+    p = malloc(RECORDS * sizeof(double));
+    for (i = 0; i < 9; i++)
+        expected[i] = malloc(RECORDS * sizeof(double));
+
+    for (i = 0; i < RECORDS; i++) {
+        s[i] = 30.0 + (i % 80) * 0.1;
+        t[i] = (float) ((i % 43) * 0.7 - 2.0);
+        p[i] = (i % 47) * 130.0;
+    }
+    conductivity_n(s, t, p, c, RECORDS);
+    free(s);
+
+    out.salinity = expected[0];
+    out.svan = expected[1];
+    out.sigma = expected[2];
+    out.theta = expected[3];
+    out.sound_speed = expected[4];
+    out.depth = expected[5];
+    out.cpsw = expected[6];
+    out.freezing_point = expected[7];
+    out.atg = expected[8];
+    ctd_derive_n(c, t, p, 30.0, 1000.0, ALL_OUTPUTS, &out, RECORDS);
+}
+
+static void teardown(void)
+{
+    int i;
+
+    free(c);
+    free(t);
+    free(p);
+    for (i = 0; i < 9; i++)
+        free(expected[i]);
+    remove(INPUT);
+    remove(OUTPUT);
+}
+
+
+START_TEST(test_stream_all_outputs)
+{
+    struct oceanography_stream stream;
+    double *out;
+    int i, k;
+
+    write_input(RECORDS, 5);
+    stream_init(&stream, ALL_OUTPUTS, OCEANOGRAPHY_FLOAT64);
+    ck_assert(oceanography_stream_file(NULL, &stream, INPUT, OUTPUT) == 0);
+
+    out = read_output(RECORDS * 9 * sizeof(double));
+    for (i = 0; i < RECORDS; i++)
+        for (k = 0; k < 9; k++)
+            ck_assert(out[i * 9 + k] == expected[k][i]);
+    free(out);
+}
+END_TEST
+
+START_TEST(test_stream_float_outputs)
+{
+    struct oceanography_stream stream;
+    struct oceanography_pool *pool;
+    float *out;
+    int i;
+
+    write_input(RECORDS, 0);
+    stream_init(&stream, OCEANOGRAPHY_CTD_DEPTH | OCEANOGRAPHY_CTD_SALINITY |
+                OCEANOGRAPHY_CTD_SOUND_SPEED, OCEANOGRAPHY_FLOAT32);
+    pool = oceanography_pool_create(3);
+    ck_assert(oceanography_stream_file(pool, &stream, INPUT, OUTPUT) == 0);
+    oceanography_pool_destroy(pool);
+
+    out = read_output(RECORDS * 3 * sizeof(float));
+    for (i = 0; i < RECORDS; i++) {
+        ck_assert(out[i * 3] == (float) expected[0][i]);
+        ck_assert(out[i * 3 + 1] == (float) expected[4][i]);
+        ck_assert(out[i * 3 + 2] == (float) expected[5][i]);
+    }
+    free(out);
+}
+END_TEST
+
+START_TEST(test_stream_empty)
+{
+    struct oceanography_stream stream;
+
+    write_input(0, RECORD - 1);
+    stream_init(&stream, ALL_OUTPUTS, OCEANOGRAPHY_FLOAT64);
+    ck_assert(oceanography_stream_file(NULL, &stream, INPUT, OUTPUT) == 0);
+    free(read_output(0));
+}
+END_TEST
+
+START_TEST(test_stream_errors)
+{
+    struct oceanography_stream stream;
+
+    write_input(10, 0);
+
+    stream_init(&stream, ALL_OUTPUTS, OCEANOGRAPHY_FLOAT64);
+    stream.conductivity.offset = 14;
+    errno = 0;
+    ck_assert(oceanography_stream_file(NULL, &stream, INPUT, OUTPUT) == -1);
+    ck_assert(errno == EINVAL);
+
+    stream_init(&stream, 0, OCEANOGRAPHY_FLOAT64);
+    ck_assert(oceanography_stream_file(NULL, &stream, INPUT, OUTPUT) == -1);
+    ck_assert(errno == EINVAL);
+
+    stream_init(&stream, 0x200, OCEANOGRAPHY_FLOAT64);
+    ck_assert(oceanography_stream_file(NULL, &stream, INPUT, OUTPUT) == -1);
+    ck_assert(errno == EINVAL);
+
+    stream_init(&stream, ALL_OUTPUTS, OCEANOGRAPHY_FLOAT64);
+    ck_assert(oceanography_stream_file(NULL, &stream, "test_stream.missing",
+                                       OUTPUT) == -1);
+    ck_assert(errno == ENOENT);
+}
+END_TEST
+
+
+Suite *stream_suite(void)
+{
+    Suite *s = suite_create("Stream");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, test_stream_all_outputs);
+    tcase_add_test(tc_core, test_stream_float_outputs);
+    tcase_add_test(tc_core, test_stream_empty);
+    tcase_add_test(tc_core, test_stream_errors);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = stream_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_summary.c -- Unit tests for the summaries of derived quantities.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* More than a block, and not a multiple of it. */
+#define SAMPLES 1000
+
+#define ALL_OUTPUTS 0x1ff
+
+static double x[SAMPLES];
+
+static void setup(void)
+{
+    int i;
+
+    /* A large mean and a small deviation: the sum of squares would lose
+     * every digit of the variance. */
+    for (i = 0; i < SAMPLES; i++)
+        x[i] = 1.0e9 + (i % 4 == 0 ? 4.0 : i % 4 == 1 ? 7.0 :
+                        i % 4 == 2 ? 13.0 : 16.0);
+}
+
+START_TEST(test_moments)
+{
+    struct oceanography_summary summary;
+
+    oceanography_summary_init(&summary, NULL, 0, 0.0, 0.0);
+    ck_assert(summary.count == 0);
+    ck_assert(oceanography_summary_variance(&summary) == 0.0);
+
+    oceanography_summary_add_n(&summary, x, SAMPLES);
+    ck_assert(summary.count == SAMPLES);
+    ck_assert(summary.mean == 1.0e9 + 10.0);
+    ck_assert(fabs(oceanography_summary_variance(&summary) -
+                   22.5 * SAMPLES / (SAMPLES - 1)) < 1.0e-9);
+    ck_assert(summary.min == 1.0e9 + 4.0);
+    ck_assert(summary.max == 1.0e9 + 16.0);
+}
+END_TEST
+
+START_TEST(test_merge)
+{
+    struct oceanography_summary all, part[3];
+    unsigned long histogram[4][6];
+    int k;
+
+    oceanography_summary_init(&all, histogram[3], 6, 1.0e9, 1.0e9 + 12.0);
+    oceanography_summary_add_n(&all, x, SAMPLES);
+
+    /* Three threads, with partitions not aligned to the blocks. */
+    for (k = 0; k < 3; k++)
+        oceanography_summary_init(&part[k], histogram[k], 6, 1.0e9,
+                                  1.0e9 + 12.0);
+    oceanography_summary_add_n(&part[0], x, 301);
+    oceanography_summary_add_n(&part[1], x + 301, 2);
+    oceanography_summary_add_n(&part[2], x + 303, SAMPLES - 303);
+    oceanography_summary_merge(&part[0], &part[1]);
+    oceanography_summary_merge(&part[0], &part[2]);
+
+    ck_assert(part[0].count == all.count);
+    ck_assert(fabs(part[0].mean - all.mean) < 1.0e-6);
+    ck_assert(fabs(part[0].m2 - all.m2) < 1.0e-6 * all.m2);
+    ck_assert(part[0].min == all.min && part[0].max == all.max);
+    for (k = 0; k < 6; k++)
+        ck_assert(histogram[0][k] == histogram[3][k]);
+    ck_assert(part[0].below == 0 && part[0].above == all.above);
+
+    /* 4 and 7 in bins 2 and 3, 13 and 16 above 12. */
+    ck_assert(histogram[3][2] == SAMPLES / 4);
+    ck_assert(histogram[3][3] == SAMPLES / 4);
+    ck_assert(all.above == SAMPLES / 2);
+
+    /* Merging an empty summary changes nothing. */
+    oceanography_summary_init(&part[1], NULL, 0, 0.0, 0.0);
+    oceanography_summary_merge(&all, &part[1]);
+    ck_assert(all.count == SAMPLES && all.mean == 1.0e9 + 10.0);
+}
+END_TEST
+
+START_TEST(test_nan)
+{
+    struct oceanography_summary summary;
+    unsigned long histogram[2];
+    double y[] = {1.0, 0.0, 3.0, -1.0};
+
+    y[1] /= y[1];
+    oceanography_summary_init(&summary, histogram, 2, 0.0, 2.0);
+    oceanography_summary_add_n(&summary, y, 4);
+    ck_assert(summary.count == 3);
+    ck_assert(summary.mean == 1.0);
+    ck_assert(oceanography_summary_variance(&summary) == 4.0);
+    ck_assert(histogram[0] == 0 && histogram[1] == 1);
+    ck_assert(summary.below == 1 && summary.above == 1);
+}
+END_TEST
+
+START_TEST(test_ctd_summarize_n)
+{
+    static double c[SAMPLES], t[SAMPLES], p[SAMPLES], out[9][SAMPLES];
+    struct oceanography_summary fused[9], expected[9];
+    struct ctd_summaries summaries;
+    struct ctd_outputs ctd;
+    int i, k;
+
+    for (i = 0; i < SAMPLES; i++) {
+        c[i] = 0.8 + (i % 37) * 0.01;
+        t[i] = 20.0 - (i % 29) * 0.5;
+        p[i] = i * 5.0;
+    }
+    for (k = 0; k < 9; k++) {
+        oceanography_summary_init(&fused[k], NULL, 0, 0.0, 0.0);
+        oceanography_summary_init(&expected[k], NULL, 0, 0.0, 0.0);
+    }
+    summaries.salinity = &fused[0];
+    summaries.svan = &fused[1];
+    summaries.sigma = &fused[2];
+    summaries.theta = &fused[3];
+    summaries.sound_speed = &fused[4];
+    summaries.depth = &fused[5];
+    summaries.cpsw = &fused[6];
+    summaries.freezing_point = &fused[7];
+    summaries.atg = &fused[8];
+    ctd.salinity = out[0];
+    ctd.svan = out[1];
+    ctd.sigma = out[2];
+    ctd.theta = out[3];
+    ctd.sound_speed = out[4];
+    ctd.depth = out[5];
+    ctd.cpsw = out[6];
+    ctd.freezing_point = out[7];
+    ctd.atg = out[8];
+
+    /* The summaries of the output arrays, bit for bit. */
+    ctd_summarize_n(c, t, p, 45.0, 0.0, ALL_OUTPUTS, &summaries, SAMPLES);
+    ctd_derive_n(c, t, p, 45.0, 0.0, ALL_OUTPUTS, &ctd, SAMPLES);
+    for (k = 0; k < 9; k++) {
+        oceanography_summary_add_n(&expected[k], out[k], SAMPLES);
+        ck_assert(fused[k].count == SAMPLES);
+        ck_assert(fused[k].mean == expected[k].mean);
+        ck_assert(fused[k].m2 == expected[k].m2);
+        ck_assert(fused[k].min == expected[k].min);
+        ck_assert(fused[k].max == expected[k].max);
+    }
+
+    /* Only depth: conductivity is not read. */
+    oceanography_summary_init(&fused[5], NULL, 0, 0.0, 0.0);
+    ctd_summarize_n(NULL, t, p, 45.0, 0.0, OCEANOGRAPHY_CTD_DEPTH,
+                    &summaries, SAMPLES);
+    ck_assert(fused[5].mean == expected[5].mean);
+}
+END_TEST
+
+
+Suite *summary_suite(void)
+{
+    Suite *s = suite_create("Summary");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, test_moments);
+    tcase_add_test(tc_core, test_merge);
+    tcase_add_test(tc_core, test_nan);
+    tcase_add_test(tc_core, test_ctd_summarize_n);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = summary_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
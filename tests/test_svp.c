@@ -0,0 +1,271 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_svp.c -- Unit tests for the sound velocity profiles of liboceanography.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+#define SAMPLES 301
+#define LATITUDE 30.0
+
+/* Points checked inside every segment. */
+#define POINTS 7
+
+static double s[SAMPLES], t[SAMPLES], p[SAMPLES];
+
+/* A cast with a warm mixed layer, a thermocline and a sound channel. */
+static void setup(void)
+{
+    int i;
+
+    for (i = 0; i < SAMPLES; i++) {
+        p[i] = i * 20.0;
+        s[i] = 35.0 - 0.5 * exp(-p[i] / 300.0);
+        t[i] = 2.0 + 20.0 / (1.0 + exp((p[i] - 150.0) / 60.0)) +
+               4.0 * exp(-p[i] / 1500.0);
+    }
+}
+
+/* Check that the profile goes through the samples and that it is monotone
+ * between them. */
+static void check_profile(const struct oceanography_svp *svp,
+                          const double *salinity, const double *temperature,
+                          const double *pressure, int n)
+{
+    double z0, z1, c0, c1, z, c, g;
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        z = depth(pressure[i], LATITUDE);
+        ck_assert(oceanography_svp_speed(svp, z) ==
+                  sound_speed(salinity[i], temperature[i], pressure[i]));
+    }
+
+    for (i = 0; i + 1 < n; i++) {
+        z0 = depth(pressure[i], LATITUDE);
+        z1 = depth(pressure[i + 1], LATITUDE);
+        c0 = sound_speed(salinity[i], temperature[i], pressure[i]);
+        c1 = sound_speed(salinity[i + 1], temperature[i + 1],
+                         pressure[i + 1]);
+        for (j = 1; j < POINTS; j++) {
+            z = z0 + (z1 - z0) * j / POINTS;
+            c = oceanography_svp_speed(svp, z);
+            g = oceanography_svp_gradient(svp, z);
+            ck_assert(c >= (c0 < c1 ? c0 : c1) - 1.0e-9);
+            ck_assert(c <= (c0 < c1 ? c1 : c0) + 1.0e-9);
+            ck_assert(g * (c1 - c0) >= -1.0e-12);
+        }
+    }
+}
+
+START_TEST(test_samples)
+{
+    struct oceanography_svp *svp;
+    double min, max;
+
+    svp = oceanography_svp_create(s, t, p, LATITUDE, SAMPLES);
+    ck_assert(svp != NULL);
+
+    oceanography_svp_range(svp, &min, &max);
+    ck_assert(min == depth(p[0], LATITUDE));
+    ck_assert(max == depth(p[SAMPLES - 1], LATITUDE));
+    check_profile(svp, s, t, p, SAMPLES);
+
+    oceanography_svp_destroy(svp);
+}
+END_TEST
+
+START_TEST(test_gradient)
+{
+    struct oceanography_svp *svp;
+    double min, max, z, h, diff, g, c, exact;
+    int i;
+
+    svp = oceanography_svp_create(s, t, p, LATITUDE, SAMPLES);
+    oceanography_svp_range(svp, &min, &max);
+
+    /* The gradient is the derivative of the spline. */
+    h = 1.0e-4;
+    for (i = 1; i < 1000; i++) {
+        z = min + (max - min) * i / 1000.0;
+        diff = (oceanography_svp_speed(svp, z + h) -
+                oceanography_svp_speed(svp, z - h)) / (2.0 * h);
+        ck_assert(fabs(oceanography_svp_gradient(svp, z) - diff) < 1.0e-5);
+    }
+
+    /* Between the samples of a smooth cast the spline is close to the sound
+     * speed, and its gradient to the one of the cast. */
+    for (i = 1; i < SAMPLES - 1; i++) {
+        z = depth(p[i] + 10.0, LATITUDE);
+        c = oceanography_svp_speed(svp, z);
+        exact = sound_speed(35.0 - 0.5 * exp(-(p[i] + 10.0) / 300.0),
+                            2.0 + 20.0 / (1.0 + exp((p[i] - 140.0) / 60.0)) +
+                            4.0 * exp(-(p[i] + 10.0) / 1500.0), p[i] + 10.0);
+        ck_assert(fabs(c - exact) < 0.05);
+
+        g = oceanography_svp_gradient(svp, depth(p[i], LATITUDE));
+        diff = (sound_speed(s[i + 1], t[i + 1], p[i + 1]) -
+                sound_speed(s[i - 1], t[i - 1], p[i - 1])) /
+               (depth(p[i + 1], LATITUDE) - depth(p[i - 1], LATITUDE));
+        ck_assert(fabs(g - diff) < 0.01);
+    }
+
+    oceanography_svp_destroy(svp);
+}
+END_TEST
+
+START_TEST(test_outside)
+{
+    struct oceanography_svp *svp;
+    double min, max, c, nan = 0.0;
+
+    nan /= nan;
+    svp = oceanography_svp_create(s, t, p, LATITUDE, SAMPLES);
+    oceanography_svp_range(svp, &min, &max);
+
+    /* The profile is flat above the first sample and below the last. */
+    ck_assert(oceanography_svp_speed(svp, min - 10.0) ==
+              sound_speed(s[0], t[0], p[0]));
+    ck_assert(oceanography_svp_gradient(svp, min - 10.0) == 0.0);
+    ck_assert(oceanography_svp_speed(svp, max) ==
+              sound_speed(s[SAMPLES - 1], t[SAMPLES - 1], p[SAMPLES - 1]));
+    ck_assert(oceanography_svp_speed(svp, max + 100.0) ==
+              oceanography_svp_speed(svp, max));
+    ck_assert(oceanography_svp_gradient(svp, max + 100.0) == 0.0);
+    ck_assert(oceanography_svp_gradient(svp, max) == 0.0);
+
+    c = oceanography_svp_speed(svp, nan);
+    ck_assert(c != c);
+    c = oceanography_svp_gradient(svp, nan);
+    ck_assert(c != c);
+
+    oceanography_svp_destroy(svp);
+}
+END_TEST
+
+START_TEST(test_eval_n)
+{
+    struct oceanography_svp *svp;
+    double z[SAMPLES], speed[SAMPLES], gradient[SAMPLES], other[SAMPLES];
+    double min, max, nan = 0.0;
+    int i;
+
+    nan /= nan;
+    svp = oceanography_svp_create(s, t, p, LATITUDE, SAMPLES);
+    oceanography_svp_range(svp, &min, &max);
+
+    for (i = 0; i < SAMPLES; i++)
+        z[i] = min - 50.0 + (max - min + 100.0) * rand() / RAND_MAX;
+    z[7] = nan;
+
+    oceanography_svp_eval_n(svp, z, speed, gradient, SAMPLES);
+    for (i = 0; i < SAMPLES; i++) {
+        if (i == 7)
+            continue;
+        ck_assert(speed[i] == oceanography_svp_speed(svp, z[i]));
+        ck_assert(gradient[i] == oceanography_svp_gradient(svp, z[i]));
+    }
+    ck_assert(speed[7] != speed[7] && gradient[7] != gradient[7]);
+
+    oceanography_svp_eval_n(svp, z, NULL, other, SAMPLES);
+    for (i = 0; i < SAMPLES; i++)
+        ck_assert(i == 7 || other[i] == gradient[i]);
+    oceanography_svp_eval_n(svp, z, other, NULL, SAMPLES);
+    for (i = 0; i < SAMPLES; i++)
+        ck_assert(i == 7 || other[i] == speed[i]);
+
+    oceanography_svp_destroy(svp);
+}
+END_TEST
+
+START_TEST(test_irregular)
+{
+    struct oceanography_svp *svp;
+    double pr[SAMPLES];
+    int i;
+
+    /* Samples 1 cm apart near the surface, 500 meters apart below: the
+     * buckets cannot be as narrow as the closest samples. */
+    for (i = 0; i < SAMPLES; i++)
+        pr[i] = i < SAMPLES - 10 ? i * 0.01 : (i - SAMPLES + 11) * 500.0;
+
+    svp = oceanography_svp_create(s, t, pr, LATITUDE, SAMPLES);
+    ck_assert(svp != NULL);
+    check_profile(svp, s, t, pr, SAMPLES);
+    oceanography_svp_destroy(svp);
+
+    /* Two samples are a straight line. */
+    svp = oceanography_svp_create(s, t, p + 10, LATITUDE, 2);
+    ck_assert(svp != NULL);
+    check_profile(svp, s, t, p + 10, 2);
+    oceanography_svp_destroy(svp);
+}
+END_TEST
+
+START_TEST(test_invalid)
+{
+    double pr[SAMPLES], nan = 0.0;
+    int i;
+
+    nan /= nan;
+    ck_assert(oceanography_svp_create(s, t, p, LATITUDE, 1) == NULL);
+
+    for (i = 0; i < SAMPLES; i++)
+        pr[i] = p[i];
+    pr[100] = pr[99];
+    ck_assert(oceanography_svp_create(s, t, pr, LATITUDE, SAMPLES) == NULL);
+    pr[100] = nan;
+    ck_assert(oceanography_svp_create(s, t, pr, LATITUDE, SAMPLES) == NULL);
+    ck_assert(oceanography_svp_create(s, t, p, nan, SAMPLES) == NULL);
+}
+END_TEST
+
+
+Suite *svp_suite(void)
+{
+    Suite *s = suite_create("Sound velocity profile");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, test_samples);
+    tcase_add_test(tc_core, test_gradient);
+    tcase_add_test(tc_core, test_outside);
+    tcase_add_test(tc_core, test_eval_n);
+    tcase_add_test(tc_core, test_irregular);
+    tcase_add_test(tc_core, test_invalid);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = svp_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
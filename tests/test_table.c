@@ -0,0 +1,282 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * test_table.c -- Unit tests for the approximation tables of liboceanography.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "oceanography.h"
+
+/* Random samples compared with the exact functions. */
+#define SAMPLES 20000
+
+/* Samples of a profile evaluated in batches. */
+#define PROFILE 1001
+
+
+static void spec_init(struct oceanography_table_spec *spec)
+{
+    spec->function = OCEANOGRAPHY_TABLE_SVAN;
+    spec->min[0] = 30.0;
+    spec->max[0] = 40.0;
+    spec->min[1] = -2.0;
+    spec->max[1] = 30.0;
+    spec->min[2] = 0.0;
+    spec->max[2] = 6000.0;
+    spec->cells[0] = 1;
+    spec->cells[1] = 4;
+    spec->cells[2] = 8;
+    spec->degree[0] = 2;
+    spec->degree[1] = 3;
+    spec->degree[2] = 3;
+}
+
+static double random_in(double min, double max)
+{
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+static double exact(double s, double t, double p)
+{
+    double sigma;
+
+    return svan(s, t, p, &sigma);
+}
+
+/* The error of random samples is within the reported one. */
+static void check_error(const struct oceanography_table *table,
+                        const struct oceanography_table_spec *spec)
+{
+    double s, t, p, error = oceanography_table_error(table);
+    int i;
+
+    srand(1);
+    for (i = 0; i < SAMPLES; i++) {
+        s = random_in(spec->min[0], spec->max[0]);
+        t = random_in(spec->min[1], spec->max[1]);
+        p = random_in(spec->min[2], spec->max[2]);
+        ck_assert(fabs(oceanography_table_eval(table, s, t, p) -
+                       exact(s, t, p)) <= error);
+    }
+
+    /* Corners of the box. */
+    ck_assert(fabs(oceanography_table_eval(table, spec->max[0], spec->max[1],
+                                           spec->max[2]) -
+                   exact(spec->max[0], spec->max[1], spec->max[2])) <=
+              error);
+    ck_assert(fabs(oceanography_table_eval(table, spec->min[0], spec->min[1],
+                                           spec->min[2]) -
+                   exact(spec->min[0], spec->min[1], spec->min[2])) <=
+              error);
+}
+
+
+START_TEST(test_svan_table)
+{
+    struct oceanography_table_spec spec;
+    struct oceanography_table *table;
+
+    spec_init(&spec);
+    table = oceanography_table_create(&spec);
+    ck_assert(table != NULL);
+    ck_assert(oceanography_table_error(table) > 0.0);
+    ck_assert(oceanography_table_error(table) < 0.1);
+    check_error(table, &spec);
+    oceanography_table_destroy(table);
+
+    /* Coarser tables have larger errors. */
+    spec.degree[0] = spec.degree[1] = spec.degree[2] = 1;
+    table = oceanography_table_create(&spec);
+    ck_assert(table != NULL);
+    ck_assert(oceanography_table_error(table) > 0.1);
+    check_error(table, &spec);
+    oceanography_table_destroy(table);
+}
+END_TEST
+
+START_TEST(test_table_outside)
+{
+    struct oceanography_table_spec spec;
+    struct oceanography_table *table;
+    double s[] = {35.0, 20.0, 35.0, 35.0};
+    double t[] = {10.0, 10.0, 31.0, 10.0};
+    double p[] = {1000.0, 1000.0, 1000.0, 7000.0};
+    double out[4];
+    int i;
+
+    spec_init(&spec);
+    table = oceanography_table_create(&spec);
+    ck_assert(table != NULL);
+
+    oceanography_table_eval_n(table, s, t, p, out, 4);
+    ck_assert(out[0] == oceanography_table_eval(table, s[0], t[0], p[0]));
+    ck_assert(out[0] != exact(s[0], t[0], p[0]));
+
+    /* Outside the box the exact function is used. */
+    for (i = 1; i < 4; i++)
+        ck_assert(out[i] == exact(s[i], t[i], p[i]));
+
+    oceanography_table_destroy(table);
+}
+END_TEST
+
+START_TEST(test_table_isa)
+{
+    struct oceanography_table_spec spec;
+    struct oceanography_table *table;
+    double s[PROFILE], t[PROFILE], p[PROFILE], out[PROFILE], nan, x;
+    enum oceanography_isa isa;
+    int i;
+
+    /* A profile crossing the cells, with random samples in and out of the
+     * box and a NaN. */
+    srand(2);
+    for (i = 0; i < PROFILE; i++) {
+        x = (double) i / (PROFILE - 1);
+        s[i] = 34.0 + x;
+        t[i] = 29.0 - 28.0 * x;
+        p[i] = 6000.0 * x * x;
+        if (i % 7 == 3) {
+            s[i] = random_in(25.0, 45.0);
+            t[i] = random_in(-5.0, 35.0);
+            p[i] = random_in(0.0, 7000.0);
+        }
+    }
+    nan = 0.0;
+    nan /= nan;
+    t[PROFILE / 2] = nan;
+
+    spec_init(&spec);
+    table = oceanography_table_create(&spec);
+    ck_assert(table != NULL);
+
+    /* Every instruction set gives the results of the scalar function. */
+    for (isa = OCEANOGRAPHY_ISA_SCALAR; isa <= OCEANOGRAPHY_ISA_AVX512;
+         isa++) {
+        if (!oceanography_isa_supported(isa))
+            continue;
+        ck_assert(oceanography_set_isa(isa) == 0);
+
+        oceanography_table_eval_n(table, s, t, p, out, PROFILE);
+        for (i = 0; i < PROFILE; i++) {
+            x = oceanography_table_eval(table, s[i], t[i], p[i]);
+            ck_assert(out[i] == x || (out[i] != out[i] && x != x));
+        }
+    }
+    ck_assert(oceanography_set_isa(OCEANOGRAPHY_ISA_AUTO) == 0);
+
+    oceanography_table_destroy(table);
+}
+END_TEST
+
+START_TEST(test_table_serialize)
+{
+    struct oceanography_table_spec spec;
+    struct oceanography_table *table, *copy;
+    char *buffer;
+    size_t size;
+    double s, t, p;
+    int i;
+
+    spec_init(&spec);
+    table = oceanography_table_create(&spec);
+    ck_assert(table != NULL);
+
+    size = oceanography_table_serialize(table, NULL, 0);
+    buffer = malloc(size);
+    ck_assert(oceanography_table_serialize(table, buffer, size - 1) == size);
+    ck_assert(oceanography_table_serialize(table, buffer, size) == size);
+
+    copy = oceanography_table_deserialize(buffer, size);
+    ck_assert(copy != NULL);
+    ck_assert(oceanography_table_error(copy) ==
+              oceanography_table_error(table));
+    srand(2);
+    for (i = 0; i < 1000; i++) {
+        s = random_in(30.0, 40.0);
+        t = random_in(-2.0, 30.0);
+        p = random_in(0.0, 6000.0);
+        ck_assert(oceanography_table_eval(copy, s, t, p) ==
+                  oceanography_table_eval(table, s, t, p));
+    }
+    oceanography_table_destroy(copy);
+
+    /* Truncated or corrupted buffers are refused. */
+    ck_assert(oceanography_table_deserialize(buffer, size - 1) == NULL);
+    ck_assert(oceanography_table_deserialize(buffer, 4) == NULL);
+    buffer[0] = 'X';
+    ck_assert(oceanography_table_deserialize(buffer, size) == NULL);
+
+    free(buffer);
+    oceanography_table_destroy(table);
+}
+END_TEST
+
+START_TEST(test_table_invalid)
+{
+    struct oceanography_table_spec spec;
+
+    spec_init(&spec);
+    spec.cells[1] = 0;
+    ck_assert(oceanography_table_create(&spec) == NULL);
+
+    spec_init(&spec);
+    spec.degree[2] = OCEANOGRAPHY_TABLE_MAX_DEGREE + 1;
+    ck_assert(oceanography_table_create(&spec) == NULL);
+
+    spec_init(&spec);
+    spec.max[0] = spec.min[0];
+    ck_assert(oceanography_table_create(&spec) == NULL);
+
+    spec_init(&spec);
+    spec.function = (enum oceanography_table_function) 1;
+    ck_assert(oceanography_table_create(&spec) == NULL);
+}
+END_TEST
+
+
+Suite *table_suite(void)
+{
+    Suite *s = suite_create("Table");
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_svan_table);
+    tcase_add_test(tc_core, test_table_outside);
+    tcase_add_test(tc_core, test_table_isa);
+    tcase_add_test(tc_core, test_table_serialize);
+    tcase_add_test(tc_core, test_table_invalid);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+  int number_failed;
+  Suite *s = table_suite();
+  SRunner *sr = srunner_create(s);
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
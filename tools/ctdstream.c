@@ -0,0 +1,201 @@
+/*
+ * Copyright 2011 Daniele Tricoli <eriol@mornie.org>
+ *
+ * This file is part of liboceanography.
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see http://www.gnu.org/licenses/.
+ *
+ *
+ * ctdstream.c -- Compute derived quantities of a binary CTD file.
+ *
+ * Usage: ctdstream --record BYTES --conductivity OFFSET[:TYPE]
+ *                  --temperature OFFSET[:TYPE] --pressure OFFSET[:TYPE]
+ *                  [--header BYTES] [--latitude DEGREES]
+ *                  [--reference-pressure DECIBARS] [--outputs LIST]
+ *                  [--output-type TYPE] [--threads N] INPUT OUTPUT
+ *
+ * TYPE is float32 or float64 (the default), in host byte order. LIST is a
+ * comma separated list of salinity, svan, sigma, theta, sound_speed, depth,
+ * cpsw, freezing_point and atg; output records hold them in this order,
+ * whatever the order of LIST. See oceanography_stream_file().
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oceanography.h"
+
+static const char *output_names[] = {
+    "salinity", "svan", "sigma", "theta", "sound_speed", "depth", "cpsw",
+    "freezing_point", "atg"
+};
+
+#define OUTPUTS (sizeof(output_names) / sizeof(output_names[0]))
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: ctdstream --record BYTES --conductivity OFFSET[:TYPE]\n"
+            "                 --temperature OFFSET[:TYPE] "
+            "--pressure OFFSET[:TYPE]\n"
+            "                 [--header BYTES] [--latitude DEGREES]\n"
+            "                 [--reference-pressure DECIBARS] "
+            "[--outputs LIST]\n"
+            "                 [--output-type TYPE] [--threads N] "
+            "INPUT OUTPUT\n");
+    exit(EXIT_FAILURE);
+}
+
+static size_t parse_size(const char *text)
+{
+    char *end;
+    unsigned long value;
+
+    value = strtoul(text, &end, 10);
+    if (end == text || *end != '\0')
+        usage();
+
+    return (size_t) value;
+}
+
+static double parse_double(const char *text)
+{
+    char *end;
+    double value;
+
+    value = strtod(text, &end);
+    if (end == text || *end != '\0')
+        usage();
+
+    return value;
+}
+
+static enum oceanography_type parse_type(const char *text)
+{
+    if (strcmp(text, "float32") == 0)
+        return OCEANOGRAPHY_FLOAT32;
+    if (strcmp(text, "float64") == 0)
+        return OCEANOGRAPHY_FLOAT64;
+    usage();
+
+    return OCEANOGRAPHY_FLOAT64;
+}
+
+/* OFFSET[:TYPE] */
+static void parse_column(char *text, struct oceanography_column *column)
+{
+    char *colon = strchr(text, ':');
+
+    column->type = OCEANOGRAPHY_FLOAT64;
+    if (colon != NULL) {
+        *colon = '\0';
+        column->type = parse_type(colon + 1);
+    }
+    column->offset = parse_size(text);
+}
+
+static unsigned int parse_outputs(char *text)
+{
+    unsigned int outputs = 0;
+    size_t k;
+    char *name;
+
+    for (name = strtok(text, ","); name != NULL; name = strtok(NULL, ",")) {
+        for (k = 0; k < OUTPUTS; k++)
+            if (strcmp(name, output_names[k]) == 0)
+                break;
+        if (k == OUTPUTS)
+            usage();
+        outputs |= 1u << k;
+    }
+
+    return outputs;
+}
+
+int main(int argc, char **argv)
+{
+    struct oceanography_stream stream;
+    struct oceanography_pool *pool = NULL;
+    const char *input = NULL, *output = NULL;
+    int i, columns = 0, result;
+
+    memset(&stream, 0, sizeof(stream));
+    stream.outputs = OCEANOGRAPHY_CTD_SALINITY;
+    stream.output_type = OCEANOGRAPHY_FLOAT64;
+
+    for (i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            if (input == NULL)
+                input = argv[i];
+            else if (output == NULL)
+                output = argv[i];
+            else
+                usage();
+            continue;
+        }
+        if (i + 1 == argc)
+            usage();
+
+        if (strcmp(argv[i], "--record") == 0)
+            stream.record_size = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--header") == 0)
+            stream.header = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--conductivity") == 0) {
+            parse_column(argv[++i], &stream.conductivity);
+            columns |= 1;
+        } else if (strcmp(argv[i], "--temperature") == 0) {
+            parse_column(argv[++i], &stream.temperature);
+            columns |= 2;
+        } else if (strcmp(argv[i], "--pressure") == 0) {
+            parse_column(argv[++i], &stream.pressure);
+            columns |= 4;
+        } else if (strcmp(argv[i], "--latitude") == 0)
+            stream.latitude = parse_double(argv[++i]);
+        else if (strcmp(argv[i], "--reference-pressure") == 0)
+            stream.reference_pressure = parse_double(argv[++i]);
+        else if (strcmp(argv[i], "--outputs") == 0)
+            stream.outputs = parse_outputs(argv[++i]);
+        else if (strcmp(argv[i], "--output-type") == 0)
+            stream.output_type = parse_type(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0) {
+            oceanography_pool_destroy(pool);
+            pool = oceanography_pool_create(
+                (unsigned int) parse_size(argv[++i]));
+            if (pool == NULL) {
+                fprintf(stderr, "ctdstream: can not create the threads\n");
+                return EXIT_FAILURE;
+            }
+        } else
+            usage();
+    }
+    if (output == NULL || columns != 7 || stream.record_size == 0)
+        usage();
+    if (stream.outputs == 0) {
+        fprintf(stderr, "ctdstream: no outputs selected\n");
+        oceanography_pool_destroy(pool);
+        return EXIT_FAILURE;
+    }
+
+    /* Anything else invalid in the stream is a column out of the record. */
+    result = oceanography_stream_file(pool, &stream, input, output);
+    if (result < 0)
+        fprintf(stderr, "ctdstream: %s\n", errno == EINVAL ?
+                "columns do not fit in the record" : strerror(errno));
+
+    oceanography_pool_destroy(pool);
+
+    return result < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}